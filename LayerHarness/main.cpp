@@ -0,0 +1,343 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <framework/mock_runtime.gen.h>
+
+// Drives frames through the layer's non-graphics path, with the mock runtime as the next layer, and reports the
+// overhead added by the layer to each call.
+//
+// Usage: LayerHarness.exe [frameCount] [path to the layer DLL]
+
+namespace {
+
+    using namespace harness;
+
+    const std::string LayerName = "XR_APILAYER_NOVENDOR_wmr_passthrough";
+
+    const XrInstance FakeInstance = reinterpret_cast<XrInstance>(0x1);
+    const XrSystemId FakeSystemId = 0x2;
+    const XrSession FakeSession = reinterpret_cast<XrSession>(0x3);
+    const XrSwapchain FakeSwapchain = reinterpret_cast<XrSwapchain>(0x4);
+    const XrSpace FakeSpace = reinterpret_cast<XrSpace>(0x5);
+
+    const XrDuration DisplayPeriod = 11'111'111;
+
+    // The end of the chain, in place of the loader's terminator.
+    XrResult XRAPI_CALL FakeCreateApiLayerInstance(const XrInstanceCreateInfo* info,
+                                                   const XrApiLayerCreateInfo* apiLayerInfo,
+                                                   XrInstance* instance) {
+        *instance = FakeInstance;
+        return XR_SUCCESS;
+    }
+
+    template <typename T>
+    T resolve(PFN_xrGetInstanceProcAddr getInstanceProcAddr, XrInstance instance, const char* name) {
+        PFN_xrVoidFunction function = nullptr;
+        if (XR_FAILED(getInstanceProcAddr(instance, name, &function)) || !function) {
+            fprintf(stderr, "Failed to resolve %s\n", name);
+            exit(1);
+        }
+        return reinterpret_cast<T>(function);
+    }
+
+    // The entry points of one end of the chain.
+    struct Dispatch {
+        Dispatch(PFN_xrGetInstanceProcAddr getInstanceProcAddr, XrInstance instance) {
+            xrEnumerateEnvironmentBlendModes = resolve<PFN_xrEnumerateEnvironmentBlendModes>(
+                getInstanceProcAddr, instance, "xrEnumerateEnvironmentBlendModes");
+            xrWaitFrame = resolve<PFN_xrWaitFrame>(getInstanceProcAddr, instance, "xrWaitFrame");
+            xrBeginFrame = resolve<PFN_xrBeginFrame>(getInstanceProcAddr, instance, "xrBeginFrame");
+            xrEndFrame = resolve<PFN_xrEndFrame>(getInstanceProcAddr, instance, "xrEndFrame");
+        }
+
+        PFN_xrEnumerateEnvironmentBlendModes xrEnumerateEnvironmentBlendModes;
+        PFN_xrWaitFrame xrWaitFrame;
+        PFN_xrBeginFrame xrBeginFrame;
+        PFN_xrEndFrame xrEndFrame;
+    };
+
+    struct Timings {
+        std::chrono::steady_clock::duration enumerateEnvironmentBlendModes{0};
+        std::chrono::steady_clock::duration waitFrame{0};
+        std::chrono::steady_clock::duration beginFrame{0};
+        std::chrono::steady_clock::duration endFrame{0};
+    };
+
+    template <typename F>
+    void measure(std::chrono::steady_clock::duration& accumulator, F&& call) {
+        const auto start = std::chrono::steady_clock::now();
+        if (XR_FAILED(call())) {
+            fprintf(stderr, "Unexpected failure\n");
+            exit(1);
+        }
+        accumulator += std::chrono::steady_clock::now() - start;
+    }
+
+    // Submits a typical frame: one projection layer and one quad layer.
+    Timings runFrames(const Dispatch& dispatch, uint32_t frameCount) {
+        XrCompositionLayerProjectionView views[2]{{XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW, nullptr},
+                                                  {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW, nullptr}};
+        for (uint32_t i = 0; i < 2; i++) {
+            views[i].pose.orientation.w = 1.f;
+            views[i].subImage.swapchain = FakeSwapchain;
+            views[i].subImage.imageRect.extent = {2048, 2048};
+            views[i].subImage.imageArrayIndex = i;
+        }
+        XrCompositionLayerProjection projection{XR_TYPE_COMPOSITION_LAYER_PROJECTION, nullptr};
+        projection.space = FakeSpace;
+        projection.viewCount = 2;
+        projection.views = views;
+
+        XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr};
+        quad.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+        quad.space = FakeSpace;
+        quad.pose.orientation.w = 1.f;
+        quad.size = {1.f, 1.f};
+        quad.subImage.swapchain = FakeSwapchain;
+        quad.subImage.imageRect.extent = {512, 512};
+
+        const XrCompositionLayerBaseHeader* layers[] = {
+            reinterpret_cast<const XrCompositionLayerBaseHeader*>(&projection),
+            reinterpret_cast<const XrCompositionLayerBaseHeader*>(&quad)};
+
+        Timings timings;
+        for (uint32_t frame = 0; frame < frameCount; frame++) {
+            measure(timings.enumerateEnvironmentBlendModes, [&] {
+                XrEnvironmentBlendMode blendModes[4];
+                uint32_t blendModesCount = 0;
+                return dispatch.xrEnumerateEnvironmentBlendModes(FakeInstance,
+                                                                 FakeSystemId,
+                                                                 XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO,
+                                                                 (uint32_t)std::size(blendModes),
+                                                                 &blendModesCount,
+                                                                 blendModes);
+            });
+
+            XrFrameState frameState{XR_TYPE_FRAME_STATE, nullptr};
+            measure(timings.waitFrame, [&] { return dispatch.xrWaitFrame(FakeSession, nullptr, &frameState); });
+
+            measure(timings.beginFrame, [&] { return dispatch.xrBeginFrame(FakeSession, nullptr); });
+
+            XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO, nullptr};
+            frameEndInfo.displayTime = frameState.predictedDisplayTime;
+            frameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+            frameEndInfo.layerCount = (uint32_t)std::size(layers);
+            frameEndInfo.layers = layers;
+            measure(timings.endFrame, [&] { return dispatch.xrEndFrame(FakeSession, &frameEndInfo); });
+        }
+
+        return timings;
+    }
+
+    void report(const char* name,
+                std::chrono::steady_clock::duration layer,
+                std::chrono::steady_clock::duration direct,
+                uint32_t frameCount) {
+        const double layerNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(layer).count() / frameCount;
+        const double directNs =
+            (double)std::chrono::duration_cast<std::chrono::nanoseconds>(direct).count() / frameCount;
+        printf("%-34s %10.1f ns %10.1f ns %10.1f ns\n", name, layerNs, directNs, layerNs - directNs);
+    }
+
+    bool expectCount(const char* name, uint64_t actual, uint64_t expected) {
+        if (actual != expected) {
+            fprintf(stderr,
+                    "%s was called %llu times, expected %llu\n",
+                    name,
+                    (unsigned long long)actual,
+                    (unsigned long long)expected);
+            return false;
+        }
+        return true;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint32_t frameCount = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 10000;
+    const std::string layerPath = argc > 2 ? argv[2] : LayerName + ".dll";
+    if (!frameCount) {
+        fprintf(stderr, "Invalid frame count\n");
+        return 1;
+    }
+
+    mock::MockRuntime runtime;
+    runtime.xrGetInstancePropertiesHook = [](XrInstance instance, XrInstanceProperties* instanceProperties) {
+        strcpy_s(instanceProperties->runtimeName, "Mock Runtime");
+        instanceProperties->runtimeVersion = XR_MAKE_VERSION(1, 0, 0);
+        return XR_SUCCESS;
+    };
+    runtime.xrGetSystemHook = [](XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+        *systemId = FakeSystemId;
+        return XR_SUCCESS;
+    };
+    runtime.xrEnumerateEnvironmentBlendModesHook = [](XrInstance instance,
+                                                      XrSystemId systemId,
+                                                      XrViewConfigurationType viewConfigurationType,
+                                                      uint32_t environmentBlendModeCapacityInput,
+                                                      uint32_t* environmentBlendModeCountOutput,
+                                                      XrEnvironmentBlendMode* environmentBlendModes) {
+        *environmentBlendModeCountOutput = 1;
+        if (environmentBlendModeCapacityInput) {
+            environmentBlendModes[0] = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+        }
+        return XR_SUCCESS;
+    };
+    runtime.xrCreateSessionHook = [](XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+        *session = FakeSession;
+        return XR_SUCCESS;
+    };
+    XrTime displayTime = 0;
+    runtime.xrWaitFrameHook = [&](XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) {
+        displayTime += DisplayPeriod;
+        frameState->predictedDisplayTime = displayTime;
+        frameState->predictedDisplayPeriod = DisplayPeriod;
+        frameState->shouldRender = XR_TRUE;
+        return XR_SUCCESS;
+    };
+    uint32_t layerCountMismatches = 0;
+    runtime.xrEndFrameHook = [&](XrSession session, const XrFrameEndInfo* frameEndInfo) {
+        if (frameEndInfo->layerCount != 2) {
+            layerCountMismatches++;
+        }
+        return XR_SUCCESS;
+    };
+
+    // Load the layer the same way the loader does.
+    const HMODULE layerModule = LoadLibraryA(layerPath.c_str());
+    if (!layerModule) {
+        fprintf(stderr, "Failed to load %s\n", layerPath.c_str());
+        return 1;
+    }
+    const auto xrNegotiateLoaderApiLayerInterface = reinterpret_cast<PFN_xrNegotiateLoaderApiLayerInterface>(
+        GetProcAddress(layerModule, "xrNegotiateLoaderApiLayerInterface"));
+    if (!xrNegotiateLoaderApiLayerInterface) {
+        fprintf(stderr, "%s is not an API layer\n", layerPath.c_str());
+        return 1;
+    }
+
+    XrNegotiateLoaderInfo loaderInfo{};
+    loaderInfo.structType = XR_LOADER_INTERFACE_STRUCT_LOADER_INFO;
+    loaderInfo.structVersion = XR_LOADER_INFO_STRUCT_VERSION;
+    loaderInfo.structSize = sizeof(XrNegotiateLoaderInfo);
+    loaderInfo.minInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+    loaderInfo.maxInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+    loaderInfo.minApiVersion = XR_CURRENT_API_VERSION;
+    loaderInfo.maxApiVersion = XR_CURRENT_API_VERSION;
+
+    XrNegotiateApiLayerRequest apiLayerRequest{};
+    apiLayerRequest.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST;
+    apiLayerRequest.structVersion = XR_API_LAYER_INFO_STRUCT_VERSION;
+    apiLayerRequest.structSize = sizeof(XrNegotiateApiLayerRequest);
+    if (XR_FAILED(xrNegotiateLoaderApiLayerInterface(&loaderInfo, LayerName.c_str(), &apiLayerRequest))) {
+        fprintf(stderr, "Failed to negotiate with the layer\n");
+        return 1;
+    }
+
+    XrApiLayerNextInfo nextInfo{};
+    nextInfo.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_NEXT_INFO;
+    nextInfo.structVersion = XR_API_LAYER_NEXT_INFO_STRUCT_VERSION;
+    nextInfo.structSize = sizeof(XrApiLayerNextInfo);
+    strcpy_s(nextInfo.layerName, LayerName.c_str());
+    nextInfo.nextGetInstanceProcAddr = mock::MockRuntime::xrGetInstanceProcAddr;
+    nextInfo.nextCreateApiLayerInstance = FakeCreateApiLayerInstance;
+
+    XrApiLayerCreateInfo apiLayerInfo{};
+    apiLayerInfo.structType = XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO;
+    apiLayerInfo.structVersion = XR_API_LAYER_CREATE_INFO_STRUCT_VERSION;
+    apiLayerInfo.structSize = sizeof(XrApiLayerCreateInfo);
+    apiLayerInfo.nextInfo = &nextInfo;
+
+    XrInstanceCreateInfo instanceCreateInfo{XR_TYPE_INSTANCE_CREATE_INFO, nullptr};
+    strcpy_s(instanceCreateInfo.applicationInfo.applicationName, "LayerHarness");
+    instanceCreateInfo.applicationInfo.apiVersion = XR_CURRENT_API_VERSION;
+    XrInstance instance = XR_NULL_HANDLE;
+    if (XR_FAILED(apiLayerRequest.createApiLayerInstance(&instanceCreateInfo, &apiLayerInfo, &instance))) {
+        fprintf(stderr, "Failed to create the layer instance\n");
+        return 1;
+    }
+
+    const PFN_xrGetInstanceProcAddr layerGetInstanceProcAddr = apiLayerRequest.getInstanceProcAddr;
+    const auto xrGetSystem = resolve<PFN_xrGetSystem>(layerGetInstanceProcAddr, instance, "xrGetSystem");
+    const auto xrCreateSession = resolve<PFN_xrCreateSession>(layerGetInstanceProcAddr, instance, "xrCreateSession");
+    const auto xrDestroySession =
+        resolve<PFN_xrDestroySession>(layerGetInstanceProcAddr, instance, "xrDestroySession");
+    const auto xrDestroyInstance =
+        resolve<PFN_xrDestroyInstance>(layerGetInstanceProcAddr, instance, "xrDestroyInstance");
+
+    // A session without graphics bindings: the layer only forwards the frames.
+    XrSystemGetInfo systemInfo{XR_TYPE_SYSTEM_GET_INFO, nullptr};
+    systemInfo.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+    XrSystemId systemId = XR_NULL_SYSTEM_ID;
+    if (XR_FAILED(xrGetSystem(instance, &systemInfo, &systemId))) {
+        fprintf(stderr, "Failed to get the system\n");
+        return 1;
+    }
+    XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO, nullptr};
+    sessionCreateInfo.systemId = systemId;
+    XrSession session = XR_NULL_HANDLE;
+    if (XR_FAILED(xrCreateSession(instance, &sessionCreateInfo, &session))) {
+        fprintf(stderr, "Failed to create the session\n");
+        return 1;
+    }
+
+    // Warm up both paths before measuring.
+    const Dispatch layerDispatch(layerGetInstanceProcAddr, instance);
+    const Dispatch directDispatch(mock::MockRuntime::xrGetInstanceProcAddr, instance);
+    runFrames(layerDispatch, 100);
+    runFrames(directDispatch, 100);
+
+    runtime.ResetCounters();
+    const Timings layerTimings = runFrames(layerDispatch, frameCount);
+
+    bool success = expectCount(
+        "xrEnumerateEnvironmentBlendModes", runtime.xrEnumerateEnvironmentBlendModesCount, frameCount);
+    success = expectCount("xrWaitFrame", runtime.xrWaitFrameCount, frameCount) && success;
+    success = expectCount("xrBeginFrame", runtime.xrBeginFrameCount, frameCount) && success;
+    success = expectCount("xrEndFrame", runtime.xrEndFrameCount, frameCount) && success;
+    if (layerCountMismatches) {
+        fprintf(stderr, "%u frames were submitted with unexpected layers\n", layerCountMismatches);
+        success = false;
+    }
+
+    const Timings directTimings = runFrames(directDispatch, frameCount);
+
+    printf("%u frames\n", frameCount);
+    printf("%-34s %13s %13s %13s\n", "", "with layer", "direct", "overhead");
+    report("xrEnumerateEnvironmentBlendModes",
+           layerTimings.enumerateEnvironmentBlendModes,
+           directTimings.enumerateEnvironmentBlendModes,
+           frameCount);
+    report("xrWaitFrame", layerTimings.waitFrame, directTimings.waitFrame, frameCount);
+    report("xrBeginFrame", layerTimings.beginFrame, directTimings.beginFrame, frameCount);
+    report("xrEndFrame", layerTimings.endFrame, directTimings.endFrame, frameCount);
+
+    if (XR_FAILED(xrDestroySession(session)) || XR_FAILED(xrDestroyInstance(instance))) {
+        fprintf(stderr, "Failed to tear down the layer\n");
+        success = false;
+    }
+
+    return success ? 0 : 1;
+}
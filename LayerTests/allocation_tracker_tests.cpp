@@ -0,0 +1,166 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <allocation_tracker.h>
+
+#include "layer_test.h"
+
+#ifdef XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::test;
+
+    constexpr uint32_t FrameCount = 100;
+
+    // The allocation tracker counts the allocations of the whole process, so the frames submitted by the tests must not
+    // allocate either.
+    class AllocationTest : public LayerTest {
+      protected:
+        void SetUp() override {
+            LayerTest::SetUp();
+
+            xrCreateSwapchain = resolve<PFN_xrCreateSwapchain>("xrCreateSwapchain");
+            xrAcquireSwapchainImage = resolve<PFN_xrAcquireSwapchainImage>("xrAcquireSwapchainImage");
+            xrReleaseSwapchainImage = resolve<PFN_xrReleaseSwapchainImage>("xrReleaseSwapchainImage");
+
+            m_layers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer));
+        }
+
+        // Submit frames with the application's layers and a new camera image each, rendering into the application's
+        // swapchains if any.
+        void runFrames(uint64_t count) {
+            for (uint64_t i = 0; i < count; i++) {
+                for (const XrSwapchain swapchain : {m_colorSwapchain, m_depthSwapchain}) {
+                    if (swapchain == XR_NULL_HANDLE) {
+                        continue;
+                    }
+                    uint32_t index;
+                    ASSERT_EQ(xrAcquireSwapchainImage(swapchain, nullptr, &index), XR_SUCCESS);
+                    ASSERT_EQ(xrReleaseSwapchainImage(swapchain, nullptr), XR_SUCCESS);
+                }
+
+                m_camera.pushImage();
+                runFrame(XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND, m_layers.data(), (uint32_t)m_layers.size());
+            }
+        }
+
+        // Create a color and a depth swapchain, and submit them with the application's projection layer.
+        void createApplicationSwapchains() {
+            XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO, nullptr};
+            createInfo.sampleCount = 1;
+            createInfo.width = 2048;
+            createInfo.height = 2048;
+            createInfo.faceCount = 1;
+            createInfo.arraySize = ViewCount;
+            createInfo.mipCount = 1;
+            createInfo.format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+            ASSERT_EQ(xrCreateSwapchain(Session, &createInfo, &m_colorSwapchain), XR_SUCCESS);
+            createInfo.format = DXGI_FORMAT_D32_FLOAT;
+            ASSERT_EQ(xrCreateSwapchain(Session, &createInfo, &m_depthSwapchain), XR_SUCCESS);
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                XrCompositionLayerDepthInfoKHR& depthInfo = m_depthInfos[eye];
+                depthInfo = {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR, nullptr};
+                depthInfo.subImage.swapchain = m_depthSwapchain;
+                depthInfo.subImage.imageArrayIndex = eye;
+                depthInfo.subImage.imageRect.extent = {2048, 2048};
+                depthInfo.minDepth = 0.f;
+                depthInfo.maxDepth = 1.f;
+                depthInfo.nearZ = 0.1f;
+                depthInfo.farZ = 100.f;
+
+                m_applicationViews[eye].next = &depthInfo;
+                m_applicationViews[eye].subImage.swapchain = m_colorSwapchain;
+                m_applicationViews[eye].subImage.imageArrayIndex = eye;
+            }
+        }
+
+        std::vector<const XrCompositionLayerBaseHeader*> m_layers;
+        XrSwapchain m_colorSwapchain{XR_NULL_HANDLE};
+        XrSwapchain m_depthSwapchain{XR_NULL_HANDLE};
+        XrCompositionLayerDepthInfoKHR m_depthInfos[ViewCount];
+
+        PFN_xrCreateSwapchain xrCreateSwapchain{nullptr};
+        PFN_xrAcquireSwapchainImage xrAcquireSwapchainImage{nullptr};
+        PFN_xrReleaseSwapchainImage xrReleaseSwapchainImage{nullptr};
+    };
+
+    TEST_F(AllocationTest, SteadyStateFramesDoNotAllocate) {
+        warmUp();
+        runFrames(allocation::WarmupFrames);
+
+        const uint64_t allocationCount = allocation::GetSteadyStateAllocationCount();
+        runFrames(FrameCount);
+
+        EXPECT_EQ(allocation::GetSteadyStateAllocationCount(), allocationCount);
+    }
+
+    TEST_F(AllocationTest, SteadyStateLayerCopiesDoNotAllocate) {
+        // The layers of known types are copied to change their flags, the others are passed through.
+        XrCompositionLayerQuad quad{XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr};
+        XrCompositionLayerCylinderKHR cylinder{XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR, nullptr};
+        XrCompositionLayerCubeKHR cube{XR_TYPE_COMPOSITION_LAYER_CUBE_KHR, nullptr};
+        XrCompositionLayerEquirectKHR equirect{XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR, nullptr};
+        XrCompositionLayerEquirect2KHR equirect2{XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR, nullptr};
+        XrCompositionLayerBaseHeader unknownLayer{static_cast<XrStructureType>(1000999000), nullptr};
+        for (const void* layer : {(const void*)&quad, (const void*)&cylinder, (const void*)&cube,
+                                  (const void*)&equirect, (const void*)&equirect2, (const void*)&unknownLayer}) {
+            m_layers.push_back(reinterpret_cast<const XrCompositionLayerBaseHeader*>(layer));
+        }
+
+        warmUp();
+        runFrames(allocation::WarmupFrames);
+
+        const uint64_t allocationCount = allocation::GetSteadyStateAllocationCount();
+        runFrames(FrameCount);
+
+        EXPECT_EQ(allocation::GetSteadyStateAllocationCount(), allocationCount);
+        ASSERT_EQ(m_submittedFrame.layerCount, 1 + m_layers.size());
+        for (uint32_t i = 1; i < m_submittedFrame.layerCount - 1; i++) {
+            EXPECT_EQ(m_submittedFrame.layerFlags[i], XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT);
+        }
+    }
+
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+    TEST_F(AllocationTest, SteadyStateDepthCompositionDoesNotAllocate) {
+        m_backend->supportsDepthComposition = true;
+        warmUp();
+        createApplicationSwapchains();
+        runFrames(allocation::WarmupFrames);
+
+        // The swapchain tracker is used for every view of every frame.
+        resetCounters();
+        const uint64_t allocationCount = allocation::GetSteadyStateAllocationCount();
+        runFrames(FrameCount);
+
+        EXPECT_EQ(allocation::GetSteadyStateAllocationCount(), allocationCount);
+        EXPECT_EQ(m_backend->calls.compositePassthroughLayer, FrameCount);
+    }
+#endif
+
+} // namespace
+
+#endif
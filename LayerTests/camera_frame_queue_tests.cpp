@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <camera_frame_queue.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    constexpr XrDuration Millisecond = 1000000;
+
+    // Each image is filled with its value, to tell them apart.
+    void push(CameraFrameQueue& queue, uint8_t value, XrTime receptionTime) {
+        uint8_t* const image = queue.beginPush(4, 2);
+        std::fill_n(image, 4 * 2, value);
+        queue.commitPush(receptionTime);
+    }
+
+    TEST(CameraFrameQueueTest, SelectsNothingWhenEmpty) {
+        CameraFrameQueue queue;
+        EXPECT_EQ(queue.select(100 * Millisecond), nullptr);
+
+        push(queue, 1, 10 * Millisecond);
+        ASSERT_NE(queue.select(100 * Millisecond), nullptr);
+
+        // An image is only shown once.
+        EXPECT_EQ(queue.select(110 * Millisecond), nullptr);
+    }
+
+    TEST(CameraFrameQueueTest, KeepsImageAndSize) {
+        CameraFrameQueue queue;
+        push(queue, 7, 10 * Millisecond);
+
+        const CameraFrameQueue::Frame* frame = queue.select(100 * Millisecond);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->width, 4u);
+        EXPECT_EQ(frame->height, 2u);
+        EXPECT_EQ(frame->image, std::vector<uint8_t>(8, 7));
+        EXPECT_EQ(frame->receptionTime, 10 * Millisecond);
+    }
+
+    TEST(CameraFrameQueueTest, SelectsNewest) {
+        CameraFrameQueue queue;
+        push(queue, 1, 10 * Millisecond);
+        push(queue, 2, 43 * Millisecond);
+        push(queue, 3, 76 * Millisecond);
+
+        // Even for a display time in the past.
+        const CameraFrameQueue::Frame* frame = queue.select(45 * Millisecond);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->image[0], 3);
+
+        // The older images are dropped.
+        EXPECT_EQ(queue.getStatistics().staleDropCount, 2u);
+        EXPECT_EQ(queue.select(80 * Millisecond), nullptr);
+    }
+
+    TEST(CameraFrameQueueTest, SelectsNewestWithoutTimes) {
+        CameraFrameQueue queue;
+        push(queue, 1, 0);
+        push(queue, 2, 0);
+
+        const CameraFrameQueue::Frame* frame = queue.select(100 * Millisecond);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->image[0], 2);
+
+        // Unknown display time.
+        push(queue, 3, 10 * Millisecond);
+        frame = queue.select(0);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->image[0], 3);
+        EXPECT_EQ(queue.getStatistics().timedSelectCount, 0u);
+    }
+
+    TEST(CameraFrameQueueTest, OverwritesOldestWhenFull) {
+        CameraFrameQueue queue(2);
+        push(queue, 1, 10 * Millisecond);
+        push(queue, 2, 43 * Millisecond);
+        push(queue, 3, 76 * Millisecond);
+        EXPECT_EQ(queue.getStatistics().staleDropCount, 1u);
+
+        const CameraFrameQueue::Frame* frame = queue.select(80 * Millisecond);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame->image[0], 3);
+        EXPECT_EQ(queue.getStatistics().staleDropCount, 2u);
+    }
+
+    TEST(CameraFrameQueueTest, KeepsShownImageWhileWritingNext) {
+        CameraFrameQueue queue(2);
+        push(queue, 1, 10 * Millisecond);
+        const CameraFrameQueue::Frame* shown = queue.select(20 * Millisecond);
+        ASSERT_NE(shown, nullptr);
+
+        // A rejected image is never committed.
+        std::fill_n(queue.beginPush(4, 2), 4 * 2, 2);
+        EXPECT_EQ(shown->image[0], 1);
+        EXPECT_EQ(queue.select(30 * Millisecond), nullptr);
+    }
+
+    TEST(CameraFrameQueueTest, CountsAgeAtDisplayTime) {
+        CameraFrameQueue queue;
+        push(queue, 1, 10 * Millisecond);
+        queue.select(40 * Millisecond);
+        push(queue, 2, 50 * Millisecond);
+        queue.select(60 * Millisecond);
+
+        const CameraFrameQueueStatistics& statistics = queue.getStatistics();
+        EXPECT_EQ(statistics.pushCount, 2u);
+        EXPECT_EQ(statistics.selectCount, 2u);
+        EXPECT_EQ(statistics.timedSelectCount, 2u);
+        EXPECT_EQ(statistics.timedSelectAgeSum, 40 * Millisecond);
+    }
+
+    TEST(CameraFrameQueueTest, ClearDropsPendingImages) {
+        CameraFrameQueue queue;
+        push(queue, 1, 10 * Millisecond);
+        queue.clear();
+
+        EXPECT_EQ(queue.select(10 * Millisecond), nullptr);
+    }
+
+} // namespace
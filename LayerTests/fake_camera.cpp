@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "fake_camera.h"
+
+namespace passthrough::test {
+
+    class FakeCamera::Client : public ICameraClientWrapper {
+      public:
+        Client(FakeCamera& camera) : m_camera(camera) {
+        }
+
+        bool AcquireNextFrame(core::CameraFrame& frame) override {
+            return m_camera.acquireImage(frame);
+        }
+
+        void ReleaseFrame() override {
+        }
+
+        bool WaitForNextFrame(core::CameraFrame& frame, std::chrono::microseconds timeout) override {
+            return m_camera.waitForImage(frame, timeout);
+        }
+
+      private:
+        FakeCamera& m_camera;
+    };
+
+    FakeCamera::FakeCamera() {
+        // The camera images carry a 32 bytes tag every 23264 + 1312 - 32 bytes, see copyCameraImage() in layer.cpp.
+        const size_t size = (size_t)Width * Height;
+        m_image.resize(size + 32 * (size / (23264 + 1312 - 32) + 1), 128);
+    }
+
+    void FakeCamera::pushImage() {
+        {
+            std::unique_lock lock(m_mutex);
+            m_hasImage = true;
+        }
+        m_imagePushed.notify_all();
+    }
+
+    std::unique_ptr<ICameraClientWrapper> FakeCamera::createClient() {
+        return std::make_unique<Client>(*this);
+    }
+
+    uint32_t FakeCamera::getAcquiredImageCount() const {
+        std::unique_lock lock(m_mutex);
+        return m_acquiredImageCount;
+    }
+
+    bool FakeCamera::acquireImage(core::CameraFrame& frame) {
+        return waitForImage(frame, 0us);
+    }
+
+    bool FakeCamera::waitForImage(core::CameraFrame& frame, std::chrono::microseconds timeout) {
+        std::unique_lock lock(m_mutex);
+        if (!m_imagePushed.wait_for(lock, timeout, [this] { return m_hasImage; })) {
+            return false;
+        }
+
+        m_hasImage = false;
+        m_acquiredImageCount++;
+        frame.Width = Width;
+        frame.Height = Height;
+        frame.CameraImage = m_image.data();
+
+        return true;
+    }
+
+} // namespace passthrough::test
@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace passthrough::test {
+
+    // A camera server delivering the images pushed by the test to the camera clients of the layer. The images are a
+    // uniform gray, with the size and the tags of the headset's camera images.
+    class FakeCamera {
+      public:
+        static constexpr uint32_t Width = 2 * 640;
+        static constexpr uint32_t Height = 480;
+
+        FakeCamera();
+
+        // Make a new image available to the clients. The images that were not acquired yet are dropped.
+        void pushImage();
+
+        std::unique_ptr<ICameraClientWrapper> createClient();
+
+        // The number of images acquired by the clients.
+        uint32_t getAcquiredImageCount() const;
+
+      private:
+        class Client;
+
+        bool acquireImage(core::CameraFrame& frame);
+        bool waitForImage(core::CameraFrame& frame, std::chrono::microseconds timeout);
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_imagePushed;
+        bool m_hasImage{false};
+        uint32_t m_acquiredImageCount{0};
+        std::vector<uint8_t> m_image;
+    };
+
+} // namespace passthrough::test
@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <ingest_scheduler.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    using Clock = IngestScheduler::Clock;
+
+    // The application renders at 90 Hz: xrWaitFrame() returns at the start of the period, the frame is submitted 8 ms
+    // later.
+    constexpr XrDuration DisplayPeriod = 11000000;
+    constexpr auto Period = std::chrono::nanoseconds(DisplayPeriod);
+    constexpr auto WaitToBeginFrame = 1ms;
+    constexpr auto WaitToEndFrame = 8ms;
+
+    // The default and minimum times from the scheduler.
+    constexpr auto DefaultIngestDuration = 4ms;
+    constexpr auto MinimumMargin = 1ms;
+
+    class IngestSchedulerTest : public ::testing::Test {
+      protected:
+        // An epoch of 0 means "not set" to the scheduler.
+        Clock::time_point m_now{Clock::time_point(1s)};
+        IngestScheduler m_scheduler;
+
+        // Runs one frame of the application followed by the start of the next ingest, and returns the submission time.
+        Clock::time_point runFrame(Clock::duration endFrameDelay = {}) {
+            const Clock::time_point waitFrame = m_now;
+            m_scheduler.onWaitFrame(waitFrame, DisplayPeriod);
+            m_scheduler.onBeginFrame(waitFrame + WaitToBeginFrame);
+            const Clock::time_point endFrame = waitFrame + WaitToEndFrame + endFrameDelay;
+            m_scheduler.onEndFrame(endFrame);
+            m_scheduler.onIngestStart(endFrame);
+            m_now = waitFrame + Period;
+            return endFrame;
+        }
+    };
+
+    TEST_F(IngestSchedulerTest, FirstIngestUsesDefaultDuration) {
+        m_scheduler.onIngestStart(m_now);
+
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + DefaultIngestDuration);
+    }
+
+    TEST_F(IngestSchedulerTest, FollowsApplicationCadence) {
+        runFrame();
+        const Clock::time_point endFrame = runFrame();
+
+        // Before xrWaitFrame(), the next submission is predicted one frame interval later.
+        EXPECT_EQ(m_scheduler.getDeadline(), endFrame + Period - MinimumMargin);
+
+        // Then from the application's frame time.
+        m_scheduler.onWaitFrame(m_now, DisplayPeriod);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + WaitToEndFrame - MinimumMargin);
+        m_scheduler.onBeginFrame(m_now + WaitToBeginFrame);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + WaitToEndFrame - MinimumMargin);
+    }
+
+    TEST_F(IngestSchedulerTest, EndFrameStopsIngest) {
+        runFrame();
+        m_scheduler.onWaitFrame(m_now, DisplayPeriod);
+        ASSERT_GT(m_scheduler.getDeadline(), m_now);
+
+        // The application submitted early.
+        m_scheduler.onEndFrame(m_now + 2ms);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + 2ms);
+
+        m_scheduler.onIngestStart(m_now + 2ms);
+        m_scheduler.stopIngest(m_now + 3ms);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + 3ms);
+    }
+
+    TEST_F(IngestSchedulerTest, KeepsPredictionMadeBeforeIngestStart) {
+        runFrame();
+        runFrame();
+        m_scheduler.onWaitFrame(m_now, DisplayPeriod);
+        m_scheduler.onBeginFrame(m_now + WaitToBeginFrame);
+        const Clock::time_point endFrame = m_now + WaitToEndFrame;
+        m_scheduler.onEndFrame(endFrame);
+
+        // The application waits for the next frame on another thread, before the ingest starts.
+        const Clock::time_point waitFrame = endFrame + 1ms;
+        m_scheduler.onWaitFrame(waitFrame, DisplayPeriod);
+        EXPECT_EQ(m_scheduler.getDeadline(), endFrame);
+        m_scheduler.onIngestStart(waitFrame + 1ms);
+
+        // The cadence would predict endFrame + Period instead.
+        EXPECT_EQ(m_scheduler.getDeadline(), waitFrame + WaitToEndFrame - MinimumMargin);
+    }
+
+    TEST_F(IngestSchedulerTest, StoppedIngestIsNotExtended) {
+        runFrame();
+        runFrame();
+
+        // The frame thread stops the ingest while another thread waits for the next frame.
+        m_scheduler.stopIngest(m_now);
+        m_scheduler.onWaitFrame(m_now + 1ms, DisplayPeriod);
+        m_scheduler.onBeginFrame(m_now + 1ms + WaitToBeginFrame);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now);
+
+        m_scheduler.onIngestStart(m_now + 2ms);
+        EXPECT_EQ(m_scheduler.getDeadline(), m_now + 1ms + WaitToEndFrame - MinimumMargin);
+    }
+
+    TEST_F(IngestSchedulerTest, MarginGrowsWithPredictionError) {
+        runFrame();
+        runFrame();
+
+        // Submitted 2 ms later than predicted.
+        runFrame(2ms);
+        m_scheduler.onWaitFrame(m_now, DisplayPeriod);
+
+        // The frame time and the error are smoothed, and twice the error is kept on top of the minimum margin.
+        const auto smoothedError = 200us;
+        const Clock::time_point expected = m_now + WaitToEndFrame + smoothedError - (MinimumMargin + 2 * smoothedError);
+        EXPECT_NEAR(m_scheduler.getDeadline().time_since_epoch().count(), expected.time_since_epoch().count(), 1);
+    }
+
+    TEST_F(IngestSchedulerTest, IgnoresPauses) {
+        runFrame();
+        runFrame();
+
+        // A loading screen.
+        m_now += 1s;
+        const Clock::time_point endFrame = runFrame();
+
+        EXPECT_EQ(m_scheduler.getDeadline(), endFrame + Period - MinimumMargin);
+    }
+
+    TEST_F(IngestSchedulerTest, CountsMissedDeadlines) {
+        Clock::time_point endFrame = runFrame();
+        m_scheduler.onIngestFinished(endFrame + 3ms);
+        endFrame = runFrame();
+        m_scheduler.onIngestFinished(endFrame - 1ms);
+
+        const IngestSchedulerStatistics statistics = m_scheduler.getStatistics();
+        EXPECT_EQ(statistics.frameCount, 2u);
+        EXPECT_EQ(statistics.frameTimeSum, 2 * (WaitToEndFrame - WaitToBeginFrame));
+        EXPECT_EQ(statistics.displayPeriod, DisplayPeriod);
+        EXPECT_EQ(statistics.missedDeadlineCount, 1u);
+        EXPECT_EQ(statistics.missedDeadlineTime, 3ms);
+        EXPECT_EQ(statistics.onTimeCount, 1u);
+        EXPECT_EQ(statistics.slackSum, 1ms);
+    }
+
+} // namespace
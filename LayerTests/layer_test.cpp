@@ -0,0 +1,233 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <openxr_layer.h>
+
+#include "layer_test.h"
+#include "mock_openxr.h"
+
+namespace passthrough::test {
+
+    void LayerTest::SetUp() {
+        m_runtime.xrGetSystemHook = [](XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId) {
+            *systemId = SystemId;
+            return XR_SUCCESS;
+        };
+        m_runtime.xrCreateSessionHook = [](XrInstance instance,
+                                           const XrSessionCreateInfo* createInfo,
+                                           XrSession* session) {
+            *session = Session;
+            return XR_SUCCESS;
+        };
+        m_runtime.xrPollEventHook = [](XrInstance instance, XrEventDataBuffer* eventData) {
+            // The application's session is always focused.
+            XrEventDataSessionStateChanged* stateChanged = reinterpret_cast<XrEventDataSessionStateChanged*>(eventData);
+            *stateChanged = {XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED, nullptr};
+            stateChanged->session = Session;
+            stateChanged->state = XR_SESSION_STATE_FOCUSED;
+            return XR_SUCCESS;
+        };
+        m_runtime.xrEnumerateSwapchainFormatsHook =
+            [](XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats) {
+                *formatCountOutput = 1;
+                if (formatCapacityInput) {
+                    formats[0] = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+                }
+                return XR_SUCCESS;
+            };
+        m_runtime.xrEnumerateViewConfigurationViewsHook = [](XrInstance instance,
+                                                             XrSystemId systemId,
+                                                             XrViewConfigurationType viewConfigurationType,
+                                                             uint32_t viewCapacityInput,
+                                                             uint32_t* viewCountOutput,
+                                                             XrViewConfigurationView* views) {
+            *viewCountOutput = ViewCount;
+            for (uint32_t i = 0; i < viewCapacityInput && i < ViewCount; i++) {
+                views[i].recommendedImageRectWidth = 2048;
+                views[i].recommendedImageRectHeight = 2048;
+            }
+            return XR_SUCCESS;
+        };
+        m_runtime.xrLocateViewsHook = [](XrSession session,
+                                         const XrViewLocateInfo* viewLocateInfo,
+                                         XrViewState* viewState,
+                                         uint32_t viewCapacityInput,
+                                         uint32_t* viewCountOutput,
+                                         XrView* views) {
+            viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT;
+            *viewCountOutput = ViewCount;
+            for (uint32_t i = 0; i < viewCapacityInput && i < ViewCount; i++) {
+                views[i].pose = xr::math::Pose::Identity();
+                views[i].fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+            }
+            return XR_SUCCESS;
+        };
+        m_runtime.xrCreateSwapchainHook =
+            [this](XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) {
+                *swapchain = m_nextSwapchain;
+                m_nextSwapchain = reinterpret_cast<XrSwapchain>(reinterpret_cast<uintptr_t>(m_nextSwapchain) + 1);
+                if (m_passthroughSwapchain == XR_NULL_HANDLE) {
+                    m_passthroughSwapchain = *swapchain;
+                }
+                return XR_SUCCESS;
+            };
+        m_runtime.xrAcquireSwapchainImageHook =
+            [](XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index) {
+                *index = 0;
+                return XR_SUCCESS;
+            };
+        m_runtime.xrWaitFrameHook =
+            [this](XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) {
+                m_displayTime += DisplayPeriod;
+                frameState->predictedDisplayTime = m_displayTime;
+                frameState->predictedDisplayPeriod = DisplayPeriod;
+                frameState->shouldRender = XR_TRUE;
+                return XR_SUCCESS;
+            };
+        m_runtime.xrEndFrameHook = [this](XrSession session, const XrFrameEndInfo* frameEndInfo) {
+            SubmittedFrame& frame = m_submittedFrame;
+            frame.environmentBlendMode = frameEndInfo->environmentBlendMode;
+            frame.layerCount = std::min(frameEndInfo->layerCount, (uint32_t)std::size(frame.layers));
+            frame.hasPassthroughLayer = false;
+            for (uint32_t i = 0; i < frame.layerCount; i++) {
+                const XrCompositionLayerBaseHeader* layer = frameEndInfo->layers[i];
+                frame.layers[i] = layer;
+                frame.layerFlags[i] = layer->layerFlags;
+
+                // The camera layer is only valid until the frame is submitted.
+                const XrCompositionLayerProjection* projection =
+                    reinterpret_cast<const XrCompositionLayerProjection*>(layer);
+                if (layer->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION && projection->viewCount == ViewCount &&
+                    projection->views[0].subImage.swapchain == m_passthroughSwapchain) {
+                    frame.hasPassthroughLayer = true;
+                    frame.passthroughLayer = *projection;
+                    for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                        frame.passthroughLayerViews[eye] = projection->views[eye];
+                    }
+                    frame.passthroughLayer.views = frame.passthroughLayerViews;
+                }
+            }
+            return XR_SUCCESS;
+        };
+
+        m_layer = CreateOpenXrLayer(
+            [this](const XrSessionCreateInfo& createInfo) {
+                auto backend = std::make_unique<NullGraphicsBackend>();
+                m_backend = backend.get();
+                return backend;
+            },
+            [this] { return m_camera.createClient(); });
+        SetLayerInstance(m_layer.get());
+
+        XrInstanceCreateInfo instanceCreateInfo{XR_TYPE_INSTANCE_CREATE_INFO, nullptr};
+        instanceCreateInfo.enabledExtensionCount = (uint32_t)m_enabledExtensions.size();
+        instanceCreateInfo.enabledExtensionNames = m_enabledExtensions.data();
+        m_layer->SetGetInstanceProcAddr(mock::MockRuntime::xrGetInstanceProcAddr, Instance);
+        ASSERT_EQ(m_layer->xrCreateInstance(&instanceCreateInfo), XR_SUCCESS);
+
+        xrPollEvent = resolve<PFN_xrPollEvent>("xrPollEvent");
+        xrWaitFrame = resolve<PFN_xrWaitFrame>("xrWaitFrame");
+        xrBeginFrame = resolve<PFN_xrBeginFrame>("xrBeginFrame");
+        xrEndFrame = resolve<PFN_xrEndFrame>("xrEndFrame");
+        xrDestroySession = resolve<PFN_xrDestroySession>("xrDestroySession");
+
+        XrSystemGetInfo systemInfo{XR_TYPE_SYSTEM_GET_INFO, nullptr};
+        systemInfo.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+        XrSystemId systemId;
+        ASSERT_EQ(resolve<PFN_xrGetSystem>("xrGetSystem")(Instance, &systemInfo, &systemId), XR_SUCCESS);
+
+        // The graphics binding is ignored, the layer always draws with the NullGraphicsBackend.
+        XrSessionCreateInfo sessionCreateInfo{XR_TYPE_SESSION_CREATE_INFO, nullptr};
+        sessionCreateInfo.systemId = systemId;
+        XrSession session;
+        ASSERT_EQ(resolve<PFN_xrCreateSession>("xrCreateSession")(Instance, &sessionCreateInfo, &session), XR_SUCCESS);
+        ASSERT_NE(m_backend, nullptr);
+
+        XrEventDataBuffer event{XR_TYPE_EVENT_DATA_BUFFER, nullptr};
+        ASSERT_EQ(xrPollEvent(Instance, &event), XR_SUCCESS);
+
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            XrCompositionLayerProjectionView& view = m_applicationViews[eye];
+            view = {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW, nullptr};
+            view.pose = xr::math::Pose::Identity();
+            view.fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+            view.subImage.swapchain = ApplicationColorSwapchain;
+            view.subImage.imageRect.extent = {2048, 2048};
+        }
+        m_applicationLayer.space = ApplicationSpace;
+        m_applicationLayer.viewCount = ViewCount;
+        m_applicationLayer.views = m_applicationViews;
+    }
+
+    void LayerTest::TearDown() {
+        if (m_layer && xrDestroySession) {
+            EXPECT_EQ(xrDestroySession(Session), XR_SUCCESS);
+        }
+        m_layer.reset();
+        SetLayerInstance(nullptr);
+    }
+
+    void LayerTest::runFrame(XrEnvironmentBlendMode environmentBlendMode) {
+        const XrCompositionLayerBaseHeader* layers[] = {
+            reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer)};
+        runFrame(environmentBlendMode, layers, (uint32_t)std::size(layers));
+    }
+
+    void LayerTest::runFrame(XrEnvironmentBlendMode environmentBlendMode,
+                             const XrCompositionLayerBaseHeader* const* layers,
+                             uint32_t layerCount) {
+        XrFrameState frameState{XR_TYPE_FRAME_STATE, nullptr};
+        ASSERT_EQ(xrWaitFrame(Session, nullptr, &frameState), XR_SUCCESS);
+        ASSERT_EQ(xrBeginFrame(Session, nullptr), XR_SUCCESS);
+
+        XrFrameEndInfo frameEndInfo{XR_TYPE_FRAME_END_INFO, nullptr};
+        frameEndInfo.displayTime = frameState.predictedDisplayTime;
+        frameEndInfo.environmentBlendMode = environmentBlendMode;
+        frameEndInfo.layerCount = layerCount;
+        frameEndInfo.layers = layers;
+        ASSERT_EQ(xrEndFrame(Session, &frameEndInfo), XR_SUCCESS);
+    }
+
+    void LayerTest::warmUp() {
+        // The shaders, the mesh and the camera client are prepared on background threads.
+        const auto deadline = std::chrono::steady_clock::now() + 10s;
+        do {
+            m_camera.pushImage();
+            runFrame();
+            if (m_submittedFrame.hasPassthroughLayer) {
+                break;
+            }
+            std::this_thread::sleep_for(1ms);
+        } while (std::chrono::steady_clock::now() < deadline);
+        ASSERT_TRUE(m_submittedFrame.hasPassthroughLayer);
+
+        resetCounters();
+    }
+
+    void LayerTest::resetCounters() {
+        m_backend->calls = {};
+        m_runtime.ResetCounters();
+    }
+
+} // namespace passthrough::test
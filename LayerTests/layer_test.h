@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <graphics_backend.h>
+
+#include <framework/mock_runtime.gen.h>
+
+#include "fake_camera.h"
+#include "null_graphics_backend.h"
+
+namespace passthrough::test {
+
+    // The layer on top of a MockRuntime, with a focused session drawing through a NullGraphicsBackend and the images of
+    // a FakeCamera. The application's side goes through the functions resolved from the layer, like with the loader.
+    class LayerTest : public ::testing::Test {
+      protected:
+        // What the layer submitted to the runtime with the latest frame.
+        struct SubmittedFrame {
+            XrEnvironmentBlendMode environmentBlendMode;
+            uint32_t layerCount;
+            const XrCompositionLayerBaseHeader* layers[8];
+            XrCompositionLayerFlags layerFlags[8];
+
+            // A copy of the camera layer drawn by the layer, if any.
+            bool hasPassthroughLayer;
+            XrCompositionLayerProjection passthroughLayer;
+            XrCompositionLayerProjectionView passthroughLayerViews[ViewCount];
+        };
+
+        void SetUp() override;
+        void TearDown() override;
+
+        // Submit a frame with the application's projection layer, and the given blend mode.
+        void runFrame(XrEnvironmentBlendMode environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND);
+
+        // Submit a frame with the given layers.
+        void runFrame(XrEnvironmentBlendMode environmentBlendMode,
+                      const XrCompositionLayerBaseHeader* const* layers,
+                      uint32_t layerCount);
+
+        // Submit frames showing passthrough, with a new camera image each, until the warm-up completed and the camera
+        // layer is drawn. The counters of the backend and the runtime are reset afterwards.
+        void warmUp();
+
+        void resetCounters();
+
+        template <typename T>
+        T resolve(const char* name) {
+            PFN_xrVoidFunction function = nullptr;
+            EXPECT_EQ(m_layer->xrGetInstanceProcAddr(Instance, name, &function), XR_SUCCESS);
+            return reinterpret_cast<T>(function);
+        }
+
+        static inline const XrInstance Instance = reinterpret_cast<XrInstance>(1);
+        static inline const XrSystemId SystemId = 2;
+        static inline const XrSession Session = reinterpret_cast<XrSession>(3);
+        static inline const XrSpace ApplicationSpace = reinterpret_cast<XrSpace>(4);
+        static inline const XrSwapchain ApplicationColorSwapchain = reinterpret_cast<XrSwapchain>(5);
+        static constexpr XrDuration DisplayPeriod = 11'111'111;
+
+        // The extensions enabled by the application, set before SetUp().
+        std::vector<const char*> m_enabledExtensions{XR_FB_PASSTHROUGH_EXTENSION_NAME};
+
+        // Declared first, so that the layer is destroyed before.
+        mock::MockRuntime m_runtime;
+        FakeCamera m_camera;
+        std::unique_ptr<OpenXrApi> m_layer;
+
+        // Owned by the layer, until the session is destroyed.
+        NullGraphicsBackend* m_backend{nullptr};
+
+        XrTime m_displayTime{0};
+        XrSwapchain m_nextSwapchain{reinterpret_cast<XrSwapchain>(0x100)};
+        XrSwapchain m_passthroughSwapchain{XR_NULL_HANDLE};
+        SubmittedFrame m_submittedFrame{};
+
+        // The projection layer submitted by the application.
+        XrCompositionLayerProjectionView m_applicationViews[ViewCount];
+        XrCompositionLayerProjection m_applicationLayer{XR_TYPE_COMPOSITION_LAYER_PROJECTION, nullptr};
+
+        PFN_xrPollEvent xrPollEvent{nullptr};
+        PFN_xrWaitFrame xrWaitFrame{nullptr};
+        PFN_xrBeginFrame xrBeginFrame{nullptr};
+        PFN_xrEndFrame xrEndFrame{nullptr};
+        PFN_xrDestroySession xrDestroySession{nullptr};
+    };
+
+} // namespace passthrough::test
@@ -0,0 +1,189 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "layer_test.h"
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::test;
+
+    constexpr uint32_t FrameCount = 10;
+
+    TEST_F(LayerTest, DrawsOncePerFrameWithNewCameraImage) {
+        warmUp();
+
+        for (uint32_t i = 0; i < FrameCount; i++) {
+            m_camera.pushImage();
+            runFrame();
+        }
+
+        // Everything else was created during the warm-up.
+        EXPECT_EQ(m_backend->calls.importSwapchainImages, 0u);
+        EXPECT_EQ(m_backend->calls.createDrawingResources, 0u);
+        EXPECT_EQ(m_backend->calls.setOpacity, 0u);
+        EXPECT_EQ(m_backend->calls.mapCameraTexture, FrameCount);
+        EXPECT_EQ(m_backend->calls.unmapCameraTexture, FrameCount);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, FrameCount);
+        EXPECT_EQ(m_backend->calls.compositePassthroughLayer, 0u);
+
+        EXPECT_EQ(m_runtime.xrAcquireSwapchainImageCount, FrameCount);
+        EXPECT_EQ(m_runtime.xrWaitSwapchainImageCount, FrameCount);
+        EXPECT_EQ(m_runtime.xrReleaseSwapchainImageCount, FrameCount);
+        EXPECT_EQ(m_runtime.xrEndFrameCount, FrameCount);
+
+        // The views are taken from the application's layer.
+        EXPECT_EQ(m_runtime.xrLocateViewsCount, 0u);
+    }
+
+    TEST_F(LayerTest, SubmitsCameraLayerUnderneathApplicationLayers) {
+        warmUp();
+
+        m_camera.pushImage();
+        runFrame();
+
+        const SubmittedFrame& frame = m_submittedFrame;
+        EXPECT_EQ(frame.environmentBlendMode, XR_ENVIRONMENT_BLEND_MODE_OPAQUE);
+        ASSERT_EQ(frame.layerCount, 2u);
+        ASSERT_TRUE(frame.hasPassthroughLayer);
+        EXPECT_EQ(frame.layers[0]->type, XR_TYPE_COMPOSITION_LAYER_PROJECTION);
+        EXPECT_EQ(frame.passthroughLayer.space, ApplicationSpace);
+        EXPECT_EQ(frame.passthroughLayer.layerFlags, 0u);
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            EXPECT_EQ(frame.passthroughLayerViews[eye].subImage.imageArrayIndex, eye);
+        }
+
+        // The application's layer is blended, without modifying its structure.
+        EXPECT_NE(frame.layers[1], reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer));
+        EXPECT_EQ(frame.layerFlags[1], XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT);
+        EXPECT_EQ(m_applicationLayer.layerFlags, 0u);
+    }
+
+    TEST_F(LayerTest, PassesUnknownLayerTypesThrough) {
+        warmUp();
+
+        // A layer from an extension the layer does not know the structure of.
+        XrCompositionLayerBaseHeader unknownLayer{static_cast<XrStructureType>(1000999000), nullptr};
+        const XrCompositionLayerBaseHeader* layers[] = {
+            reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer), &unknownLayer};
+        m_camera.pushImage();
+        runFrame(XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND, layers, (uint32_t)std::size(layers));
+
+        ASSERT_EQ(m_submittedFrame.layerCount, 3u);
+        EXPECT_TRUE(m_submittedFrame.hasPassthroughLayer);
+        EXPECT_EQ(m_submittedFrame.layerFlags[1], XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT);
+        EXPECT_EQ(m_submittedFrame.layers[2], &unknownLayer);
+        EXPECT_EQ(m_submittedFrame.layerFlags[2], 0u);
+        EXPECT_EQ(unknownLayer.layerFlags, 0u);
+    }
+
+#ifndef XR_WMR_PASSTHROUGH_CAMERA_RATE_RENDERING
+    TEST_F(LayerTest, RedrawsWithoutNewCameraImage) {
+        warmUp();
+
+        for (uint32_t i = 0; i < FrameCount; i++) {
+            runFrame();
+        }
+
+        EXPECT_EQ(m_backend->calls.mapCameraTexture, 0u);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, FrameCount);
+        EXPECT_TRUE(m_submittedFrame.hasPassthroughLayer);
+    }
+#else
+    // The application's views are moved along X between frames, so that the submitted views tell which frame the camera
+    // layer was drawn for.
+    class CameraRateLayerTest : public LayerTest {
+      protected:
+        void runFrameAt(float headPosition) {
+            for (XrCompositionLayerProjectionView& view : m_applicationViews) {
+                view.pose.position.x = headPosition;
+            }
+            runFrame();
+        }
+
+        float getSubmittedHeadPosition() const {
+            EXPECT_EQ(m_submittedFrame.passthroughLayerViews[0].pose.position.x,
+                      m_submittedFrame.passthroughLayerViews[1].pose.position.x);
+            return m_submittedFrame.passthroughLayerViews[0].pose.position.x;
+        }
+    };
+
+    TEST_F(CameraRateLayerTest, ResubmitsLayerDrawnForLatestCameraImage) {
+        warmUp();
+
+        m_camera.pushImage();
+        runFrameAt(1.f);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, 1u);
+        EXPECT_EQ(getSubmittedHeadPosition(), 1.f);
+
+        // The compositor reprojects the previous image from the pose it was drawn for.
+        for (uint32_t i = 0; i < FrameCount; i++) {
+            runFrameAt(2.f + i);
+            ASSERT_TRUE(m_submittedFrame.hasPassthroughLayer);
+            EXPECT_EQ(getSubmittedHeadPosition(), 1.f);
+            EXPECT_EQ(m_submittedFrame.passthroughLayerViews[0].subImage.swapchain, m_passthroughSwapchain);
+        }
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, 1u);
+        EXPECT_EQ(m_runtime.xrAcquireSwapchainImageCount, 1u);
+
+        // Until the next camera image arrives, which is drawn for the current frame.
+        m_camera.pushImage();
+        runFrameAt(20.f);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, 2u);
+        EXPECT_EQ(m_backend->calls.mapCameraTexture, 2u);
+        EXPECT_EQ(getSubmittedHeadPosition(), 20.f);
+    }
+
+    TEST_F(CameraRateLayerTest, RedrawsWhenApplicationSpaceChanges) {
+        warmUp();
+
+        m_camera.pushImage();
+        runFrameAt(1.f);
+
+        // The previous image cannot be reprojected into another space.
+        m_applicationLayer.space = reinterpret_cast<XrSpace>(42);
+        runFrameAt(2.f);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, 2u);
+        EXPECT_EQ(m_submittedFrame.passthroughLayer.space, m_applicationLayer.space);
+        EXPECT_EQ(getSubmittedHeadPosition(), 2.f);
+    }
+#endif
+
+    TEST_F(LayerTest, OpaqueFramesAreForwarded) {
+        warmUp();
+
+        for (uint32_t i = 0; i < FrameCount; i++) {
+            m_camera.pushImage();
+            runFrame(XR_ENVIRONMENT_BLEND_MODE_OPAQUE);
+        }
+
+        EXPECT_EQ(m_backend->calls.mapCameraTexture, 0u);
+        EXPECT_EQ(m_backend->calls.drawPassthroughLayer, 0u);
+        EXPECT_EQ(m_runtime.xrAcquireSwapchainImageCount, 0u);
+        EXPECT_EQ(m_submittedFrame.layerCount, 1u);
+        EXPECT_EQ(m_submittedFrame.layers[0],
+                  reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer));
+    }
+
+} // namespace
@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <mesh_deformer.h>
+
+namespace {
+
+    using namespace passthrough;
+    using namespace DirectX;
+
+    // The head turns left at a constant speed during the readout: Angle over the first half, Angle over the second.
+    constexpr float Angle = 0.1f;
+
+    class MeshDeformerTest : public ::testing::Test {
+      protected:
+        void SetUp() override {
+            m_orientations[0] = xr::math::Quaternion::Identity();
+            m_orientations[1] = xr::math::Quaternion::RotationAxisAngle({0.f, 1.f, 0.f}, Angle);
+            m_orientations[2] = xr::math::Quaternion::RotationAxisAngle({0.f, 1.f, 0.f}, 2.f * Angle);
+        }
+
+        // A column of rows of 2 vertices, 1 meter in front of the model's origin, read out at the given times.
+        void setMesh(const std::vector<float>& rowReadouts, const XMMATRIX (&modelToHead)[ViewCount]) {
+            std::vector<VertexPositionTexture> vertices;
+            for (const float readout : rowReadouts) {
+                vertices.push_back({{0.f, 0.f, -1.f}, {0.f, readout}});
+                vertices.push_back({{0.5f, 0.f, -1.f}, {1.f, readout}});
+            }
+            m_deformer.setMesh(vertices, 2, modelToHead);
+        }
+
+        void expectPosition(uint32_t eye, size_t vertex, const XMFLOAT3& expected) {
+            const XMFLOAT3& position = m_deformer.getPositions()[eye][vertex];
+            EXPECT_NEAR(position.x, expected.x, 1e-5f) << "eye " << eye << ", vertex " << vertex;
+            EXPECT_NEAR(position.y, expected.y, 1e-5f) << "eye " << eye << ", vertex " << vertex;
+            EXPECT_NEAR(position.z, expected.z, 1e-5f) << "eye " << eye << ", vertex " << vertex;
+        }
+
+        // Where the row-vector point (x, 0, z) is after a rotation of angle around the Y axis.
+        static XMFLOAT3 rotateY(float x, float z, float angle) {
+            return {x * std::cos(angle) + z * std::sin(angle), 0.f, z * std::cos(angle) - x * std::sin(angle)};
+        }
+
+        MeshDeformer m_deformer;
+        XrQuaternionf m_orientations[3];
+    };
+
+    TEST_F(MeshDeformerTest, NotDeformedAfterSetMesh) {
+        setMesh({0.f, 1.f}, {XMMatrixIdentity(), XMMatrixIdentity()});
+
+        EXPECT_FALSE(m_deformer.isDeformed());
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            expectPosition(eye, 0, {0.f, 0.f, -1.f});
+            expectPosition(eye, 3, {0.5f, 0.f, -1.f});
+        }
+    }
+
+    TEST_F(MeshDeformerTest, RotatesEachRowRelativeToTheMiddleOfTheReadout) {
+        setMesh({0.f, 0.25f, 0.5f, 1.f}, {XMMatrixIdentity(), XMMatrixIdentity()});
+
+        m_deformer.deform(m_orientations, 3);
+
+        // The first row was seen Angle earlier than the middle row, so the head was turned Angle to the right of the
+        // reference orientation.
+        EXPECT_TRUE(m_deformer.isDeformed());
+        const float rowAngles[] = {-Angle, -Angle / 2.f, 0.f, Angle};
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            for (size_t row = 0; row < std::size(rowAngles); row++) {
+                expectPosition(eye, row * 2, rotateY(0.f, -1.f, rowAngles[row]));
+                expectPosition(eye, row * 2 + 1, rotateY(0.5f, -1.f, rowAngles[row]));
+            }
+        }
+    }
+
+    TEST_F(MeshDeformerTest, RotatesAroundTheHead) {
+        // The mesh of the right eye is offset to the right of the head.
+        setMesh({0.f, 1.f}, {XMMatrixIdentity(), XMMatrixTranslation(0.1f, 0.f, 0.f)});
+
+        m_deformer.deform(m_orientations, 3);
+
+        const XMFLOAT3 firstRow = rotateY(0.1f, -1.f, -Angle);
+        expectPosition(1, 0, {firstRow.x - 0.1f, firstRow.y, firstRow.z});
+        const XMFLOAT3 lastRow = rotateY(0.1f, -1.f, Angle);
+        expectPosition(1, 2, {lastRow.x - 0.1f, lastRow.y, lastRow.z});
+    }
+
+    TEST_F(MeshDeformerTest, NoMotionKeepsTheMesh) {
+        setMesh({0.f, 0.5f, 1.f}, {XMMatrixIdentity(), XMMatrixTranslation(0.1f, 0.f, 0.f)});
+        const XrQuaternionf orientations[] = {m_orientations[1], m_orientations[1]};
+
+        m_deformer.deform(orientations, 2);
+
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            for (size_t row = 0; row < 3; row++) {
+                expectPosition(eye, row * 2, {0.f, 0.f, -1.f});
+                expectPosition(eye, row * 2 + 1, {0.5f, 0.f, -1.f});
+            }
+        }
+    }
+
+    TEST_F(MeshDeformerTest, ResetRestoresTheMesh) {
+        setMesh({0.f, 1.f}, {XMMatrixIdentity(), XMMatrixIdentity()});
+        m_deformer.deform(m_orientations, 3);
+
+        m_deformer.reset();
+
+        EXPECT_FALSE(m_deformer.isDeformed());
+        expectPosition(0, 0, {0.f, 0.f, -1.f});
+        expectPosition(0, 3, {0.5f, 0.f, -1.f});
+    }
+
+    TEST_F(MeshDeformerTest, DeformsTheLayerMeshWithinBudget) {
+#ifdef _DEBUG
+        GTEST_SKIP() << "The timing is only meaningful in optimized builds";
+#endif
+
+        // The size of the mesh drawn by the layer: 21 x 21 vertices per eye.
+        constexpr uint32_t RowLength = 21;
+        std::vector<float> rowReadouts;
+        for (uint32_t row = 0; row < RowLength; row++) {
+            rowReadouts.push_back((float)row / (RowLength - 1));
+        }
+        std::vector<VertexPositionTexture> vertices;
+        for (const float readout : rowReadouts) {
+            for (uint32_t column = 0; column < RowLength; column++) {
+                vertices.push_back({{(float)column / (RowLength - 1) - 0.5f, 0.5f - readout, 0.f}, {0.f, readout}});
+            }
+        }
+        m_deformer.setMesh(
+            vertices, RowLength, {XMMatrixTranslation(-0.03f, 0.f, -1.f), XMMatrixTranslation(0.03f, 0.f, -1.f)});
+
+        // The deformation runs on the frame thread for each new camera image, it must only take a few microseconds.
+        constexpr uint32_t Iterations = 1000;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < Iterations; i++) {
+            m_deformer.deform(m_orientations, 3);
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        EXPECT_LT(elapsed.count() / Iterations, 10.0);
+    }
+
+} // namespace
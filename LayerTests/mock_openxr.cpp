@@ -0,0 +1,63 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include "mock_openxr.h"
+
+namespace {
+
+    passthrough::OpenXrApi* g_instance = nullptr;
+
+} // namespace
+
+namespace passthrough {
+
+    std::filesystem::path dllHome = std::filesystem::temp_directory_path();
+    std::filesystem::path localAppData =
+        std::filesystem::temp_directory_path() / fmt::format("wmr-passthrough-tests-{}", GetCurrentProcessId());
+
+    OpenXrApi* GetInstance() {
+        return g_instance;
+    }
+
+    void ResetInstance() {
+    }
+
+} // namespace passthrough
+
+namespace passthrough::test {
+
+    MockOpenXrApi::MockOpenXrApi() {
+        // The runtime does not check the instance handle.
+        SetGetInstanceProcAddr(mock::MockRuntime::xrGetInstanceProcAddr, reinterpret_cast<XrInstance>(1));
+
+        XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
+        CHECK_XRCMD(xrCreateInstance(&createInfo));
+    }
+
+    void SetLayerInstance(OpenXrApi* instance) {
+        g_instance = instance;
+    }
+
+} // namespace passthrough::test
@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <layer.h>
+
+#include <framework/mock_runtime.gen.h>
+
+namespace passthrough::test {
+
+    // An OpenXrApi whose next layer is a MockRuntime, for the code of the layer that calls the runtime through an
+    // OpenXrApi. Only one may exist at a time.
+    class MockOpenXrApi : public OpenXrApi {
+      public:
+        MockOpenXrApi();
+
+        mock::MockRuntime runtime;
+    };
+
+    // The layer called by the functions resolved through xrGetInstanceProcAddr(). The tests do not create the layer
+    // singleton.
+    void SetLayerInstance(OpenXrApi* instance);
+
+} // namespace passthrough::test
@@ -0,0 +1,135 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "null_graphics_backend.h"
+
+namespace {
+
+    using namespace passthrough;
+
+    class NullShaderCompiler : public IShaderCompiler {
+      public:
+        uint32_t getVersion() const override {
+            return 1;
+        }
+
+        std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) override {
+            return {source.cbegin(), source.cend()};
+        }
+    };
+
+} // namespace
+
+namespace passthrough::test {
+
+    std::unique_ptr<IShaderCompiler> NullGraphicsBackend::createShaderCompiler() const {
+        return std::make_unique<NullShaderCompiler>();
+    }
+
+    ShaderDescription NullGraphicsBackend::getVertexShader() const {
+        return {"null vertex shader", "main", "vs", 0};
+    }
+
+    ShaderDescription NullGraphicsBackend::getPixelShader() const {
+        return {"null pixel shader", "main", "ps", 0};
+    }
+
+    SwapchainFormatApi NullGraphicsBackend::getSwapchainFormatApi() const {
+        return SwapchainFormatApi::DXGIOrOpenGL;
+    }
+
+    void NullGraphicsBackend::importSwapchainImages(OpenXrApi& openXR,
+                                                    XrSwapchain swapchain,
+                                                    const XrSwapchainCreateInfo& createInfo) {
+        calls.importSwapchainImages++;
+    }
+
+    void NullGraphicsBackend::createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                                     const std::vector<uint8_t>& psBytes,
+                                                     const std::vector<VertexPositionTexture>* vertices,
+                                                     const std::vector<uint16_t>& indices) {
+        calls.createDrawingResources++;
+    }
+
+    void NullGraphicsBackend::updateVertexPositions(const std::vector<DirectX::XMFLOAT3>* positions) {
+        calls.updateVertexPositions++;
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            vertexPositions[eye] = positions[eye];
+        }
+    }
+
+    uint8_t* NullGraphicsBackend::mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) {
+        calls.mapCameraTexture++;
+        m_cameraTexture.resize((size_t)width * height);
+        pitch = width;
+        return m_cameraTexture.data();
+    }
+
+    void NullGraphicsBackend::unmapCameraTexture(bool commit) {
+        calls.unmapCameraTexture++;
+        if (commit) {
+            committedCameraImageCount++;
+        }
+    }
+
+    const UploadRingStatistics& NullGraphicsBackend::getCameraUploadStatistics() const {
+        return m_uploadStatistics;
+    }
+
+    void NullGraphicsBackend::setOpacity(float opacity) {
+        calls.setOpacity++;
+        this->opacity = opacity;
+    }
+
+    void NullGraphicsBackend::drawPassthroughLayer(uint32_t imageIndex,
+                                                   const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) {
+        calls.drawPassthroughLayer++;
+    }
+
+    void
+    NullGraphicsBackend::uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) {
+        calls.uploadSwapchainImage++;
+    }
+
+    bool NullGraphicsBackend::isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const {
+        return supportsDepthComposition;
+    }
+
+    void NullGraphicsBackend::importApplicationSwapchain(OpenXrApi& openXR,
+                                                         XrSwapchain swapchain,
+                                                         const XrSwapchainCreateInfo& createInfo) {
+        calls.importApplicationSwapchain++;
+    }
+
+    void NullGraphicsBackend::forgetApplicationSwapchain(XrSwapchain swapchain) {
+        calls.forgetApplicationSwapchain++;
+    }
+
+    void NullGraphicsBackend::compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                                        const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) {
+        calls.compositePassthroughLayer++;
+    }
+
+} // namespace passthrough::test
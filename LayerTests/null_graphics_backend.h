@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <graphics_backend.h>
+
+namespace passthrough::test {
+
+    // A graphics backend that draws nothing, and counts the calls made by the layer.
+    class NullGraphicsBackend : public IGraphicsBackend {
+      public:
+        // The number of calls to each of the methods doing work for the frame.
+        struct Calls {
+            uint32_t importSwapchainImages{0};
+            uint32_t createDrawingResources{0};
+            uint32_t updateVertexPositions{0};
+            uint32_t mapCameraTexture{0};
+            uint32_t unmapCameraTexture{0};
+            uint32_t setOpacity{0};
+            uint32_t drawPassthroughLayer{0};
+            uint32_t uploadSwapchainImage{0};
+            uint32_t importApplicationSwapchain{0};
+            uint32_t forgetApplicationSwapchain{0};
+            uint32_t compositePassthroughLayer{0};
+        };
+
+        std::unique_ptr<IShaderCompiler> createShaderCompiler() const override;
+        ShaderDescription getVertexShader() const override;
+        ShaderDescription getPixelShader() const override;
+        SwapchainFormatApi getSwapchainFormatApi() const override;
+        void importSwapchainImages(OpenXrApi& openXR,
+                                   XrSwapchain swapchain,
+                                   const XrSwapchainCreateInfo& createInfo) override;
+        void createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                    const std::vector<uint8_t>& psBytes,
+                                    const std::vector<VertexPositionTexture>* vertices,
+                                    const std::vector<uint16_t>& indices) override;
+        void updateVertexPositions(const std::vector<DirectX::XMFLOAT3>* positions) override;
+        uint8_t* mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) override;
+        void unmapCameraTexture(bool commit) override;
+        const UploadRingStatistics& getCameraUploadStatistics() const override;
+        void setOpacity(float opacity) override;
+        void drawPassthroughLayer(uint32_t imageIndex,
+                                  const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override;
+        void uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) override;
+        bool isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const override;
+        void importApplicationSwapchain(OpenXrApi& openXR,
+                                        XrSwapchain swapchain,
+                                        const XrSwapchainCreateInfo& createInfo) override;
+        void forgetApplicationSwapchain(XrSwapchain swapchain) override;
+        void compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                       const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override;
+
+        Calls calls;
+
+        // Whether isDepthCompositionSupported() accepts all the formats.
+        bool supportsDepthComposition{false};
+
+        // The arguments of the latest calls.
+        float opacity{1.f};
+        uint32_t committedCameraImageCount{0};
+        std::vector<DirectX::XMFLOAT3> vertexPositions[ViewCount];
+
+      private:
+        // The camera texture. Only reallocated when the size of the camera image changes.
+        std::vector<uint8_t> m_cameraTexture;
+        UploadRingStatistics m_uploadStatistics;
+    };
+
+} // namespace passthrough::test
@@ -0,0 +1,335 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <passthrough_fb.h>
+
+#include "layer_test.h"
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::test;
+
+    const XrSession Session = reinterpret_cast<XrSession>(1);
+    const XrSession OtherSession = reinterpret_cast<XrSession>(2);
+
+    class PassthroughStateFBTest : public ::testing::Test {
+      protected:
+        XrPassthroughFB createPassthrough(bool isRunning, XrSession session = Session) {
+            XrPassthroughCreateInfoFB createInfo{XR_TYPE_PASSTHROUGH_CREATE_INFO_FB, nullptr};
+            createInfo.flags = isRunning ? XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB : 0;
+            XrPassthroughFB passthrough{XR_NULL_HANDLE};
+            EXPECT_EQ(m_state.createPassthrough(session, createInfo, passthrough), XR_SUCCESS);
+            return passthrough;
+        }
+
+        XrPassthroughLayerFB createLayer(XrPassthroughFB passthrough, bool isRunning, XrSession session = Session) {
+            XrPassthroughLayerFB layer{XR_NULL_HANDLE};
+            EXPECT_EQ(m_state.createLayer(session, getLayerCreateInfo(passthrough, isRunning), layer), XR_SUCCESS);
+            return layer;
+        }
+
+        static XrPassthroughLayerCreateInfoFB getLayerCreateInfo(XrPassthroughFB passthrough, bool isRunning) {
+            XrPassthroughLayerCreateInfoFB createInfo{XR_TYPE_PASSTHROUGH_LAYER_CREATE_INFO_FB, nullptr};
+            createInfo.passthrough = passthrough;
+            createInfo.flags = isRunning ? XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB : 0;
+            createInfo.purpose = XR_PASSTHROUGH_LAYER_PURPOSE_RECONSTRUCTION_FB;
+            return createInfo;
+        }
+
+        static XrPassthroughStyleFB getStyle(float opacity) {
+            XrPassthroughStyleFB style{XR_TYPE_PASSTHROUGH_STYLE_FB, nullptr};
+            style.textureOpacityFactor = opacity;
+            return style;
+        }
+
+        PassthroughStateFB m_state;
+    };
+
+    TEST_F(PassthroughStateFBTest, RunningLayerIsShown) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, true);
+
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 1.f);
+        EXPECT_FALSE(m_state.isPaused());
+    }
+
+    TEST_F(PassthroughStateFBTest, LayerIsShownOnceBothAreStarted) {
+        const XrPassthroughFB passthrough = createPassthrough(false);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, false);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_TRUE(m_state.isPaused());
+
+        ASSERT_EQ(m_state.setPassthroughRunning(passthrough, true), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_FALSE(m_state.isPaused());
+
+        ASSERT_EQ(m_state.setLayerRunning(layer, true), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 1.f);
+    }
+
+    TEST_F(PassthroughStateFBTest, PauseHidesLayers) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, true);
+
+        ASSERT_EQ(m_state.setPassthroughRunning(passthrough, false), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_TRUE(m_state.isPaused());
+
+        ASSERT_EQ(m_state.setPassthroughRunning(passthrough, true), XR_SUCCESS);
+        ASSERT_EQ(m_state.setLayerRunning(layer, false), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_FALSE(m_state.isPaused());
+
+        ASSERT_EQ(m_state.setLayerRunning(layer, true), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 1.f);
+    }
+
+    TEST_F(PassthroughStateFBTest, PausedUntilAllPassthroughsArePaused) {
+        EXPECT_FALSE(m_state.isPaused());
+
+        const XrPassthroughFB passthrough1 = createPassthrough(true);
+        const XrPassthroughFB passthrough2 = createPassthrough(true);
+        ASSERT_EQ(m_state.setPassthroughRunning(passthrough1, false), XR_SUCCESS);
+        EXPECT_FALSE(m_state.isPaused());
+        ASSERT_EQ(m_state.setPassthroughRunning(passthrough2, false), XR_SUCCESS);
+        EXPECT_TRUE(m_state.isPaused());
+
+        ASSERT_EQ(m_state.destroyPassthrough(passthrough1), XR_SUCCESS);
+        ASSERT_EQ(m_state.destroyPassthrough(passthrough2), XR_SUCCESS);
+        EXPECT_FALSE(m_state.isPaused());
+    }
+
+    TEST_F(PassthroughStateFBTest, StyleSetsOpacity) {
+        const XrPassthroughLayerFB layer = createLayer(createPassthrough(true), true);
+
+        ASSERT_EQ(m_state.setLayerStyle(layer, getStyle(0.25f)), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.25f);
+
+        // The opacity is kept while paused.
+        ASSERT_EQ(m_state.setLayerRunning(layer, false), XR_SUCCESS);
+        ASSERT_EQ(m_state.setLayerRunning(layer, true), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.25f);
+
+        EXPECT_EQ(m_state.setLayerStyle(layer, getStyle(1.5f)), XR_ERROR_VALIDATION_FAILURE);
+        EXPECT_EQ(m_state.setLayerStyle(layer, getStyle(-0.5f)), XR_ERROR_VALIDATION_FAILURE);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.25f);
+    }
+
+    TEST_F(PassthroughStateFBTest, DestroyedHandlesAreInvalid) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, true);
+
+        ASSERT_EQ(m_state.destroyLayer(layer), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_EQ(m_state.destroyLayer(layer), XR_ERROR_HANDLE_INVALID);
+        EXPECT_EQ(m_state.setLayerRunning(layer, true), XR_ERROR_HANDLE_INVALID);
+        EXPECT_EQ(m_state.setLayerStyle(layer, getStyle(1.f)), XR_ERROR_HANDLE_INVALID);
+
+        ASSERT_EQ(m_state.destroyPassthrough(passthrough), XR_SUCCESS);
+        EXPECT_EQ(m_state.destroyPassthrough(passthrough), XR_ERROR_HANDLE_INVALID);
+        EXPECT_EQ(m_state.setPassthroughRunning(passthrough, true), XR_ERROR_HANDLE_INVALID);
+
+        XrPassthroughLayerFB otherLayer{XR_NULL_HANDLE};
+        EXPECT_EQ(m_state.createLayer(Session, getLayerCreateInfo(passthrough, true), otherLayer),
+                  XR_ERROR_HANDLE_INVALID);
+    }
+
+    TEST_F(PassthroughStateFBTest, InvalidHandles) {
+        const XrPassthroughLayerFB layer = createLayer(createPassthrough(true), true);
+
+        for (const uint64_t handle : {(uint64_t)0, (uint64_t)1, reinterpret_cast<uint64_t>(layer) + 1}) {
+            EXPECT_EQ(m_state.getLayerOpacity(reinterpret_cast<XrPassthroughLayerFB>(handle)), 0.f);
+            EXPECT_EQ(m_state.setLayerRunning(reinterpret_cast<XrPassthroughLayerFB>(handle), true),
+                      XR_ERROR_HANDLE_INVALID);
+            EXPECT_EQ(m_state.setPassthroughRunning(reinterpret_cast<XrPassthroughFB>(handle), true),
+                      XR_ERROR_HANDLE_INVALID);
+        }
+    }
+
+    TEST_F(PassthroughStateFBTest, DestroyingPassthroughHidesItsLayers) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, true);
+
+        ASSERT_EQ(m_state.destroyPassthrough(passthrough), XR_SUCCESS);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_EQ(m_state.destroyLayer(layer), XR_SUCCESS);
+    }
+
+    TEST_F(PassthroughStateFBTest, DestroySessionDestroysItsChildren) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        const XrPassthroughLayerFB layer = createLayer(passthrough, true);
+        const XrPassthroughFB otherPassthrough = createPassthrough(true, OtherSession);
+        const XrPassthroughLayerFB otherLayer = createLayer(otherPassthrough, true, OtherSession);
+
+        m_state.destroySession(Session);
+
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_EQ(m_state.destroyLayer(layer), XR_ERROR_HANDLE_INVALID);
+        EXPECT_EQ(m_state.destroyPassthrough(passthrough), XR_ERROR_HANDLE_INVALID);
+        EXPECT_EQ(m_state.getLayerOpacity(otherLayer), 1.f);
+    }
+
+    TEST_F(PassthroughStateFBTest, LimitsLayerCount) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+        XrPassthroughLayerFB layers[PassthroughStateFB::MaxLayers];
+        for (XrPassthroughLayerFB& layer : layers) {
+            layer = createLayer(passthrough, true);
+        }
+
+        XrPassthroughLayerFB layer{XR_NULL_HANDLE};
+        EXPECT_EQ(m_state.createLayer(Session, getLayerCreateInfo(passthrough, true), layer), XR_ERROR_LIMIT_REACHED);
+
+        // The new layer does not share the state of the layer it replaced.
+        ASSERT_EQ(m_state.setLayerStyle(layers[3], getStyle(0.5f)), XR_SUCCESS);
+        ASSERT_EQ(m_state.destroyLayer(layers[3]), XR_SUCCESS);
+        layer = createLayer(passthrough, false);
+        EXPECT_NE(layer, layers[3]);
+        EXPECT_EQ(m_state.getLayerOpacity(layer), 0.f);
+        EXPECT_EQ(m_state.getLayerOpacity(layers[3]), 0.f);
+        for (const XrPassthroughLayerFB other : layers) {
+            if (other != layers[3]) {
+                EXPECT_EQ(m_state.getLayerOpacity(other), 1.f);
+            }
+        }
+    }
+
+    TEST_F(PassthroughStateFBTest, OnlyReconstructionLayersAreSupported) {
+        const XrPassthroughFB passthrough = createPassthrough(true);
+
+        XrPassthroughLayerCreateInfoFB createInfo = getLayerCreateInfo(passthrough, true);
+        createInfo.purpose = XR_PASSTHROUGH_LAYER_PURPOSE_PROJECTED_FB;
+        XrPassthroughLayerFB layer{XR_NULL_HANDLE};
+        EXPECT_EQ(m_state.createLayer(Session, createInfo, layer), XR_ERROR_FEATURE_UNSUPPORTED);
+
+        createInfo = getLayerCreateInfo(passthrough, true);
+        createInfo.type = XR_TYPE_PASSTHROUGH_CREATE_INFO_FB;
+        EXPECT_EQ(m_state.createLayer(Session, createInfo, layer), XR_ERROR_VALIDATION_FAILURE);
+    }
+
+    // The application's side of XR_FB_passthrough, through the functions resolved from the layer.
+    class PassthroughFBTest : public LayerTest {
+      protected:
+        void SetUp() override {
+            LayerTest::SetUp();
+
+            xrCreatePassthroughFB = resolve<PFN_xrCreatePassthroughFB>("xrCreatePassthroughFB");
+            xrPassthroughPauseFB = resolve<PFN_xrPassthroughPauseFB>("xrPassthroughPauseFB");
+            xrCreatePassthroughLayerFB = resolve<PFN_xrCreatePassthroughLayerFB>("xrCreatePassthroughLayerFB");
+            xrPassthroughLayerSetStyleFB = resolve<PFN_xrPassthroughLayerSetStyleFB>("xrPassthroughLayerSetStyleFB");
+        }
+
+        // Create a running passthrough with a running layer, submitted underneath the application's layer.
+        void createPassthroughLayer() {
+            XrPassthroughCreateInfoFB createInfo{XR_TYPE_PASSTHROUGH_CREATE_INFO_FB, nullptr};
+            createInfo.flags = XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB;
+            ASSERT_EQ(xrCreatePassthroughFB(Session, &createInfo, &m_passthrough), XR_SUCCESS);
+
+            XrPassthroughLayerCreateInfoFB layerCreateInfo{XR_TYPE_PASSTHROUGH_LAYER_CREATE_INFO_FB, nullptr};
+            layerCreateInfo.passthrough = m_passthrough;
+            layerCreateInfo.flags = XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB;
+            layerCreateInfo.purpose = XR_PASSTHROUGH_LAYER_PURPOSE_RECONSTRUCTION_FB;
+            ASSERT_EQ(xrCreatePassthroughLayerFB(Session, &layerCreateInfo, &m_passthroughLayer.layerHandle),
+                      XR_SUCCESS);
+            m_passthroughLayer.space = ApplicationSpace;
+        }
+
+        // Submit a frame with the passthrough layer underneath the application's layer, without blend mode.
+        void runPassthroughLayerFrame() {
+            const XrCompositionLayerBaseHeader* layers[] = {
+                reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_passthroughLayer),
+                reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer)};
+            m_camera.pushImage();
+            runFrame(XR_ENVIRONMENT_BLEND_MODE_OPAQUE, layers, (uint32_t)std::size(layers));
+        }
+
+        XrPassthroughFB m_passthrough{XR_NULL_HANDLE};
+        XrCompositionLayerPassthroughFB m_passthroughLayer{XR_TYPE_COMPOSITION_LAYER_PASSTHROUGH_FB, nullptr};
+
+        PFN_xrCreatePassthroughFB xrCreatePassthroughFB{nullptr};
+        PFN_xrPassthroughPauseFB xrPassthroughPauseFB{nullptr};
+        PFN_xrCreatePassthroughLayerFB xrCreatePassthroughLayerFB{nullptr};
+        PFN_xrPassthroughLayerSetStyleFB xrPassthroughLayerSetStyleFB{nullptr};
+    };
+
+    TEST_F(PassthroughFBTest, DrawsPassthroughLayerWithItsOpacity) {
+        warmUp();
+        createPassthroughLayer();
+
+        XrPassthroughStyleFB style{XR_TYPE_PASSTHROUGH_STYLE_FB, nullptr};
+        style.textureOpacityFactor = 0.5f;
+        ASSERT_EQ(xrPassthroughLayerSetStyleFB(m_passthroughLayer.layerHandle, &style), XR_SUCCESS);
+        runPassthroughLayerFrame();
+
+        // The passthrough layer is replaced by the camera layer.
+        ASSERT_EQ(m_submittedFrame.layerCount, 2u);
+        EXPECT_TRUE(m_submittedFrame.hasPassthroughLayer);
+        EXPECT_EQ(m_submittedFrame.layerFlags[1], XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT);
+        EXPECT_EQ(m_backend->opacity, 0.5f);
+    }
+
+    TEST_F(PassthroughFBTest, PausedPassthroughIsNotDrawn) {
+        warmUp();
+        createPassthroughLayer();
+        ASSERT_EQ(xrPassthroughPauseFB(m_passthrough), XR_SUCCESS);
+        runPassthroughLayerFrame();
+
+        ASSERT_EQ(m_submittedFrame.layerCount, 1u);
+        EXPECT_FALSE(m_submittedFrame.hasPassthroughLayer);
+        EXPECT_EQ(m_submittedFrame.layers[0],
+                  reinterpret_cast<const XrCompositionLayerBaseHeader*>(&m_applicationLayer));
+    }
+
+    TEST_F(PassthroughFBTest, InvalidSession) {
+        XrPassthroughCreateInfoFB createInfo{XR_TYPE_PASSTHROUGH_CREATE_INFO_FB, nullptr};
+        EXPECT_EQ(xrCreatePassthroughFB(reinterpret_cast<XrSession>(42), &createInfo, &m_passthrough),
+                  XR_ERROR_HANDLE_INVALID);
+    }
+
+    class PassthroughFBDisabledTest : public LayerTest {
+      protected:
+        void SetUp() override {
+            m_enabledExtensions.clear();
+            LayerTest::SetUp();
+        }
+    };
+
+    TEST_F(PassthroughFBDisabledTest, FunctionsAreUnsupported) {
+        for (const char* name : {"xrCreatePassthroughFB",
+                                 "xrDestroyPassthroughFB",
+                                 "xrPassthroughStartFB",
+                                 "xrPassthroughPauseFB",
+                                 "xrCreatePassthroughLayerFB",
+                                 "xrDestroyPassthroughLayerFB",
+                                 "xrPassthroughLayerPauseFB",
+                                 "xrPassthroughLayerResumeFB",
+                                 "xrPassthroughLayerSetStyleFB"}) {
+            PFN_xrVoidFunction function = nullptr;
+            EXPECT_EQ(m_layer->xrGetInstanceProcAddr(Instance, name, &function), XR_ERROR_FUNCTION_UNSUPPORTED)
+                << name;
+            EXPECT_EQ(function, nullptr) << name;
+        }
+    }
+
+} // namespace
@@ -0,0 +1,208 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <shader_cache.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    // Produces a bytecode unique to its inputs, and counts the compilations.
+    class FakeShaderCompiler : public IShaderCompiler {
+      public:
+        FakeShaderCompiler(uint32_t version, std::atomic<uint32_t>& compileCount)
+            : m_version(version), m_compileCount(compileCount) {
+        }
+
+        uint32_t getVersion() const override {
+            return m_version;
+        }
+
+        std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) override {
+            m_compileCount++;
+
+            const std::string text = fmt::format("{}|{}|{}|{}|{}", source, entryPoint, target, flags, m_version);
+            return {text.cbegin(), text.cend()};
+        }
+
+      private:
+        const uint32_t m_version;
+        std::atomic<uint32_t>& m_compileCount;
+    };
+
+    const std::string_view Source = "float4 main() : SV_TARGET { return 0; }";
+
+    class ShaderCacheTest : public ::testing::Test {
+      protected:
+        void SetUp() override {
+            const auto* testInfo = ::testing::UnitTest::GetInstance()->current_test_info();
+            m_directory = std::filesystem::temp_directory_path() /
+                          fmt::format("wmr-passthrough-tests-{}-{}", GetCurrentProcessId(), testInfo->name());
+            std::filesystem::remove_all(m_directory);
+        }
+
+        void TearDown() override {
+            std::error_code ec;
+            std::filesystem::remove_all(m_directory, ec);
+        }
+
+        std::unique_ptr<ShaderCache> makeCache(uint32_t version = 1,
+                                               const PrecompiledShader* precompiledShaders = nullptr,
+                                               size_t precompiledShadersCount = 0) {
+            return std::make_unique<ShaderCache>(std::make_unique<FakeShaderCompiler>(version, m_compileCount),
+                                                 m_directory,
+                                                 precompiledShaders,
+                                                 precompiledShadersCount);
+        }
+
+        std::vector<std::filesystem::path> listCacheFiles() const {
+            std::vector<std::filesystem::path> files;
+            for (const auto& entry : std::filesystem::directory_iterator(m_directory)) {
+                files.push_back(entry.path());
+            }
+            return files;
+        }
+
+        std::filesystem::path m_directory;
+        std::atomic<uint32_t> m_compileCount{0};
+    };
+
+    TEST_F(ShaderCacheTest, MissCompilesAndStores) {
+        auto cache = makeCache();
+        const auto bytecode = cache->getOrCompile(Source, "main", "ps_5_0", 0);
+
+        EXPECT_EQ(m_compileCount, 1u);
+        EXPECT_FALSE(bytecode.empty());
+        EXPECT_EQ(listCacheFiles().size(), 1u);
+    }
+
+    TEST_F(ShaderCacheTest, HitDoesNotCompile) {
+        const auto expected = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+
+        // A new cache, like upon the next session.
+        const auto bytecode = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+
+        EXPECT_EQ(m_compileCount, 1u);
+        EXPECT_EQ(bytecode, expected);
+    }
+
+    TEST_F(ShaderCacheTest, KeyCoversAllInputs) {
+        auto cache = makeCache();
+        const uint64_t key = cache->computeKey(Source, "main", "ps_5_0", 0);
+
+        EXPECT_NE(cache->computeKey("float4 main() : SV_TARGET { return 1; }", "main", "ps_5_0", 0), key);
+        EXPECT_NE(cache->computeKey(Source, "main2", "ps_5_0", 0), key);
+        EXPECT_NE(cache->computeKey(Source, "main", "ps_5_1", 0), key);
+        EXPECT_NE(cache->computeKey(Source, "main", "ps_5_0", 1), key);
+        EXPECT_NE(makeCache(2)->computeKey(Source, "main", "ps_5_0", 0), key);
+
+        // The boundaries between the fields are part of the key.
+        EXPECT_NE(cache->computeKey(Source, "ma", "inps_5_0", 0), key);
+    }
+
+    TEST_F(ShaderCacheTest, CompilerUpdateInvalidatesEntries) {
+        makeCache(1)->getOrCompile(Source, "main", "ps_5_0", 0);
+        const auto bytecode = makeCache(2)->getOrCompile(Source, "main", "ps_5_0", 0);
+
+        EXPECT_EQ(m_compileCount, 2u);
+        EXPECT_EQ(bytecode.back(), '2');
+    }
+
+    TEST_F(ShaderCacheTest, CorruptedEntryIsRecompiled) {
+        const auto expected = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+        const auto files = listCacheFiles();
+        ASSERT_EQ(files.size(), 1u);
+
+        // Flip the last byte of the bytecode.
+        {
+            std::fstream file(files[0], std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+            file.seekg(-1, std::ios_base::end);
+            const char last = (char)file.get();
+            file.seekp(-1, std::ios_base::end);
+            file.put(last ^ 0x5a);
+        }
+
+        const auto bytecode = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+        EXPECT_EQ(m_compileCount, 2u);
+        EXPECT_EQ(bytecode, expected);
+
+        // The entry was rewritten.
+        makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+        EXPECT_EQ(m_compileCount, 2u);
+    }
+
+    TEST_F(ShaderCacheTest, TruncatedEntryIsRecompiled) {
+        const auto expected = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+        const auto files = listCacheFiles();
+        ASSERT_EQ(files.size(), 1u);
+
+        std::filesystem::resize_file(files[0], std::filesystem::file_size(files[0]) - 1);
+
+        const auto bytecode = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0);
+        EXPECT_EQ(m_compileCount, 2u);
+        EXPECT_EQ(bytecode, expected);
+    }
+
+    TEST_F(ShaderCacheTest, PrecompiledShaderIsPreferred) {
+        const uint8_t precompiledBytecode[] = {0x44, 0x58, 0x42, 0x43};
+        const uint64_t key = makeCache()->computeKey(Source, "main", "ps_5_0", 0);
+        const PrecompiledShader precompiledShaders[] = {{key, precompiledBytecode, sizeof(precompiledBytecode)}};
+
+        auto cache = makeCache(1, precompiledShaders, std::size(precompiledShaders));
+        const auto bytecode = cache->getOrCompile(Source, "main", "ps_5_0", 0);
+
+        EXPECT_EQ(m_compileCount, 0u);
+        EXPECT_EQ(bytecode, std::vector<uint8_t>(std::cbegin(precompiledBytecode), std::cend(precompiledBytecode)));
+
+        // Another shader is not affected.
+        cache->getOrCompile(Source, "main", "vs_5_0", 0);
+        EXPECT_EQ(m_compileCount, 1u);
+    }
+
+    TEST_F(ShaderCacheTest, ConcurrentWritersProduceOneValidEntry) {
+        constexpr uint32_t WriterCount = 8;
+
+        std::vector<std::vector<uint8_t>> results(WriterCount);
+        std::vector<std::thread> writers;
+        for (uint32_t i = 0; i < WriterCount; i++) {
+            writers.emplace_back([&, i] { results[i] = makeCache()->getOrCompile(Source, "main", "ps_5_0", 0); });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+
+        for (uint32_t i = 1; i < WriterCount; i++) {
+            EXPECT_EQ(results[i], results[0]);
+        }
+
+        // No temporary file is left behind, and the entry is readable.
+        EXPECT_EQ(listCacheFiles().size(), 1u);
+        const uint32_t compileCount = m_compileCount;
+        EXPECT_EQ(makeCache()->getOrCompile(Source, "main", "ps_5_0", 0), results[0]);
+        EXPECT_EQ(m_compileCount, compileCount);
+    }
+
+} // namespace
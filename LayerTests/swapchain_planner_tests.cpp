@@ -0,0 +1,187 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <swapchain_planner.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    constexpr int64_t GL_RGBA8 = 0x8058;
+    constexpr int64_t GL_RGBA16F = 0x881A;
+    constexpr int64_t GL_SRGB8_ALPHA8 = 0x8C43;
+
+    // The camera image spans 2 units vertically, 1 meter away, and the field of view 2 units in each direction. This
+    // puts 240 camera pixels per unit on both axes.
+    SwapchainPlannerInput makeInput(PassthroughQuality quality, const std::vector<int64_t>& formats) {
+        SwapchainPlannerInput input{};
+        input.cameraWidth = 640;
+        input.cameraHeight = 480;
+        input.meshScale = 2.f;
+        const float halfAngle = std::atan(1.f);
+        input.fov = {-halfAngle, halfAngle, halfAngle, -halfAngle};
+        input.recommendedWidth = 2000;
+        input.recommendedHeight = 2000;
+        input.formats = formats.data();
+        input.formatCount = formats.size();
+        input.quality = quality;
+        input.isCpuWritten = false;
+        return input;
+    }
+
+    const std::vector<int64_t> DefaultFormats = {DXGI_FORMAT_R8G8B8A8_UNORM};
+
+    TEST(SwapchainPlannerTest, PerformanceMatchesCameraDensity) {
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Performance, DefaultFormats));
+
+        // 480 pixels across the field of view, but never fewer than the camera width.
+        EXPECT_EQ(plan.width, 640u);
+        EXPECT_NEAR(plan.height, 480u, 1);
+    }
+
+    TEST(SwapchainPlannerTest, QualityOversamples) {
+        const SwapchainPlan balanced =
+            planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, DefaultFormats));
+        const SwapchainPlan quality = planPassthroughSwapchain(makeInput(PassthroughQuality::Quality, DefaultFormats));
+
+        EXPECT_NEAR(balanced.width, 672u, 1);
+        EXPECT_NEAR(balanced.height, 672u, 1);
+        EXPECT_NEAR(quality.width, 960u, 1);
+        EXPECT_NEAR(quality.height, 960u, 1);
+    }
+
+    TEST(SwapchainPlannerTest, NeverExceedsRecommendedResolution) {
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Quality, DefaultFormats);
+        input.recommendedWidth = 800;
+        input.recommendedHeight = 600;
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(plan.width, 800u);
+        EXPECT_EQ(plan.height, 600u);
+
+        // Even below the camera resolution.
+        input.recommendedWidth = 320;
+        input.recommendedHeight = 240;
+        const SwapchainPlan smallPlan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(smallPlan.width, 320u);
+        EXPECT_EQ(smallPlan.height, 240u);
+    }
+
+    TEST(SwapchainPlannerTest, WiderFieldOfViewNeedsMorePixels) {
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Performance, DefaultFormats);
+        const float halfAngle = std::atan(2.f);
+        input.fov = {-halfAngle, halfAngle, halfAngle, -halfAngle};
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_NEAR(plan.width, 960u, 1);
+        EXPECT_NEAR(plan.height, 960u, 1);
+    }
+
+    TEST(SwapchainPlannerTest, AsymmetricFieldOfView) {
+        // Canted displays have an asymmetric field of view, only its extent matters.
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Performance, DefaultFormats);
+        input.fov = {-std::atan(1.5f), std::atan(0.5f), std::atan(0.5f), -std::atan(1.5f)};
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(plan.width, 640u);
+        EXPECT_NEAR(plan.height, 480u, 1);
+    }
+
+    TEST(SwapchainPlannerTest, InvalidFieldOfViewUsesRecommendedResolution) {
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Performance, DefaultFormats);
+        input.fov = {};
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(plan.width, 2000u);
+        EXPECT_EQ(plan.height, 2000u);
+    }
+
+    TEST(SwapchainPlannerTest, PicksCheapestFormatWithSameEncoding) {
+        const std::vector<int64_t> formats = {DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+                                              DXGI_FORMAT_R10G10B10A2_UNORM,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM};
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, formats));
+
+        // The first 4 bytes per pixel format that is not sRGB, like the preferred one.
+        EXPECT_EQ(plan.format, DXGI_FORMAT_R10G10B10A2_UNORM);
+    }
+
+    TEST(SwapchainPlannerTest, KeepsSRGBEncoding) {
+        const std::vector<int64_t> formats = {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,
+                                              DXGI_FORMAT_R16G16B16A16_FLOAT,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM_SRGB};
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, formats));
+
+        EXPECT_EQ(plan.format, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB);
+    }
+
+    TEST(SwapchainPlannerTest, CpuWrittenRequires8BitChannels) {
+        const std::vector<int64_t> formats = {
+            DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM};
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Balanced, formats);
+        input.isCpuWritten = true;
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(plan.format, DXGI_FORMAT_B8G8R8A8_UNORM);
+        EXPECT_TRUE(getSwapchainFormatInfo(plan.format)->isBGRA);
+    }
+
+    TEST(SwapchainPlannerTest, OpenGLFormats) {
+        const std::vector<int64_t> formats = {GL_RGBA16F, GL_SRGB8_ALPHA8, GL_RGBA8};
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, formats));
+
+        EXPECT_EQ(plan.format, GL_RGBA8);
+    }
+
+    TEST(SwapchainPlannerTest, VulkanFormats) {
+        // VK_FORMAT_R16G16B16A16_UNORM has the value of DXGI_FORMAT_B8G8R8A8_UNORM_SRGB.
+        const std::vector<int64_t> formats = {
+            VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM};
+        SwapchainPlannerInput input = makeInput(PassthroughQuality::Balanced, formats);
+        input.formatApi = SwapchainFormatApi::Vulkan;
+        const SwapchainPlan plan = planPassthroughSwapchain(input);
+
+        EXPECT_EQ(plan.format, VK_FORMAT_B8G8R8A8_UNORM);
+        EXPECT_TRUE(getSwapchainFormatInfo(plan.format, SwapchainFormatApi::Vulkan)->isBGRA);
+    }
+
+    TEST(SwapchainPlannerTest, UnknownFormatsFallBackToPreferred) {
+        const std::vector<int64_t> formats = {DXGI_FORMAT_D32_FLOAT, DXGI_FORMAT_R8_UNORM};
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, formats));
+
+        EXPECT_EQ(plan.format, DXGI_FORMAT_D32_FLOAT);
+    }
+
+    TEST(SwapchainPlannerTest, NoFormat) {
+        const SwapchainPlan plan = planPassthroughSwapchain(makeInput(PassthroughQuality::Balanced, {}));
+
+        EXPECT_EQ(plan.format, 0);
+        EXPECT_NEAR(plan.height, 672u, 1);
+    }
+
+} // namespace
@@ -0,0 +1,219 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <swapchain_tracker.h>
+
+#include "mock_openxr.h"
+
+namespace {
+
+    using namespace passthrough;
+
+    const XrSwapchain Swapchain = reinterpret_cast<XrSwapchain>(1);
+    const XrSwapchain OtherSwapchain = reinterpret_cast<XrSwapchain>(2);
+    constexpr uint32_t ImageCount = 3;
+
+    // The runtime hands out the images in order, and fails the releases that do not match an acquire, like a
+    // conformant runtime would.
+    class SwapchainTrackerTest : public ::testing::Test {
+      protected:
+        void SetUp() override {
+            m_openXR.runtime.xrAcquireSwapchainImageHook =
+                [this](XrSwapchain swapchain,
+                       const XrSwapchainImageAcquireInfo* acquireInfo,
+                       uint32_t* index) -> XrResult {
+                    RuntimeSwapchain& runtimeSwapchain = m_runtimeSwapchains[swapchain];
+                    if (runtimeSwapchain.acquiredCount == ImageCount) {
+                        return XR_ERROR_CALL_ORDER_INVALID;
+                    }
+                    *index = runtimeSwapchain.nextIndex;
+                    runtimeSwapchain.nextIndex = (runtimeSwapchain.nextIndex + 1) % ImageCount;
+                    runtimeSwapchain.acquiredCount++;
+                    return XR_SUCCESS;
+                };
+            m_openXR.runtime.xrReleaseSwapchainImageHook =
+                [this](XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) -> XrResult {
+                    RuntimeSwapchain& runtimeSwapchain = m_runtimeSwapchains[swapchain];
+                    if (XR_FAILED(m_releaseResult)) {
+                        return m_releaseResult;
+                    }
+                    if (runtimeSwapchain.acquiredCount == 0) {
+                        return XR_ERROR_CALL_ORDER_INVALID;
+                    }
+                    runtimeSwapchain.acquiredCount--;
+                    return XR_SUCCESS;
+                };
+
+            XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+            createInfo.width = 64;
+            createInfo.height = 64;
+            m_tracker.add(Swapchain, createInfo);
+            m_tracker.add(OtherSwapchain, createInfo);
+        }
+
+        uint32_t acquire(XrSwapchain swapchain = Swapchain) {
+            XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+            uint32_t index = ~0u;
+            EXPECT_EQ(m_tracker.acquireImage(m_openXR, swapchain, &acquireInfo, &index), XR_SUCCESS);
+            return index;
+        }
+
+        XrResult release(XrSwapchain swapchain = Swapchain) {
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+            return m_tracker.releaseImage(m_openXR, swapchain, &releaseInfo);
+        }
+
+        uint32_t getRuntimeAcquiredCount(XrSwapchain swapchain = Swapchain) {
+            return m_runtimeSwapchains[swapchain].acquiredCount;
+        }
+
+        struct RuntimeSwapchain {
+            uint32_t nextIndex{0};
+            uint32_t acquiredCount{0};
+        };
+
+        test::MockOpenXrApi m_openXR;
+        std::map<XrSwapchain, RuntimeSwapchain> m_runtimeSwapchains;
+        XrResult m_releaseResult{XR_SUCCESS};
+
+        SwapchainTracker m_tracker;
+    };
+
+    TEST_F(SwapchainTrackerTest, PassesReleasesThrough) {
+        EXPECT_EQ(acquire(), 0u);
+        EXPECT_EQ(release(), XR_SUCCESS);
+        EXPECT_EQ(acquire(), 1u);
+        EXPECT_EQ(release(), XR_SUCCESS);
+
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 2u);
+        EXPECT_EQ(getRuntimeAcquiredCount(), 0u);
+
+        const std::optional<ApplicationSwapchain> swapchain = m_tracker.get(Swapchain);
+        ASSERT_TRUE(swapchain);
+        EXPECT_EQ(swapchain->acquiredImageCount, 0u);
+        EXPECT_EQ(swapchain->lastReleasedImage, 1u);
+        EXPECT_EQ(swapchain->deferredReleaseCount, 0u);
+    }
+
+    TEST_F(SwapchainTrackerTest, TracksImagesInAcquireOrder) {
+        EXPECT_EQ(acquire(), 0u);
+        EXPECT_EQ(acquire(), 1u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->acquiredImageCount, 2u);
+
+        // The oldest image is released first.
+        EXPECT_EQ(release(), XR_SUCCESS);
+        EXPECT_EQ(m_tracker.get(Swapchain)->acquiredImageCount, 1u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->lastReleasedImage, 0u);
+        EXPECT_EQ(release(), XR_SUCCESS);
+        EXPECT_EQ(m_tracker.get(Swapchain)->acquiredImageCount, 0u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->lastReleasedImage, 1u);
+    }
+
+    TEST_F(SwapchainTrackerTest, DefersReleasesOfCompositionTargets) {
+        m_tracker.setCompositionTarget(Swapchain);
+
+        EXPECT_EQ(acquire(), 0u);
+        EXPECT_EQ(release(), XR_SUCCESS);
+
+        // The image is still held by the layer, and remains the one to draw into.
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 0u);
+        EXPECT_EQ(getRuntimeAcquiredCount(), 1u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->deferredReleaseCount, 1u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->lastReleasedImage, 0u);
+
+        // Other swapchains are not held back.
+        acquire(OtherSwapchain);
+        EXPECT_EQ(release(OtherSwapchain), XR_SUCCESS);
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 1u);
+    }
+
+    TEST_F(SwapchainTrackerTest, FlushesDeferredReleasesBeforeAcquire) {
+        m_tracker.setCompositionTarget(Swapchain);
+        acquire();
+        release();
+
+        m_openXR.runtime.recordCalls = true;
+        EXPECT_EQ(acquire(), 1u);
+
+        // The application must wait on the image it just acquired, which requires the previous one to be released.
+        ASSERT_EQ(m_openXR.runtime.callLog.size(), 2u);
+        EXPECT_STREQ(m_openXR.runtime.callLog[0], "xrReleaseSwapchainImage");
+        EXPECT_STREQ(m_openXR.runtime.callLog[1], "xrAcquireSwapchainImage");
+        EXPECT_EQ(getRuntimeAcquiredCount(), 1u);
+        EXPECT_EQ(m_tracker.get(Swapchain)->deferredReleaseCount, 0u);
+    }
+
+    TEST_F(SwapchainTrackerTest, FlushesAllDeferredReleases) {
+        m_tracker.setCompositionTarget(Swapchain);
+        m_tracker.setCompositionTarget(OtherSwapchain);
+        acquire();
+        release();
+        acquire(OtherSwapchain);
+        release(OtherSwapchain);
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 0u);
+
+        EXPECT_EQ(m_tracker.flushDeferredReleases(m_openXR), XR_SUCCESS);
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 2u);
+        EXPECT_EQ(getRuntimeAcquiredCount(Swapchain), 0u);
+        EXPECT_EQ(getRuntimeAcquiredCount(OtherSwapchain), 0u);
+
+        // Nothing is released twice.
+        EXPECT_EQ(m_tracker.flushDeferredReleases(m_openXR), XR_SUCCESS);
+        EXPECT_EQ(acquire(), 1u);
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 2u);
+    }
+
+    TEST_F(SwapchainTrackerTest, ReportsReleaseErrors) {
+        m_tracker.setCompositionTarget(Swapchain);
+        acquire();
+        release();
+
+        m_releaseResult = XR_ERROR_SESSION_LOST;
+        EXPECT_EQ(m_tracker.flushDeferredReleases(m_openXR), XR_ERROR_SESSION_LOST);
+
+        acquire();
+        release();
+        XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+        uint32_t index;
+        EXPECT_EQ(m_tracker.acquireImage(m_openXR, Swapchain, &acquireInfo, &index), XR_ERROR_SESSION_LOST);
+
+        // The image is not acquired after the failed release.
+        EXPECT_EQ(m_openXR.runtime.xrAcquireSwapchainImageCount, 2u);
+
+        m_releaseResult = XR_SUCCESS;
+        m_tracker.remove(Swapchain);
+        EXPECT_EQ(release(), XR_SUCCESS);
+    }
+
+    TEST_F(SwapchainTrackerTest, IgnoresUntrackedSwapchains) {
+        m_tracker.remove(Swapchain);
+        m_tracker.setCompositionTarget(Swapchain);
+
+        EXPECT_EQ(acquire(), 0u);
+        EXPECT_EQ(release(), XR_SUCCESS);
+        EXPECT_EQ(m_openXR.runtime.xrReleaseSwapchainImageCount, 1u);
+        EXPECT_FALSE(m_tracker.get(Swapchain));
+    }
+
+} // namespace
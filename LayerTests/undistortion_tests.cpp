@@ -0,0 +1,191 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <graphics_backend.h>
+#include <undistortion.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    // The image from one camera.
+    constexpr uint32_t Width = 64;
+    constexpr uint32_t Height = 48;
+    constexpr float Aspect = (float)Width / Height;
+
+    // The color of a black destination pixel, outside of the camera image.
+    constexpr uint32_t Black = 0xff000000;
+
+    class UndistortionTest : public ::testing::Test {
+      protected:
+        void SetUp() override {
+            for (uint32_t i = 0; i < 256; i++) {
+                m_palette[i] = i;
+            }
+        }
+
+        // Fill each quarter of the image with its own value: 10 top-left, 20 top-right, 30 bottom-left, 40
+        // bottom-right.
+        void fillQuarters() {
+            for (uint32_t y = 0; y < Height; y++) {
+                for (uint32_t x = 0; x < Width; x++) {
+                    m_source[y][x] = (uint8_t)(10 + (x >= Width / 2 ? 10 : 0) + (y >= Height / 2 ? 20 : 0));
+                }
+            }
+        }
+
+        void undistort(const UndistortionMap& map) {
+            ASSERT_EQ(map.getWidth(), Width);
+            ASSERT_EQ(map.getHeight(), Height);
+            map.undistort(&m_source[0][0], Width, m_palette, &m_destination[0][0], Width * sizeof(uint32_t));
+        }
+
+        uint8_t m_source[Height][Width]{};
+        uint32_t m_palette[256];
+        uint32_t m_destination[Height][Width]{};
+    };
+
+    TEST_F(UndistortionTest, ExtentWithoutDistortion) {
+        const XrExtent2Df extent = getUndistortedExtent(0.f, 0.f, Aspect);
+
+        EXPECT_NEAR(extent.width, Aspect, 1e-5f);
+        EXPECT_NEAR(extent.height, 1.f, 1e-5f);
+    }
+
+    TEST_F(UndistortionTest, ExtentIsReachedInTheCorners) {
+        // With k1 < 0, the image is stretched more further from the center.
+        const float k1 = -0.65f;
+        const XrExtent2Df extent = getUndistortedExtent(k1, 0.f, Aspect);
+
+        const float cornerRadiusSquared = Aspect * Aspect / 4.f + 0.25f;
+        const float cornerScale = 1.f / (1.f + k1 * cornerRadiusSquared);
+        EXPECT_NEAR(extent.width, Aspect * cornerScale, 1e-4f);
+        EXPECT_NEAR(extent.height, cornerScale, 1e-4f);
+    }
+
+    TEST_F(UndistortionTest, IdentityWithoutDistortion) {
+        for (uint32_t y = 0; y < Height; y++) {
+            for (uint32_t x = 0; x < Width; x++) {
+                m_source[y][x] = (uint8_t)(x * 3 + y);
+            }
+        }
+
+        undistort(UndistortionMap(0.f, 0.f, getUndistortedExtent(0.f, 0.f, Aspect), Width, Height, Width, Height));
+
+        // The last row and column are sampled from their neighbor, to keep the bilinear footprint within the image.
+        for (uint32_t y = 0; y < Height - 1; y++) {
+            for (uint32_t x = 0; x < Width - 1; x++) {
+                ASSERT_EQ(m_destination[y][x], m_source[y][x]) << x << "," << y;
+            }
+        }
+    }
+
+    TEST_F(UndistortionTest, KnownPoints) {
+        const float k1 = -0.65f;
+        fillQuarters();
+
+        undistort(UndistortionMap(k1, 0.f, getUndistortedExtent(k1, 0.f, Aspect), Width, Height, Width, Height));
+
+        // The corners of the camera image are displayed in the corners of the extent.
+        EXPECT_EQ(m_destination[0][0], 10u);
+        EXPECT_EQ(m_destination[0][Width - 1], 20u);
+        EXPECT_EQ(m_destination[Height - 1][0], 30u);
+        EXPECT_EQ(m_destination[Height - 1][Width - 1], 40u);
+
+        // The center stays in the center.
+        EXPECT_EQ(m_destination[Height / 2 - 1][Width / 2 - 1], 10u);
+        EXPECT_EQ(m_destination[Height / 2][Width / 2], 40u);
+
+        // The middle of the edges is pulled inwards, leaving black borders.
+        EXPECT_EQ(m_destination[0][Width / 2], Black);
+        EXPECT_EQ(m_destination[Height - 1][Width / 2], Black);
+        EXPECT_EQ(m_destination[Height / 2][0], Black);
+        EXPECT_EQ(m_destination[Height / 2][Width - 1], Black);
+    }
+
+    TEST_F(UndistortionTest, SamplesOnlySourceWidth) {
+        // The rows of the source are twice as wide, their right half is not shown.
+        uint8_t source[Height][2 * Width];
+        for (uint32_t y = 0; y < Height; y++) {
+            for (uint32_t x = 0; x < 2 * Width; x++) {
+                source[y][x] = x < Width ? 50 : 200;
+            }
+        }
+
+        const UndistortionMap map(0.f, 0.f, getUndistortedExtent(0.f, 0.f, Aspect), Width, Height, Width, Height);
+        map.undistort(&source[0][0], 2 * Width, m_palette, &m_destination[0][0], Width * sizeof(uint32_t));
+
+        for (uint32_t y = 0; y < Height; y++) {
+            for (uint32_t x = 0; x < Width; x++) {
+                ASSERT_EQ(m_destination[y][x], 50u) << x << "," << y;
+            }
+        }
+    }
+
+    class PassthroughQuadLayerTest : public ::testing::Test {
+      protected:
+        HeadsetCameraCalibration m_calibration;
+        XrExtent2Df m_extent{1.5f, 1.1f};
+    };
+
+    TEST_F(PassthroughQuadLayerTest, PlacedInFrontOfEachEye) {
+        const XrPosef eyePose = xr::math::Pose::Identity();
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            XrCompositionLayerQuad layer{XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr};
+            placePassthroughQuadLayer(layer, eye, eyePose, m_calibration, m_extent);
+
+            const float sign = eye ? 1.f : -1.f;
+            EXPECT_EQ(layer.eyeVisibility, eye ? XR_EYE_VISIBILITY_RIGHT : XR_EYE_VISIBILITY_LEFT);
+            EXPECT_NEAR(layer.pose.position.x, sign * 0.241f * 1.9f, 1e-5f);
+            EXPECT_NEAR(layer.pose.position.y, -0.178f * 1.9f, 1e-5f);
+            EXPECT_NEAR(layer.pose.position.z, -1.f, 1e-5f);
+            EXPECT_NEAR(layer.size.width, 1.5f * 1.9f, 1e-5f);
+            EXPECT_NEAR(layer.size.height, 1.1f * 1.9f, 1e-5f);
+
+            // The cant of the cameras, mirrored for the two eyes.
+            const XrQuaternionf expected = xr::math::Quaternion::RotationRollPitchYaw(
+                {m_calibration.EyeCantX, sign * m_calibration.EyeCantY, sign * m_calibration.EyeCantZ});
+            EXPECT_NEAR(layer.pose.orientation.x, expected.x, 1e-5f);
+            EXPECT_NEAR(layer.pose.orientation.y, expected.y, 1e-5f);
+            EXPECT_NEAR(layer.pose.orientation.z, expected.z, 1e-5f);
+            EXPECT_NEAR(layer.pose.orientation.w, expected.w, 1e-5f);
+        }
+    }
+
+    TEST_F(PassthroughQuadLayerTest, FollowsTheEye) {
+        // The eye is turned 90 degrees to the left, and raised.
+        XrPosef eyePose;
+        eyePose.orientation = xr::math::Quaternion::RotationAxisAngle({0.f, 1.f, 0.f}, DirectX::XM_PIDIV2);
+        eyePose.position = {0.f, 1.6f, 0.f};
+
+        XrCompositionLayerQuad layer{XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr};
+        placePassthroughQuadLayer(layer, 0, eyePose, m_calibration, m_extent);
+
+        // In front of the eye is now -X, and the left of the eye is +Z.
+        EXPECT_NEAR(layer.pose.position.x, -1.f, 1e-5f);
+        EXPECT_NEAR(layer.pose.position.y, 1.6f - 0.178f * 1.9f, 1e-5f);
+        EXPECT_NEAR(layer.pose.position.z, 0.241f * 1.9f, 1e-5f);
+    }
+
+} // namespace
@@ -0,0 +1,178 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <upload_ring.h>
+
+namespace {
+
+    using namespace passthrough;
+
+    // What the GPU did with one slot. The state outlives the fences, which the ring owns.
+    struct FakeFenceState {
+        bool isCompleted{true};
+        uint32_t waitCount{0};
+    };
+
+    class FakeFence {
+      public:
+        FakeFence(FakeFenceState& state) : m_state(&state) {
+        }
+
+        bool isCompleted() {
+            return m_state->isCompleted;
+        }
+
+        void wait() {
+            m_state->waitCount++;
+            m_state->isCompleted = true;
+        }
+
+      private:
+        FakeFenceState* m_state;
+    };
+
+    class UploadRingTest : public ::testing::Test {
+      protected:
+        void reset(uint32_t size) {
+            m_states = std::make_unique<FakeFenceState[]>(size);
+            std::vector<FakeFence> fences;
+            for (uint32_t i = 0; i < size; i++) {
+                fences.emplace_back(m_states[i]);
+            }
+            m_ring.reset(std::move(fences));
+        }
+
+        // Write to the next slot and queue its copy, which the GPU has not done yet.
+        uint32_t upload() {
+            const uint32_t slot = m_ring.acquire();
+            m_states[slot].isCompleted = false;
+            m_ring.submit(slot);
+            return slot;
+        }
+
+        UploadRing<FakeFence> m_ring;
+        std::unique_ptr<FakeFenceState[]> m_states;
+    };
+
+    TEST_F(UploadRingTest, UsesSlotsInOrder) {
+        reset(3);
+        for (uint32_t i = 0; i < 7; i++) {
+            const uint32_t slot = m_ring.acquire();
+            EXPECT_EQ(slot, i % 3);
+            m_ring.submit(slot);
+        }
+
+        // The copies were always done before the slots came around again.
+        const UploadRingStatistics& statistics = m_ring.getStatistics();
+        EXPECT_EQ(statistics.acquireCount, 7u);
+        EXPECT_EQ(statistics.submitCount, 7u);
+        EXPECT_EQ(statistics.stallCount, 0u);
+        EXPECT_EQ(statistics.inFlightMax, 0u);
+    }
+
+    TEST_F(UploadRingTest, WaitsOnlyWhenAllSlotsAreInFlight) {
+        reset(3);
+        upload();
+        upload();
+        EXPECT_EQ(m_ring.getInFlightCount(), 2u);
+
+        // One slot is still free.
+        EXPECT_EQ(upload(), 2u);
+        EXPECT_EQ(m_states[0].waitCount, 0u);
+        EXPECT_EQ(m_ring.getStatistics().stallCount, 0u);
+
+        // The oldest slot is reused, once its copy is done.
+        EXPECT_EQ(m_ring.acquire(), 0u);
+        EXPECT_EQ(m_states[0].waitCount, 1u);
+        EXPECT_EQ(m_states[1].waitCount, 0u);
+        EXPECT_EQ(m_states[2].waitCount, 0u);
+        EXPECT_EQ(m_ring.getStatistics().stallCount, 1u);
+        EXPECT_EQ(m_ring.getStatistics().inFlightMax, 3u);
+    }
+
+    TEST_F(UploadRingTest, DoesNotWaitForCompletedCopies) {
+        reset(2);
+        upload();
+        upload();
+
+        m_states[0].isCompleted = true;
+        EXPECT_EQ(m_ring.getInFlightCount(), 1u);
+        EXPECT_EQ(m_ring.acquire(), 0u);
+        EXPECT_EQ(m_states[0].waitCount, 0u);
+        EXPECT_EQ(m_ring.getStatistics().stallCount, 0u);
+    }
+
+    TEST_F(UploadRingTest, CancelledSlotIsReused) {
+        reset(2);
+        EXPECT_EQ(m_ring.acquire(), 0u);
+        m_ring.cancel(0);
+        EXPECT_EQ(m_ring.getInFlightCount(), 0u);
+
+        EXPECT_EQ(upload(), 0u);
+        EXPECT_EQ(upload(), 1u);
+        EXPECT_EQ(m_ring.getStatistics().acquireCount, 3u);
+        EXPECT_EQ(m_ring.getStatistics().submitCount, 2u);
+    }
+
+    TEST_F(UploadRingTest, CountsSlotsInFlightOnAcquire) {
+        reset(3);
+        upload();
+        upload();
+        upload();
+
+        // 0, then 1, then 2 slots in flight.
+        EXPECT_EQ(m_ring.getStatistics().inFlightSum, 3u);
+        EXPECT_EQ(m_ring.getStatistics().inFlightMax, 2u);
+    }
+
+    TEST_F(UploadRingTest, FlushWaitsForAllCopies) {
+        reset(3);
+        upload();
+        upload();
+
+        m_ring.flush();
+        EXPECT_EQ(m_states[0].waitCount, 1u);
+        EXPECT_EQ(m_states[1].waitCount, 1u);
+        EXPECT_EQ(m_states[2].waitCount, 0u);
+        EXPECT_EQ(m_ring.getInFlightCount(), 0u);
+
+        // The next slot is unchanged.
+        EXPECT_EQ(m_ring.acquire(), 2u);
+    }
+
+    TEST_F(UploadRingTest, ResetWaitsForPreviousSlotsAndKeepsStatistics) {
+        reset(2);
+        upload();
+        const std::unique_ptr<FakeFenceState[]> previousStates = std::move(m_states);
+
+        reset(4);
+        EXPECT_EQ(previousStates[0].waitCount, 1u);
+        EXPECT_EQ(m_ring.getSize(), 4u);
+        EXPECT_EQ(m_ring.getInFlightCount(), 0u);
+        EXPECT_EQ(m_ring.acquire(), 0u);
+        EXPECT_EQ(m_ring.getStatistics().acquireCount, 2u);
+    }
+
+} // namespace
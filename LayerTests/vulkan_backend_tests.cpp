@@ -0,0 +1,506 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "pch.h"
+
+#include <graphics_backend.h>
+
+#include "mock_openxr.h"
+
+// The Vulkan functions used by the tests themselves, to create the device and the swapchain images and to read them
+// back.
+#define TEST_VK_FUNCTIONS(X)                                                                                           \
+    X(vkDestroyInstance)                                                                                               \
+    X(vkEnumeratePhysicalDevices)                                                                                      \
+    X(vkGetPhysicalDeviceQueueFamilyProperties)                                                                        \
+    X(vkGetPhysicalDeviceMemoryProperties)                                                                             \
+    X(vkCreateDevice)                                                                                                  \
+    X(vkDestroyDevice)                                                                                                 \
+    X(vkDeviceWaitIdle)                                                                                                \
+    X(vkGetDeviceQueue)                                                                                                \
+    X(vkQueueSubmit)                                                                                                   \
+    X(vkQueueWaitIdle)                                                                                                 \
+    X(vkCreateCommandPool)                                                                                             \
+    X(vkDestroyCommandPool)                                                                                            \
+    X(vkAllocateCommandBuffers)                                                                                        \
+    X(vkBeginCommandBuffer)                                                                                            \
+    X(vkEndCommandBuffer)                                                                                              \
+    X(vkCmdPipelineBarrier)                                                                                            \
+    X(vkCmdClearColorImage)                                                                                            \
+    X(vkCmdCopyImageToBuffer)                                                                                          \
+    X(vkCreateImage)                                                                                                   \
+    X(vkDestroyImage)                                                                                                  \
+    X(vkGetImageMemoryRequirements)                                                                                    \
+    X(vkBindImageMemory)                                                                                               \
+    X(vkCreateBuffer)                                                                                                  \
+    X(vkDestroyBuffer)                                                                                                 \
+    X(vkGetBufferMemoryRequirements)                                                                                   \
+    X(vkBindBufferMemory)                                                                                              \
+    X(vkAllocateMemory)                                                                                                \
+    X(vkFreeMemory)                                                                                                    \
+    X(vkMapMemory)
+
+namespace {
+
+    using namespace passthrough;
+    using namespace DirectX;
+
+    constexpr uint32_t ImageWidth = 64;
+    constexpr uint32_t ImageHeight = 64;
+    constexpr uint32_t ImageCount = 2;
+
+#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
+    const float ColorAdjustment[] = {XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT};
+#else
+    const float ColorAdjustment[] = {1.f, 1.f, 1.f};
+#endif
+
+    const XMFLOAT4X4 Identity{1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+
+    // Drive the Vulkan backend the way the layer does, with swapchain images created by the test instead of the
+    // runtime. Any Vulkan driver works, including a software one like lavapipe selected with VK_ICD_FILENAMES. The
+    // tests are skipped without a Vulkan device.
+    class VulkanBackendTest : public ::testing::Test {
+      protected:
+        void SetUp() override {
+            m_loader = LoadLibraryA("vulkan-1.dll");
+            if (!m_loader) {
+                GTEST_SKIP() << "The Vulkan loader is not installed";
+            }
+            vkGetInstanceProcAddr =
+                reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(m_loader, "vkGetInstanceProcAddr"));
+            ASSERT_NE(vkGetInstanceProcAddr, nullptr);
+
+            {
+                const auto vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(
+                    vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance"));
+                ASSERT_NE(vkCreateInstance, nullptr);
+
+                VkApplicationInfo applicationInfo{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+                applicationInfo.pApplicationName = "LayerTests";
+                applicationInfo.apiVersion = VK_API_VERSION_1_0;
+                VkInstanceCreateInfo createInfo{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+                createInfo.pApplicationInfo = &applicationInfo;
+                if (vkCreateInstance(&createInfo, nullptr, &m_instance) != VK_SUCCESS) {
+                    GTEST_SKIP() << "There is no Vulkan driver";
+                }
+            }
+#define LOAD_VK_FUNCTION(name)                                                                                         \
+    name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(m_instance, #name));                                     \
+    ASSERT_NE(name, nullptr) << #name;
+            TEST_VK_FUNCTIONS(LOAD_VK_FUNCTION)
+#undef LOAD_VK_FUNCTION
+
+            {
+                uint32_t count = 0;
+                vkEnumeratePhysicalDevices(m_instance, &count, nullptr);
+                if (count == 0) {
+                    GTEST_SKIP() << "There is no Vulkan device";
+                }
+                std::vector<VkPhysicalDevice> physicalDevices(count);
+                ASSERT_EQ(vkEnumeratePhysicalDevices(m_instance, &count, physicalDevices.data()), VK_SUCCESS);
+                m_physicalDevice = physicalDevices[0];
+                vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+
+                vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, nullptr);
+                std::vector<VkQueueFamilyProperties> queueFamilies(count);
+                vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &count, queueFamilies.data());
+                m_queueFamilyIndex = 0;
+                while (m_queueFamilyIndex < count &&
+                       !(queueFamilies[m_queueFamilyIndex].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                    m_queueFamilyIndex++;
+                }
+                if (m_queueFamilyIndex == count) {
+                    GTEST_SKIP() << "The Vulkan device cannot draw";
+                }
+            }
+            {
+                const float priority = 1.f;
+                VkDeviceQueueCreateInfo queueInfo{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+                queueInfo.queueFamilyIndex = m_queueFamilyIndex;
+                queueInfo.queueCount = 1;
+                queueInfo.pQueuePriorities = &priority;
+                VkDeviceCreateInfo createInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+                createInfo.queueCreateInfoCount = 1;
+                createInfo.pQueueCreateInfos = &queueInfo;
+                ASSERT_EQ(vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device), VK_SUCCESS);
+                vkGetDeviceQueue(m_device, m_queueFamilyIndex, 0, &m_queue);
+            }
+            {
+                VkCommandPoolCreateInfo createInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+                createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+                createInfo.queueFamilyIndex = m_queueFamilyIndex;
+                ASSERT_EQ(vkCreateCommandPool(m_device, &createInfo, nullptr, &m_commandPool), VK_SUCCESS);
+
+                VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+                allocateInfo.commandPool = m_commandPool;
+                allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                allocateInfo.commandBufferCount = 1;
+                ASSERT_EQ(vkAllocateCommandBuffers(m_device, &allocateInfo, &m_commandBuffer), VK_SUCCESS);
+            }
+
+            createSwapchainImages();
+            {
+                VkBufferCreateInfo createInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+                createInfo.size = ImageWidth * ImageHeight * sizeof(uint32_t);
+                createInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+                createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                ASSERT_EQ(vkCreateBuffer(m_device, &createInfo, nullptr, &m_readbackBuffer), VK_SUCCESS);
+
+                VkMemoryRequirements requirements;
+                vkGetBufferMemoryRequirements(m_device, m_readbackBuffer, &requirements);
+                m_readbackMemory = allocateMemory(
+                    requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+                ASSERT_EQ(vkBindBufferMemory(m_device, m_readbackBuffer, m_readbackMemory, 0), VK_SUCCESS);
+                ASSERT_EQ(vkMapMemory(m_device, m_readbackMemory, 0, VK_WHOLE_SIZE, 0, &m_readbackData), VK_SUCCESS);
+            }
+
+            m_backend = createVulkanBackend(m_instance, m_physicalDevice, m_device, m_queueFamilyIndex, 0);
+            ASSERT_TRUE(m_backend);
+
+            m_openXR.runtime.xrEnumerateSwapchainImagesHook = [&](XrSwapchain swapchain,
+                                                                  uint32_t imageCapacityInput,
+                                                                  uint32_t* imageCountOutput,
+                                                                  XrSwapchainImageBaseHeader* images) {
+                *imageCountOutput = ImageCount;
+                if (imageCapacityInput < ImageCount) {
+                    return imageCapacityInput ? XR_ERROR_SIZE_INSUFFICIENT : XR_SUCCESS;
+                }
+                XrSwapchainImageVulkanKHR* const vkImages = reinterpret_cast<XrSwapchainImageVulkanKHR*>(images);
+                for (uint32_t i = 0; i < ImageCount; i++) {
+                    vkImages[i].image = m_images[i];
+                }
+                return XR_SUCCESS;
+            };
+
+            XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+            createInfo.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+            createInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+            createInfo.sampleCount = 1;
+            createInfo.width = ImageWidth;
+            createInfo.height = ImageHeight;
+            createInfo.faceCount = 1;
+            createInfo.arraySize = ViewCount;
+            createInfo.mipCount = 1;
+            m_backend->importSwapchainImages(m_openXR, reinterpret_cast<XrSwapchain>(1), createInfo);
+        }
+
+        void TearDown() override {
+            // Destroying the backend waits for its submissions.
+            m_backend.reset();
+
+            if (m_device != VK_NULL_HANDLE) {
+                vkDeviceWaitIdle(m_device);
+                for (uint32_t i = 0; i < ImageCount; i++) {
+                    vkDestroyImage(m_device, m_images[i], nullptr);
+                    vkFreeMemory(m_device, m_imageMemory[i], nullptr);
+                }
+                vkDestroyBuffer(m_device, m_readbackBuffer, nullptr);
+                vkFreeMemory(m_device, m_readbackMemory, nullptr);
+                vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+                vkDestroyDevice(m_device, nullptr);
+            }
+            if (m_instance != VK_NULL_HANDLE) {
+                vkDestroyInstance(m_instance, nullptr);
+            }
+            if (m_loader) {
+                FreeLibrary(m_loader);
+            }
+        }
+
+        void createDrawingResources() {
+            const std::unique_ptr<IShaderCompiler> compiler = m_backend->createShaderCompiler();
+            const ShaderDescription vs = m_backend->getVertexShader();
+            const ShaderDescription ps = m_backend->getPixelShader();
+
+            // A quad covering the whole view.
+            std::vector<VertexPositionTexture> vertices[ViewCount];
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                vertices[eye] = {{{-1.f, -1.f, 0.f}, {0.f, 1.f}},
+                                 {{-1.f, 1.f, 0.f}, {0.f, 0.f}},
+                                 {{1.f, 1.f, 0.f}, {1.f, 0.f}},
+                                 {{1.f, -1.f, 0.f}, {1.f, 1.f}}};
+            }
+            m_backend->createDrawingResources(compiler->compile(vs.source, vs.entryPoint, vs.target, vs.flags),
+                                              compiler->compile(ps.source, ps.entryPoint, ps.target, ps.flags),
+                                              vertices,
+                                              {0, 1, 2, 2, 3, 0});
+        }
+
+        // Fill the camera texture with a uniform intensity.
+        void uploadCameraImage(uint8_t intensity, bool commit = true) {
+            uint32_t pitch;
+            uint8_t* const data = m_backend->mapCameraTexture(8, 8, pitch);
+            for (uint32_t y = 0; y < 8; y++) {
+                memset(data + y * pitch, intensity, 8);
+            }
+            m_backend->unmapCameraTexture(commit);
+        }
+
+        // Copy one slice of a swapchain image to the CPU, once the GPU is done with the previous submissions.
+        std::vector<uint32_t> readSlice(uint32_t imageIndex, uint32_t slice) {
+            beginCommands();
+            barrier(m_images[imageIndex],
+                    slice,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_ACCESS_TRANSFER_READ_BIT);
+            VkBufferImageCopy region{};
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.baseArrayLayer = slice;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent = {ImageWidth, ImageHeight, 1};
+            vkCmdCopyImageToBuffer(m_commandBuffer,
+                                   m_images[imageIndex],
+                                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                   m_readbackBuffer,
+                                   1,
+                                   &region);
+            barrier(m_images[imageIndex],
+                    slice,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                    0,
+                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+            submitCommands();
+
+            const uint32_t* const pixels = reinterpret_cast<const uint32_t*>(m_readbackData);
+            return {pixels, pixels + ImageWidth * ImageHeight};
+        }
+
+        test::MockOpenXrApi m_openXR;
+        std::unique_ptr<IGraphicsBackend> m_backend;
+
+      private:
+        // The images are handed to the layer in the color attachment layout, cleared to transparent black.
+        void createSwapchainImages() {
+            beginCommands();
+            for (uint32_t i = 0; i < ImageCount; i++) {
+                VkImageCreateInfo createInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+                createInfo.imageType = VK_IMAGE_TYPE_2D;
+                createInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+                createInfo.extent = {ImageWidth, ImageHeight, 1};
+                createInfo.mipLevels = 1;
+                createInfo.arrayLayers = ViewCount;
+                createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+                createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+                createInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                                   VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                ASSERT_EQ(vkCreateImage(m_device, &createInfo, nullptr, &m_images[i]), VK_SUCCESS);
+
+                VkMemoryRequirements requirements;
+                vkGetImageMemoryRequirements(m_device, m_images[i], &requirements);
+                m_imageMemory[i] = allocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                ASSERT_EQ(vkBindImageMemory(m_device, m_images[i], m_imageMemory[i], 0), VK_SUCCESS);
+
+                for (uint32_t slice = 0; slice < ViewCount; slice++) {
+                    barrier(m_images[i],
+                            slice,
+                            VK_IMAGE_LAYOUT_UNDEFINED,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            0,
+                            VK_ACCESS_TRANSFER_WRITE_BIT);
+                    const VkClearColorValue black{};
+                    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, slice, 1};
+                    vkCmdClearColorImage(
+                        m_commandBuffer, m_images[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &black, 1, &range);
+                    barrier(m_images[i],
+                            slice,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                            VK_ACCESS_TRANSFER_WRITE_BIT,
+                            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+                }
+            }
+            submitCommands();
+        }
+
+        VkDeviceMemory allocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags) {
+            VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+            allocateInfo.allocationSize = requirements.size;
+            while (!(requirements.memoryTypeBits & (1u << allocateInfo.memoryTypeIndex)) ||
+                   (m_memoryProperties.memoryTypes[allocateInfo.memoryTypeIndex].propertyFlags & flags) != flags) {
+                allocateInfo.memoryTypeIndex++;
+            }
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            EXPECT_EQ(vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory), VK_SUCCESS);
+            return memory;
+        }
+
+        void beginCommands() {
+            VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            EXPECT_EQ(vkBeginCommandBuffer(m_commandBuffer, &beginInfo), VK_SUCCESS);
+        }
+
+        // The commands are submitted after the ones of the backend, on the same queue.
+        void submitCommands() {
+            EXPECT_EQ(vkEndCommandBuffer(m_commandBuffer), VK_SUCCESS);
+            VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &m_commandBuffer;
+            EXPECT_EQ(vkQueueSubmit(m_queue, 1, &submitInfo, VK_NULL_HANDLE), VK_SUCCESS);
+            EXPECT_EQ(vkQueueWaitIdle(m_queue), VK_SUCCESS);
+        }
+
+        void barrier(VkImage image,
+                     uint32_t slice,
+                     VkImageLayout oldLayout,
+                     VkImageLayout newLayout,
+                     VkAccessFlags srcAccessMask,
+                     VkAccessFlags dstAccessMask) {
+            VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+            barrier.srcAccessMask = srcAccessMask;
+            barrier.dstAccessMask = dstAccessMask;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, slice, 1};
+            vkCmdPipelineBarrier(m_commandBuffer,
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0,
+                                 0,
+                                 nullptr,
+                                 0,
+                                 nullptr,
+                                 1,
+                                 &barrier);
+        }
+
+        HMODULE m_loader{nullptr};
+        PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr{nullptr};
+#define DECLARE_VK_FUNCTION(name) PFN_##name name{nullptr};
+        TEST_VK_FUNCTIONS(DECLARE_VK_FUNCTION)
+#undef DECLARE_VK_FUNCTION
+
+        VkInstance m_instance{VK_NULL_HANDLE};
+        VkPhysicalDevice m_physicalDevice{VK_NULL_HANDLE};
+        VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+        uint32_t m_queueFamilyIndex{0};
+        VkDevice m_device{VK_NULL_HANDLE};
+        VkQueue m_queue{VK_NULL_HANDLE};
+        VkCommandPool m_commandPool{VK_NULL_HANDLE};
+        VkCommandBuffer m_commandBuffer{VK_NULL_HANDLE};
+        VkImage m_images[ImageCount]{};
+        VkDeviceMemory m_imageMemory[ImageCount]{};
+        VkBuffer m_readbackBuffer{VK_NULL_HANDLE};
+        VkDeviceMemory m_readbackMemory{VK_NULL_HANDLE};
+        void* m_readbackData{nullptr};
+    };
+
+    uint8_t getChannel(uint32_t pixel, uint32_t channel) {
+        return (pixel >> (channel * 8)) & 0xff;
+    }
+
+    TEST_F(VulkanBackendTest, DrawsCameraImageIntoBothViews) {
+        createDrawingResources();
+        uploadCameraImage(200);
+        const XMFLOAT4X4 modelViewProjection[ViewCount] = {Identity, Identity};
+        m_backend->drawPassthroughLayer(1, modelViewProjection);
+
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            const std::vector<uint32_t> pixels = readSlice(1, eye);
+            const uint32_t center = pixels[ImageHeight / 2 * ImageWidth + ImageWidth / 2];
+            for (const uint32_t pixel : {pixels.front(), center, pixels.back()}) {
+                for (uint32_t channel = 0; channel < 3; channel++) {
+                    EXPECT_NEAR(getChannel(pixel, channel), 200 * ColorAdjustment[channel], 2) << "eye " << eye;
+                }
+                EXPECT_EQ(getChannel(pixel, 3), 255) << "eye " << eye;
+            }
+        }
+
+        // The other image is untouched.
+        EXPECT_EQ(readSlice(0, 0), std::vector<uint32_t>(ImageWidth * ImageHeight, 0));
+    }
+
+    TEST_F(VulkanBackendTest, DrawsNothingWithoutCameraImage) {
+        createDrawingResources();
+        const XMFLOAT4X4 modelViewProjection[ViewCount] = {Identity, Identity};
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+
+        // A cancelled upload is not a camera image either.
+        uploadCameraImage(200, false);
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+
+        EXPECT_EQ(readSlice(0, 0), std::vector<uint32_t>(ImageWidth * ImageHeight, 0));
+        EXPECT_EQ(readSlice(0, 1), std::vector<uint32_t>(ImageWidth * ImageHeight, 0));
+    }
+
+    TEST_F(VulkanBackendTest, RedrawUsesLatestCameraImage) {
+        createDrawingResources();
+        const XMFLOAT4X4 modelViewProjection[ViewCount] = {Identity, Identity};
+        uploadCameraImage(100);
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+
+        // The draw recorded for the image is submitted again, with the new camera image.
+        uploadCameraImage(200);
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+
+        const std::vector<uint32_t> pixels = readSlice(0, 0);
+        EXPECT_NEAR(getChannel(pixels[0], 0), 200 * ColorAdjustment[0], 2);
+    }
+
+    TEST_F(VulkanBackendTest, FadesCameraImageWithOpacity) {
+        createDrawingResources();
+        uploadCameraImage(200);
+        const XMFLOAT4X4 modelViewProjection[ViewCount] = {Identity, Identity};
+        m_backend->setOpacity(0.5f);
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+
+        // The layer stays opaque, it is faded to black instead.
+        const std::vector<uint32_t> pixels = readSlice(0, 0);
+        for (uint32_t channel = 0; channel < 3; channel++) {
+            EXPECT_NEAR(getChannel(pixels[0], channel), 100 * ColorAdjustment[channel], 2);
+        }
+        EXPECT_EQ(getChannel(pixels[0], 3), 255);
+
+        // The opacity is read by the recorded draw when submitted.
+        m_backend->setOpacity(1.f);
+        m_backend->drawPassthroughLayer(0, modelViewProjection);
+        EXPECT_NEAR(getChannel(readSlice(0, 0)[0], 0), 200 * ColorAdjustment[0], 2);
+    }
+
+    TEST_F(VulkanBackendTest, UploadsSwapchainImage) {
+        // The rows of the source are further apart than the rows of the image.
+        constexpr uint32_t SourcePitch = ImageWidth + 4;
+        std::vector<uint32_t> source(SourcePitch * ImageHeight);
+        std::vector<uint32_t> expected(ImageWidth * ImageHeight);
+        for (uint32_t y = 0; y < ImageHeight; y++) {
+            for (uint32_t x = 0; x < ImageWidth; x++) {
+                source[y * SourcePitch + x] = expected[y * ImageWidth + x] = 0xff000000 | (y << 8) | x;
+            }
+        }
+
+        m_backend->uploadSwapchainImage(0, 1, source.data(), SourcePitch * sizeof(uint32_t));
+
+        EXPECT_EQ(readSlice(0, 1), expected);
+        EXPECT_EQ(readSlice(0, 0), std::vector<uint32_t>(ImageWidth * ImageHeight, 0));
+    }
+
+} // namespace
@@ -0,0 +1,192 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "allocation_tracker.h"
+#include "layer.h"
+#include "log.h"
+
+#ifdef XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+
+namespace passthrough::allocation {
+
+    using namespace passthrough::log;
+
+    namespace {
+
+        // Number of distinct tags that can be tracked. The first slot collects the allocations made outside of any
+        // scope, and the allocations with a tag that did not fit.
+        constexpr uint32_t MaxScopes = 32;
+
+        struct ScopeStatistics {
+            std::atomic<const char*> tag{nullptr};
+            std::atomic<uint64_t> allocationCount{0};
+            std::atomic<uint64_t> allocationBytes{0};
+
+            // Only accessed by EndFrame() and DumpAllocationStatistics().
+            uint64_t lastAllocationCount{0};
+            uint64_t lastAllocationBytes{0};
+            uint64_t maxFrameAllocationCount{0};
+            uint64_t maxFrameAllocationBytes{0};
+            uint64_t steadyStateFramesWithAllocations{0};
+        };
+
+        // The statistics must not allocate memory themselves, hence the fixed-size storage.
+        ScopeStatistics g_scopes[MaxScopes];
+        uint64_t g_frameIndex = 0;
+        uint64_t g_steadyStateAllocationCount = 0;
+
+        thread_local const char* t_currentTag = nullptr;
+
+        ScopeStatistics& getScope(const char* tag) {
+            if (!tag) {
+                return g_scopes[0];
+            }
+
+            for (uint32_t i = 1; i < MaxScopes; i++) {
+                const char* current = g_scopes[i].tag.load(std::memory_order_acquire);
+                if (!current && g_scopes[i].tag.compare_exchange_strong(current, tag, std::memory_order_acq_rel)) {
+                    return g_scopes[i];
+                }
+                if (current == tag) {
+                    return g_scopes[i];
+                }
+            }
+            return g_scopes[0];
+        }
+
+        void recordAllocation(size_t size) {
+            ScopeStatistics& scope = getScope(t_currentTag);
+            scope.allocationCount.fetch_add(1, std::memory_order_relaxed);
+            scope.allocationBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        const char* getTagName(const ScopeStatistics& scope) {
+            const char* tag = scope.tag.load(std::memory_order_acquire);
+            return tag ? tag : "(no scope)";
+        }
+
+    } // namespace
+
+    AllocationScope::AllocationScope(const char* tag) : m_previousTag(t_currentTag) {
+        t_currentTag = tag;
+    }
+
+    AllocationScope::~AllocationScope() {
+        t_currentTag = m_previousTag;
+    }
+
+    void EndFrame() {
+        g_frameIndex++;
+
+        for (uint32_t i = 0; i < MaxScopes; i++) {
+            ScopeStatistics& scope = g_scopes[i];
+
+            const uint64_t allocationCount = scope.allocationCount.load(std::memory_order_relaxed);
+            const uint64_t allocationBytes = scope.allocationBytes.load(std::memory_order_relaxed);
+            const uint64_t frameAllocationCount = allocationCount - scope.lastAllocationCount;
+            const uint64_t frameAllocationBytes = allocationBytes - scope.lastAllocationBytes;
+            scope.lastAllocationCount = allocationCount;
+            scope.lastAllocationBytes = allocationBytes;
+
+            if (!frameAllocationCount || g_frameIndex <= WarmupFrames) {
+                continue;
+            }
+
+            scope.maxFrameAllocationCount = std::max(scope.maxFrameAllocationCount, frameAllocationCount);
+            scope.maxFrameAllocationBytes = std::max(scope.maxFrameAllocationBytes, frameAllocationBytes);
+            scope.steadyStateFramesWithAllocations++;
+            g_steadyStateAllocationCount += frameAllocationCount;
+
+            Log("Frame %llu: %llu allocations (%llu bytes) in %s\n",
+                g_frameIndex,
+                frameAllocationCount,
+                frameAllocationBytes,
+                getTagName(scope));
+        }
+    }
+
+    uint64_t GetSteadyStateAllocationCount() {
+        return g_steadyStateAllocationCount;
+    }
+
+    void DumpAllocationStatistics() {
+        Log("Allocation statistics over %llu frames (%llu warmup frames):\n", g_frameIndex, WarmupFrames);
+        for (uint32_t i = 0; i < MaxScopes; i++) {
+            const ScopeStatistics& scope = g_scopes[i];
+
+            const uint64_t allocationCount = scope.allocationCount.load(std::memory_order_relaxed);
+            if (!allocationCount) {
+                continue;
+            }
+
+            Log("  %-24s %8llu allocations %12llu bytes, allocated during %llu steady-state frames (max %llu "
+                "allocations %llu bytes)\n",
+                getTagName(scope),
+                allocationCount,
+                scope.allocationBytes.load(std::memory_order_relaxed),
+                scope.steadyStateFramesWithAllocations,
+                scope.maxFrameAllocationCount,
+                scope.maxFrameAllocationBytes);
+        }
+    }
+
+} // namespace passthrough::allocation
+
+// Replace the global allocation functions for this module. The array and nothrow variants forward to these.
+
+void* operator new(size_t size) {
+    passthrough::allocation::recordAllocation(size);
+    void* const ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    passthrough::allocation::recordAllocation(size);
+    void* const ptr = _aligned_malloc(size ? size : 1, (size_t)alignment);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    _aligned_free(ptr);
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    _aligned_free(ptr);
+}
+
+#endif
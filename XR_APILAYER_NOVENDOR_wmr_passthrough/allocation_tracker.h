@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+#include "layer.h"
+
+namespace passthrough::allocation {
+
+    // Allocations made during the first frames are expected (lazy initialization, arena growth, etc).
+    constexpr uint64_t WarmupFrames = 300;
+
+    // Attribute the heap allocations made by the current thread to a tag until the end of the scope. Scopes can be
+    // nested, in which case the innermost tag is used. Tags must be string literals.
+    class AllocationScope {
+      public:
+        AllocationScope(const char* tag);
+        ~AllocationScope();
+
+      private:
+        const char* const m_previousTag;
+    };
+
+    // Report the allocations made since the previous frame. Called once per frame.
+    void EndFrame();
+
+    // The number of allocations reported by EndFrame() after the warm-up frames.
+    uint64_t GetSteadyStateAllocationCount();
+
+    // Log the allocation totals for each scope.
+    void DumpAllocationStatistics();
+
+} // namespace passthrough::allocation
+
+#ifdef XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+#define ALLOCATION_SCOPE(tag) const passthrough::allocation::AllocationScope allocationScope(tag)
+#else
+#define ALLOCATION_SCOPE(tag)
+#endif
@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // Run the same work repeatedly on a dedicated thread, without the cost of creating a thread each time.
+    class BackgroundTask {
+      public:
+        explicit BackgroundTask(std::function<void()> work) : m_work(std::move(work)) {
+            m_thread = std::thread([this] { run(); });
+        }
+
+        ~BackgroundTask() {
+            {
+                std::unique_lock lock(m_mutex);
+                m_isStopping = true;
+            }
+            m_condition.notify_all();
+            m_thread.join();
+        }
+
+        // Must not be called again before wait() returns.
+        void start() {
+            {
+                std::unique_lock lock(m_mutex);
+                assert(!m_isPending);
+                m_isPending = true;
+            }
+            m_condition.notify_all();
+        }
+
+        // Block until the work started last is done.
+        void wait() {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return !m_isPending; });
+        }
+
+      private:
+        void run() {
+            std::unique_lock lock(m_mutex);
+            while (true) {
+                m_condition.wait(lock, [this] { return m_isPending || m_isStopping; });
+                if (m_isStopping) {
+                    break;
+                }
+
+                lock.unlock();
+                m_work();
+                lock.lock();
+
+                m_isPending = false;
+                m_condition.notify_all();
+            }
+        }
+
+        const std::function<void()> m_work;
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_isPending{false};
+        bool m_isStopping{false};
+
+        std::thread m_thread;
+    };
+
+} // namespace passthrough
@@ -0,0 +1,396 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "camera_broker.h"
+#include "log.h"
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::log;
+
+    const wchar_t* const SharedMemoryName = L"Local\\XR_APILAYER_NOVENDOR_wmr_passthrough.camera";
+
+    // Followed by the index of the subscriber. Set by the publisher for each new image.
+    const wchar_t* const SubscriberEventName = L"Local\\XR_APILAYER_NOVENDOR_wmr_passthrough.camera.event";
+    constexpr uint32_t SharedMemoryVersion = 2;
+
+    constexpr uint32_t MaxSubscribers = 8;
+
+    // A reader can hold on to one slot while the publisher writes another, with room to spare for the readers that
+    // exited while holding a slot.
+    constexpr uint32_t SlotCount = MaxSubscribers + 2;
+    constexpr size_t MaxImageSize = 1 << 20;
+
+    // Another process may take over when the publisher did not look for a camera image for that long.
+    constexpr auto PublisherTimeout = 1s;
+
+    struct SharedSlot {
+        // Zero while the image is being written.
+        std::atomic<uint64_t> sequence;
+        uint32_t width;
+        uint32_t height;
+        uint8_t image[MaxImageSize];
+    };
+
+    struct SharedSubscriber {
+        std::atomic<uint32_t> processId;
+
+        // The sequence of the slot being read, that the publisher must not overwrite.
+        std::atomic<uint64_t> readingSequence;
+    };
+
+    // The mapping is zero-initialized upon creation, which is a valid initial state.
+    struct SharedCamera {
+        std::atomic<uint32_t> version;
+
+        std::atomic<uint32_t> publisherProcessId;
+        std::atomic<int64_t> publisherHeartbeat;
+
+        std::atomic<uint64_t> nextSequence;
+        std::atomic<uint32_t> latestSlot;
+
+        SharedSubscriber subscribers[MaxSubscribers];
+        SharedSlot slots[SlotCount];
+    };
+
+    // The camera images carry a 32 bytes tag every 23264 + 1312 - 32 bytes, see copyCameraImage() in layer.cpp.
+    size_t getRawImageSize(const core::CameraFrame& frame) {
+        const size_t size = (size_t)frame.Width * frame.Height;
+        return size + 32 * (size / (23264 + 1312 - 32) + 1);
+    }
+
+    int64_t getHeartbeat() {
+        // QueryPerformanceCounter() based, so comparable between processes.
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    // A process that cannot be opened for another reason than not existing is assumed to be running.
+    bool isProcessRunning(uint32_t processId) {
+        const HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+        if (!process) {
+            return GetLastError() != ERROR_INVALID_PARAMETER;
+        }
+
+        DWORD exitCode = STILL_ACTIVE;
+        const bool isRunning = !GetExitCodeProcess(process, &exitCode) || exitCode == STILL_ACTIVE;
+        CloseHandle(process);
+        return isRunning;
+    }
+
+    class SharedCameraClient : public ICameraClientWrapper {
+      public:
+        SharedCameraClient() : m_processId(GetCurrentProcessId()) {
+            m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE,
+                                           nullptr,
+                                           PAGE_READWRITE,
+                                           (DWORD)(sizeof(SharedCamera) >> 32),
+                                           (DWORD)sizeof(SharedCamera),
+                                           SharedMemoryName);
+            if (m_mapping) {
+                m_shared = reinterpret_cast<SharedCamera*>(
+                    MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SharedCamera)));
+            }
+
+            uint32_t version = 0;
+            if (m_shared && !m_shared->version.compare_exchange_strong(version, SharedMemoryVersion) &&
+                version != SharedMemoryVersion) {
+                Log("Camera shared with an incompatible version %u\n", version);
+                closeSharedMemory();
+            }
+
+            if (m_shared) {
+                m_subscriberIndex = claimSubscriber();
+                if (m_subscriberIndex == MaxSubscribers) {
+                    Log("Too many processes sharing the camera\n");
+                    closeSharedMemory();
+                }
+            }
+
+            if (m_shared) {
+                m_subscriber = &m_shared->subscribers[m_subscriberIndex];
+                for (uint32_t i = 0; i < MaxSubscribers; i++) {
+                    const std::wstring name = std::wstring(SubscriberEventName) + L"." + std::to_wstring(i);
+                    m_subscriberEvents[i] = CreateEventW(nullptr, FALSE, FALSE, name.c_str());
+                    if (!m_subscriberEvents[i]) {
+                        Log("Failed to create the shared camera events: %u\n", GetLastError());
+                        m_subscriber->processId.store(0);
+                        m_subscriber = nullptr;
+                        closeSharedMemory();
+                        break;
+                    }
+                }
+            }
+
+            if (!m_shared) {
+                m_cameraClient = createCameraClientWrapper();
+                return;
+            }
+
+            updateRole();
+        }
+
+        ~SharedCameraClient() override {
+            Log("Shared camera: %llu images published, %llu images received\n", m_publishedCount, m_receivedCount);
+
+            if (m_shared) {
+                uint32_t processId = m_processId;
+                m_shared->publisherProcessId.compare_exchange_strong(processId, 0);
+
+                m_subscriber->readingSequence.store(0);
+                m_subscriber->processId.store(0);
+            }
+            closeSharedMemory();
+        }
+
+        bool AcquireNextFrame(core::CameraFrame& frame) override {
+            updateRole();
+
+            if (m_cameraClient) {
+                if (!m_cameraClient->AcquireNextFrame(frame)) {
+                    return false;
+                }
+                publish(frame);
+                m_isFrameFromClient = true;
+                return true;
+            }
+
+            return receive(frame);
+        }
+
+        void ReleaseFrame() override {
+            if (m_isFrameFromClient) {
+                m_cameraClient->ReleaseFrame();
+                m_isFrameFromClient = false;
+            } else if (m_subscriber) {
+                m_subscriber->readingSequence.store(0);
+            }
+        }
+
+        bool WaitForNextFrame(core::CameraFrame& frame, std::chrono::microseconds timeout) override {
+            updateRole();
+
+            if (m_cameraClient) {
+                if (!m_cameraClient->WaitForNextFrame(frame, timeout)) {
+                    return false;
+                }
+                publish(frame);
+                m_isFrameFromClient = true;
+                return true;
+            }
+
+            // The event may have been set for an image that was already received, so check again after each wake-up.
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (!receive(frame)) {
+                const auto remaining = deadline - std::chrono::steady_clock::now();
+                if (!m_shared || remaining <= 0s) {
+                    return false;
+                }
+                WaitForSingleObject(m_subscriberEvents[m_subscriberIndex],
+                                    (DWORD)std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+            }
+            return true;
+        }
+
+      private:
+        // Returns MaxSubscribers when all the entries are used by running processes. The entries of the processes that
+        // exited without releasing theirs are reclaimed.
+        uint32_t claimSubscriber() {
+            for (uint32_t i = 0; i < MaxSubscribers; i++) {
+                uint32_t processId = 0;
+                if (m_shared->subscribers[i].processId.compare_exchange_strong(processId, m_processId)) {
+                    return i;
+                }
+            }
+
+            for (uint32_t i = 0; i < MaxSubscribers; i++) {
+                SharedSubscriber& subscriber = m_shared->subscribers[i];
+                uint32_t processId = subscriber.processId.load();
+                if (processId && !isProcessRunning(processId) &&
+                    subscriber.processId.compare_exchange_strong(processId, m_processId)) {
+                    Log("Reclaimed the camera subscriber of process %u\n", processId);
+                    subscriber.readingSequence.store(0);
+                    return i;
+                }
+            }
+
+            return MaxSubscribers;
+        }
+
+        // Keep publishing while we hold the role, or take over from a publisher that went away.
+        void updateRole() {
+            if (!m_shared) {
+                return;
+            }
+
+            if (m_cameraClientFuture.valid() && m_cameraClientFuture.wait_for(0s) == std::future_status::ready) {
+                m_cameraClient = m_cameraClientFuture.get();
+            }
+
+            const int64_t now = getHeartbeat();
+            uint32_t publisher = m_shared->publisherProcessId.load();
+            if (publisher == m_processId) {
+                m_shared->publisherHeartbeat.store(now);
+                return;
+            }
+
+            // Another process took over while our application was not submitting frames.
+            if (m_cameraClient) {
+                Log("Camera now published by process %u\n", publisher);
+                m_cameraClient.reset();
+            }
+
+            const int64_t timeout =
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(PublisherTimeout).count();
+            if (!m_cameraClientFuture.valid() &&
+                (publisher == 0 || now - m_shared->publisherHeartbeat.load() > timeout) &&
+                m_shared->publisherProcessId.compare_exchange_strong(publisher, m_processId)) {
+                m_shared->publisherHeartbeat.store(now);
+                Log("Publishing the camera to the other processes\n");
+
+                // Starting the camera is slow, keep reading from the shared memory in the meantime.
+                m_cameraClientFuture = std::async(std::launch::async, [] { return createCameraClientWrapper(); });
+            }
+        }
+
+        void publish(const core::CameraFrame& frame) {
+            if (!m_shared) {
+                return;
+            }
+
+            const size_t size = getRawImageSize(frame);
+            if (size > MaxImageSize) {
+                return;
+            }
+
+            // Pick the oldest slot that no subscriber is reading. Both sides make their change visible before looking
+            // at the other side's, so either the publisher sees the subscriber's sequence, or the subscriber sees the
+            // slot invalidated.
+            const uint32_t latestSlot = m_shared->latestSlot.load();
+            for (uint32_t i = 1; i <= SlotCount; i++) {
+                const uint32_t index = (latestSlot + i) % SlotCount;
+                SharedSlot& slot = m_shared->slots[index];
+                const uint64_t previousSequence = slot.sequence.exchange(0);
+                if (previousSequence && isBeingRead(previousSequence)) {
+                    slot.sequence.store(previousSequence);
+                    continue;
+                }
+
+                memcpy(slot.image, frame.CameraImage, size);
+                slot.width = frame.Width;
+                slot.height = frame.Height;
+                slot.sequence.store(m_shared->nextSequence.fetch_add(1) + 1);
+                m_shared->latestSlot.store(index);
+                m_publishedCount++;
+
+                // Wake up the other processes waiting for an image.
+                for (uint32_t i = 0; i < MaxSubscribers; i++) {
+                    const uint32_t processId = m_shared->subscribers[i].processId.load();
+                    if (processId && processId != m_processId) {
+                        SetEvent(m_subscriberEvents[i]);
+                    }
+                }
+                return;
+            }
+        }
+
+        bool isBeingRead(uint64_t sequence) const {
+            return std::any_of(std::cbegin(m_shared->subscribers),
+                               std::cend(m_shared->subscribers),
+                               [&](const SharedSubscriber& subscriber) {
+                                   return subscriber.readingSequence.load() == sequence;
+                               });
+        }
+
+        bool receive(core::CameraFrame& frame) {
+            if (!m_shared) {
+                return false;
+            }
+
+            SharedSlot& slot = m_shared->slots[m_shared->latestSlot.load() % SlotCount];
+            const uint64_t sequence = slot.sequence.load();
+            if (!sequence || sequence == m_lastReceivedSequence) {
+                return false;
+            }
+
+            m_subscriber->readingSequence.store(sequence);
+            if (slot.sequence.load() != sequence) {
+                // The publisher is already overwriting the slot.
+                m_subscriber->readingSequence.store(0);
+                return false;
+            }
+
+            frame = {};
+            frame.Width = slot.width;
+            frame.Height = slot.height;
+            frame.CameraImage = slot.image;
+            m_lastReceivedSequence = sequence;
+            m_receivedCount++;
+
+            return true;
+        }
+
+        void closeSharedMemory() {
+            for (HANDLE& event : m_subscriberEvents) {
+                if (event) {
+                    CloseHandle(event);
+                    event = nullptr;
+                }
+            }
+            if (m_shared) {
+                UnmapViewOfFile(m_shared);
+                m_shared = nullptr;
+            }
+            if (m_mapping) {
+                CloseHandle(m_mapping);
+                m_mapping = nullptr;
+            }
+        }
+
+        const uint32_t m_processId;
+        HANDLE m_mapping{nullptr};
+        SharedCamera* m_shared{nullptr};
+        SharedSubscriber* m_subscriber{nullptr};
+        uint32_t m_subscriberIndex{0};
+        HANDLE m_subscriberEvents[MaxSubscribers]{};
+
+        // Only set while this process is the publisher (or does not share the camera).
+        std::unique_ptr<ICameraClientWrapper> m_cameraClient;
+        std::future<std::unique_ptr<ICameraClientWrapper>> m_cameraClientFuture;
+        bool m_isFrameFromClient{false};
+
+        uint64_t m_lastReceivedSequence{0};
+        uint64_t m_publishedCount{0};
+        uint64_t m_receivedCount{0};
+    };
+
+} // namespace
+
+namespace passthrough {
+
+    std::unique_ptr<ICameraClientWrapper> createSharedCameraClient() {
+        return std::make_unique<SharedCameraClient>();
+    }
+
+} // namespace passthrough
@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    struct CameraFrameQueueStatistics {
+        uint64_t pushCount{0};
+        uint64_t selectCount{0};
+
+        // Images replaced by a newer one before being shown.
+        uint64_t staleDropCount{0};
+
+        // The time between the reception and the display of the images shown, when both are known.
+        uint64_t timedSelectCount{0};
+        XrDuration timedSelectAgeSum{0};
+    };
+
+    // A short queue of the latest processed camera images, each tagged with its reception time. The producer pushes all
+    // the images it received, then the consumer takes the newest one. The queue has no dependency on the camera or the
+    // graphics API, and can be driven with synthetic timestamps.
+    // The camera client does not expose the capture times. The images are displayed after they are received, so the
+    // newest image is always the closest to the display time.
+    class CameraFrameQueue {
+      public:
+        struct Frame {
+            std::vector<uint8_t> image;
+            uint32_t width{0};
+            uint32_t height{0};
+
+            // 0 when unknown.
+            XrTime receptionTime{0};
+        };
+
+        CameraFrameQueue(uint32_t capacity = 3) : m_slots(capacity) {
+        }
+
+        // Returns the memory to write the next image to, with a pitch equal to the width. Reuses the oldest slot.
+        uint8_t* beginPush(uint32_t width, uint32_t height) {
+            Slot& slot = m_slots[m_next];
+            if (slot.isPending) {
+                slot.isPending = false;
+                m_statistics.staleDropCount++;
+            }
+
+            slot.frame.width = width;
+            slot.frame.height = height;
+            slot.frame.image.resize((size_t)width * height);
+            return slot.frame.image.data();
+        }
+
+        // The image written since beginPush() can be selected. The reception time is 0 when unknown.
+        void commitPush(XrTime receptionTime) {
+            Slot& slot = m_slots[m_next];
+            slot.frame.receptionTime = receptionTime;
+            slot.sequence = ++m_sequence;
+            slot.isPending = true;
+
+            m_next = (m_next + 1) % (uint32_t)m_slots.size();
+            m_statistics.pushCount++;
+        }
+
+        // Pick the newest image that was not shown yet. The older images are dropped. The display time is only used
+        // for the statistics. Returns nullptr when there is no new image.
+        const Frame* select(XrTime displayTime) {
+            Slot* newest = nullptr;
+            for (Slot& slot : m_slots) {
+                if (slot.isPending && (!newest || slot.sequence > newest->sequence)) {
+                    newest = &slot;
+                }
+            }
+            if (!newest) {
+                return nullptr;
+            }
+
+            for (Slot& slot : m_slots) {
+                if (slot.isPending && &slot != newest) {
+                    slot.isPending = false;
+                    m_statistics.staleDropCount++;
+                }
+            }
+
+            newest->isPending = false;
+            m_statistics.selectCount++;
+            if (newest->frame.receptionTime && displayTime > newest->frame.receptionTime) {
+                m_statistics.timedSelectCount++;
+                m_statistics.timedSelectAgeSum += displayTime - newest->frame.receptionTime;
+            }
+
+            return &newest->frame;
+        }
+
+        // Forget the images that were not shown yet, for example when the camera stops streaming.
+        void clear() {
+            for (Slot& slot : m_slots) {
+                slot.isPending = false;
+            }
+        }
+
+        const CameraFrameQueueStatistics& getStatistics() const {
+            return m_statistics;
+        }
+
+      private:
+        struct Slot {
+            Frame frame;
+            uint64_t sequence{0};
+            bool isPending{false};
+        };
+
+        std::vector<Slot> m_slots;
+        uint32_t m_next{0};
+        uint64_t m_sequence{0};
+
+        CameraFrameQueueStatistics m_statistics;
+    };
+
+} // namespace passthrough
@@ -0,0 +1,892 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// This file includes many code snippets from https://github.com/catid/XRmonitors
+// Copyright (c) 2020, Christopher A. Taylor
+// Copyright 2019 Augmented Perception Corporation
+
+#include "pch.h"
+
+#include "allocation_tracker.h"
+#include "graphics_backend.h"
+#include "log.h"
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::log;
+
+    using namespace DirectX;
+
+    struct ModelViewProjectionConstantBuffer {
+        XMFLOAT4X4 modelViewProjection[ViewCount];
+    };
+
+    // The meshes of both eyes have the same topology, so they are drawn from a single vertex buffer.
+    struct StereoVertex {
+        XMFLOAT3 position[ViewCount];
+        XMFLOAT2 textureCoordinate[ViewCount];
+    };
+
+    // The eye drawn by each instance, and the render target array slice it goes to with single-pass stereo.
+    struct InstanceData {
+        uint32_t eye;
+        uint32_t slice;
+    };
+
+    // The instances for drawing into the passthrough swapchain, then into an application's render target views, which
+    // only have one slice.
+    const InstanceData Instances[] = {{0, 0}, {1, 1}, {0, 0}, {1, 0}};
+    constexpr uint32_t CompositionInstanceOffset = ViewCount;
+
+    struct ColorAdjustmentConstantBuffer {
+        XMFLOAT4 colorAdjustment;
+    };
+
+    // This code is adapted from XRmonitors\XRmonitorsHologram\CameraRenderer.cpp
+    const std::string_view VertexShaderSource = R"_(
+struct Vertex {
+    float3 pos[2] : POSITION0;
+    float2 tex[2] : TEXCOORD0;
+    uint eye : EYE;
+    uint slice : SLICE;
+};
+
+struct PSVertex {
+    float4 pos : SV_POSITION;
+    float2 tex : TEXCOORD0;
+#ifdef SINGLE_PASS_STEREO
+    uint slice : SV_RenderTargetArrayIndex;
+#endif
+};
+
+cbuffer ModelViewProjectionConstantBuffer : register(b0) {
+    float4x4 modelViewProjection[2];
+};
+
+PSVertex vsMain(Vertex input) {
+    PSVertex output;
+    output.pos = mul(float4(input.pos[input.eye], 1), modelViewProjection[input.eye]);
+
+    // Place it behind everything else
+    output.pos.z = 0.9999f * output.pos.w;
+
+    output.tex = input.tex[input.eye];
+#ifdef SINGLE_PASS_STEREO
+    output.slice = input.slice;
+#endif
+    return output;
+}
+)_";
+
+    // Both eyes are drawn with one instanced draw call, each instance selecting its array slice from the vertex shader.
+    const std::string SinglePassVertexShaderSource =
+        std::string("#define SINGLE_PASS_STEREO\n").append(VertexShaderSource);
+
+    // This code is adapted from XRmonitors\XRmonitorsHologram\CameraRenderer.cpp
+    const std::string_view PixelShaderSource = R"_(
+struct PSVertex {
+    float4 Pos : SV_POSITION;
+    float2 Tex : TEXCOORD0;
+};
+
+// The alpha component is the opacity of the passthrough.
+cbuffer ColorAdjustmentConstantBuffer : register(b0) {
+    float4 colorAdjustment;
+};
+
+SamplerState textureSampler : register(s0);
+Texture2D cameraTexture : register(t0);
+
+float4 psMain(PSVertex input) : SV_TARGET {
+    float4 color = cameraTexture.Sample(textureSampler, input.Tex);
+    return float4(
+        color.r * colorAdjustment.r * colorAdjustment.a,
+        color.r * colorAdjustment.g * colorAdjustment.a,
+        color.r * colorAdjustment.b * colorAdjustment.a,
+        1.0);
+}
+)_";
+
+    // Enough to never wait on the GPU before reusing a slot.
+    constexpr uint32_t CameraUploadSlots = 3;
+
+    // An event query, issued after the copy from an upload slot.
+    class D3D11UploadFence {
+      public:
+        D3D11UploadFence(ID3D11Device* device, ID3D11DeviceContext* context) : m_context(context) {
+            D3D11_QUERY_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.Query = D3D11_QUERY_EVENT;
+            CHECK_HRCMD(device->CreateQuery(&desc, &m_query));
+        }
+
+        void signal() {
+            m_context->End(m_query.Get());
+        }
+
+        bool isCompleted() {
+            return m_context->GetData(m_query.Get(), nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+        }
+
+        void wait() {
+            while (m_context->GetData(m_query.Get(), nullptr, 0, 0) != S_OK) {
+                std::this_thread::yield();
+            }
+        }
+
+      private:
+        ComPtr<ID3D11DeviceContext> m_context;
+        ComPtr<ID3D11Query> m_query;
+    };
+
+    // Depth swapchains may be created with a typeless format.
+    DXGI_FORMAT getDepthStencilViewFormat(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R32_TYPELESS:
+            return DXGI_FORMAT_D32_FLOAT;
+        case DXGI_FORMAT_R16_TYPELESS:
+            return DXGI_FORMAT_D16_UNORM;
+        case DXGI_FORMAT_R24G8_TYPELESS:
+            return DXGI_FORMAT_D24_UNORM_S8_UINT;
+        case DXGI_FORMAT_R32G8X24_TYPELESS:
+            return DXGI_FORMAT_D32_FLOAT_S8X24_UINT;
+        default:
+            return format;
+        }
+    }
+
+    constexpr uint32_t ShaderCompileFlags = D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS;
+
+    class D3DShaderCompiler : public IShaderCompiler {
+      public:
+        uint32_t getVersion() const override {
+            return D3D_COMPILER_VERSION;
+        }
+
+        std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) override {
+            ComPtr<ID3DBlob> errors;
+            ComPtr<ID3DBlob> bytes;
+            HRESULT hr = D3DCompile(source.data(),
+                                    source.length(),
+                                    nullptr,
+                                    nullptr,
+                                    nullptr,
+                                    entryPoint,
+                                    target,
+                                    flags,
+                                    0,
+                                    &bytes,
+                                    &errors);
+            if (FAILED(hr)) {
+                if (errors) {
+                    Log("%s", (char*)errors->GetBufferPointer());
+                }
+                CHECK_HRESULT(hr, "Failed to compile shader");
+            }
+
+            const uint8_t* bytecode = reinterpret_cast<const uint8_t*>(bytes->GetBufferPointer());
+            return {bytecode, bytecode + bytes->GetBufferSize()};
+        }
+    };
+
+    // Draw with D3D11, either directly or on top of a D3D12 device with D3D11On12.
+    class D3D11Backend : public IGraphicsBackend {
+      public:
+        D3D11Backend(ID3D11Device* device) : m_d3d11Device(device) {
+            m_d3d11Device->GetImmediateContext(&m_d3d11DeviceContext);
+            CHECK_HRCMD(m_d3d11Device->CreateDeferredContext(0, &m_deferredContext));
+            detectSinglePassStereo();
+        }
+
+        D3D11Backend(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+            : m_d3d12Device(device), m_d3d12CommandQueue(commandQueue) {
+            // Create resources for interop.
+            D3D_FEATURE_LEVEL featureLevel = {D3D_FEATURE_LEVEL_11_1};
+            CHECK_HRCMD(D3D11On12CreateDevice(m_d3d12Device.Get(),
+                                              D3D11_CREATE_DEVICE_SINGLETHREADED,
+                                              &featureLevel,
+                                              1,
+                                              reinterpret_cast<IUnknown**>(m_d3d12CommandQueue.GetAddressOf()),
+                                              1,
+                                              0,
+                                              &m_d3d11Device,
+                                              &m_d3d11DeviceContext,
+                                              nullptr));
+            CHECK_HRCMD(m_d3d11Device->QueryInterface(__uuidof(ID3D11On12Device),
+                                                      reinterpret_cast<void**>(m_d3d11on12Device.GetAddressOf())));
+
+            // Create a fence so we can wait for pending work upon shutdown.
+            CHECK_HRCMD(m_d3d12Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_d3d12Fence)));
+
+            detectSinglePassStereo();
+        }
+
+        ~D3D11Backend() override {
+            if (m_d3d12Device) {
+                // Wait for all resources to be safe to destroy.
+                m_d3d12CommandQueue->Signal(m_d3d12Fence.Get(), 1);
+                if (m_d3d12Fence->GetCompletedValue() < 1) {
+                    HANDLE eventHandle = CreateEventEx(nullptr, L"Flush D3D12 Fence", 0, EVENT_ALL_ACCESS);
+                    CHECK_HRCMD(m_d3d12Fence->SetEventOnCompletion(1, eventHandle));
+                    WaitForSingleObject(eventHandle, INFINITE);
+                    CloseHandle(eventHandle);
+                }
+            }
+        }
+
+        std::unique_ptr<IShaderCompiler> createShaderCompiler() const override {
+            return std::make_unique<D3DShaderCompiler>();
+        }
+
+        ShaderDescription getVertexShader() const override {
+            return {m_useSinglePassStereo ? SinglePassVertexShaderSource : VertexShaderSource,
+                    "vsMain",
+                    "vs_5_0",
+                    ShaderCompileFlags};
+        }
+
+        ShaderDescription getPixelShader() const override {
+            return {PixelShaderSource, "psMain", "ps_5_0", ShaderCompileFlags};
+        }
+
+        SwapchainFormatApi getSwapchainFormatApi() const override {
+            return SwapchainFormatApi::DXGIOrOpenGL;
+        }
+
+        void importSwapchainImages(OpenXrApi& openXR,
+                                   XrSwapchain swapchain,
+                                   const XrSwapchainCreateInfo& createInfo) override {
+            m_swapchainInfo = createInfo;
+
+            uint32_t imageCount;
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+            if (!m_d3d12Device) {
+                std::vector<XrSwapchainImageD3D11KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR, nullptr});
+                CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                    swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                for (uint32_t i = 0; i < imageCount; i++) {
+                    m_swapchainTexture.push_back(images[i].texture);
+                }
+            } else {
+                std::vector<XrSwapchainImageD3D12KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D12_KHR, nullptr});
+                CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                    swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                D3D11_RESOURCE_FLAGS flags;
+                ZeroMemory(&flags, sizeof(flags));
+                flags.BindFlags = D3D11_BIND_RENDER_TARGET;
+                for (uint32_t i = 0; i < imageCount; i++) {
+                    ComPtr<ID3D11Texture2D> interopTexture;
+
+                    // Create the interop texture.
+                    m_d3d11on12Device->CreateWrappedResource(images[i].texture,
+                                                             &flags,
+                                                             D3D12_RESOURCE_STATE_RENDER_TARGET,
+                                                             D3D12_RESOURCE_STATE_RENDER_TARGET,
+                                                             IID_PPV_ARGS(&interopTexture));
+                    m_swapchainTexture.push_back(interopTexture);
+                }
+            }
+
+            m_recordedDraw.resize(m_swapchainTexture.size());
+
+            // Create render target views. With single-pass stereo, one view covers both array slices.
+            const uint32_t renderTargetCount = m_useSinglePassStereo ? 1 : ViewCount;
+            for (uint32_t eye = 0; eye < renderTargetCount; eye++) {
+                for (uint32_t i = 0; i < m_swapchainTexture.size(); i++) {
+                    D3D11_RENDER_TARGET_VIEW_DESC desc;
+                    ZeroMemory(&desc, sizeof(desc));
+                    desc.Format = (DXGI_FORMAT)m_swapchainInfo.format;
+                    desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+                    desc.Texture2DArray.ArraySize = m_useSinglePassStereo ? ViewCount : 1;
+                    desc.Texture2DArray.FirstArraySlice = eye;
+                    desc.Texture2DArray.MipSlice = D3D11CalcSubresource(0, 0, m_swapchainInfo.mipCount);
+
+                    ComPtr<ID3D11RenderTargetView> rtv;
+                    CHECK_HRCMD(m_d3d11Device->CreateRenderTargetView(m_swapchainTexture[i].Get(), &desc, &rtv));
+                    m_swapchainRenderTarget[eye].push_back(rtv);
+                }
+            }
+        }
+
+        void createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                    const std::vector<uint8_t>& psBytes,
+                                    const std::vector<VertexPositionTexture>* vertices,
+                                    const std::vector<uint16_t>& indices) override {
+            ALLOCATION_SCOPE("createDrawingResources");
+
+            {
+                CHECK_HRCMD(
+                    m_d3d11Device->CreateVertexShader(vsBytes.data(), vsBytes.size(), nullptr, &m_vertexShader));
+
+                // The eye index is per-instance data, so that the same shader works when drawing each eye separately.
+                const D3D11_INPUT_ELEMENT_DESC desc[] = {
+                    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"POSITION", 1, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 0, 32, D3D11_INPUT_PER_VERTEX_DATA, 0},
+                    {"EYE", 0, DXGI_FORMAT_R32_UINT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                    {"SLICE", 0, DXGI_FORMAT_R32_UINT, 1, 4, D3D11_INPUT_PER_INSTANCE_DATA, 1},
+                };
+
+                CHECK_HRCMD(m_d3d11Device->CreateInputLayout(
+                    desc, ARRAYSIZE(desc), vsBytes.data(), vsBytes.size(), &m_inputLayout));
+            }
+            {
+                CHECK_HRCMD(m_d3d11Device->CreatePixelShader(psBytes.data(), psBytes.size(), nullptr, &m_pixelShader));
+            }
+            {
+                D3D11_SAMPLER_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+                desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+                desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+                desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+                desc.MaxAnisotropy = 1;
+                desc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
+                CHECK_HRCMD(m_d3d11Device->CreateSamplerState(&desc, &m_sampler));
+            }
+            {
+                D3D11_BUFFER_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.Usage = D3D11_USAGE_IMMUTABLE;
+
+                m_stereoVertices.resize(vertices[0].size());
+                for (size_t i = 0; i < m_stereoVertices.size(); i++) {
+                    for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                        m_stereoVertices[i].position[eye] = vertices[eye][i].position;
+                        m_stereoVertices[i].textureCoordinate[eye] = vertices[eye][i].textureCoordinate;
+                    }
+                }
+
+                // The positions may be updated, like the view-projection matrices.
+                D3D11_SUBRESOURCE_DATA data;
+                ZeroMemory(&data, sizeof(data));
+                desc.Usage = D3D11_USAGE_DEFAULT;
+                desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+                desc.ByteWidth = (UINT)m_stereoVertices.size() * sizeof(StereoVertex);
+                data.pSysMem = m_stereoVertices.data();
+                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &data, &m_vertexBuffer));
+
+                desc.Usage = D3D11_USAGE_IMMUTABLE;
+                desc.ByteWidth = (UINT)sizeof(Instances);
+                data.pSysMem = Instances;
+                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &data, &m_instanceBuffer));
+
+                desc.ByteWidth = (UINT)indices.size() * sizeof(uint16_t);
+                desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+                data.pSysMem = indices.data();
+                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &data, &m_indexBuffer));
+
+                m_indexBufferNumIndices = (UINT)indices.size();
+            }
+            {
+                D3D11_BUFFER_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.ByteWidth = (UINT)sizeof(ModelViewProjectionConstantBuffer);
+                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, nullptr, &m_modelViewProjectionConstantBuffer));
+            }
+            {
+                D3D11_BUFFER_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.ByteWidth = (UINT)sizeof(ColorAdjustmentConstantBuffer);
+                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+
+#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
+                m_colorAdjustment.colorAdjustment = {XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT, 1.f};
+#else
+                m_colorAdjustment.colorAdjustment = {1.f, 1.f, 1.f, 1.f};
+#endif
+
+                D3D11_SUBRESOURCE_DATA initialData;
+                ZeroMemory(&initialData, sizeof(initialData));
+                initialData.pSysMem = &m_colorAdjustment;
+
+                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &initialData, &m_colorAdjustmentConstantBuffer));
+            }
+            {
+                // Only pass where the application's depth is at the far plane, without modifying it.
+                D3D11_DEPTH_STENCIL_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.DepthEnable = TRUE;
+                desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+                desc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+                CHECK_HRCMD(m_d3d11Device->CreateDepthStencilState(&desc, &m_farDepthTest[0]));
+                desc.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
+                CHECK_HRCMD(m_d3d11Device->CreateDepthStencilState(&desc, &m_farDepthTest[1]));
+            }
+        }
+
+        void updateVertexPositions(const std::vector<XMFLOAT3>* positions) override {
+            for (size_t i = 0; i < m_stereoVertices.size(); i++) {
+                for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                    m_stereoVertices[i].position[eye] = positions[eye][i];
+                }
+            }
+
+            // The recorded commands read the buffer when executed.
+            m_d3d11DeviceContext->UpdateSubresource(m_vertexBuffer.Get(), 0, nullptr, m_stereoVertices.data(), 0, 0);
+        }
+
+        uint8_t* mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) override {
+            ensureCameraTexture(width, height);
+
+            // The slot is not in use by the GPU anymore, so mapping it does not block.
+            m_cameraUploadSlot = m_cameraUploadRing.acquire();
+
+            D3D11_MAPPED_SUBRESOURCE subresource;
+            ZeroMemory(&subresource, sizeof(subresource));
+            CHECK_HRCMD(m_d3d11DeviceContext->Map(m_cameraStagingTexture[m_cameraUploadSlot].Get(),
+                                                  D3D11CalcSubresource(0, 0, 1),
+                                                  D3D11_MAP_WRITE,
+                                                  0,
+                                                  &subresource));
+
+            pitch = subresource.RowPitch;
+            return reinterpret_cast<uint8_t*>(subresource.pData);
+        }
+
+        void unmapCameraTexture(bool commit) override {
+            ID3D11Texture2D* const stagingTexture = m_cameraStagingTexture[m_cameraUploadSlot].Get();
+            m_d3d11DeviceContext->Unmap(stagingTexture, D3D11CalcSubresource(0, 0, 1));
+            if (commit) {
+                m_d3d11DeviceContext->CopyResource(m_cameraTexture.Get(), stagingTexture);
+                m_cameraUploadRing.getFence(m_cameraUploadSlot).signal();
+                m_cameraUploadRing.submit(m_cameraUploadSlot);
+            } else {
+                m_cameraUploadRing.cancel(m_cameraUploadSlot);
+            }
+        }
+
+        const UploadRingStatistics& getCameraUploadStatistics() const override {
+            return m_cameraUploadRing.getStatistics();
+        }
+
+        void setOpacity(float opacity) override {
+            if (opacity == m_colorAdjustment.colorAdjustment.w) {
+                return;
+            }
+
+            // The recorded commands read the buffer when executed.
+            m_colorAdjustment.colorAdjustment.w = opacity;
+            m_d3d11DeviceContext->UpdateSubresource(
+                m_colorAdjustmentConstantBuffer.Get(), 0, nullptr, &m_colorAdjustment, 0, 0);
+        }
+
+        void drawPassthroughLayer(uint32_t imageIndex,
+                                  const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+            // Update the viewer's projection for both eyes at once. The recorded commands read the buffer when executed.
+            {
+                ModelViewProjectionConstantBuffer constants;
+                std::copy(std::begin(modelViewProjection),
+                          std::end(modelViewProjection),
+                          std::begin(constants.modelViewProjection));
+                m_d3d11DeviceContext->UpdateSubresource(
+                    m_modelViewProjectionConstantBuffer.Get(), 0, nullptr, &constants, 0, 0);
+            }
+
+            const bool isPureD3D11 = !m_d3d12Device;
+
+            if (isPureD3D11) {
+                // With D3D11, the draw is recorded once per swapchain image, and replayed with the context saving
+                // feature.
+                ComPtr<ID3D11CommandList>& commandList = m_recordedDraw[imageIndex];
+                if (!commandList) {
+                    recordDraw(m_deferredContext.Get(), imageIndex);
+                    CHECK_HRCMD(m_deferredContext->FinishCommandList(FALSE, commandList.GetAddressOf()));
+                }
+
+                m_d3d11DeviceContext->ExecuteCommandList(commandList.Get(), TRUE);
+            } else {
+                ID3D11Resource* interopResource[] = {m_swapchainTexture[imageIndex].Get()};
+                m_d3d11on12Device->AcquireWrappedResources(interopResource, 1);
+
+                recordDraw(m_d3d11DeviceContext.Get(), imageIndex);
+
+                m_d3d11on12Device->ReleaseWrappedResources(interopResource, 1);
+
+                // Flush to the D3D12 command queue.
+                m_d3d11DeviceContext->Flush();
+            }
+        }
+
+        void uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) override {
+            ID3D11Resource* const texture = m_swapchainTexture[imageIndex].Get();
+            if (m_d3d12Device) {
+                m_d3d11on12Device->AcquireWrappedResources(&texture, 1);
+            }
+
+            m_d3d11DeviceContext->UpdateSubresource(
+                texture, D3D11CalcSubresource(0, slice, 1), nullptr, data, (UINT)pitch, 0);
+
+            if (m_d3d12Device) {
+                m_d3d11on12Device->ReleaseWrappedResources(&texture, 1);
+
+                // Flush to the D3D12 command queue.
+                m_d3d11DeviceContext->Flush();
+            }
+        }
+
+        bool isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const override {
+            UINT colorSupport = 0;
+            UINT depthSupport = 0;
+            return SUCCEEDED(m_d3d11Device->CheckFormatSupport((DXGI_FORMAT)colorFormat, &colorSupport)) &&
+                   (colorSupport & D3D11_FORMAT_SUPPORT_RENDER_TARGET) &&
+                   SUCCEEDED(m_d3d11Device->CheckFormatSupport(getDepthStencilViewFormat((DXGI_FORMAT)depthFormat),
+                                                               &depthSupport)) &&
+                   (depthSupport & D3D11_FORMAT_SUPPORT_DEPTH_STENCIL);
+        }
+
+        void importApplicationSwapchain(OpenXrApi& openXR,
+                                        XrSwapchain swapchain,
+                                        const XrSwapchainCreateInfo& createInfo) override {
+            ApplicationSwapchainImages& entry = m_applicationSwapchains[swapchain];
+            entry = {};
+            entry.createInfo = createInfo;
+            entry.isDepth = createInfo.usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+            uint32_t imageCount;
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+            if (!m_d3d12Device) {
+                std::vector<XrSwapchainImageD3D11KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR, nullptr});
+                CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                    swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+                for (uint32_t i = 0; i < imageCount; i++) {
+                    entry.textures.push_back(images[i].texture);
+                }
+            } else {
+                std::vector<XrSwapchainImageD3D12KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D12_KHR, nullptr});
+                CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                    swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+
+                // The images of the application are released in these states.
+                const D3D12_RESOURCE_STATES state =
+                    entry.isDepth ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_RENDER_TARGET;
+                D3D11_RESOURCE_FLAGS flags;
+                ZeroMemory(&flags, sizeof(flags));
+                flags.BindFlags = entry.isDepth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET;
+                for (uint32_t i = 0; i < imageCount; i++) {
+                    ComPtr<ID3D11Texture2D> interopTexture;
+                    CHECK_HRCMD(m_d3d11on12Device->CreateWrappedResource(
+                        images[i].texture, &flags, state, state, IID_PPV_ARGS(&interopTexture)));
+                    entry.textures.push_back(interopTexture);
+                }
+            }
+        }
+
+        void forgetApplicationSwapchain(XrSwapchain swapchain) override {
+            m_applicationSwapchains.erase(swapchain);
+        }
+
+        void compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                       const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+            {
+                ModelViewProjectionConstantBuffer constants;
+                std::copy(std::begin(modelViewProjection),
+                          std::end(modelViewProjection),
+                          std::begin(constants.modelViewProjection));
+                m_d3d11DeviceContext->UpdateSubresource(
+                    m_modelViewProjectionConstantBuffer.Get(), 0, nullptr, &constants, 0, 0);
+            }
+
+            const bool isPureD3D11 = !m_d3d12Device;
+
+            // The views may share the same images.
+            ID3D11Resource* interopResources[2 * ViewCount];
+            uint32_t interopResourceCount = 0;
+            if (!isPureD3D11) {
+                for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                    for (ID3D11Resource* resource :
+                         {getApplicationTexture(views[eye].colorSwapchain, views[eye].colorImageIndex),
+                          getApplicationTexture(views[eye].depthSwapchain, views[eye].depthImageIndex)}) {
+                        if (std::find(interopResources, interopResources + interopResourceCount, resource) ==
+                            interopResources + interopResourceCount) {
+                            interopResources[interopResourceCount++] = resource;
+                        }
+                    }
+                }
+                m_d3d11on12Device->AcquireWrappedResources(interopResources, interopResourceCount);
+            }
+
+            // The target changes every frame, there is nothing to gain from keeping the commands.
+            ID3D11DeviceContext* const context = isPureD3D11 ? m_deferredContext.Get() : m_d3d11DeviceContext.Get();
+            setCommonState(context);
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                const CompositionView& view = views[eye];
+
+                ID3D11RenderTargetView* rtv[] = {
+                    getApplicationRenderTarget(view.colorSwapchain, view.colorImageIndex, view.colorArrayIndex)};
+                ID3D11DepthStencilView* const dsv =
+                    getApplicationDepthStencil(view.depthSwapchain, view.depthImageIndex, view.depthArrayIndex);
+                context->OMSetRenderTargets(1, rtv, dsv);
+                context->OMSetDepthStencilState(m_farDepthTest[view.isReversedZ ? 1 : 0].Get(), 0);
+
+                // Flatten the mesh onto the far plane, so that the depth test only passes where the application did
+                // not draw anything.
+                D3D11_VIEWPORT viewport;
+                viewport.TopLeftX = (float)view.imageRect.offset.x;
+                viewport.TopLeftY = (float)view.imageRect.offset.y;
+                viewport.Width = (float)view.imageRect.extent.width;
+                viewport.Height = (float)view.imageRect.extent.height;
+                viewport.MinDepth = viewport.MaxDepth = view.farDepth;
+                context->RSSetViewports(1, &viewport);
+
+                context->DrawIndexedInstanced(m_indexBufferNumIndices, 1, 0, 0, CompositionInstanceOffset + eye);
+            }
+
+            if (isPureD3D11) {
+                ComPtr<ID3D11CommandList> commandList;
+                CHECK_HRCMD(m_deferredContext->FinishCommandList(FALSE, commandList.GetAddressOf()));
+                m_d3d11DeviceContext->ExecuteCommandList(commandList.Get(), TRUE);
+            } else {
+                m_d3d11on12Device->ReleaseWrappedResources(interopResources, interopResourceCount);
+
+                // Flush to the D3D12 command queue.
+                m_d3d11DeviceContext->Flush();
+            }
+        }
+
+      private:
+        struct ApplicationSwapchainImages {
+            XrSwapchainCreateInfo createInfo;
+            bool isDepth;
+            std::vector<ComPtr<ID3D11Texture2D>> textures;
+
+            // Created on first use, for each image and array slice.
+            std::map<std::pair<uint32_t, uint32_t>, ComPtr<ID3D11RenderTargetView>> renderTargets;
+            std::map<std::pair<uint32_t, uint32_t>, ComPtr<ID3D11DepthStencilView>> depthStencils;
+        };
+
+        ID3D11Texture2D* getApplicationTexture(XrSwapchain swapchain, uint32_t imageIndex) {
+            return m_applicationSwapchains.at(swapchain).textures.at(imageIndex).Get();
+        }
+
+        ID3D11RenderTargetView* getApplicationRenderTarget(XrSwapchain swapchain, uint32_t imageIndex, uint32_t slice) {
+            ApplicationSwapchainImages& entry = m_applicationSwapchains.at(swapchain);
+            ComPtr<ID3D11RenderTargetView>& rtv = entry.renderTargets[{imageIndex, slice}];
+            if (!rtv) {
+                D3D11_RENDER_TARGET_VIEW_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.Format = (DXGI_FORMAT)entry.createInfo.format;
+                desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
+                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.MipSlice = 0;
+                CHECK_HRCMD(m_d3d11Device->CreateRenderTargetView(entry.textures.at(imageIndex).Get(), &desc, &rtv));
+            }
+            return rtv.Get();
+        }
+
+        ID3D11DepthStencilView* getApplicationDepthStencil(XrSwapchain swapchain, uint32_t imageIndex, uint32_t slice) {
+            ApplicationSwapchainImages& entry = m_applicationSwapchains.at(swapchain);
+            ComPtr<ID3D11DepthStencilView>& dsv = entry.depthStencils[{imageIndex, slice}];
+            if (!dsv) {
+                D3D11_DEPTH_STENCIL_VIEW_DESC desc;
+                ZeroMemory(&desc, sizeof(desc));
+                desc.Format = getDepthStencilViewFormat((DXGI_FORMAT)entry.createInfo.format);
+                desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2DARRAY;
+                desc.Flags = D3D11_DSV_READ_ONLY_DEPTH;
+                desc.Texture2DArray.ArraySize = 1;
+                desc.Texture2DArray.FirstArraySlice = slice;
+                desc.Texture2DArray.MipSlice = 0;
+                CHECK_HRCMD(m_d3d11Device->CreateDepthStencilView(entry.textures.at(imageIndex).Get(), &desc, &dsv));
+            }
+            return dsv.Get();
+        }
+
+        void detectSinglePassStereo() {
+            // Writing SV_RenderTargetArrayIndex from the vertex shader is optional in D3D11.
+            D3D11_FEATURE_DATA_D3D11_OPTIONS3 options;
+            ZeroMemory(&options, sizeof(options));
+            if (SUCCEEDED(m_d3d11Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS3, &options, sizeof(options)))) {
+                m_useSinglePassStereo = options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizer;
+            }
+            Log("Using %s stereo rendering\n", m_useSinglePassStereo ? "single-pass" : "multi-pass");
+        }
+
+        // Everything but the view-projection matrices, which are updated before the commands are executed.
+        void recordDraw(ID3D11DeviceContext* context, uint32_t imageIndex) {
+            CD3D11_VIEWPORT viewport(0.0f,
+                                     0.0f,
+                                     (float)m_swapchainInfo.width,
+                                     (float)m_swapchainInfo.height);
+            context->RSSetViewports(1, &viewport);
+
+            setCommonState(context);
+
+            if (m_useSinglePassStereo) {
+                ID3D11RenderTargetView* rtv[] = {m_swapchainRenderTarget[0][imageIndex].Get()};
+                context->OMSetRenderTargets(1, rtv, nullptr);
+
+                // Draw the screen, one instance per eye.
+                context->DrawIndexedInstanced(m_indexBufferNumIndices, ViewCount, 0, 0, 0);
+            } else {
+                for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                    // Setup per-eye rendering state.
+                    {
+                        ID3D11RenderTargetView* rtv[] = {m_swapchainRenderTarget[eye][imageIndex].Get()};
+                        context->OMSetRenderTargets(1, rtv, nullptr);
+                    }
+
+                    // Draw the screen. The start instance selects the eye index.
+                    context->DrawIndexedInstanced(m_indexBufferNumIndices, 1, 0, 0, eye);
+                }
+            }
+        }
+
+        void setCommonState(ID3D11DeviceContext* context) {
+            context->IASetInputLayout(m_inputLayout.Get());
+            context->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
+            context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+            context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+            {
+                ID3D11Buffer* cbs[] = {m_modelViewProjectionConstantBuffer.Get()};
+                context->VSSetConstantBuffers(0, ARRAYSIZE(cbs), cbs);
+            }
+            {
+                ID3D11Buffer* cbs[] = {m_colorAdjustmentConstantBuffer.Get()};
+                context->PSSetConstantBuffers(0, ARRAYSIZE(cbs), cbs);
+            }
+            {
+                ID3D11SamplerState* samplers[] = {m_sampler.Get()};
+                context->PSSetSamplers(0, ARRAYSIZE(samplers), samplers);
+            };
+            {
+                ID3D11ShaderResourceView* srvs[] = {m_cameraResourceView.Get()};
+                context->PSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
+            };
+            {
+                ID3D11Buffer* vbs[] = {m_vertexBuffer.Get(), m_instanceBuffer.Get()};
+                const UINT strides[] = {sizeof(StereoVertex), sizeof(InstanceData)};
+                const UINT offsets[] = {0, 0};
+                context->IASetVertexBuffers(0, ARRAYSIZE(vbs), vbs, strides, offsets);
+            }
+        }
+
+        // The recorded commands reference the camera texture, and must be recorded again when it changes.
+        void invalidateRecordedDraws() {
+            for (auto& commandList : m_recordedDraw) {
+                commandList = nullptr;
+            }
+        }
+
+        void ensureCameraTexture(uint32_t width, uint32_t height) {
+            if (!m_cameraTexture || m_cameraTextureDesc.Width != width || m_cameraTextureDesc.Height != height) {
+                ZeroMemory(&m_cameraTextureDesc, sizeof(m_cameraTextureDesc));
+                m_cameraTextureDesc.Format = DXGI_FORMAT_R8_UNORM;
+                m_cameraTextureDesc.Width = width;
+                m_cameraTextureDesc.Height = height;
+                m_cameraTextureDesc.ArraySize = 1;
+                m_cameraTextureDesc.MipLevels = 1;
+                m_cameraTextureDesc.SampleDesc.Count = 1;
+                m_cameraTextureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+                m_cameraTexture = nullptr;
+                CHECK_HRCMD(m_d3d11Device->CreateTexture2D(&m_cameraTextureDesc, nullptr, &m_cameraTexture));
+
+                D3D11_TEXTURE2D_DESC stagingTextureDesc = m_cameraTextureDesc;
+                stagingTextureDesc.BindFlags = 0;
+                stagingTextureDesc.Usage = D3D11_USAGE_STAGING;
+                stagingTextureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+                std::vector<D3D11UploadFence> fences;
+                for (uint32_t i = 0; i < CameraUploadSlots; i++) {
+                    m_cameraStagingTexture[i] = nullptr;
+                    CHECK_HRCMD(
+                        m_d3d11Device->CreateTexture2D(&stagingTextureDesc, nullptr, &m_cameraStagingTexture[i]));
+                    fences.emplace_back(m_d3d11Device.Get(), m_d3d11DeviceContext.Get());
+                }
+                m_cameraUploadRing.reset(std::move(fences));
+
+                D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+                ZeroMemory(&srvDesc, sizeof(srvDesc));
+                srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+                srvDesc.Format = m_cameraTextureDesc.Format;
+                srvDesc.Texture2D.MipLevels = 1;
+
+                m_cameraResourceView = nullptr;
+                invalidateRecordedDraws();
+                CHECK_HRCMD(
+                    m_d3d11Device->CreateShaderResourceView(m_cameraTexture.Get(), &srvDesc, &m_cameraResourceView));
+            }
+        }
+
+        // Direct3D device resources.
+        ComPtr<ID3D11Device> m_d3d11Device;
+        ComPtr<ID3D11DeviceContext> m_d3d11DeviceContext;
+        ComPtr<ID3D12Device> m_d3d12Device;
+        ComPtr<ID3D12CommandQueue> m_d3d12CommandQueue;
+        ComPtr<ID3D12Fence> m_d3d12Fence;
+        ComPtr<ID3D11On12Device> m_d3d11on12Device;
+        ComPtr<ID3D11DeviceContext> m_deferredContext;
+        bool m_useSinglePassStereo{false};
+
+        // Swapchain resources.
+        XrSwapchainCreateInfo m_swapchainInfo{};
+        std::vector<ComPtr<ID3D11Texture2D>> m_swapchainTexture;
+        std::vector<ComPtr<ID3D11RenderTargetView>> m_swapchainRenderTarget[ViewCount];
+        std::vector<ComPtr<ID3D11CommandList>> m_recordedDraw;
+
+        // Camera image resources.
+        D3D11_TEXTURE2D_DESC m_cameraTextureDesc;
+        ComPtr<ID3D11Texture2D> m_cameraTexture;
+        ComPtr<ID3D11Texture2D> m_cameraStagingTexture[CameraUploadSlots];
+        UploadRing<D3D11UploadFence> m_cameraUploadRing;
+        uint32_t m_cameraUploadSlot{0};
+        ComPtr<ID3D11ShaderResourceView> m_cameraResourceView;
+
+        // Drawing resources.
+        ComPtr<ID3D11InputLayout> m_inputLayout;
+        ComPtr<ID3D11VertexShader> m_vertexShader;
+        ComPtr<ID3D11PixelShader> m_pixelShader;
+        ComPtr<ID3D11SamplerState> m_sampler;
+        std::vector<StereoVertex> m_stereoVertices;
+        ComPtr<ID3D11Buffer> m_vertexBuffer;
+        ComPtr<ID3D11Buffer> m_instanceBuffer;
+        ComPtr<ID3D11Buffer> m_indexBuffer;
+        ComPtr<ID3D11Buffer> m_modelViewProjectionConstantBuffer;
+        ComPtr<ID3D11Buffer> m_colorAdjustmentConstantBuffer;
+        ColorAdjustmentConstantBuffer m_colorAdjustment;
+        ComPtr<ID3D11DepthStencilState> m_farDepthTest[2];
+
+        // Swapchains of the application, for depth composition.
+        std::map<XrSwapchain, ApplicationSwapchainImages> m_applicationSwapchains;
+        UINT m_indexBufferNumIndices;
+    };
+
+} // namespace
+
+namespace passthrough {
+
+    std::unique_ptr<IGraphicsBackend> createD3D11Backend(ID3D11Device* device) {
+        return std::make_unique<D3D11Backend>(device);
+    }
+
+    std::unique_ptr<IGraphicsBackend> createD3D12Backend(ID3D12Device* device, ID3D12CommandQueue* commandQueue) {
+        return std::make_unique<D3D11Backend>(device, commandQueue);
+    }
+
+} // namespace passthrough
@@ -0,0 +1,90 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // A bump allocator for the data that only needs to live until the end of the frame. Memory is recycled by reset(),
+    // so once the arena has grown to what the application needs, no more heap allocation happens.
+    class FrameArena {
+      public:
+        FrameArena(size_t initialCapacity = 4096) {
+            grow(initialCapacity);
+        }
+
+        // Invalidates all the previous allocations.
+        void reset() {
+            if (!m_overflow.empty()) {
+                // Consolidate into a single block large enough for the previous frame.
+                grow(m_capacity + m_overflowSize);
+                m_overflow.clear();
+                m_overflowSize = 0;
+            }
+            m_used = 0;
+        }
+
+        void* allocate(size_t size, size_t alignment) {
+            size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+            if (offset + size <= m_capacity) {
+                m_used = offset + size;
+                return m_buffer.get() + offset;
+            }
+
+            // Previous allocations must remain valid until reset(), so we cannot reallocate the main block now.
+            m_overflow.push_back(std::make_unique<uint8_t[]>(size + alignment));
+            m_overflowSize += size + alignment;
+            const uintptr_t address = reinterpret_cast<uintptr_t>(m_overflow.back().get());
+            return reinterpret_cast<void*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        }
+
+        template <typename T>
+        T* allocateArray(size_t count) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return reinterpret_cast<T*>(allocate(std::max(count, (size_t)1) * sizeof(T), alignof(T)));
+        }
+
+        // Make a shallow copy of a structure.
+        template <typename T>
+        T* copy(const T& source) {
+            T* const destination = allocateArray<T>(1);
+            memcpy(destination, &source, sizeof(T));
+            return destination;
+        }
+
+      private:
+        void grow(size_t capacity) {
+            m_buffer = std::make_unique<uint8_t[]>(capacity);
+            m_capacity = capacity;
+        }
+
+        std::unique_ptr<uint8_t[]> m_buffer;
+        size_t m_capacity{0};
+        size_t m_used{0};
+
+        std::vector<std::unique_ptr<uint8_t[]>> m_overflow;
+        size_t m_overflowSize{0};
+    };
+
+} // namespace passthrough
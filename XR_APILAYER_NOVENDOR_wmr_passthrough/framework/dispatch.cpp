@@ -53,11 +53,56 @@ namespace LAYER_NAMESPACE {
             return XR_ERROR_INITIALIZATION_FAILED;
         }
 
+        // The extensions implemented by the layer are unknown to the runtime.
+        std::vector<const char*> enabledExtensionNames;
+        for (uint32_t i = 0; i < instanceCreateInfo->enabledExtensionCount; i++) {
+            const std::string_view extensionName(instanceCreateInfo->enabledExtensionNames[i]);
+            if (std::find(ImplementedExtensions.cbegin(), ImplementedExtensions.cend(), extensionName) ==
+                ImplementedExtensions.cend()) {
+                enabledExtensionNames.push_back(instanceCreateInfo->enabledExtensionNames[i]);
+            }
+        }
+
+        // The extensions requested by the layer are enabled on the runtime when it supports them.
+        PFN_xrEnumerateInstanceExtensionProperties xrEnumerateInstanceExtensionProperties = nullptr;
+        if (XR_SUCCEEDED(apiLayerInfo->nextInfo->nextGetInstanceProcAddr(
+                XR_NULL_HANDLE,
+                "xrEnumerateInstanceExtensionProperties",
+                reinterpret_cast<PFN_xrVoidFunction*>(&xrEnumerateInstanceExtensionProperties)))) {
+            uint32_t extensionsCount = 0;
+            std::vector<XrExtensionProperties> extensions;
+            if (XR_SUCCEEDED(xrEnumerateInstanceExtensionProperties(nullptr, 0, &extensionsCount, nullptr))) {
+                extensions.resize(extensionsCount, {XR_TYPE_EXTENSION_PROPERTIES});
+                if (XR_FAILED(xrEnumerateInstanceExtensionProperties(
+                        nullptr, extensionsCount, &extensionsCount, extensions.data()))) {
+                    extensions.clear();
+                }
+            }
+
+            for (const std::string_view& extensionName : RequestedExtensions) {
+                const bool isSupported =
+                    std::find_if(extensions.cbegin(), extensions.cend(), [&](const XrExtensionProperties& extension) {
+                        return extensionName == extension.extensionName;
+                    }) != extensions.cend();
+                const bool isEnabled =
+                    std::find(enabledExtensionNames.cbegin(), enabledExtensionNames.cend(), extensionName) !=
+                    enabledExtensionNames.cend();
+                if (isSupported && !isEnabled) {
+                    Log("Enabling extension %s\n", extensionName.data());
+                    enabledExtensionNames.push_back(extensionName.data());
+                }
+            }
+        }
+
+        XrInstanceCreateInfo chainInstanceCreateInfo = *instanceCreateInfo;
+        chainInstanceCreateInfo.enabledExtensionCount = (uint32_t)enabledExtensionNames.size();
+        chainInstanceCreateInfo.enabledExtensionNames = enabledExtensionNames.data();
+
         // Call the chain to create the instance.
         XrApiLayerCreateInfo chainApiLayerInfo = *apiLayerInfo;
         chainApiLayerInfo.nextInfo = apiLayerInfo->nextInfo->next;
         XrResult result =
-            apiLayerInfo->nextInfo->nextCreateApiLayerInstance(instanceCreateInfo, &chainApiLayerInfo, instance);
+            apiLayerInfo->nextInfo->nextCreateApiLayerInstance(&chainInstanceCreateInfo, &chainApiLayerInfo, instance);
         if (result == XR_SUCCESS) {
             // Create our layer.
             LAYER_NAMESPACE::GetInstance()->SetGetInstanceProcAddr(apiLayerInfo->nextInfo->nextGetInstanceProcAddr,
@@ -107,6 +152,9 @@ namespace LAYER_NAMESPACE {
         try {
             result = LAYER_NAMESPACE::GetInstance()->xrDestroyInstance(instance);
             if (XR_SUCCEEDED(result)) {
+#ifdef LAYER_API_TIMING
+                DumpApiTimingStatistics();
+#endif
                 LAYER_NAMESPACE::ResetInstance();
             }
         } catch (std::runtime_error exc) {
@@ -116,6 +164,12 @@ namespace LAYER_NAMESPACE {
 
         DebugLog("<-- xrDestroyInstance %d\n", result);
 
+        // Write out the pending messages before the DLL might be unloaded. Messages logged past this point are only
+        // written if the layer is negotiated again.
+        if (XR_SUCCEEDED(result)) {
+            Flush(std::chrono::milliseconds(500));
+        }
+
         return result;
     }
 
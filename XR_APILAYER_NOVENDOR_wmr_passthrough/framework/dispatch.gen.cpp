@@ -39,10 +39,38 @@ namespace LAYER_NAMESPACE
 
 	// Auto-generated wrappers for the requested APIs.
 
+	XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData)
+	{
+		DebugLog("--> xrPollEvent\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPollEvent, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPollEvent(instance, eventData);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPollEvent %d\n", result);
+
+		return result;
+	}
+
 	XrResult xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId)
 	{
 		DebugLog("--> xrGetSystem\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrGetSystem, false);
+#endif
+
 		XrResult result;
 		try
 		{
@@ -59,10 +87,38 @@ namespace LAYER_NAMESPACE
 		return result;
 	}
 
+	XrResult xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties)
+	{
+		DebugLog("--> xrGetSystemProperties\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrGetSystemProperties, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrGetSystemProperties(instance, systemId, properties);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrGetSystemProperties %d\n", result);
+
+		return result;
+	}
+
 	XrResult xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)
 	{
 		DebugLog("--> xrEnumerateEnvironmentBlendModes\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrEnumerateEnvironmentBlendModes, false);
+#endif
+
 		XrResult result;
 		try
 		{
@@ -83,6 +139,10 @@ namespace LAYER_NAMESPACE
 	{
 		DebugLog("--> xrCreateSession\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrCreateSession, false);
+#endif
+
 		XrResult result;
 		try
 		{
@@ -103,6 +163,10 @@ namespace LAYER_NAMESPACE
 	{
 		DebugLog("--> xrDestroySession\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrDestroySession, false);
+#endif
+
 		XrResult result;
 		try
 		{
@@ -119,10 +183,206 @@ namespace LAYER_NAMESPACE
 		return result;
 	}
 
+	XrResult xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain)
+	{
+		DebugLog("--> xrCreateSwapchain\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrCreateSwapchain, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrCreateSwapchain(session, createInfo, swapchain);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrCreateSwapchain %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrDestroySwapchain(XrSwapchain swapchain)
+	{
+		DebugLog("--> xrDestroySwapchain\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrDestroySwapchain, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrDestroySwapchain(swapchain);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrDestroySwapchain %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)
+	{
+		DebugLog("--> xrAcquireSwapchainImage\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrAcquireSwapchainImage, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrAcquireSwapchainImage(swapchain, acquireInfo, index);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrAcquireSwapchainImage %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo)
+	{
+		DebugLog("--> xrReleaseSwapchainImage\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrReleaseSwapchainImage, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrReleaseSwapchainImage(swapchain, releaseInfo);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrReleaseSwapchainImage %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo)
+	{
+		DebugLog("--> xrBeginSession\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrBeginSession, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrBeginSession(session, beginInfo);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrBeginSession %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrEndSession(XrSession session)
+	{
+		DebugLog("--> xrEndSession\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrEndSession, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrEndSession(session);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrEndSession %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)
+	{
+		DebugLog("--> xrWaitFrame\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrWaitFrame, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrWaitFrame(session, frameWaitInfo, frameState);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrWaitFrame %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo)
+	{
+		DebugLog("--> xrBeginFrame\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrBeginFrame, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrBeginFrame(session, frameBeginInfo);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrBeginFrame %d\n", result);
+
+		return result;
+	}
+
 	XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo)
 	{
 		DebugLog("--> xrEndFrame\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrEndFrame, false);
+#endif
+
 		XrResult result;
 		try
 		{
@@ -139,47 +399,383 @@ namespace LAYER_NAMESPACE
 		return result;
 	}
 
+	XrResult xrCreatePassthroughFB(XrSession session, const XrPassthroughCreateInfoFB* createInfo, XrPassthroughFB* outPassthrough)
+	{
+		DebugLog("--> xrCreatePassthroughFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrCreatePassthroughFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrCreatePassthroughFB(session, createInfo, outPassthrough);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrCreatePassthroughFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrDestroyPassthroughFB(XrPassthroughFB passthrough)
+	{
+		DebugLog("--> xrDestroyPassthroughFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrDestroyPassthroughFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrDestroyPassthroughFB(passthrough);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrDestroyPassthroughFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrPassthroughStartFB(XrPassthroughFB passthrough)
+	{
+		DebugLog("--> xrPassthroughStartFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPassthroughStartFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPassthroughStartFB(passthrough);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPassthroughStartFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrPassthroughPauseFB(XrPassthroughFB passthrough)
+	{
+		DebugLog("--> xrPassthroughPauseFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPassthroughPauseFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPassthroughPauseFB(passthrough);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPassthroughPauseFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrCreatePassthroughLayerFB(XrSession session, const XrPassthroughLayerCreateInfoFB* createInfo, XrPassthroughLayerFB* outLayer)
+	{
+		DebugLog("--> xrCreatePassthroughLayerFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrCreatePassthroughLayerFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrCreatePassthroughLayerFB(session, createInfo, outLayer);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrCreatePassthroughLayerFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer)
+	{
+		DebugLog("--> xrDestroyPassthroughLayerFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrDestroyPassthroughLayerFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrDestroyPassthroughLayerFB(layer);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrDestroyPassthroughLayerFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrPassthroughLayerPauseFB(XrPassthroughLayerFB layer)
+	{
+		DebugLog("--> xrPassthroughLayerPauseFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPassthroughLayerPauseFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPassthroughLayerPauseFB(layer);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPassthroughLayerPauseFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrPassthroughLayerResumeFB(XrPassthroughLayerFB layer)
+	{
+		DebugLog("--> xrPassthroughLayerResumeFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPassthroughLayerResumeFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPassthroughLayerResumeFB(layer);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPassthroughLayerResumeFB %d\n", result);
+
+		return result;
+	}
+
+	XrResult xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB layer, const XrPassthroughStyleFB* style)
+	{
+		DebugLog("--> xrPassthroughLayerSetStyleFB\n");
+
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::xrPassthroughLayerSetStyleFB, false);
+#endif
+
+		XrResult result;
+		try
+		{
+			result = LAYER_NAMESPACE::GetInstance()->xrPassthroughLayerSetStyleFB(layer, style);
+		}
+		catch (std::exception exc)
+		{
+			Log("%s\n", exc.what());
+			result = XR_ERROR_RUNTIME_FAILURE;
+		}
+
+		DebugLog("<-- xrPassthroughLayerSetStyleFB %d\n", result);
+
+		return result;
+	}
+
 
 	// Auto-generated dispatcher handler.
 	XrResult OpenXrApi::xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
 	{
-		XrResult result = m_xrGetInstanceProcAddr(instance, name, function);
+		static constexpr std::array<std::string_view, 16> interceptedFunctions = {
+			"xrAcquireSwapchainImage",
+			"xrBeginFrame",
+			"xrBeginSession",
+			"xrCreateSession",
+			"xrCreateSwapchain",
+			"xrDestroyInstance",
+			"xrDestroySession",
+			"xrDestroySwapchain",
+			"xrEndFrame",
+			"xrEndSession",
+			"xrEnumerateEnvironmentBlendModes",
+			"xrGetSystem",
+			"xrGetSystemProperties",
+			"xrPollEvent",
+			"xrReleaseSwapchainImage",
+			"xrWaitFrame",
+		};
+
+		// The functions implemented by the layer are never resolved from the next layer or the runtime.
+		static constexpr std::array<std::pair<std::string_view, std::string_view>, 9> implementedFunctions = {{
+			{ "xrCreatePassthroughFB", "XR_FB_passthrough" },
+			{ "xrCreatePassthroughLayerFB", "XR_FB_passthrough" },
+			{ "xrDestroyPassthroughFB", "XR_FB_passthrough" },
+			{ "xrDestroyPassthroughLayerFB", "XR_FB_passthrough" },
+			{ "xrPassthroughLayerPauseFB", "XR_FB_passthrough" },
+			{ "xrPassthroughLayerResumeFB", "XR_FB_passthrough" },
+			{ "xrPassthroughLayerSetStyleFB", "XR_FB_passthrough" },
+			{ "xrPassthroughPauseFB", "XR_FB_passthrough" },
+			{ "xrPassthroughStartFB", "XR_FB_passthrough" },
+		}};
 
-		if (XR_SUCCEEDED(result))
 		{
-			const std::string apiName(name);
+			const std::string_view apiName(name);
 
-			if (apiName == "xrDestroyInstance")
-			{
-				m_xrDestroyInstance = reinterpret_cast<PFN_xrDestroyInstance>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroyInstance);
-			}
-			else if (apiName == "xrGetSystem")
-			{
-				m_xrGetSystem = reinterpret_cast<PFN_xrGetSystem>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetSystem);
-			}
-			else if (apiName == "xrEnumerateEnvironmentBlendModes")
-			{
-				m_xrEnumerateEnvironmentBlendModes = reinterpret_cast<PFN_xrEnumerateEnvironmentBlendModes>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrEnumerateEnvironmentBlendModes);
-			}
-			else if (apiName == "xrCreateSession")
-			{
-				m_xrCreateSession = reinterpret_cast<PFN_xrCreateSession>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrCreateSession);
-			}
-			else if (apiName == "xrDestroySession")
+			const auto it = std::lower_bound(implementedFunctions.cbegin(), implementedFunctions.cend(), apiName,
+				[](const auto& entry, const std::string_view& value) { return entry.first < value; });
+			if (it != implementedFunctions.cend() && it->first == apiName)
 			{
-				m_xrDestroySession = reinterpret_cast<PFN_xrDestroySession>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroySession);
+				if (!IsExtensionEnabled(it->second))
+				{
+					*function = nullptr;
+					return XR_ERROR_FUNCTION_UNSUPPORTED;
+				}
+
+				switch (it - implementedFunctions.cbegin())
+				{
+				case 0:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrCreatePassthroughFB);
+					break;
+				case 1:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrCreatePassthroughLayerFB);
+					break;
+				case 2:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroyPassthroughFB);
+					break;
+				case 3:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroyPassthroughLayerFB);
+					break;
+				case 4:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPassthroughLayerPauseFB);
+					break;
+				case 5:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPassthroughLayerResumeFB);
+					break;
+				case 6:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPassthroughLayerSetStyleFB);
+					break;
+				case 7:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPassthroughPauseFB);
+					break;
+				case 8:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPassthroughStartFB);
+					break;
+				}
+
+				return XR_SUCCESS;
 			}
-			else if (apiName == "xrEndFrame")
+		}
+
+		XrResult result = m_xrGetInstanceProcAddr(instance, name, function);
+
+		if (XR_SUCCEEDED(result))
+		{
+			const std::string_view apiName(name);
+
+			const auto it = std::lower_bound(interceptedFunctions.cbegin(), interceptedFunctions.cend(), apiName);
+			if (it != interceptedFunctions.cend() && *it == apiName)
 			{
-				m_xrEndFrame = reinterpret_cast<PFN_xrEndFrame>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrEndFrame);
+				switch (it - interceptedFunctions.cbegin())
+				{
+				case 0:
+					m_xrAcquireSwapchainImage = reinterpret_cast<PFN_xrAcquireSwapchainImage>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrAcquireSwapchainImage);
+					break;
+				case 1:
+					m_xrBeginFrame = reinterpret_cast<PFN_xrBeginFrame>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrBeginFrame);
+					break;
+				case 2:
+					m_xrBeginSession = reinterpret_cast<PFN_xrBeginSession>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrBeginSession);
+					break;
+				case 3:
+					m_xrCreateSession = reinterpret_cast<PFN_xrCreateSession>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrCreateSession);
+					break;
+				case 4:
+					m_xrCreateSwapchain = reinterpret_cast<PFN_xrCreateSwapchain>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrCreateSwapchain);
+					break;
+				case 5:
+					m_xrDestroyInstance = reinterpret_cast<PFN_xrDestroyInstance>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroyInstance);
+					break;
+				case 6:
+					m_xrDestroySession = reinterpret_cast<PFN_xrDestroySession>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroySession);
+					break;
+				case 7:
+					m_xrDestroySwapchain = reinterpret_cast<PFN_xrDestroySwapchain>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroySwapchain);
+					break;
+				case 8:
+					m_xrEndFrame = reinterpret_cast<PFN_xrEndFrame>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrEndFrame);
+					break;
+				case 9:
+					m_xrEndSession = reinterpret_cast<PFN_xrEndSession>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrEndSession);
+					break;
+				case 10:
+					m_xrEnumerateEnvironmentBlendModes = reinterpret_cast<PFN_xrEnumerateEnvironmentBlendModes>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrEnumerateEnvironmentBlendModes);
+					break;
+				case 11:
+					m_xrGetSystem = reinterpret_cast<PFN_xrGetSystem>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetSystem);
+					break;
+				case 12:
+					m_xrGetSystemProperties = reinterpret_cast<PFN_xrGetSystemProperties>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrGetSystemProperties);
+					break;
+				case 13:
+					m_xrPollEvent = reinterpret_cast<PFN_xrPollEvent>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrPollEvent);
+					break;
+				case 14:
+					m_xrReleaseSwapchainImage = reinterpret_cast<PFN_xrReleaseSwapchainImage>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrReleaseSwapchainImage);
+					break;
+				case 15:
+					m_xrWaitFrame = reinterpret_cast<PFN_xrWaitFrame>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrWaitFrame);
+					break;
+				}
 			}
-
 		}
 
 		return result;
@@ -196,6 +792,10 @@ namespace LAYER_NAMESPACE
 		{
 			throw new std::runtime_error("Failed to resolve xrCreateReferenceSpace");
 		}
+		if (XR_FAILED(m_xrGetInstanceProcAddr(m_instance, "xrLocateSpace", reinterpret_cast<PFN_xrVoidFunction*>(&m_xrLocateSpace))))
+		{
+			throw new std::runtime_error("Failed to resolve xrLocateSpace");
+		}
 		if (XR_FAILED(m_xrGetInstanceProcAddr(m_instance, "xrDestroySpace", reinterpret_cast<PFN_xrVoidFunction*>(&m_xrDestroySpace))))
 		{
 			throw new std::runtime_error("Failed to resolve xrDestroySpace");
@@ -236,9 +836,131 @@ namespace LAYER_NAMESPACE
 		{
 			throw new std::runtime_error("Failed to resolve xrLocateViews");
 		}
+		if (XR_FAILED(m_xrGetInstanceProcAddr(m_instance, "xrConvertWin32PerformanceCounterToTimeKHR", reinterpret_cast<PFN_xrVoidFunction*>(&m_xrConvertWin32PerformanceCounterToTimeKHR))))
+		{
+			m_xrConvertWin32PerformanceCounterToTimeKHR = nullptr;
+		}
 		m_applicationName = createInfo->applicationInfo.applicationName;
+		for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++)
+		{
+			m_enabledExtensions.push_back(createInfo->enabledExtensionNames[i]);
+		}
 		return XR_SUCCESS;
 	}
 
+#ifdef LAYER_API_TIMING
+	// Auto-generated API timing statistics.
+	ApiTimingStatistics g_apiTimingStatistics[static_cast<size_t>(ApiTimingIndex::Count)];
+
+	namespace
+	{
+		// Reference points to convert the time stamp counter ticks into microseconds.
+		struct ApiTimingEpoch
+		{
+			ApiTimingEpoch()
+			{
+				reset();
+			}
+
+			void reset()
+			{
+				QueryPerformanceCounter(&qpc);
+				tsc = __rdtsc();
+			}
+
+			LARGE_INTEGER qpc;
+			uint64_t tsc;
+		} g_apiTimingEpoch;
+
+		const char* const ApiNames[] = {
+			"xrDestroyInstance",
+			"xrGetInstanceProperties",
+			"xrPollEvent",
+			"xrGetSystem",
+			"xrGetSystemProperties",
+			"xrEnumerateEnvironmentBlendModes",
+			"xrCreateSession",
+			"xrDestroySession",
+			"xrCreateReferenceSpace",
+			"xrLocateSpace",
+			"xrDestroySpace",
+			"xrEnumerateViewConfigurationViews",
+			"xrEnumerateSwapchainFormats",
+			"xrCreateSwapchain",
+			"xrDestroySwapchain",
+			"xrEnumerateSwapchainImages",
+			"xrAcquireSwapchainImage",
+			"xrWaitSwapchainImage",
+			"xrReleaseSwapchainImage",
+			"xrBeginSession",
+			"xrEndSession",
+			"xrWaitFrame",
+			"xrBeginFrame",
+			"xrEndFrame",
+			"xrLocateViews",
+			"xrConvertWin32PerformanceCounterToTimeKHR",
+			"xrCreatePassthroughFB",
+			"xrDestroyPassthroughFB",
+			"xrPassthroughStartFB",
+			"xrPassthroughPauseFB",
+			"xrCreatePassthroughLayerFB",
+			"xrDestroyPassthroughLayerFB",
+			"xrPassthroughLayerPauseFB",
+			"xrPassthroughLayerResumeFB",
+			"xrPassthroughLayerSetStyleFB",
+		};
+	} // namespace
+
+	void DumpApiTimingStatistics()
+	{
+		LARGE_INTEGER qpcFrequency;
+		LARGE_INTEGER qpcNow;
+		QueryPerformanceFrequency(&qpcFrequency);
+		QueryPerformanceCounter(&qpcNow);
+		const uint64_t tscNow = __rdtsc();
+
+		const double elapsedUs = (double)(qpcNow.QuadPart - g_apiTimingEpoch.qpc.QuadPart) * 1e6 / qpcFrequency.QuadPart;
+		const double ticksPerUs = elapsedUs > 0 ? (tscNow - g_apiTimingEpoch.tsc) / elapsedUs : 1.0;
+		g_apiTimingEpoch.reset();
+
+		// Rows are batched to keep the number of log messages low.
+		std::string rows = fmt::format("API timing statistics over {:.1f} s (total = layer + downstream, downstream = next layer or runtime):\n", elapsedUs / 1e6);
+		rows += fmt::format("{:<40} {:>10} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n", "Function", "Calls", "Total avg us", "Total max us", "Layer avg us", "Down calls", "Down avg us", "Down max us");
+		for (size_t i = 0; i < static_cast<size_t>(ApiTimingIndex::Count); i++)
+		{
+			ApiTimingStatistics& statistics = g_apiTimingStatistics[i];
+			const uint64_t callCount = statistics.callCount.exchange(0);
+			const uint64_t totalTicks = statistics.totalTicks.exchange(0);
+			const uint64_t maxTicks = statistics.maxTicks.exchange(0);
+			const uint64_t downstreamCallCount = statistics.downstreamCallCount.exchange(0);
+			const uint64_t downstreamTicks = statistics.downstreamTicks.exchange(0);
+			const uint64_t maxDownstreamTicks = statistics.maxDownstreamTicks.exchange(0);
+			if (!callCount && !downstreamCallCount)
+			{
+				continue;
+			}
+
+			rows += fmt::format("{:<40} {:>10} {:>12.1f} {:>12.1f} {:>12.1f} {:>12} {:>12.1f} {:>12.1f}\n",
+				ApiNames[i],
+				callCount,
+				callCount ? totalTicks / ticksPerUs / callCount : 0.0,
+				maxTicks / ticksPerUs,
+				callCount && totalTicks > downstreamTicks ? (totalTicks - downstreamTicks) / ticksPerUs / callCount : 0.0,
+				downstreamCallCount,
+				downstreamCallCount ? downstreamTicks / ticksPerUs / downstreamCallCount : 0.0,
+				maxDownstreamTicks / ticksPerUs);
+			if (rows.size() > 768)
+			{
+				Log("%s", rows.c_str());
+				rows.clear();
+			}
+		}
+		if (!rows.empty())
+		{
+			Log("%s", rows.c_str());
+		}
+	}
+#endif
+
 } // namespace LAYER_NAMESPACE
 
@@ -30,11 +30,121 @@
 namespace LAYER_NAMESPACE
 {
 
+#ifdef LAYER_API_TIMING
+	// Indices of the entries in the API timing statistics table.
+	enum class ApiTimingIndex : uint32_t
+	{
+		xrDestroyInstance,
+		xrGetInstanceProperties,
+		xrPollEvent,
+		xrGetSystem,
+		xrGetSystemProperties,
+		xrEnumerateEnvironmentBlendModes,
+		xrCreateSession,
+		xrDestroySession,
+		xrCreateReferenceSpace,
+		xrLocateSpace,
+		xrDestroySpace,
+		xrEnumerateViewConfigurationViews,
+		xrEnumerateSwapchainFormats,
+		xrCreateSwapchain,
+		xrDestroySwapchain,
+		xrEnumerateSwapchainImages,
+		xrAcquireSwapchainImage,
+		xrWaitSwapchainImage,
+		xrReleaseSwapchainImage,
+		xrBeginSession,
+		xrEndSession,
+		xrWaitFrame,
+		xrBeginFrame,
+		xrEndFrame,
+		xrLocateViews,
+		xrConvertWin32PerformanceCounterToTimeKHR,
+		xrCreatePassthroughFB,
+		xrDestroyPassthroughFB,
+		xrPassthroughStartFB,
+		xrPassthroughPauseFB,
+		xrCreatePassthroughLayerFB,
+		xrDestroyPassthroughLayerFB,
+		xrPassthroughLayerPauseFB,
+		xrPassthroughLayerResumeFB,
+		xrPassthroughLayerSetStyleFB,
+		Count
+	};
+
+	struct ApiTimingStatistics
+	{
+		// Time spent from the entry point of the layer until it returns.
+		std::atomic<uint64_t> callCount{ 0 };
+		std::atomic<uint64_t> totalTicks{ 0 };
+		std::atomic<uint64_t> maxTicks{ 0 };
+
+		// Time spent in the next layer or the runtime.
+		std::atomic<uint64_t> downstreamCallCount{ 0 };
+		std::atomic<uint64_t> downstreamTicks{ 0 };
+		std::atomic<uint64_t> maxDownstreamTicks{ 0 };
+	};
+
+	extern ApiTimingStatistics g_apiTimingStatistics[static_cast<size_t>(ApiTimingIndex::Count)];
+
+	// Log the statistics collected since the previous dump, then reset them.
+	void DumpApiTimingStatistics();
+
+	// Accumulates the time stamp counter ticks elapsed during its lifetime.
+	class ApiTimer
+	{
+	public:
+		ApiTimer(ApiTimingIndex index, bool isDownstream)
+			: m_statistics(g_apiTimingStatistics[static_cast<size_t>(index)]), m_isDownstream(isDownstream), m_start(__rdtsc())
+		{
+		}
+
+		~ApiTimer()
+		{
+			const uint64_t elapsed = __rdtsc() - m_start;
+			if (m_isDownstream)
+			{
+				record(m_statistics.downstreamCallCount, m_statistics.downstreamTicks, m_statistics.maxDownstreamTicks, elapsed);
+			}
+			else
+			{
+				record(m_statistics.callCount, m_statistics.totalTicks, m_statistics.maxTicks, elapsed);
+			}
+		}
+
+	private:
+		static void record(std::atomic<uint64_t>& count, std::atomic<uint64_t>& ticks, std::atomic<uint64_t>& maxTicks, uint64_t elapsed)
+		{
+			count.fetch_add(1, std::memory_order_relaxed);
+			ticks.fetch_add(elapsed, std::memory_order_relaxed);
+			uint64_t previousMax = maxTicks.load(std::memory_order_relaxed);
+			while (elapsed > previousMax && !maxTicks.compare_exchange_weak(previousMax, elapsed, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		ApiTimingStatistics& m_statistics;
+		const bool m_isDownstream;
+		const uint64_t m_start;
+	};
+#endif
+
+	// Auto-generated list of the extensions implemented by the layer.
+	constexpr std::array<std::string_view, 1> ImplementedExtensions = {
+		"XR_FB_passthrough",
+	};
+
+	// Auto-generated list of the extensions the layer enables on the runtime when they are supported.
+	constexpr std::array<std::string_view, 1> RequestedExtensions = {
+		"XR_KHR_win32_convert_performance_counter_time",
+	};
+
 	class OpenXrApi
 	{
 	private:
 		XrInstance m_instance{ XR_NULL_HANDLE };
 		std::string m_applicationName;
+		std::vector<std::string> m_enabledExtensions;
 		std::vector<std::string> m_upstreamLayers;
 
 	protected:
@@ -71,6 +181,11 @@ namespace LAYER_NAMESPACE
 			return m_upstreamLayers;
 		}
 
+		bool IsExtensionEnabled(std::string_view extensionName) const
+		{
+			return std::find(m_enabledExtensions.cbegin(), m_enabledExtensions.cend(), extensionName) != m_enabledExtensions.cend();
+		}
+
 		// Specially-handled by the auto-generated code.
 		virtual XrResult xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
 		virtual XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo);
@@ -81,6 +196,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrDestroyInstance(XrInstance instance)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrDestroyInstance, true);
+#endif
 			return m_xrDestroyInstance(instance);
 		}
 	private:
@@ -89,22 +207,53 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrGetInstanceProperties, true);
+#endif
 			return m_xrGetInstanceProperties(instance, instanceProperties);
 		}
 	private:
 		PFN_xrGetInstanceProperties m_xrGetInstanceProperties{ nullptr };
 
+	public:
+		virtual XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrPollEvent, true);
+#endif
+			return m_xrPollEvent(instance, eventData);
+		}
+	private:
+		PFN_xrPollEvent m_xrPollEvent{ nullptr };
+
 	public:
 		virtual XrResult xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrGetSystem, true);
+#endif
 			return m_xrGetSystem(instance, getInfo, systemId);
 		}
 	private:
 		PFN_xrGetSystem m_xrGetSystem{ nullptr };
 
+	public:
+		virtual XrResult xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrGetSystemProperties, true);
+#endif
+			return m_xrGetSystemProperties(instance, systemId, properties);
+		}
+	private:
+		PFN_xrGetSystemProperties m_xrGetSystemProperties{ nullptr };
+
 	public:
 		virtual XrResult xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEnumerateEnvironmentBlendModes, true);
+#endif
 			return m_xrEnumerateEnvironmentBlendModes(instance, systemId, viewConfigurationType, environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes);
 		}
 	private:
@@ -113,6 +262,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrCreateSession, true);
+#endif
 			return m_xrCreateSession(instance, createInfo, session);
 		}
 	private:
@@ -121,6 +273,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrDestroySession(XrSession session)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrDestroySession, true);
+#endif
 			return m_xrDestroySession(session);
 		}
 	private:
@@ -129,14 +284,31 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrCreateReferenceSpace, true);
+#endif
 			return m_xrCreateReferenceSpace(session, createInfo, space);
 		}
 	private:
 		PFN_xrCreateReferenceSpace m_xrCreateReferenceSpace{ nullptr };
 
+	public:
+		virtual XrResult xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrLocateSpace, true);
+#endif
+			return m_xrLocateSpace(space, baseSpace, time, location);
+		}
+	private:
+		PFN_xrLocateSpace m_xrLocateSpace{ nullptr };
+
 	public:
 		virtual XrResult xrDestroySpace(XrSpace space)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrDestroySpace, true);
+#endif
 			return m_xrDestroySpace(space);
 		}
 	private:
@@ -145,6 +317,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEnumerateViewConfigurationViews, true);
+#endif
 			return m_xrEnumerateViewConfigurationViews(instance, systemId, viewConfigurationType, viewCapacityInput, viewCountOutput, views);
 		}
 	private:
@@ -153,6 +328,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEnumerateSwapchainFormats, true);
+#endif
 			return m_xrEnumerateSwapchainFormats(session, formatCapacityInput, formatCountOutput, formats);
 		}
 	private:
@@ -161,6 +339,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrCreateSwapchain, true);
+#endif
 			return m_xrCreateSwapchain(session, createInfo, swapchain);
 		}
 	private:
@@ -169,6 +350,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrDestroySwapchain(XrSwapchain swapchain)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrDestroySwapchain, true);
+#endif
 			return m_xrDestroySwapchain(swapchain);
 		}
 	private:
@@ -177,6 +361,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEnumerateSwapchainImages, true);
+#endif
 			return m_xrEnumerateSwapchainImages(swapchain, imageCapacityInput, imageCountOutput, images);
 		}
 	private:
@@ -185,6 +372,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrAcquireSwapchainImage, true);
+#endif
 			return m_xrAcquireSwapchainImage(swapchain, acquireInfo, index);
 		}
 	private:
@@ -193,6 +383,9 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrWaitSwapchainImage, true);
+#endif
 			return m_xrWaitSwapchainImage(swapchain, waitInfo);
 		}
 	private:
@@ -201,14 +394,64 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrReleaseSwapchainImage, true);
+#endif
 			return m_xrReleaseSwapchainImage(swapchain, releaseInfo);
 		}
 	private:
 		PFN_xrReleaseSwapchainImage m_xrReleaseSwapchainImage{ nullptr };
 
+	public:
+		virtual XrResult xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrBeginSession, true);
+#endif
+			return m_xrBeginSession(session, beginInfo);
+		}
+	private:
+		PFN_xrBeginSession m_xrBeginSession{ nullptr };
+
+	public:
+		virtual XrResult xrEndSession(XrSession session)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEndSession, true);
+#endif
+			return m_xrEndSession(session);
+		}
+	private:
+		PFN_xrEndSession m_xrEndSession{ nullptr };
+
+	public:
+		virtual XrResult xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrWaitFrame, true);
+#endif
+			return m_xrWaitFrame(session, frameWaitInfo, frameState);
+		}
+	private:
+		PFN_xrWaitFrame m_xrWaitFrame{ nullptr };
+
+	public:
+		virtual XrResult xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo)
+		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrBeginFrame, true);
+#endif
+			return m_xrBeginFrame(session, frameBeginInfo);
+		}
+	private:
+		PFN_xrBeginFrame m_xrBeginFrame{ nullptr };
+
 	public:
 		virtual XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrEndFrame, true);
+#endif
 			return m_xrEndFrame(session, frameEndInfo);
 		}
 	private:
@@ -217,11 +460,83 @@ namespace LAYER_NAMESPACE
 	public:
 		virtual XrResult xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)
 		{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrLocateViews, true);
+#endif
 			return m_xrLocateViews(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
 		}
 	private:
 		PFN_xrLocateViews m_xrLocateViews{ nullptr };
 
+	public:
+		virtual XrResult xrConvertWin32PerformanceCounterToTimeKHR(XrInstance instance, const LARGE_INTEGER* performanceCounter, XrTime* time)
+		{
+			if (!m_xrConvertWin32PerformanceCounterToTimeKHR)
+			{
+				return XR_ERROR_FUNCTION_UNSUPPORTED;
+			}
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::xrConvertWin32PerformanceCounterToTimeKHR, true);
+#endif
+			return m_xrConvertWin32PerformanceCounterToTimeKHR(instance, performanceCounter, time);
+		}
+	private:
+		PFN_xrConvertWin32PerformanceCounterToTimeKHR m_xrConvertWin32PerformanceCounterToTimeKHR{ nullptr };
+
+	public:
+		virtual XrResult xrCreatePassthroughFB(XrSession session, const XrPassthroughCreateInfoFB* createInfo, XrPassthroughFB* outPassthrough)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrDestroyPassthroughFB(XrPassthroughFB passthrough)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrPassthroughStartFB(XrPassthroughFB passthrough)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrPassthroughPauseFB(XrPassthroughFB passthrough)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrCreatePassthroughLayerFB(XrSession session, const XrPassthroughLayerCreateInfoFB* createInfo, XrPassthroughLayerFB* outLayer)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrPassthroughLayerPauseFB(XrPassthroughLayerFB layer)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrPassthroughLayerResumeFB(XrPassthroughLayerFB layer)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+	public:
+		virtual XrResult xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB layer, const XrPassthroughStyleFB* style)
+		{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
 
 
 	};
@@ -54,6 +54,14 @@ if 'xrGetInstanceProcAddr' in layer_apis.override_functions:
 if 'xrGetInstanceProcAddr' in layer_apis.requested_functions:
     raise Exception("xrGetInstanceProcAddr() cannot be specified in requested_functions. Use the m_xrGetInstanceProcAddr() class member.")
 
+for name in layer_apis.requested_extensions:
+    if name in layer_apis.implemented_extensions:
+        raise Exception(f"{name} is implemented by the layer and shall not be specified in requested_extensions.")
+
+for name in layer_apis.implemented_functions:
+    if name in layer_apis.override_functions or name in layer_apis.requested_functions:
+        raise Exception(f"{name}() is implemented by the layer and shall not be specified in override_functions or requested_functions.")
+
 
 class DispatchGenOutputGenerator(AutomaticSourceOutputGenerator):
     '''Common generator utilities and formatting.'''
@@ -89,6 +97,23 @@ class DispatchGenOutputGenerator(AutomaticSourceOutputGenerator):
     def outputGeneratedAuthorNote(self):
         pass
 
+    def layerCommands(self):
+        commands_to_include = list(set(layer_apis.override_functions + layer_apis.requested_functions + ['xrDestroyInstance']))
+        return [cur_cmd for cur_cmd in self.core_commands + self.requestedExtensionCommands() if cur_cmd.name in commands_to_include]
+
+    def requestedExtensionCommands(self):
+        return [cur_cmd for cur_cmd in self.ext_commands if cur_cmd.ext_name in layer_apis.requested_extensions]
+
+    def isOptionalCommand(self, cmd):
+        # The extensions requested by the layer might not be supported by the runtime.
+        return cmd.ext_name in layer_apis.requested_extensions and cmd not in self.core_commands
+
+    def implementedCommands(self):
+        return [cur_cmd for cur_cmd in self.core_commands + self.ext_commands if cur_cmd.name in layer_apis.implemented_functions]
+
+    def timedCommands(self):
+        return self.layerCommands() + self.implementedCommands()
+
     def makeParametersList(self, cmd):
         parameters_list = ""
         for param in cmd.params:
@@ -132,6 +157,7 @@ namespace LAYER_NAMESPACE
         generated_wrappers = self.genWrappers()
         generated_get_instance_proc_addr = self.genGetInstanceProcAddr()
         generated_create_instance = self.genCreateInstance()
+        generated_api_timing = self.genApiTiming()
 
         postamble = '''} // namespace LAYER_NAMESPACE
 '''
@@ -146,6 +172,11 @@ namespace LAYER_NAMESPACE
 	// Auto-generated create instance handler.
 {generated_create_instance}
 
+#ifdef LAYER_API_TIMING
+	// Auto-generated API timing statistics.
+{generated_api_timing}
+#endif
+
 {postamble}'''
 
         write(contents, file=self.outFile)
@@ -154,8 +185,8 @@ namespace LAYER_NAMESPACE
     def genWrappers(self):
         generated = ''
 
-        for cur_cmd in self.core_commands:
-            if cur_cmd.name in layer_apis.override_functions:
+        for cur_cmd in self.core_commands + self.implementedCommands():
+            if cur_cmd.name in layer_apis.override_functions or cur_cmd.name in layer_apis.implemented_functions:
                 parameters_list = self.makeParametersList(cur_cmd)
                 arguments_list = self.makeArgumentsList(cur_cmd)
 
@@ -165,6 +196,10 @@ namespace LAYER_NAMESPACE
 	{{
 		DebugLog("--> {cur_cmd.name}\\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::{cur_cmd.name}, false);
+#endif
+
 		XrResult result;
 		try
 		{{
@@ -187,6 +222,10 @@ namespace LAYER_NAMESPACE
 	{{
 		DebugLog("--> {cur_cmd.name}\\n");
 
+#ifdef LAYER_API_TIMING
+		ApiTimer timer(ApiTimingIndex::{cur_cmd.name}, false);
+#endif
+
 		try
 		{{
 			LAYER_NAMESPACE::GetInstance()->{cur_cmd.name}({arguments_list});
@@ -202,13 +241,106 @@ namespace LAYER_NAMESPACE
                 
         return generated
 
+    def genApiTiming(self):
+        generated = '''	ApiTimingStatistics g_apiTimingStatistics[static_cast<size_t>(ApiTimingIndex::Count)];
+
+	namespace
+	{
+		// Reference points to convert the time stamp counter ticks into microseconds.
+		struct ApiTimingEpoch
+		{
+			ApiTimingEpoch()
+			{
+				reset();
+			}
+
+			void reset()
+			{
+				QueryPerformanceCounter(&qpc);
+				tsc = __rdtsc();
+			}
+
+			LARGE_INTEGER qpc;
+			uint64_t tsc;
+		} g_apiTimingEpoch;
+
+		const char* const ApiNames[] = {
+'''
+
+        for cur_cmd in self.timedCommands():
+            generated += f'''			"{cur_cmd.name}",
+'''
+
+        generated += '''		};
+	} // namespace
+
+	void DumpApiTimingStatistics()
+	{
+		LARGE_INTEGER qpcFrequency;
+		LARGE_INTEGER qpcNow;
+		QueryPerformanceFrequency(&qpcFrequency);
+		QueryPerformanceCounter(&qpcNow);
+		const uint64_t tscNow = __rdtsc();
+
+		const double elapsedUs = (double)(qpcNow.QuadPart - g_apiTimingEpoch.qpc.QuadPart) * 1e6 / qpcFrequency.QuadPart;
+		const double ticksPerUs = elapsedUs > 0 ? (tscNow - g_apiTimingEpoch.tsc) / elapsedUs : 1.0;
+		g_apiTimingEpoch.reset();
+
+		// Rows are batched to keep the number of log messages low.
+		std::string rows = fmt::format("API timing statistics over {:.1f} s (total = layer + downstream, downstream = next layer or runtime):\\n", elapsedUs / 1e6);
+		rows += fmt::format("{:<40} {:>10} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\\n", "Function", "Calls", "Total avg us", "Total max us", "Layer avg us", "Down calls", "Down avg us", "Down max us");
+		for (size_t i = 0; i < static_cast<size_t>(ApiTimingIndex::Count); i++)
+		{
+			ApiTimingStatistics& statistics = g_apiTimingStatistics[i];
+			const uint64_t callCount = statistics.callCount.exchange(0);
+			const uint64_t totalTicks = statistics.totalTicks.exchange(0);
+			const uint64_t maxTicks = statistics.maxTicks.exchange(0);
+			const uint64_t downstreamCallCount = statistics.downstreamCallCount.exchange(0);
+			const uint64_t downstreamTicks = statistics.downstreamTicks.exchange(0);
+			const uint64_t maxDownstreamTicks = statistics.maxDownstreamTicks.exchange(0);
+			if (!callCount && !downstreamCallCount)
+			{
+				continue;
+			}
+
+			rows += fmt::format("{:<40} {:>10} {:>12.1f} {:>12.1f} {:>12.1f} {:>12} {:>12.1f} {:>12.1f}\\n",
+				ApiNames[i],
+				callCount,
+				callCount ? totalTicks / ticksPerUs / callCount : 0.0,
+				maxTicks / ticksPerUs,
+				callCount && totalTicks > downstreamTicks ? (totalTicks - downstreamTicks) / ticksPerUs / callCount : 0.0,
+				downstreamCallCount,
+				downstreamCallCount ? downstreamTicks / ticksPerUs / downstreamCallCount : 0.0,
+				maxDownstreamTicks / ticksPerUs);
+			if (rows.size() > 768)
+			{
+				Log("%s", rows.c_str());
+				rows.clear();
+			}
+		}
+		if (!rows.empty())
+		{
+			Log("%s", rows.c_str());
+		}
+	}'''
+
+        return generated
+
     def genCreateInstance(self):
         generated = '''	XrResult OpenXrApi::xrCreateInstance(const XrInstanceCreateInfo* createInfo)
     {
 '''
 
-        for cur_cmd in self.core_commands:
+        for cur_cmd in self.layerCommands():
             if cur_cmd.name in layer_apis.requested_functions:
+                if self.isOptionalCommand(cur_cmd):
+                    generated += f'''		if (XR_FAILED(m_xrGetInstanceProcAddr(m_instance, "{cur_cmd.name}", reinterpret_cast<PFN_xrVoidFunction*>(&m_{cur_cmd.name}))))
+		{{
+			m_{cur_cmd.name} = nullptr;
+		}}
+'''
+                    continue
+
                 generated += f'''		if (XR_FAILED(m_xrGetInstanceProcAddr(m_instance, "{cur_cmd.name}", reinterpret_cast<PFN_xrVoidFunction*>(&m_{cur_cmd.name}))))
 		{{
 			throw new std::runtime_error("Failed to resolve {cur_cmd.name}");
@@ -216,37 +348,102 @@ namespace LAYER_NAMESPACE
 '''
 
         generated += '''		m_applicationName = createInfo->applicationInfo.applicationName;
+		for (uint32_t i = 0; i < createInfo->enabledExtensionCount; i++)
+		{
+			m_enabledExtensions.push_back(createInfo->enabledExtensionNames[i]);
+		}
 		return XR_SUCCESS;
 	}'''
 
         return generated;
 
     def genGetInstanceProcAddr(self):
-        generated = '''	XrResult OpenXrApi::xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
-	{
+        # The table is sorted so that the lookup can use a binary search without building any string.
+        intercepted_functions = ['xrDestroyInstance']
+        for cur_cmd in self.core_commands:
+            if cur_cmd.name in layer_apis.override_functions:
+                intercepted_functions.append(cur_cmd.name)
+        intercepted_functions.sort()
+
+        implemented_functions = sorted([(cur_cmd.name, cur_cmd.ext_name) for cur_cmd in self.implementedCommands()])
+
+        generated = f'''	XrResult OpenXrApi::xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
+	{{
+		static constexpr std::array<std::string_view, {len(intercepted_functions)}> interceptedFunctions = {{
+'''
+
+        for name in intercepted_functions:
+            generated += f'''			"{name}",
+'''
+
+        generated += '''		};
+'''
+
+        if implemented_functions:
+            generated += f'''
+		// The functions implemented by the layer are never resolved from the next layer or the runtime.
+		static constexpr std::array<std::pair<std::string_view, std::string_view>, {len(implemented_functions)}> implementedFunctions = {{{{
+'''
+
+            for name, extension in implemented_functions:
+                generated += f'''			{{ "{name}", "{extension}" }},
+'''
+
+            generated += '''		}};
+
+		{
+			const std::string_view apiName(name);
+
+			const auto it = std::lower_bound(implementedFunctions.cbegin(), implementedFunctions.cend(), apiName,
+				[](const auto& entry, const std::string_view& value) { return entry.first < value; });
+			if (it != implementedFunctions.cend() && it->first == apiName)
+			{
+				if (!IsExtensionEnabled(it->second))
+				{
+					*function = nullptr;
+					return XR_ERROR_FUNCTION_UNSUPPORTED;
+				}
+
+				switch (it - implementedFunctions.cbegin())
+				{
+'''
+
+            for index, (name, extension) in enumerate(implemented_functions):
+                generated += f'''				case {index}:
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::{name});
+					break;
+'''
+
+            generated += '''				}
+
+				return XR_SUCCESS;
+			}
+		}
+'''
+
+        generated += '''
 		XrResult result = m_xrGetInstanceProcAddr(instance, name, function);
 
 		if (XR_SUCCEEDED(result))
 		{
-			const std::string apiName(name);
+			const std::string_view apiName(name);
 
-			if (apiName == "xrDestroyInstance")
+			const auto it = std::lower_bound(interceptedFunctions.cbegin(), interceptedFunctions.cend(), apiName);
+			if (it != interceptedFunctions.cend() && *it == apiName)
 			{
-				m_xrDestroyInstance = reinterpret_cast<PFN_xrDestroyInstance>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::xrDestroyInstance);
-			}
+				switch (it - interceptedFunctions.cbegin())
+				{
 '''
 
-        for cur_cmd in self.core_commands:
-            if cur_cmd.name in layer_apis.override_functions:
-                generated += f'''			else if (apiName == "{cur_cmd.name}")
-			{{
-				m_{cur_cmd.name} = reinterpret_cast<PFN_{cur_cmd.name}>(*function);
-				*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::{cur_cmd.name});
-			}}
+        for index, name in enumerate(intercepted_functions):
+            generated += f'''				case {index}:
+					m_{name} = reinterpret_cast<PFN_{name}>(*function);
+					*function = reinterpret_cast<PFN_xrVoidFunction>(LAYER_NAMESPACE::{name});
+					break;
 '''
 
-        generated += '''
+        generated += '''				}
+			}
 		}
 
 		return result;
@@ -267,12 +464,22 @@ class DispatchGenHOutputGenerator(DispatchGenOutputGenerator):
 
 namespace LAYER_NAMESPACE
 {
+'''
+        write(preamble, file=self.outFile)
+
+    def endFile(self):
+        generated_api_timing = self.genApiTiming()
+        generated_implemented_extensions = self.genExtensionsList('ImplementedExtensions', layer_apis.implemented_extensions)
+        generated_requested_extensions = self.genExtensionsList('RequestedExtensions', layer_apis.requested_extensions)
+        generated_virtual_methods = self.genVirtualMethods()
 
+        class_preamble = '''
 	class OpenXrApi
 	{
 	private:
 		XrInstance m_instance{ XR_NULL_HANDLE };
 		std::string m_applicationName;
+		std::vector<std::string> m_enabledExtensions;
 		std::vector<std::string> m_upstreamLayers;
 
 	protected:
@@ -309,14 +516,15 @@ namespace LAYER_NAMESPACE
 			return m_upstreamLayers;
 		}
 
+		bool IsExtensionEnabled(std::string_view extensionName) const
+		{
+			return std::find(m_enabledExtensions.cbegin(), m_enabledExtensions.cend(), extensionName) != m_enabledExtensions.cend();
+		}
+
 		// Specially-handled by the auto-generated code.
 		virtual XrResult xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function);
 		virtual XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo);
 '''
-        write(preamble, file=self.outFile)
-
-    def endFile(self):
-        generated_virtual_methods = self.genVirtualMethods()
 
         postamble = '''
 	};
@@ -324,7 +532,17 @@ namespace LAYER_NAMESPACE
 } // namespace LAYER_NAMESPACE
 '''
 
-        contents = f'''
+        contents = f'''#ifdef LAYER_API_TIMING
+{generated_api_timing}
+#endif
+
+	// Auto-generated list of the extensions implemented by the layer.
+{generated_implemented_extensions}
+
+	// Auto-generated list of the extensions the layer enables on the runtime when they are supported.
+{generated_requested_extensions}
+{class_preamble}
+
 		// Auto-generated entries for the requested APIs.
 {generated_virtual_methods}
 
@@ -334,37 +552,275 @@ namespace LAYER_NAMESPACE
 
         DispatchGenOutputGenerator.endFile(self)
 
+    def genApiTiming(self):
+        generated = '''	// Indices of the entries in the API timing statistics table.
+	enum class ApiTimingIndex : uint32_t
+	{
+'''
+
+        for cur_cmd in self.timedCommands():
+            generated += f'''		{cur_cmd.name},
+'''
+
+        generated += '''		Count
+	};
+
+	struct ApiTimingStatistics
+	{
+		// Time spent from the entry point of the layer until it returns.
+		std::atomic<uint64_t> callCount{ 0 };
+		std::atomic<uint64_t> totalTicks{ 0 };
+		std::atomic<uint64_t> maxTicks{ 0 };
+
+		// Time spent in the next layer or the runtime.
+		std::atomic<uint64_t> downstreamCallCount{ 0 };
+		std::atomic<uint64_t> downstreamTicks{ 0 };
+		std::atomic<uint64_t> maxDownstreamTicks{ 0 };
+	};
+
+	extern ApiTimingStatistics g_apiTimingStatistics[static_cast<size_t>(ApiTimingIndex::Count)];
+
+	// Log the statistics collected since the previous dump, then reset them.
+	void DumpApiTimingStatistics();
+
+	// Accumulates the time stamp counter ticks elapsed during its lifetime.
+	class ApiTimer
+	{
+	public:
+		ApiTimer(ApiTimingIndex index, bool isDownstream)
+			: m_statistics(g_apiTimingStatistics[static_cast<size_t>(index)]), m_isDownstream(isDownstream), m_start(__rdtsc())
+		{
+		}
+
+		~ApiTimer()
+		{
+			const uint64_t elapsed = __rdtsc() - m_start;
+			if (m_isDownstream)
+			{
+				record(m_statistics.downstreamCallCount, m_statistics.downstreamTicks, m_statistics.maxDownstreamTicks, elapsed);
+			}
+			else
+			{
+				record(m_statistics.callCount, m_statistics.totalTicks, m_statistics.maxTicks, elapsed);
+			}
+		}
+
+	private:
+		static void record(std::atomic<uint64_t>& count, std::atomic<uint64_t>& ticks, std::atomic<uint64_t>& maxTicks, uint64_t elapsed)
+		{
+			count.fetch_add(1, std::memory_order_relaxed);
+			ticks.fetch_add(elapsed, std::memory_order_relaxed);
+			uint64_t previousMax = maxTicks.load(std::memory_order_relaxed);
+			while (elapsed > previousMax && !maxTicks.compare_exchange_weak(previousMax, elapsed, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		ApiTimingStatistics& m_statistics;
+		const bool m_isDownstream;
+		const uint64_t m_start;
+	};'''
+
+        return generated
+
+    def genExtensionsList(self, list_name, extensions):
+        generated = f'''	constexpr std::array<std::string_view, {len(extensions)}> {list_name} = {{
+'''
+
+        for name in extensions:
+            generated += f'''		"{name}",
+'''
+
+        generated += '''	};'''
+
+        return generated
+
     def genVirtualMethods(self):
         generated = ''
 
-        commands_to_include = list(set(layer_apis.override_functions + layer_apis.requested_functions + ['xrDestroyInstance']))
-        for cur_cmd in self.core_commands:
-            if cur_cmd.name in commands_to_include:
-                parameters_list = self.makeParametersList(cur_cmd)
-                arguments_list = self.makeArgumentsList(cur_cmd)
+        for cur_cmd in self.layerCommands():
+            parameters_list = self.makeParametersList(cur_cmd)
+            arguments_list = self.makeArgumentsList(cur_cmd)
 
-                generated += '''
+            generated += '''
 	public:'''
 
-                if cur_cmd.return_type is not None:
-                    generated += f'''
+            # Functions from the requested extensions might not have been resolved.
+            check_resolved = ''
+            if self.isOptionalCommand(cur_cmd) and cur_cmd.return_type is not None:
+                check_resolved = f'''
+			if (!m_{cur_cmd.name})
+			{{
+				return XR_ERROR_FUNCTION_UNSUPPORTED;
+			}}'''
+
+            if cur_cmd.return_type is not None:
+                generated += f'''
 		virtual XrResult {cur_cmd.name}({parameters_list})
-		{{
+		{{{check_resolved}
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::{cur_cmd.name}, true);
+#endif
 			return m_{cur_cmd.name}({arguments_list});
 		}}
 '''
-                else:
-                    generated += f'''
+            else:
+                generated += f'''
 		virtual void {cur_cmd.name}({parameters_list})
 		{{
+#ifdef LAYER_API_TIMING
+			ApiTimer timer(ApiTimingIndex::{cur_cmd.name}, true);
+#endif
 			m_{cur_cmd.name}({arguments_list});
 		}}
 '''
 
-                generated += f'''	private:
+            generated += f'''	private:
 		PFN_{cur_cmd.name} m_{cur_cmd.name}{{ nullptr }};
 '''
-                
+
+        # The functions implemented by the layer have no next layer to call.
+        for cur_cmd in self.implementedCommands():
+            parameters_list = self.makeParametersList(cur_cmd)
+
+            generated += f'''
+	public:
+		virtual XrResult {cur_cmd.name}({parameters_list})
+		{{
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}}
+'''
+
+        return generated
+
+
+class DispatchGenMockOutputGenerator(DispatchGenOutputGenerator):
+    '''Generator for mock_runtime.gen.h.'''
+    def beginFile(self, genOpts):
+        DispatchGenOutputGenerator.beginFile(self, genOpts)
+        preamble = '''#pragma once
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#ifndef LAYER_NAMESPACE
+#error Must define LAYER_NAMESPACE
+#endif
+
+namespace LAYER_NAMESPACE::mock
+{
+
+	// A fake "next layer" implementing all the functions overriden or requested by the layer, so that the layer can be
+	// exercised without a runtime or a headset. Each function counts its invocations and can be scripted by setting its
+	// hook. Without a hook, a function does nothing and returns XR_SUCCESS.
+	// Only one MockRuntime may exist at a time.
+	class MockRuntime
+	{
+	public:
+		MockRuntime()
+		{
+			s_instance = this;
+		}
+
+		~MockRuntime()
+		{
+			s_instance = nullptr;
+		}
+
+		// To be handed to the layer as the next xrGetInstanceProcAddr.
+		static XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
+		{
+			const std::string_view apiName(name);
+'''
+        write(preamble, file=self.outFile)
+
+    def endFile(self):
+        generated_resolver = self.genResolver()
+        generated_reset_counters = self.genResetCounters()
+        generated_entries = self.genEntries()
+
+        postamble = '''
+		static inline MockRuntime* s_instance{ nullptr };
+	};
+
+} // namespace LAYER_NAMESPACE::mock
+'''
+
+        contents = f'''{generated_resolver}
+			*function = nullptr;
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}}
+
+		void ResetCounters()
+		{{
+{generated_reset_counters}
+			callLog.clear();
+		}}
+
+		// When set, the name of each function called is appended to callLog.
+		bool recordCalls{{ false }};
+		std::vector<const char*> callLog;
+
+		// Auto-generated entries for the mocked APIs.
+{generated_entries}
+{postamble}'''
+
+        write(contents, file=self.outFile)
+
+        DispatchGenOutputGenerator.endFile(self)
+
+    def genResolver(self):
+        generated = ''
+
+        for cur_cmd in self.layerCommands():
+            generated += f'''			if (apiName == "{cur_cmd.name}")
+			{{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_{cur_cmd.name});
+				return XR_SUCCESS;
+			}}
+'''
+
+        return generated
+
+    def genResetCounters(self):
+        generated = ''
+
+        for cur_cmd in self.layerCommands():
+            generated += f'''			{cur_cmd.name}Count = 0;
+'''
+
+        return generated.rstrip('\n')
+
+    def genEntries(self):
+        generated = ''
+
+        for cur_cmd in self.layerCommands():
+            parameters_list = self.makeParametersList(cur_cmd)
+            arguments_list = self.makeArgumentsList(cur_cmd)
+
+            return_type = 'XrResult' if cur_cmd.return_type is not None else 'void'
+            default_return = 'XR_SUCCESS' if cur_cmd.return_type is not None else ''
+            generated += f'''
+	public:
+		std::function<{return_type}({parameters_list})> {cur_cmd.name}Hook;
+		uint64_t {cur_cmd.name}Count{{ 0 }};
+	private:
+		static {return_type} XRAPI_CALL Mock_{cur_cmd.name}({parameters_list})
+		{{
+			s_instance->{cur_cmd.name}Count++;
+			if (s_instance->recordCalls)
+			{{
+				s_instance->callLog.push_back("{cur_cmd.name}");
+			}}
+			if (s_instance->{cur_cmd.name}Hook)
+			{{
+				return s_instance->{cur_cmd.name}Hook({arguments_list});
+			}}
+			return {default_return};
+		}}
+'''.replace('return ;', 'return;')
+
         return generated
 
 
@@ -402,3 +858,17 @@ if __name__ == '__main__':
             addExtensions     = None,
             removeExtensions  = None,
             emitExtensions    = None))
+
+    registry.setGenerator(DispatchGenMockOutputGenerator(diagFile=None))
+    registry.apiGen(AutomaticSourceGeneratorOptions(
+            conventions       = conventions,
+            filename          = 'mock_runtime.gen.h',
+            directory         = cur_dir,
+            apiname           = 'openxr',
+            profile           = None,
+            versions          = featuresPat,
+            emitversions      = featuresPat,
+            defaultExtensions = 'openxr',
+            addExtensions     = None,
+            removeExtensions  = None,
+            emitExtensions    = None))
@@ -79,6 +79,7 @@ XrResult __declspec(dllexport) XRAPI_CALL
         std::string logFile = (localAppData / "logs" / (LayerName + ".log")).string();
         logStream.open(logFile, std::ios_base::ate);
     }
+    Start();
 
     Log("dllHome is \"%s\"\n", dllHome.string().c_str());
 
@@ -1,9 +1,19 @@
 # The list of OpenXR functions our layer will override.
 override_functions = [
     "xrGetSystem",
+    "xrGetSystemProperties",
     "xrEnumerateEnvironmentBlendModes",
+    "xrPollEvent",
     "xrCreateSession",
     "xrDestroySession",
+    "xrBeginSession",
+    "xrEndSession",
+    "xrCreateSwapchain",
+    "xrDestroySwapchain",
+    "xrAcquireSwapchainImage",
+    "xrReleaseSwapchainImage",
+    "xrWaitFrame",
+    "xrBeginFrame",
     "xrEndFrame"
 ]
 
@@ -21,5 +31,33 @@ requested_functions = [
     "xrAcquireSwapchainImage",
     "xrWaitSwapchainImage",
     "xrReleaseSwapchainImage",
-    "xrLocateViews"
+    "xrLocateViews",
+    "xrLocateSpace",
+    "xrConvertWin32PerformanceCounterToTimeKHR"
+]
+
+# The list of OpenXR extensions our layer enables on the runtime when they are supported, in addition to the ones
+# enabled by the application. Their functions are left unresolved otherwise.
+requested_extensions = [
+    "XR_KHR_win32_convert_performance_counter_time"
+]
+
+# The list of OpenXR extensions our layer implements on its own. They are advertised through the layer's manifest and
+# removed from the list of extensions enabled on the runtime.
+implemented_extensions = [
+    "XR_FB_passthrough"
+]
+
+# The list of OpenXR functions our layer implements on its own, without calling the runtime. They are only resolved
+# when their extension is enabled by the application.
+implemented_functions = [
+    "xrCreatePassthroughFB",
+    "xrDestroyPassthroughFB",
+    "xrPassthroughStartFB",
+    "xrPassthroughPauseFB",
+    "xrCreatePassthroughLayerFB",
+    "xrDestroyPassthroughLayerFB",
+    "xrPassthroughLayerPauseFB",
+    "xrPassthroughLayerResumeFB",
+    "xrPassthroughLayerSetStyleFB"
 ]
@@ -0,0 +1,704 @@
+// *********** THIS FILE IS GENERATED - DO NOT EDIT ***********
+// MIT License
+//
+// Copyright(c) 2021-2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#ifndef LAYER_NAMESPACE
+#error Must define LAYER_NAMESPACE
+#endif
+
+namespace LAYER_NAMESPACE::mock
+{
+
+	// A fake "next layer" implementing all the functions overriden or requested by the layer, so that the layer can be
+	// exercised without a runtime or a headset. Each function counts its invocations and can be scripted by setting its
+	// hook. Without a hook, a function does nothing and returns XR_SUCCESS.
+	// Only one MockRuntime may exist at a time.
+	class MockRuntime
+	{
+	public:
+		MockRuntime()
+		{
+			s_instance = this;
+		}
+
+		~MockRuntime()
+		{
+			s_instance = nullptr;
+		}
+
+		// To be handed to the layer as the next xrGetInstanceProcAddr.
+		static XrResult XRAPI_CALL xrGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function)
+		{
+			const std::string_view apiName(name);
+
+			if (apiName == "xrDestroyInstance")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrDestroyInstance);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrGetInstanceProperties")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrGetInstanceProperties);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrPollEvent")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrPollEvent);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrGetSystem")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrGetSystem);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrGetSystemProperties")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrGetSystemProperties);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEnumerateEnvironmentBlendModes")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEnumerateEnvironmentBlendModes);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrCreateSession")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrCreateSession);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrDestroySession")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrDestroySession);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrCreateReferenceSpace")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrCreateReferenceSpace);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrLocateSpace")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrLocateSpace);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrDestroySpace")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrDestroySpace);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEnumerateViewConfigurationViews")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEnumerateViewConfigurationViews);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEnumerateSwapchainFormats")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEnumerateSwapchainFormats);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrCreateSwapchain")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrCreateSwapchain);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrDestroySwapchain")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrDestroySwapchain);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEnumerateSwapchainImages")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEnumerateSwapchainImages);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrAcquireSwapchainImage")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrAcquireSwapchainImage);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrWaitSwapchainImage")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrWaitSwapchainImage);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrReleaseSwapchainImage")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrReleaseSwapchainImage);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrBeginSession")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrBeginSession);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEndSession")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEndSession);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrWaitFrame")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrWaitFrame);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrBeginFrame")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrBeginFrame);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrEndFrame")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrEndFrame);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrLocateViews")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrLocateViews);
+				return XR_SUCCESS;
+			}
+			if (apiName == "xrConvertWin32PerformanceCounterToTimeKHR")
+			{
+				*function = reinterpret_cast<PFN_xrVoidFunction>(Mock_xrConvertWin32PerformanceCounterToTimeKHR);
+				return XR_SUCCESS;
+			}
+
+			*function = nullptr;
+			return XR_ERROR_FUNCTION_UNSUPPORTED;
+		}
+
+		void ResetCounters()
+		{
+			xrDestroyInstanceCount = 0;
+			xrGetInstancePropertiesCount = 0;
+			xrPollEventCount = 0;
+			xrGetSystemCount = 0;
+			xrGetSystemPropertiesCount = 0;
+			xrEnumerateEnvironmentBlendModesCount = 0;
+			xrCreateSessionCount = 0;
+			xrDestroySessionCount = 0;
+			xrCreateReferenceSpaceCount = 0;
+			xrLocateSpaceCount = 0;
+			xrDestroySpaceCount = 0;
+			xrEnumerateViewConfigurationViewsCount = 0;
+			xrEnumerateSwapchainFormatsCount = 0;
+			xrCreateSwapchainCount = 0;
+			xrDestroySwapchainCount = 0;
+			xrEnumerateSwapchainImagesCount = 0;
+			xrAcquireSwapchainImageCount = 0;
+			xrWaitSwapchainImageCount = 0;
+			xrReleaseSwapchainImageCount = 0;
+			xrBeginSessionCount = 0;
+			xrEndSessionCount = 0;
+			xrWaitFrameCount = 0;
+			xrBeginFrameCount = 0;
+			xrEndFrameCount = 0;
+			xrLocateViewsCount = 0;
+			xrConvertWin32PerformanceCounterToTimeKHRCount = 0;
+			callLog.clear();
+		}
+
+		// When set, the name of each function called is appended to callLog.
+		bool recordCalls{ false };
+		std::vector<const char*> callLog;
+
+		// Auto-generated entries for the mocked APIs.
+
+	public:
+		std::function<XrResult(XrInstance instance)> xrDestroyInstanceHook;
+		uint64_t xrDestroyInstanceCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrDestroyInstance(XrInstance instance)
+		{
+			s_instance->xrDestroyInstanceCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrDestroyInstance");
+			}
+			if (s_instance->xrDestroyInstanceHook)
+			{
+				return s_instance->xrDestroyInstanceHook(instance);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, XrInstanceProperties* instanceProperties)> xrGetInstancePropertiesHook;
+		uint64_t xrGetInstancePropertiesCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties)
+		{
+			s_instance->xrGetInstancePropertiesCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrGetInstanceProperties");
+			}
+			if (s_instance->xrGetInstancePropertiesHook)
+			{
+				return s_instance->xrGetInstancePropertiesHook(instance, instanceProperties);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, XrEventDataBuffer* eventData)> xrPollEventHook;
+		uint64_t xrPollEventCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData)
+		{
+			s_instance->xrPollEventCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrPollEvent");
+			}
+			if (s_instance->xrPollEventHook)
+			{
+				return s_instance->xrPollEventHook(instance, eventData);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId)> xrGetSystemHook;
+		uint64_t xrGetSystemCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* systemId)
+		{
+			s_instance->xrGetSystemCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrGetSystem");
+			}
+			if (s_instance->xrGetSystemHook)
+			{
+				return s_instance->xrGetSystemHook(instance, getInfo, systemId);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties)> xrGetSystemPropertiesHook;
+		uint64_t xrGetSystemPropertiesCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties* properties)
+		{
+			s_instance->xrGetSystemPropertiesCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrGetSystemProperties");
+			}
+			if (s_instance->xrGetSystemPropertiesHook)
+			{
+				return s_instance->xrGetSystemPropertiesHook(instance, systemId, properties);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)> xrEnumerateEnvironmentBlendModesHook;
+		uint64_t xrEnumerateEnvironmentBlendModesCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t environmentBlendModeCapacityInput, uint32_t* environmentBlendModeCountOutput, XrEnvironmentBlendMode* environmentBlendModes)
+		{
+			s_instance->xrEnumerateEnvironmentBlendModesCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEnumerateEnvironmentBlendModes");
+			}
+			if (s_instance->xrEnumerateEnvironmentBlendModesHook)
+			{
+				return s_instance->xrEnumerateEnvironmentBlendModesHook(instance, systemId, viewConfigurationType, environmentBlendModeCapacityInput, environmentBlendModeCountOutput, environmentBlendModes);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session)> xrCreateSessionHook;
+		uint64_t xrCreateSessionCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session)
+		{
+			s_instance->xrCreateSessionCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrCreateSession");
+			}
+			if (s_instance->xrCreateSessionHook)
+			{
+				return s_instance->xrCreateSessionHook(instance, createInfo, session);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session)> xrDestroySessionHook;
+		uint64_t xrDestroySessionCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrDestroySession(XrSession session)
+		{
+			s_instance->xrDestroySessionCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrDestroySession");
+			}
+			if (s_instance->xrDestroySessionHook)
+			{
+				return s_instance->xrDestroySessionHook(session);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space)> xrCreateReferenceSpaceHook;
+		uint64_t xrCreateReferenceSpaceCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo, XrSpace* space)
+		{
+			s_instance->xrCreateReferenceSpaceCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrCreateReferenceSpace");
+			}
+			if (s_instance->xrCreateReferenceSpaceHook)
+			{
+				return s_instance->xrCreateReferenceSpaceHook(session, createInfo, space);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)> xrLocateSpaceHook;
+		uint64_t xrLocateSpaceCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation* location)
+		{
+			s_instance->xrLocateSpaceCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrLocateSpace");
+			}
+			if (s_instance->xrLocateSpaceHook)
+			{
+				return s_instance->xrLocateSpaceHook(space, baseSpace, time, location);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSpace space)> xrDestroySpaceHook;
+		uint64_t xrDestroySpaceCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrDestroySpace(XrSpace space)
+		{
+			s_instance->xrDestroySpaceCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrDestroySpace");
+			}
+			if (s_instance->xrDestroySpaceHook)
+			{
+				return s_instance->xrDestroySpaceHook(space);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views)> xrEnumerateViewConfigurationViewsHook;
+		uint64_t xrEnumerateViewConfigurationViewsCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId systemId, XrViewConfigurationType viewConfigurationType, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrViewConfigurationView* views)
+		{
+			s_instance->xrEnumerateViewConfigurationViewsCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEnumerateViewConfigurationViews");
+			}
+			if (s_instance->xrEnumerateViewConfigurationViewsHook)
+			{
+				return s_instance->xrEnumerateViewConfigurationViewsHook(instance, systemId, viewConfigurationType, viewCapacityInput, viewCountOutput, views);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats)> xrEnumerateSwapchainFormatsHook;
+		uint64_t xrEnumerateSwapchainFormatsCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput, int64_t* formats)
+		{
+			s_instance->xrEnumerateSwapchainFormatsCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEnumerateSwapchainFormats");
+			}
+			if (s_instance->xrEnumerateSwapchainFormatsHook)
+			{
+				return s_instance->xrEnumerateSwapchainFormatsHook(session, formatCapacityInput, formatCountOutput, formats);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain)> xrCreateSwapchainHook;
+		uint64_t xrCreateSwapchainCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain)
+		{
+			s_instance->xrCreateSwapchainCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrCreateSwapchain");
+			}
+			if (s_instance->xrCreateSwapchainHook)
+			{
+				return s_instance->xrCreateSwapchainHook(session, createInfo, swapchain);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSwapchain swapchain)> xrDestroySwapchainHook;
+		uint64_t xrDestroySwapchainCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrDestroySwapchain(XrSwapchain swapchain)
+		{
+			s_instance->xrDestroySwapchainCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrDestroySwapchain");
+			}
+			if (s_instance->xrDestroySwapchainHook)
+			{
+				return s_instance->xrDestroySwapchainHook(swapchain);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images)> xrEnumerateSwapchainImagesHook;
+		uint64_t xrEnumerateSwapchainImagesCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images)
+		{
+			s_instance->xrEnumerateSwapchainImagesCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEnumerateSwapchainImages");
+			}
+			if (s_instance->xrEnumerateSwapchainImagesHook)
+			{
+				return s_instance->xrEnumerateSwapchainImagesHook(swapchain, imageCapacityInput, imageCountOutput, images);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)> xrAcquireSwapchainImageHook;
+		uint64_t xrAcquireSwapchainImageCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index)
+		{
+			s_instance->xrAcquireSwapchainImageCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrAcquireSwapchainImage");
+			}
+			if (s_instance->xrAcquireSwapchainImageHook)
+			{
+				return s_instance->xrAcquireSwapchainImageHook(swapchain, acquireInfo, index);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo)> xrWaitSwapchainImageHook;
+		uint64_t xrWaitSwapchainImageCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo)
+		{
+			s_instance->xrWaitSwapchainImageCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrWaitSwapchainImage");
+			}
+			if (s_instance->xrWaitSwapchainImageHook)
+			{
+				return s_instance->xrWaitSwapchainImageHook(swapchain, waitInfo);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo)> xrReleaseSwapchainImageHook;
+		uint64_t xrReleaseSwapchainImageCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo)
+		{
+			s_instance->xrReleaseSwapchainImageCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrReleaseSwapchainImage");
+			}
+			if (s_instance->xrReleaseSwapchainImageHook)
+			{
+				return s_instance->xrReleaseSwapchainImageHook(swapchain, releaseInfo);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrSessionBeginInfo* beginInfo)> xrBeginSessionHook;
+		uint64_t xrBeginSessionCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo)
+		{
+			s_instance->xrBeginSessionCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrBeginSession");
+			}
+			if (s_instance->xrBeginSessionHook)
+			{
+				return s_instance->xrBeginSessionHook(session, beginInfo);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session)> xrEndSessionHook;
+		uint64_t xrEndSessionCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEndSession(XrSession session)
+		{
+			s_instance->xrEndSessionCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEndSession");
+			}
+			if (s_instance->xrEndSessionHook)
+			{
+				return s_instance->xrEndSessionHook(session);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)> xrWaitFrameHook;
+		uint64_t xrWaitFrameCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState)
+		{
+			s_instance->xrWaitFrameCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrWaitFrame");
+			}
+			if (s_instance->xrWaitFrameHook)
+			{
+				return s_instance->xrWaitFrameHook(session, frameWaitInfo, frameState);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrFrameBeginInfo* frameBeginInfo)> xrBeginFrameHook;
+		uint64_t xrBeginFrameCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo)
+		{
+			s_instance->xrBeginFrameCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrBeginFrame");
+			}
+			if (s_instance->xrBeginFrameHook)
+			{
+				return s_instance->xrBeginFrameHook(session, frameBeginInfo);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrFrameEndInfo* frameEndInfo)> xrEndFrameHook;
+		uint64_t xrEndFrameCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo)
+		{
+			s_instance->xrEndFrameCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrEndFrame");
+			}
+			if (s_instance->xrEndFrameHook)
+			{
+				return s_instance->xrEndFrameHook(session, frameEndInfo);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)> xrLocateViewsHook;
+		uint64_t xrLocateViewsCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState, uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views)
+		{
+			s_instance->xrLocateViewsCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrLocateViews");
+			}
+			if (s_instance->xrLocateViewsHook)
+			{
+				return s_instance->xrLocateViewsHook(session, viewLocateInfo, viewState, viewCapacityInput, viewCountOutput, views);
+			}
+			return XR_SUCCESS;
+		}
+
+	public:
+		std::function<XrResult(XrInstance instance, const LARGE_INTEGER* performanceCounter, XrTime* time)> xrConvertWin32PerformanceCounterToTimeKHRHook;
+		uint64_t xrConvertWin32PerformanceCounterToTimeKHRCount{ 0 };
+	private:
+		static XrResult XRAPI_CALL Mock_xrConvertWin32PerformanceCounterToTimeKHR(XrInstance instance, const LARGE_INTEGER* performanceCounter, XrTime* time)
+		{
+			s_instance->xrConvertWin32PerformanceCounterToTimeKHRCount++;
+			if (s_instance->recordCalls)
+			{
+				s_instance->callLog.push_back("xrConvertWin32PerformanceCounterToTimeKHR");
+			}
+			if (s_instance->xrConvertWin32PerformanceCounterToTimeKHRHook)
+			{
+				return s_instance->xrConvertWin32PerformanceCounterToTimeKHRHook(instance, performanceCounter, time);
+			}
+			return XR_SUCCESS;
+		}
+
+
+		static inline MockRuntime* s_instance{ nullptr };
+	};
+
+} // namespace LAYER_NAMESPACE::mock
+
@@ -0,0 +1,136 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+#include "layer.h"
+#include "shader_cache.h"
+#include "swapchain_planner.h"
+#include "upload_ring.h"
+
+namespace passthrough {
+
+    // 2 views to process, one per eye.
+    constexpr uint32_t ViewCount = 2;
+
+    struct VertexPositionTexture {
+        DirectX::XMFLOAT3 position;
+        DirectX::XMFLOAT2 textureCoordinate;
+    };
+
+    struct ShaderDescription {
+        std::string_view source;
+        const char* entryPoint;
+        const char* target;
+        uint32_t flags;
+    };
+
+    // Where to draw the passthrough into one view of an application's projection layer.
+    struct CompositionView {
+        XrSwapchain colorSwapchain;
+        uint32_t colorImageIndex;
+        uint32_t colorArrayIndex;
+        XrRect2Di imageRect;
+
+        XrSwapchain depthSwapchain;
+        uint32_t depthImageIndex;
+        uint32_t depthArrayIndex;
+
+        // The depth value of the far plane. With reversed Z, depth decreases away from the viewer.
+        float farDepth;
+        bool isReversedZ;
+    };
+
+    // The drawing code of the passthrough layer, for the graphics API used by the application. The OpenXR swapchain
+    // itself (acquire, wait and release) is managed by the caller.
+    class IGraphicsBackend {
+      public:
+        virtual ~IGraphicsBackend() = default;
+
+        // The shaders are compiled through the shader cache, on a background thread.
+        virtual std::unique_ptr<IShaderCompiler> createShaderCompiler() const = 0;
+        virtual ShaderDescription getVertexShader() const = 0;
+        virtual ShaderDescription getPixelShader() const = 0;
+
+        // How to interpret the swapchain formats of the session.
+        virtual SwapchainFormatApi getSwapchainFormatApi() const = 0;
+
+        // Import the images of the passthrough layer swapchain.
+        virtual void
+        importSwapchainImages(OpenXrApi& openXR, XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo) = 0;
+
+        // Create the objects needed by drawPassthroughLayer(). Must be called from the frame thread.
+        virtual void createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                            const std::vector<uint8_t>& psBytes,
+                                            const std::vector<VertexPositionTexture>* vertices,
+                                            const std::vector<uint16_t>& indices) = 0;
+
+        // Replace the vertex positions of the mesh of each eye, for example to deform it. The texture coordinates are
+        // unchanged.
+        virtual void updateVertexPositions(const std::vector<DirectX::XMFLOAT3>* positions) = 0;
+
+        // Write access to the camera texture. The new content is only used if committed.
+        virtual uint8_t* mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) = 0;
+        virtual void unmapCameraTexture(bool commit) = 0;
+        virtual const UploadRingStatistics& getCameraUploadStatistics() const = 0;
+
+        // The opacity requested by the application through XR_FB_passthrough, used by the next draws. The camera layer
+        // is the bottom layer, so the image is faded to black rather than blended.
+        virtual void setOpacity(float opacity) = 0;
+
+        // Draw the mesh of each eye into its slice of the swapchain image.
+        virtual void drawPassthroughLayer(uint32_t imageIndex,
+                                          const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) = 0;
+
+        // Copy an image prepared on the CPU into one slice of the swapchain image.
+        virtual void uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) = 0;
+
+        // Drawing directly into the application's projection layer, only where its depth is at the far plane.
+        // D3D11 (and D3D12) only: the OpenGL and Vulkan backends return false.
+        virtual bool isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const = 0;
+        virtual void importApplicationSwapchain(OpenXrApi& openXR,
+                                                XrSwapchain swapchain,
+                                                const XrSwapchainCreateInfo& createInfo) = 0;
+        virtual void forgetApplicationSwapchain(XrSwapchain swapchain) = 0;
+        virtual void compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                               const DirectX::XMFLOAT4X4 (&modelViewProjection)[ViewCount]) = 0;
+    };
+
+    std::unique_ptr<IGraphicsBackend> createD3D11Backend(ID3D11Device* device);
+
+    // D3D12 is supported through D3D11On12.
+    std::unique_ptr<IGraphicsBackend> createD3D12Backend(ID3D12Device* device, ID3D12CommandQueue* commandQueue);
+
+    // Returns nullptr if the context does not support OpenGL 4.4.
+    std::unique_ptr<IGraphicsBackend> createOpenGLBackend(HDC dc, HGLRC glrc);
+
+    // For both XR_KHR_vulkan_enable and XR_KHR_vulkan_enable2 sessions. Returns nullptr if the Vulkan functions cannot
+    // be resolved.
+    std::unique_ptr<IGraphicsBackend> createVulkanBackend(VkInstance instance,
+                                                          VkPhysicalDevice physicalDevice,
+                                                          VkDevice device,
+                                                          uint32_t queueFamilyIndex,
+                                                          uint32_t queueIndex);
+
+} // namespace passthrough
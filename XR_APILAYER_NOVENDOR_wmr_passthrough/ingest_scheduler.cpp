@@ -0,0 +1,186 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "ingest_scheduler.h"
+#include "log.h"
+
+namespace {
+
+    using namespace passthrough::log;
+
+    using Clock = std::chrono::steady_clock;
+
+    // How much the estimates follow the latest frame.
+    constexpr double Smoothing = 0.1;
+
+    // The time kept between the end of the ingest and the predicted submission of the frame, on top of twice the
+    // average prediction error. Covers the processing of the last camera image and the worker's wake up.
+    constexpr auto MinimumMargin = 1ms;
+
+    // How long the first ingest waits for a camera image, before the application's frame cadence is known.
+    constexpr auto DefaultIngestDuration = 4ms;
+
+    // Frame intervals longer than this many display periods are pauses (eg: loading screen), not the cadence.
+    constexpr int MaxFrameIntervalPeriods = 4;
+
+    Clock::duration smooth(const std::optional<Clock::duration>& average, Clock::duration sample) {
+        if (!average) {
+            return sample;
+        }
+        return *average + std::chrono::duration_cast<Clock::duration>((sample - *average) * Smoothing);
+    }
+
+    double toMilliseconds(Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+} // namespace
+
+namespace passthrough {
+
+    void IngestScheduler::onWaitFrame(Clock::time_point now, XrDuration predictedDisplayPeriod) {
+        std::unique_lock lock(m_mutex);
+
+        m_waitFrameTime = now;
+        if (predictedDisplayPeriod > 0) {
+            m_statistics.displayPeriod = predictedDisplayPeriod;
+        }
+        if (m_waitToEndFrame) {
+            setPredictedEndFrame(now, now + *m_waitToEndFrame, "xrWaitFrame");
+        }
+    }
+
+    void IngestScheduler::onBeginFrame(Clock::time_point now) {
+        std::unique_lock lock(m_mutex);
+
+        m_beginFrameTime = now;
+        if (m_beginToEndFrame) {
+            setPredictedEndFrame(now, now + *m_beginToEndFrame, "xrBeginFrame");
+        }
+    }
+
+    void IngestScheduler::onEndFrame(Clock::time_point now) {
+        std::unique_lock lock(m_mutex);
+
+        // The camera image must be ready now.
+        m_isIngestRunning = false;
+        m_deadline.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+
+        if (m_predictedEndFrameTime != Clock::time_point{}) {
+            const Clock::duration error =
+                now > m_predictedEndFrameTime ? now - m_predictedEndFrameTime : m_predictedEndFrameTime - now;
+            m_predictionError = smooth(m_predictionError, error);
+            m_predictedEndFrameTime = {};
+        }
+
+        if (m_waitFrameTime != Clock::time_point{}) {
+            m_waitToEndFrame = smooth(m_waitToEndFrame, now - m_waitFrameTime);
+        }
+        if (m_beginFrameTime != Clock::time_point{}) {
+            const Clock::duration frameTime = now - m_beginFrameTime;
+            m_beginToEndFrame = smooth(m_beginToEndFrame, frameTime);
+            m_statistics.frameCount++;
+            m_statistics.frameTimeSum += frameTime;
+        }
+        if (m_endFrameTime != Clock::time_point{}) {
+            const Clock::duration interval = now - m_endFrameTime;
+            const auto maxInterval = std::chrono::nanoseconds(m_statistics.displayPeriod * MaxFrameIntervalPeriods);
+            if (!m_statistics.displayPeriod || interval < maxInterval) {
+                m_endFrameInterval = smooth(m_endFrameInterval, interval);
+            }
+        }
+
+        m_waitFrameTime = m_beginFrameTime = {};
+        m_endFrameTime = now;
+    }
+
+    void IngestScheduler::onIngestStart(Clock::time_point now) {
+        std::unique_lock lock(m_mutex);
+
+        m_isIngestRunning = true;
+
+        // xrWaitFrame() or xrBeginFrame() may already have predicted the next submission from another thread. Their
+        // prediction is more recent than the cadence. Otherwise, until the next xrWaitFrame(), assume the application
+        // keeps its cadence.
+        if (m_predictedEndFrameTime != Clock::time_point{}) {
+            setPredictedEndFrame(now, m_predictedEndFrameTime, "earlier prediction");
+        } else if (m_endFrameInterval && m_endFrameTime != Clock::time_point{}) {
+            setPredictedEndFrame(now, m_endFrameTime + *m_endFrameInterval, "cadence");
+        } else {
+            m_deadline.store((now + DefaultIngestDuration).time_since_epoch().count(), std::memory_order_relaxed);
+        }
+    }
+
+    void IngestScheduler::onIngestFinished(Clock::time_point ingestEnd) {
+        std::unique_lock lock(m_mutex);
+
+        if (m_endFrameTime == Clock::time_point{} || ingestEnd <= m_endFrameTime) {
+            m_statistics.onTimeCount++;
+            if (m_endFrameTime != Clock::time_point{}) {
+                m_statistics.slackSum += m_endFrameTime - ingestEnd;
+            }
+        } else {
+            m_statistics.missedDeadlineCount++;
+            m_statistics.missedDeadlineTime += ingestEnd - m_endFrameTime;
+            DebugLog("Camera ingest missed its deadline by %.2f ms\n", toMilliseconds(ingestEnd - m_endFrameTime));
+        }
+    }
+
+    void IngestScheduler::stopIngest(Clock::time_point now) {
+        std::unique_lock lock(m_mutex);
+
+        m_isIngestRunning = false;
+        m_deadline.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    IngestSchedulerStatistics IngestScheduler::getStatistics() const {
+        std::unique_lock lock(m_mutex);
+
+        return m_statistics;
+    }
+
+    void IngestScheduler::setPredictedEndFrame(Clock::time_point now,
+                                               Clock::time_point predictedEndFrame,
+                                               const char* reason) {
+        m_predictedEndFrameTime = predictedEndFrame;
+
+        // Once stopped, the ingest must not be made to wait again, until the next one starts.
+        if (!m_isIngestRunning) {
+            return;
+        }
+
+        const Clock::duration margin = getMargin();
+        m_deadline.store((predictedEndFrame - margin).time_since_epoch().count(), std::memory_order_relaxed);
+
+        DebugLog("Camera ingest deadline in %.2f ms from %s (margin %.2f ms)\n",
+                 toMilliseconds(predictedEndFrame - margin - now),
+                 reason,
+                 toMilliseconds(margin));
+    }
+
+    Clock::duration IngestScheduler::getMargin() const {
+        return MinimumMargin + 2 * m_predictionError;
+    }
+
+} // namespace passthrough
@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    struct IngestSchedulerStatistics {
+        uint64_t frameCount{0};
+
+        // The application's CPU frame time, from xrBeginFrame() to xrEndFrame().
+        std::chrono::steady_clock::duration frameTimeSum{};
+        XrDuration displayPeriod{0};
+
+        // Ingests done before the application submitted its frame, and how early.
+        uint64_t onTimeCount{0};
+        std::chrono::steady_clock::duration slackSum{};
+
+        // Ingests still running when the application submitted its frame, and how long the frame thread waited.
+        uint64_t missedDeadlineCount{0};
+        std::chrono::steady_clock::duration missedDeadlineTime{};
+    };
+
+    // Plan the camera ingest for the next frame as late as possible, so that it uses the newest camera image, but
+    // without delaying the application's submission of the frame. The application's frame cadence is learned from
+    // xrWaitFrame(), xrBeginFrame() and xrEndFrame(). All the times are passed in, so the scheduler can be driven with
+    // a simulated clock.
+    // The frame loop calls may come from different threads, in any order. They are serialized, and the ingest worker
+    // only reads the deadline.
+    class IngestScheduler {
+      public:
+        using Clock = std::chrono::steady_clock;
+
+        void onWaitFrame(Clock::time_point now, XrDuration predictedDisplayPeriod);
+        void onBeginFrame(Clock::time_point now);
+
+        // Also stops the ingest in progress.
+        void onEndFrame(Clock::time_point now);
+
+        // The ingest for the next frame starts, after the previous frame was submitted.
+        void onIngestStart(Clock::time_point now);
+
+        // The frame thread joined the ingest, which finished at the given time.
+        void onIngestFinished(Clock::time_point ingestEnd);
+
+        // Stop the ingest in progress outside of the frame loop.
+        void stopIngest(Clock::time_point now);
+
+        // The time after which the ingest must stop waiting for newer camera images.
+        Clock::time_point getDeadline() const {
+            return Clock::time_point(Clock::duration(m_deadline.load(std::memory_order_relaxed)));
+        }
+
+        IngestSchedulerStatistics getStatistics() const;
+
+      private:
+        void setPredictedEndFrame(Clock::time_point now, Clock::time_point predictedEndFrame, const char* reason);
+        Clock::duration getMargin() const;
+
+        mutable std::mutex m_mutex;
+
+        // The frame in progress.
+        Clock::time_point m_waitFrameTime;
+        Clock::time_point m_beginFrameTime;
+        Clock::time_point m_endFrameTime;
+        Clock::time_point m_predictedEndFrameTime;
+
+        // Smoothed durations of the application's frame, and how far off the predictions are.
+        std::optional<Clock::duration> m_waitToEndFrame;
+        std::optional<Clock::duration> m_beginToEndFrame;
+        std::optional<Clock::duration> m_endFrameInterval;
+        Clock::duration m_predictionError{};
+
+        // Whether an ingest was started and not stopped yet. Only then the predictions update the deadline.
+        bool m_isIngestRunning{false};
+        std::atomic<Clock::rep> m_deadline{0};
+
+        IngestSchedulerStatistics m_statistics;
+    };
+
+} // namespace passthrough
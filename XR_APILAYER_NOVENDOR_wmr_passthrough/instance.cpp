@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "allocation_tracker.h"
+#include "camera_broker.h"
+#include "graphics_backend.h"
+#include "layer.h"
+#include "openxr_layer.h"
+
+namespace {
+
+    using namespace passthrough;
+
+    std::unique_ptr<IGraphicsBackend> createGraphicsBackend(const XrSessionCreateInfo& createInfo) {
+        const XrBaseInStructure* entry = reinterpret_cast<const XrBaseInStructure*>(createInfo.next);
+        while (entry) {
+            if (entry->type == XR_TYPE_GRAPHICS_BINDING_D3D11_KHR) {
+                const XrGraphicsBindingD3D11KHR* d3dBindings =
+                    reinterpret_cast<const XrGraphicsBindingD3D11KHR*>(entry);
+                return createD3D11Backend(d3dBindings->device);
+            } else if (entry->type == XR_TYPE_GRAPHICS_BINDING_D3D12_KHR) {
+                const XrGraphicsBindingD3D12KHR* d3dBindings =
+                    reinterpret_cast<const XrGraphicsBindingD3D12KHR*>(entry);
+                return createD3D12Backend(d3dBindings->device, d3dBindings->queue);
+            } else if (entry->type == XR_TYPE_GRAPHICS_BINDING_OPENGL_WIN32_KHR) {
+                const XrGraphicsBindingOpenGLWin32KHR* glBindings =
+                    reinterpret_cast<const XrGraphicsBindingOpenGLWin32KHR*>(entry);
+                return createOpenGLBackend(glBindings->hDC, glBindings->hGLRC);
+            } else if (entry->type == XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR) {
+                // XR_KHR_vulkan_enable2 uses the same structure.
+                const XrGraphicsBindingVulkanKHR* vkBindings =
+                    reinterpret_cast<const XrGraphicsBindingVulkanKHR*>(entry);
+                return createVulkanBackend(vkBindings->instance,
+                                           vkBindings->physicalDevice,
+                                           vkBindings->device,
+                                           vkBindings->queueFamilyIndex,
+                                           vkBindings->queueIndex);
+            }
+
+            entry = entry->next;
+        }
+
+        return nullptr;
+    }
+
+    std::unique_ptr<ICameraClientWrapper> createCameraClient() {
+#ifdef XR_WMR_PASSTHROUGH_SHARED_CAMERA
+        return createSharedCameraClient();
+#else
+        return createCameraClientWrapper();
+#endif
+    }
+
+    std::unique_ptr<OpenXrApi> g_instance = nullptr;
+
+} // namespace
+
+namespace passthrough {
+    OpenXrApi* GetInstance() {
+        if (!g_instance) {
+            g_instance = CreateOpenXrLayer(createGraphicsBackend, createCameraClient);
+        }
+        return g_instance.get();
+    }
+
+    void ResetInstance() {
+        g_instance.reset();
+
+#ifdef XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+        allocation::DumpAllocationStatistics();
+#endif
+    }
+
+} // namespace passthrough
@@ -28,13 +28,63 @@
 
 #include "pch.h"
 
+#include "allocation_tracker.h"
+#include "background_task.h"
+#include "camera_frame_queue.h"
+#include "frame_arena.h"
+#include "graphics_backend.h"
+#include "ingest_scheduler.h"
 #include "layer.h"
 #include "log.h"
+#include "mesh_deformer.h"
+#include "openxr_layer.h"
+#include "passthrough_fb.h"
+#include "shader_cache.h"
+#include "swapchain_planner.h"
+#include "swapchain_tracker.h"
+#include "undistortion.h"
 
 namespace {
 
-    // 2 views to process, one per eye.
-    constexpr uint32_t ViewCount = 2;
+    // How long to keep the camera streaming after the application stopped using passthrough.
+    constexpr auto CameraIdleTimeout = 5s;
+
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+    // How long the worker waits for the next camera image before checking its deadline again. Bounds how long the frame
+    // thread waits when the application submits its frame earlier than predicted.
+    constexpr auto CameraIngestWaitSlice = 1ms;
+#endif
+
+    // How many camera images are processed per frame at most. The camera is slower than the display, so there are more
+    // than one only after a hitch.
+    constexpr uint32_t MaxQueuedCameraImages = 3;
+
+    // The number of quads of the passthrough mesh in each direction.
+    constexpr uint32_t MeshColumns = 20;
+    constexpr uint32_t MeshRows = 20;
+
+#if defined(XR_WMR_PASSTHROUGH_PIPELINED_INGEST) || defined(XR_WMR_PASSTHROUGH_QUAD_LAYERS)
+    // The camera images are staged in CPU memory: the worker cannot use the graphics device, and the quad layers are
+    // undistorted on the CPU. Otherwise, they are copied straight into the upload memory of the camera texture.
+#define XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+#endif
+
+#if defined(XR_WMR_PASSTHROUGH_ROLLING_SHUTTER_READOUT) && !defined(XR_WMR_PASSTHROUGH_QUAD_LAYERS)
+#define XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+
+    constexpr XrDuration CameraReadoutTime = (XrDuration)(XR_WMR_PASSTHROUGH_ROLLING_SHUTTER_READOUT * 1e6);
+
+    // How many head orientations are sampled over the readout of a camera image. The head motion is smooth enough over
+    // a few milliseconds to be interpolated between them.
+    constexpr uint32_t CameraReadoutPoseCount = 3;
+#endif
+
+    // The resolution of the image from each camera.
+    constexpr uint32_t CameraWidth = 640;
+    constexpr uint32_t CameraHeight = 480;
+
+    // The margin between the images of the two cameras, to avoid sampling across them.
+    constexpr float CameraImageBorder = 0.005f;
 
     using namespace passthrough;
     using namespace passthrough::log;
@@ -42,131 +92,107 @@ namespace {
     using namespace xr::math;
     using namespace DirectX;
 
-    // These values are taken as-is from XRmonitors\XRmonitorsHologram\CameraCalibration.hpp
-    struct HeadsetCameraCalibration {
-        float K1 = -0.65f;
-        float K2 = 0.f;
-        float Scale = 1.9f;
-        float OffsetX = 0.241f;
-        float OffsetY = -0.178f;
-        float RightOffsetY = 0.f;
-        float EyeCantX = -0.391003f;
-        float EyeCantY = -0.504997f;
-        float EyeCantZ = 0.012f;
-    };
-
-    struct VertexPositionTexture {
-        XMFLOAT3 position;
-        XMFLOAT2 textureCoordinate;
-    };
-
-    struct ModelViewProjectionConstantBuffer {
-        XMFLOAT4X4 modelViewProjection;
-    };
+    // Shaders cached from a previous run, embedded with scripts\embed_shader_cache.py.
+#if __has_include("precompiled_shaders.gen.h")
+#include "precompiled_shaders.gen.h"
+#else
+    const std::array<PrecompiledShader, 0> PrecompiledShaders{};
+#endif
 
-    struct ColorAdjustmentConstantBuffer {
-        XMFLOAT4 colorAdjustment;
+    struct PassthroughMesh {
+        std::vector<VertexPositionTexture> vertices[ViewCount];
+        std::vector<uint16_t> indices;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+        UndistortionMap undistortionMap;
+#endif
     };
 
-    // This code is adapted from XRmonitors\XRmonitorsHologram\CameraRenderer.cpp
-    const std::string_view VertexShaderSource = R"_(
-struct Vertex {
-    float3 pos : POSITION;
-    float2 tex : TEXCOORD0;
-};
-
-struct PSVertex {
-    float4 pos : SV_POSITION;
-    float2 tex : TEXCOORD0;
-};
-
-cbuffer ModelViewProjectionConstantBuffer : register(b0) {
-    float4x4 modelViewProjection;
-};
-
-PSVertex vsMain(Vertex input) {
-    PSVertex output;
-    output.pos = mul(float4(input.pos, 1), modelViewProjection);
-
-    // Place it behind everything else
-    output.pos.z = 0.9999f * output.pos.w;
-
-    output.tex = input.tex;
-    return output;
-}
-)_";
-
-    // This code is adapted from XRmonitors\XRmonitorsHologram\CameraRenderer.cpp
-    const std::string_view PixelShaderSource = R"_(
-struct PSVertex {
-    float4 Pos : SV_POSITION;
-    float2 Tex : TEXCOORD0;
-};
-
-cbuffer ColorAdjustmentConstantBuffer : register(b0) {
-    float4 colorAdjustment;
-};
-
-SamplerState textureSampler : register(s0);
-Texture2D cameraTexture : register(t0);
-
-float4 psMain(PSVertex input) : SV_TARGET {
-    float4 color = cameraTexture.Sample(textureSampler, input.Tex);
-    return float4(
-        color.r * colorAdjustment.r,
-        color.r * colorAdjustment.g,
-        color.r * colorAdjustment.b,
-        1.0);
-}
-)_";
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+    // The size of the undistorted camera image. The camera resolution is kept at the center of the image.
+    XrExtent2Di getQuadLayerImageSize(const XrExtent2Df& extent) {
+        return {(int32_t)std::ceil(extent.width * CameraHeight), (int32_t)std::ceil(extent.height * CameraHeight)};
+    }
+#endif
 
     class GraphicsResources {
       public:
-        GraphicsResources(OpenXrApi& openXR, XrSystemId systemId, ID3D11Device* device)
-            : m_openXR(openXR), m_systemId(systemId), m_d3d11Device(device) {
-            m_d3d11Device->GetImmediateContext(&m_d3d11DeviceContext);
-        }
-
         GraphicsResources(OpenXrApi& openXR,
                           XrSystemId systemId,
-                          ID3D12Device* device,
-                          ID3D12CommandQueue* commandQueue)
-            : m_openXR(openXR), m_systemId(systemId), m_d3d12Device(device), m_d3d12CommandQueue(commandQueue) {
-            // Create resources for interop.
-            D3D_FEATURE_LEVEL featureLevel = {D3D_FEATURE_LEVEL_11_1};
-            CHECK_HRCMD(D3D11On12CreateDevice(m_d3d12Device.Get(),
-                                              D3D11_CREATE_DEVICE_SINGLETHREADED,
-                                              &featureLevel,
-                                              1,
-                                              reinterpret_cast<IUnknown**>(m_d3d12CommandQueue.GetAddressOf()),
-                                              1,
-                                              0,
-                                              &m_d3d11Device,
-                                              &m_d3d11DeviceContext,
-                                              nullptr));
-            CHECK_HRCMD(m_d3d11Device->QueryInterface(__uuidof(ID3D11On12Device),
-                                                      reinterpret_cast<void**>(m_d3d11on12Device.GetAddressOf())));
-
-            // Create a fence so we can wait for pending work upon shutdown.
-            CHECK_HRCMD(m_d3d12Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_d3d12Fence)));
+                          std::unique_ptr<IGraphicsBackend> backend,
+                          CameraClientFactory createCameraClient)
+            : m_openXR(openXR), m_systemId(systemId), m_backend(std::move(backend)),
+              m_createCameraClient(std::move(createCameraClient)) {
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            m_cameraIngestTask = std::make_unique<BackgroundTask>([this] { ingestNextCameraImage(); });
+#endif
         }
 
         ~GraphicsResources() {
-            if (m_d3d12Device) {
-                // Wait for all resources to be safe to destroy.
-                m_d3d12CommandQueue->Signal(m_d3d12Fence.Get(), 1);
-                if (m_d3d12Fence->GetCompletedValue() < 1) {
-                    HANDLE eventHandle = CreateEventEx(nullptr, L"Flush D3D12 Fence", 0, EVENT_ALL_ACCESS);
-                    CHECK_HRCMD(m_d3d12Fence->SetEventOnCompletion(1, eventHandle));
-                    WaitForSingleObject(eventHandle, INFINITE);
-                    CloseHandle(eventHandle);
-                }
-            }
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            // The worker writes to the camera images queue and to the statistics, it must be stopped first.
+            finishCameraIngest();
+            m_cameraIngestTask.reset();
+#endif
 
-            for (uint32_t i = 0; i < ViewCount; i++) {
-                m_passthroughLayerRenderTarget[i].clear();
+            if (m_lastCameraStreamingChange != std::chrono::steady_clock::time_point{}) {
+                const auto elapsed = std::chrono::steady_clock::now() - m_lastCameraStreamingChange;
+                (m_isCameraStreamingRequested ? m_cameraStreamingTime : m_cameraIdleTime) += elapsed;
+                Log("Camera streamed for %.1f s, idle for %.1f s\n",
+                    std::chrono::duration<double>(m_cameraStreamingTime).count(),
+                    std::chrono::duration<double>(m_cameraIdleTime).count());
             }
-            m_passthroughLayerTexture.clear();
+            Log("Passthrough layer drawn %llu times, reused %llu times\n", m_drawnLayerCount, m_reusedLayerCount);
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+            Log("Passthrough mesh deformed %llu times, %.1f us average\n",
+                m_meshDeformCount,
+                m_meshDeformCount
+                    ? std::chrono::duration<double, std::micro>(m_meshDeformTime).count() / m_meshDeformCount
+                    : 0.0);
+#endif
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+            Log("Passthrough composited into the application's layer %llu times\n", m_compositedLayerCount);
+#endif
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+            const CameraFrameQueueStatistics& queue = m_cameraFrameQueue.getStatistics();
+            Log("Camera images: %llu queued, %llu shown, %llu dropped as stale, %.1f ms average age at display time\n",
+                queue.pushCount,
+                queue.selectCount,
+                queue.staleDropCount,
+                queue.timedSelectCount ? queue.timedSelectAgeSum / 1e6 / queue.timedSelectCount : 0.0);
+#else
+            Log("Camera images: %llu uploaded, %llu dropped as stale\n", m_cameraUploadCount, m_cameraStaleDropCount);
+#endif
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            Log("Pipelined camera ingest: %llu images, %.1f ms off the frame thread, %.1f ms waited on it\n",
+                m_cameraIngestCount,
+                std::chrono::duration<double, std::milli>(m_cameraIngestWorkTime).count(),
+                std::chrono::duration<double, std::milli>(m_cameraIngestWaitTime).count());
+            const IngestSchedulerStatistics schedule = m_ingestScheduler.getStatistics();
+            const auto averageMs = [](std::chrono::steady_clock::duration sum, uint64_t count) {
+                return count ? std::chrono::duration<double, std::milli>(sum).count() / count : 0.0;
+            };
+            Log("Camera ingest schedule: %.2f ms application frame time over %llu frames, %.2f ms display period, "
+                "%llu ingests on time by %.2f ms, %llu missed deadlines by %.2f ms\n",
+                averageMs(schedule.frameTimeSum, schedule.frameCount),
+                schedule.frameCount,
+                schedule.displayPeriod / 1e6,
+                schedule.onTimeCount,
+                averageMs(schedule.slackSum, schedule.onTimeCount),
+                schedule.missedDeadlineCount,
+                averageMs(schedule.missedDeadlineTime, schedule.missedDeadlineCount));
+#endif
+            if (m_backend) {
+                const UploadRingStatistics& upload = m_backend->getCameraUploadStatistics();
+                Log("Camera uploads: %llu submitted, %llu stalled for %.1f ms, %.2f average in flight (%u max)\n",
+                    upload.submitCount,
+                    upload.stallCount,
+                    std::chrono::duration<double, std::milli>(upload.stallTime).count(),
+                    upload.acquireCount ? (double)upload.inFlightSum / upload.acquireCount : 0.0,
+                    upload.inFlightMax);
+            }
+
+            // The swapchain images must be released before the swapchain.
+            m_backend.reset();
             if (m_passthroughLayerSwapchain != XR_NULL_HANDLE) {
                 m_openXR.xrDestroySwapchain(m_passthroughLayerSwapchain);
             }
@@ -174,9 +200,16 @@ float4 psMain(PSVertex input) : SV_TARGET {
             if (m_viewSpace != XR_NULL_HANDLE) {
                 m_openXR.xrDestroySpace(m_viewSpace);
             }
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+            if (m_localSpace != XR_NULL_HANDLE) {
+                m_openXR.xrDestroySpace(m_localSpace);
+            }
+#endif
         }
 
-        void connect(XrSession session) {
+        void connect(XrSession session, XrTime displayTime) {
+            ALLOCATION_SCOPE("connect");
+
             m_session = session;
 
             {
@@ -184,34 +217,169 @@ float4 psMain(PSVertex input) : SV_TARGET {
                 createInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_VIEW;
                 createInfo.poseInReferenceSpace = Pose::Identity();
                 CHECK_XRCMD(m_openXR.xrCreateReferenceSpace(m_session, &createInfo, &m_viewSpace));
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+                createInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+                CHECK_XRCMD(m_openXR.xrCreateReferenceSpace(m_session, &createInfo, &m_localSpace));
+#endif
             }
 
-            // Connect to the camera service.
-            m_cameraClient = createCameraClientWrapper();
-
             // Allocate a swapchain for the camera layer.
-            createSwapchain();
-
-            // Allocate resources for drawing the camera layer.
-            createDrawingResources();
+            createSwapchain(displayTime);
 
             m_isConnected = true;
         }
 
+        // Start the work that does not need the session or the D3D device on background threads, so that the first
+        // frame using passthrough does not hitch.
+        void startWarmUp() {
+            const auto start = std::chrono::steady_clock::now();
+            m_warmUpStart = start;
+
+            const auto shaderCache = std::make_shared<ShaderCache>(m_backend->createShaderCompiler(),
+                                                                   localAppData / "shader-cache",
+                                                                   PrecompiledShaders.data(),
+                                                                   PrecompiledShaders.size());
+
+            // Streaming is started ahead of time, and will be stopped if the application does not use passthrough.
+            m_isCameraStreamingRequested = true;
+            m_lastCameraStreamingChange = start;
+            startCameraClient(start);
+
+            const auto compileShader = [shaderCache](const ShaderDescription& shader) {
+                return shaderCache->getOrCompile(shader.source, shader.entryPoint, shader.target, shader.flags);
+            };
+            m_vertexShaderFuture =
+                std::async(std::launch::async, [start, compileShader, shader = m_backend->getVertexShader()] {
+                    auto bytes = compileShader(shader);
+                    logWarmUpStep("Vertex shader", start);
+                    return bytes;
+                });
+            m_pixelShaderFuture =
+                std::async(std::launch::async, [start, compileShader, shader = m_backend->getPixelShader()] {
+                    auto bytes = compileShader(shader);
+                    logWarmUpStep("Pixel shader", start);
+                    return bytes;
+                });
+            m_meshFuture = std::async(std::launch::async, [start, calibration = m_passthroughCameraCalibrations] {
+                PassthroughMesh mesh;
+                generateMesh(calibration.K1, calibration.K2, mesh.vertices, mesh.indices);
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+                const XrExtent2Df extent =
+                    getUndistortedExtent(calibration.K1, calibration.K2, (float)CameraWidth / CameraHeight);
+                const XrExtent2Di size = getQuadLayerImageSize(extent);
+                mesh.undistortionMap = UndistortionMap(calibration.K1,
+                                                       calibration.K2,
+                                                       extent,
+                                                       size.width,
+                                                       size.height,
+                                                       2 * CameraWidth * (0.5f - CameraImageBorder),
+                                                       CameraHeight);
+#endif
+                logWarmUpStep("Mesh", start);
+                return mesh;
+            });
+        }
+
+        // Whether all resources needed to draw the camera layer are available. Never blocks.
+        bool isReady() {
+            if (m_isReady || !m_isConnected) {
+                return m_isReady;
+            }
+
+            const auto isFutureReady = [](const auto& future) {
+                return future.wait_for(0s) == std::future_status::ready;
+            };
+            if (!isFutureReady(m_vertexShaderFuture) || !isFutureReady(m_pixelShaderFuture) ||
+                !isFutureReady(m_meshFuture)) {
+                return false;
+            }
+
+            // The device objects are created here, since the D3D11On12 device is single-threaded.
+            PassthroughMesh mesh = m_meshFuture.get();
+            m_backend->createDrawingResources(
+                m_vertexShaderFuture.get(), m_pixelShaderFuture.get(), mesh.vertices, mesh.indices);
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+            m_undistortionMap = std::move(mesh.undistortionMap);
+#endif
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+            // Both eyes share the same rows, only the horizontal texture coordinates differ.
+            const XMMATRIX modelToEye[ViewCount] = {getModelToEye(0), getModelToEye(1)};
+            m_meshDeformer.setMesh(mesh.vertices[0], MeshColumns + 1, modelToEye);
+#endif
+
+            logWarmUpStep("Passthrough", m_warmUpStart);
+            m_isReady = true;
+
+            return m_isReady;
+        }
+
+        // Start or stop the camera streaming. Never blocks on the camera client being started.
+        void setCameraStreaming(bool enable) {
+            if (enable != m_isCameraStreamingRequested) {
+                const auto now = std::chrono::steady_clock::now();
+                const auto elapsed = now - m_lastCameraStreamingChange;
+                (m_isCameraStreamingRequested ? m_cameraStreamingTime : m_cameraIdleTime) += elapsed;
+                Log("%s camera streaming after %.1f s %s\n",
+                    enable ? "Starting" : "Stopping",
+                    std::chrono::duration<double>(elapsed).count(),
+                    enable ? "idle" : "streaming");
+
+                m_isCameraStreamingRequested = enable;
+                m_lastCameraStreamingChange = now;
+            }
+
+            if (m_cameraClientFuture.valid() && m_cameraClientFuture.wait_for(0s) == std::future_status::ready) {
+                m_cameraClient = m_cameraClientFuture.get();
+                m_lastAcceptedBright = 0;
+                m_frameSkipped = 0;
+            }
+
+            if (enable && !m_cameraClient && !m_cameraClientFuture.valid()) {
+                startCameraClient(std::chrono::steady_clock::now());
+            } else if (!enable && m_cameraClient) {
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+                finishCameraIngest();
+#endif
+
+                // Destroying the client stops the streaming from the camera server.
+                m_cameraClient.reset();
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+                m_cameraFrameQueue.clear();
+#endif
+
+                // The images left in the textures are stale, they must not be shown when the streaming restarts.
+                m_hasCameraImage = false;
+                m_hasLastDrawnLayer = false;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+                m_hasQuadLayerImage = false;
+#endif
+            }
+        }
+
+        // The opacity requested through XR_FB_passthrough. The camera layer is redrawn with the next frame, while quad
+        // layers only change with the next camera image.
+        void setOpacity(float opacity) {
+            if (opacity == m_opacity) {
+                return;
+            }
+
+            m_opacity = opacity;
+            m_backend->setOpacity(opacity);
+            m_hasLastDrawnLayer = false;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+            createQuadLayerPalette();
+#endif
+        }
+
+        // Fills the layer and its views, which must be the views referenced by the layer.
         bool drawPassthroughLayer(XrCompositionLayerProjection& layer,
+                                  XrCompositionLayerProjectionView (&views)[ViewCount],
                                   XrTime displayTime,
                                   const XrCompositionLayerProjection* proj0) {
-            assert(layer.viewCount == ViewCount);
-
-            // Check if we have a camera image.
-            core::CameraFrame cameraFrame;
-            const bool frameAcquired = m_cameraClient->AcquireNextFrame(cameraFrame);
-            if (!m_passthroughCameraTexture && (!frameAcquired || cameraFrame.Width == 0)) {
-                if (frameAcquired) {
-                    m_cameraClient->ReleaseFrame();
-                }
+            assert(layer.viewCount == ViewCount && layer.views == views);
 
-                // We don't even have a previous image to show.
+            bool hasNewImage;
+            if (!updateCameraImage(displayTime, hasNewImage)) {
                 return false;
             }
 
@@ -239,80 +407,40 @@ float4 psMain(PSVertex input) : SV_TARGET {
                 uint32_t viewCount;
                 CHECK_XRCMD(m_openXR.xrLocateViews(m_session, &locateInfo, &state, ViewCount, &viewCount, projViews));
                 if (!Pose::IsPoseValid(state.viewStateFlags)) {
-                    m_cameraClient->ReleaseFrame();
                     return false;
                 }
             }
 
-            // Draw the camera layer.
-            beginSwapchainContext();
-            beginDrawContext();
+#ifdef XR_WMR_PASSTHROUGH_CAMERA_RATE_RENDERING
+            // Without a new camera image, resubmit the previous swapchain image with the pose it was rendered for, and
+            // let the compositor reproject it. This is only possible when it was rendered in the application's space.
+            if (!hasNewImage && m_hasLastDrawnLayer && proj0 && proj0->space == m_lastDrawnLayerSpace) {
+                for (uint32_t i = 0; i < ViewCount; i++) {
+                    views[i] = m_lastDrawnLayerViews[i];
+                }
+                layer.space = m_lastDrawnLayerSpace;
+                layer.layerFlags = 0;
+                m_reusedLayerCount++;
 
-            // Import the texture from the camera service.
-            // TODO: Workaround to bad image. We will just show the previous image.
-            if (cameraFrame.Width > 0) {
-                ensurePassthroughCameraResources(cameraFrame);
-                updatePassthroughCameraTexture(cameraFrame);
-            }
-            m_cameraClient->ReleaseFrame();
-
-            // Setup the common rendering state.
-            m_currentContext->IASetInputLayout(m_inputLayout.Get());
-            m_currentContext->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R16_UINT, 0);
-            m_currentContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            m_currentContext->VSSetShader(m_vertexShader.Get(), nullptr, 0);
-            m_currentContext->PSSetShader(m_pixelShader.Get(), nullptr, 0);
-            {
-                ID3D11Buffer* cbs[] = {m_colorAdjustmentConstantBuffer.Get()};
-                m_currentContext->PSSetConstantBuffers(0, ARRAYSIZE(cbs), cbs);
+                return true;
             }
-            {
-                ID3D11SamplerState* samplers[] = {m_sampler.Get()};
-                m_currentContext->PSSetSamplers(0, ARRAYSIZE(samplers), samplers);
-            };
-            {
-                ID3D11ShaderResourceView* srvs[] = {m_passthroughCameraResourceView.Get()};
-                m_currentContext->PSSetShaderResources(0, ARRAYSIZE(srvs), srvs);
-            };
+#endif
 
+            // Draw the camera layer.
+            XMFLOAT4X4 modelViewProjection[ViewCount];
             for (uint32_t eye = 0; eye < ViewCount; eye++) {
-                // Update the viewer's projection.
-                {
-                    ModelViewProjectionConstantBuffer modelViewProjection;
-                    updateModelViewProjection(modelViewProjection,
-                                              eye,
-                                              proj0 ? proj0->views[eye].pose : projViews[eye].pose,
-                                              proj0 ? proj0->views[eye].fov : projViews[eye].fov,
-                                              nearFar);
-                    m_d3d11DeviceContext->UpdateSubresource(
-                        m_modelViewProjectionConstantBuffer[eye].Get(), 0, nullptr, &modelViewProjection, 0, 0);
-                }
-
-                // Setup per-eye rendering state.
-                {
-                    ID3D11RenderTargetView* rtv[] = {m_passthroughLayerRenderTarget[eye][m_swapchainImageIndex].Get()};
-                    m_currentContext->OMSetRenderTargets(1, rtv, nullptr);
-                }
-                {
-                    ID3D11Buffer* vbs[] = {m_vertexBuffer[eye].Get()};
-                    const UINT strides[] = {sizeof(VertexPositionTexture)};
-                    const UINT offsets[] = {0};
-                    m_currentContext->IASetVertexBuffers(0, ARRAYSIZE(vbs), vbs, strides, offsets);
-                }
-                {
-                    ID3D11Buffer* cbs[] = {m_modelViewProjectionConstantBuffer[eye].Get()};
-                    m_currentContext->VSSetConstantBuffers(0, ARRAYSIZE(cbs), cbs);
-                }
-
-                // Draw the screen.
-                m_currentContext->DrawIndexed(m_indexBufferNumIndices, 0, 0);
+                updateModelViewProjection(modelViewProjection[eye],
+                                          eye,
+                                          proj0 ? proj0->views[eye].pose : projViews[eye].pose,
+                                          proj0 ? proj0->views[eye].fov : projViews[eye].fov,
+                                          nearFar);
             }
 
-            endDrawContext();
+            beginSwapchainContext();
+            m_backend->drawPassthroughLayer(m_swapchainImageIndex, modelViewProjection);
             endSwapchainContext();
 
-            XrCompositionLayerProjectionView* views = const_cast<XrCompositionLayerProjectionView*>(layer.views);
-            for (uint32_t i = 0; i < layer.viewCount; i++) {
+            for (uint32_t i = 0; i < ViewCount; i++) {
                 if (proj0) {
                     views[i].fov = proj0->views[i].fov;
                     views[i].pose = proj0->views[i].pose;
@@ -329,16 +457,231 @@ float4 psMain(PSVertex input) : SV_TARGET {
 
             layer.space = proj0 ? proj0->space : m_viewSpace;
             layer.layerFlags = 0;
+            m_drawnLayerCount++;
+
+            // Remember the layer for resubmission. Only world-locked images can be reprojected.
+            m_hasLastDrawnLayer = proj0 != nullptr;
+            m_lastDrawnLayerSpace = layer.space;
+            for (uint32_t i = 0; i < ViewCount; i++) {
+                m_lastDrawnLayerViews[i] = views[i];
+            }
+
+            return true;
+        }
+
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+        // Draw the camera image directly into the application's projection layer, where its depth is at the far plane.
+        // This saves the compositor from blending a whole layer. Only possible when the application submits depth, and
+        // while the layer holds back the release of the application's images.
+        bool compositePassthroughLayer(const XrCompositionLayerProjection& layer,
+                                       XrTime displayTime,
+                                       SwapchainTracker& swapchainTracker) {
+            if (layer.viewCount != ViewCount) {
+                return false;
+            }
+
+            CompositionView views[ViewCount];
+            NearFar nearFar{0.001f, 100.f};
+            bool isReady = true;
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                const XrCompositionLayerProjectionView& view = layer.views[eye];
+
+                const XrCompositionLayerDepthInfoKHR* depth = nullptr;
+                const XrBaseInStructure* entry = reinterpret_cast<const XrBaseInStructure*>(view.next);
+                while (entry) {
+                    if (entry->type == XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR) {
+                        depth = reinterpret_cast<const XrCompositionLayerDepthInfoKHR*>(entry);
+                        break;
+                    }
+                    entry = entry->next;
+                }
+                if (!depth) {
+                    return false;
+                }
+
+                const std::optional<ApplicationSwapchain> color = swapchainTracker.get(view.subImage.swapchain);
+                const std::optional<ApplicationSwapchain> depthStencil =
+                    swapchainTracker.get(depth->subImage.swapchain);
+                if (!color || !depthStencil || color->createInfo.width != depthStencil->createInfo.width ||
+                    color->createInfo.height != depthStencil->createInfo.height) {
+                    return false;
+                }
+
+                // The backend only draws into the first mip level of single-sampled, non-cubemap images. Otherwise the
+                // separate passthrough layer is used.
+                for (const ApplicationSwapchain* swapchainInfo : {&*color, &*depthStencil}) {
+                    const XrSwapchainCreateInfo& createInfo = swapchainInfo->createInfo;
+                    if (createInfo.sampleCount != 1 || createInfo.faceCount != 1 || createInfo.mipCount != 1) {
+                        return false;
+                    }
+                }
+                if (!m_backend->isDepthCompositionSupported(color->createInfo.format,
+                                                            depthStencil->createInfo.format)) {
+                    return false;
+                }
+
+                // Start holding back the releases of the images, which takes effect with the next frame.
+                for (const auto& [swapchain, swapchainInfo] :
+                     {std::make_pair(view.subImage.swapchain, &*color),
+                      std::make_pair(depth->subImage.swapchain, &*depthStencil)}) {
+                    if (!swapchainInfo->isCompositionTarget) {
+                        m_backend->importApplicationSwapchain(m_openXR, swapchain, swapchainInfo->createInfo);
+                        swapchainTracker.setCompositionTarget(swapchain);
+                        isReady = false;
+                    }
+                }
+                if (!color->deferredReleaseCount || !depthStencil->deferredReleaseCount ||
+                    !color->lastReleasedImage || !depthStencil->lastReleasedImage) {
+                    isReady = false;
+                }
+                if (!isReady) {
+                    continue;
+                }
+
+                views[eye].colorSwapchain = view.subImage.swapchain;
+                views[eye].colorImageIndex = *color->lastReleasedImage;
+                views[eye].colorArrayIndex = view.subImage.imageArrayIndex;
+                views[eye].imageRect = view.subImage.imageRect;
+                views[eye].depthSwapchain = depth->subImage.swapchain;
+                views[eye].depthImageIndex = *depthStencil->lastReleasedImage;
+                views[eye].depthArrayIndex = depth->subImage.imageArrayIndex;
+                views[eye].isReversedZ = depth->farZ < depth->nearZ;
+                views[eye].farDepth = views[eye].isReversedZ ? depth->minDepth : depth->maxDepth;
+                nearFar.Near = depth->nearZ;
+                nearFar.Far = depth->farZ;
+            }
+            if (!isReady) {
+                return false;
+            }
+
+            bool hasNewImage;
+            if (!updateCameraImage(displayTime, hasNewImage)) {
+                return false;
+            }
+
+            XMFLOAT4X4 modelViewProjection[ViewCount];
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                updateModelViewProjection(
+                    modelViewProjection[eye], eye, layer.views[eye].pose, layer.views[eye].fov, nearFar);
+            }
+
+            m_backend->compositePassthroughLayer(views, modelViewProjection);
+            m_compositedLayerCount++;
 
             return true;
         }
 
+        void forgetApplicationSwapchain(XrSwapchain swapchain) {
+            // The layer's own swapchain is destroyed after the backend.
+            if (m_backend) {
+                m_backend->forgetApplicationSwapchain(swapchain);
+            }
+        }
+#endif
+
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+        // Undistort the camera images on the CPU, and let the compositor place them with one quad layer per eye. The
+        // swapchain is only updated when there is a new camera image.
+        bool preparePassthroughQuadLayers(XrCompositionLayerQuad* layers, XrTime displayTime) {
+            if (!m_cameraClient) {
+                return false;
+            }
+
+            ingestCameraImages();
+            const CameraFrameQueue::Frame* cameraFrame = m_cameraFrameQueue.select(displayTime);
+            if (cameraFrame) {
+                if (cameraFrame->width == 2 * CameraWidth && cameraFrame->height == CameraHeight) {
+                    updatePassthroughQuadTexture(cameraFrame->image.data());
+                } else {
+                    Log("Unexpected camera image size %ux%u\n", cameraFrame->width, cameraFrame->height);
+                }
+            }
+
+            if (!m_hasQuadLayerImage) {
+                return false;
+            }
+
+            XrView eyeViews[ViewCount] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
+            {
+                XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO, nullptr};
+                locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                locateInfo.space = m_viewSpace;
+                locateInfo.displayTime = displayTime;
+
+                XrViewState state{XR_TYPE_VIEW_STATE, nullptr};
+                uint32_t viewCount;
+                CHECK_XRCMD(m_openXR.xrLocateViews(m_session, &locateInfo, &state, ViewCount, &viewCount, eyeViews));
+                if (!Pose::IsPoseValid(state.viewStateFlags)) {
+                    return false;
+                }
+            }
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                XrCompositionLayerQuad& layer = layers[eye];
+                placePassthroughQuadLayer(
+                    layer, eye, eyeViews[eye].pose, m_passthroughCameraCalibrations, m_quadLayerExtent);
+                layer.layerFlags = 0;
+                layer.space = m_viewSpace;
+                layer.subImage.swapchain = m_passthroughLayerSwapchain;
+                layer.subImage.imageArrayIndex = eye;
+                layer.subImage.imageRect.offset = {0, 0};
+                layer.subImage.imageRect.extent = {(int32_t)m_passthroughLayerSwapchainInfo.width,
+                                                   (int32_t)m_passthroughLayerSwapchainInfo.height};
+            }
+            m_drawnLayerCount++;
+
+            return true;
+        }
+#endif
+
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+        // Prepare the camera images for the next frame on the worker thread, once the current frame was submitted. The
+        // worker keeps catching newer images until shortly before the application is expected to submit the next
+        // frame, which then only selects one of the queued images and uploads it.
+        void startCameraIngest() {
+            if (m_isCameraIngestPending || !m_cameraClient) {
+                return;
+            }
+
+            m_ingestScheduler.onIngestStart(std::chrono::steady_clock::now());
+            m_isCameraIngestPending = true;
+            m_cameraIngestTask->start();
+        }
+
+        void onWaitFrame(XrDuration predictedDisplayPeriod) {
+            m_ingestScheduler.onWaitFrame(std::chrono::steady_clock::now(), predictedDisplayPeriod);
+        }
+
+        void onBeginFrame() {
+            m_ingestScheduler.onBeginFrame(std::chrono::steady_clock::now());
+        }
+
+        void onEndFrame() {
+            m_ingestScheduler.onEndFrame(std::chrono::steady_clock::now());
+        }
+#endif
+
         bool isConnected() const {
             return m_isConnected;
         }
 
       private:
-        void createSwapchain() {
+        void startCameraClient(std::chrono::steady_clock::time_point start) {
+            m_cameraClientFuture = std::async(std::launch::async, [start, createCameraClient = m_createCameraClient] {
+                auto cameraClient = createCameraClient();
+                logWarmUpStep("Camera client", start);
+                return cameraClient;
+            });
+        }
+
+        static void logWarmUpStep(const char* step, std::chrono::steady_clock::time_point start) {
+            const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+            Log("%s ready after %.1f ms\n", step, elapsed.count());
+        }
+
+        void createSwapchain(XrTime displayTime) {
+            ALLOCATION_SCOPE("createSwapchain");
+
             // Determine what properties out swapchain must have.
             ZeroMemory(&m_passthroughLayerSwapchainInfo, sizeof(m_passthroughLayerSwapchainInfo));
             {
@@ -347,9 +690,6 @@ float4 psMain(PSVertex input) : SV_TARGET {
                 std::vector<int64_t> formats(formatCount);
                 CHECK_XRCMD(m_openXR.xrEnumerateSwapchainFormats(m_session, formatCount, &formatCount, formats.data()));
 
-                m_passthroughLayerSwapchainInfo.format = formats[0];
-            }
-            {
                 uint32_t viewCount;
                 XrViewConfigurationView views[ViewCount] = {{XR_TYPE_VIEW_CONFIGURATION_VIEW, nullptr},
                                                             {XR_TYPE_VIEW_CONFIGURATION_VIEW, nullptr}};
@@ -360,12 +700,64 @@ float4 psMain(PSVertex input) : SV_TARGET {
                                                                        &viewCount,
                                                                        views));
 
-                m_passthroughLayerSwapchainInfo.width = views[0].recommendedImageRectWidth;
-                m_passthroughLayerSwapchainInfo.height = views[0].recommendedImageRectHeight;
+                // The field of view does not depend on the pose, but we need a valid time to query it.
+                XrView eyeViews[ViewCount] = {{XR_TYPE_VIEW, nullptr}, {XR_TYPE_VIEW, nullptr}};
+                {
+                    XrViewLocateInfo locateInfo{XR_TYPE_VIEW_LOCATE_INFO, nullptr};
+                    locateInfo.viewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+                    locateInfo.displayTime = displayTime;
+                    locateInfo.space = m_viewSpace;
+                    XrViewState viewState{XR_TYPE_VIEW_STATE, nullptr};
+                    if (XR_FAILED(m_openXR.xrLocateViews(
+                            m_session, &locateInfo, &viewState, ViewCount, &viewCount, eyeViews))) {
+                        // The planner falls back to the recommended resolution.
+                        eyeViews[0].fov = {};
+                    }
+                }
+
+                SwapchainPlannerInput input{};
+                input.cameraWidth = CameraWidth;
+                input.cameraHeight = CameraHeight;
+                input.meshScale = m_passthroughCameraCalibrations.Scale;
+                input.fov = eyeViews[0].fov;
+                input.recommendedWidth = views[0].recommendedImageRectWidth;
+                input.recommendedHeight = views[0].recommendedImageRectHeight;
+                input.formats = formats.data();
+                input.formatCount = formats.size();
+                input.formatApi = m_backend->getSwapchainFormatApi();
+                input.quality = PassthroughQuality::XR_WMR_PASSTHROUGH_QUALITY;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+                input.isCpuWritten = true;
+#endif
+                SwapchainPlan plan = planPassthroughSwapchain(input);
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+                // The quad layers show the undistorted camera image as-is.
+                m_quadLayerExtent = getUndistortedExtent(m_passthroughCameraCalibrations.K1,
+                                                         m_passthroughCameraCalibrations.K2,
+                                                         (float)CameraWidth / CameraHeight);
+                const XrExtent2Di size = getQuadLayerImageSize(m_quadLayerExtent);
+                plan.width = size.width;
+                plan.height = size.height;
+#endif
+
+                Log("Passthrough swapchain is %ux%u (recommended %ux%u), format %lld (preferred %lld)\n",
+                    plan.width,
+                    plan.height,
+                    input.recommendedWidth,
+                    input.recommendedHeight,
+                    plan.format,
+                    formats.empty() ? 0 : formats[0]);
+
+                m_passthroughLayerSwapchainInfo.format = plan.format;
+                m_passthroughLayerSwapchainInfo.width = plan.width;
+                m_passthroughLayerSwapchainInfo.height = plan.height;
             }
 
             m_passthroughLayerSwapchainInfo.type = XR_TYPE_SWAPCHAIN_CREATE_INFO;
             m_passthroughLayerSwapchainInfo.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+            m_passthroughLayerSwapchainInfo.usageFlags |= XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT;
+#endif
             m_passthroughLayerSwapchainInfo.arraySize = ViewCount;
             m_passthroughLayerSwapchainInfo.mipCount = 1;
             m_passthroughLayerSwapchainInfo.faceCount = 1;
@@ -375,57 +767,11 @@ float4 psMain(PSVertex input) : SV_TARGET {
             CHECK_XRCMD(
                 m_openXR.xrCreateSwapchain(m_session, &m_passthroughLayerSwapchainInfo, &m_passthroughLayerSwapchain));
 
-            uint32_t imageCount;
-            CHECK_XRCMD(m_openXR.xrEnumerateSwapchainImages(m_passthroughLayerSwapchain, 0, &imageCount, nullptr));
-            if (!m_d3d12Device) {
-                std::vector<XrSwapchainImageD3D11KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR, nullptr});
-                CHECK_XRCMD(
-                    m_openXR.xrEnumerateSwapchainImages(m_passthroughLayerSwapchain,
-                                                        imageCount,
-                                                        &imageCount,
-                                                        reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
-                for (uint32_t i = 0; i < imageCount; i++) {
-                    m_passthroughLayerTexture.push_back(images[i].texture);
-                }
-            } else {
-                std::vector<XrSwapchainImageD3D12KHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_D3D12_KHR, nullptr});
-                CHECK_XRCMD(
-                    m_openXR.xrEnumerateSwapchainImages(m_passthroughLayerSwapchain,
-                                                        imageCount,
-                                                        &imageCount,
-                                                        reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
-                D3D11_RESOURCE_FLAGS flags;
-                ZeroMemory(&flags, sizeof(flags));
-                flags.BindFlags = D3D11_BIND_RENDER_TARGET;
-                for (uint32_t i = 0; i < imageCount; i++) {
-                    ComPtr<ID3D11Texture2D> interopTexture;
-
-                    // Create the interop texture.
-                    m_d3d11on12Device->CreateWrappedResource(images[i].texture,
-                                                             &flags,
-                                                             D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                             D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                             IID_PPV_ARGS(&interopTexture));
-                    m_passthroughLayerTexture.push_back(interopTexture);
-                }
-            }
+            m_backend->importSwapchainImages(m_openXR, m_passthroughLayerSwapchain, m_passthroughLayerSwapchainInfo);
 
-            // Create render target views.
-            for (uint32_t eye = 0; eye < ViewCount; eye++) {
-                for (uint32_t i = 0; i < m_passthroughLayerTexture.size(); i++) {
-                    D3D11_RENDER_TARGET_VIEW_DESC desc;
-                    ZeroMemory(&desc, sizeof(desc));
-                    desc.Format = (DXGI_FORMAT)m_passthroughLayerSwapchainInfo.format;
-                    desc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2DARRAY;
-                    desc.Texture2DArray.ArraySize = 1;
-                    desc.Texture2DArray.FirstArraySlice = eye;
-                    desc.Texture2DArray.MipSlice = D3D11CalcSubresource(0, 0, m_passthroughLayerSwapchainInfo.mipCount);
-
-                    ComPtr<ID3D11RenderTargetView> rtv;
-                    CHECK_HRCMD(m_d3d11Device->CreateRenderTargetView(m_passthroughLayerTexture[i].Get(), &desc, &rtv));
-                    m_passthroughLayerRenderTarget[eye].push_back(rtv);
-                }
-            }
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+            createQuadLayerPalette();
+#endif
         }
 
         void beginSwapchainContext() {
@@ -443,219 +789,227 @@ float4 psMain(PSVertex input) : SV_TARGET {
             CHECK_XRCMD(m_openXR.xrReleaseSwapchainImage(m_passthroughLayerSwapchain, &releaseInfo));
         }
 
-        void beginDrawContext() {
-            const bool isPureD3D11 = !m_d3d12Device;
-
-            if (isPureD3D11) {
-                // With D3D11, Use a deferred context so we can use the context saving feature.
-                CHECK_HRCMD(m_d3d11Device->CreateDeferredContext(0, &m_currentContext));
-                m_currentContext->ClearState();
-            } else {
-                ID3D11Resource* interopResource[] = {m_passthroughLayerTexture[m_swapchainImageIndex].Get()};
-                m_d3d11on12Device->AcquireWrappedResources(interopResource, 1);
+        // Returns false if there is no camera image to show.
+        bool updateCameraImage(XrTime displayTime, bool& hasNewImage) {
+            if (!m_cameraClient) {
+                return false;
+            }
 
-                m_currentContext = m_d3d11DeviceContext;
+            // Import the texture from the camera service.
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+            ingestCameraImages();
+            hasNewImage = updatePassthroughCameraTexture(displayTime);
+#else
+            hasNewImage = uploadCameraImages();
+#endif
+            if (hasNewImage) {
+                m_hasCameraImage = true;
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+                deformMesh();
+#endif
             }
 
-            CD3D11_VIEWPORT viewport(0.0f,
-                                     0.0f,
-                                     (float)m_passthroughLayerSwapchainInfo.width,
-                                     (float)m_passthroughLayerSwapchainInfo.height);
-            m_currentContext->RSSetViewports(1, &viewport);
+            // We may not even have a previous image to show.
+            return m_hasCameraImage;
         }
 
-        void endDrawContext() {
-            const bool isPureD3D11 = !m_d3d12Device;
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+        // Queue the camera images received since the previous frame, unless the worker already did.
+        void ingestCameraImages() {
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            if (m_isCameraIngestPending) {
+                finishCameraIngest();
+                return;
+            }
+#endif
+            queueCameraImages(0us);
+        }
 
-            if (isPureD3D11) {
-                // Dispatch the deferred context.
-                ComPtr<ID3D11CommandList> commandList;
-                CHECK_HRCMD(m_currentContext->FinishCommandList(FALSE, commandList.GetAddressOf()));
+        // Process all the camera images received since the previous call, so that the newest one can be selected for
+        // the display time. Waits up to the timeout for the first image. Returns the number of images accepted.
+        uint32_t queueCameraImages(std::chrono::microseconds timeout) {
+            uint32_t acceptedCount = 0;
+            for (uint32_t i = 0; i < MaxQueuedCameraImages; i++) {
+                const CameraFrameLease cameraFrame(*m_cameraClient, i ? 0us : timeout);
+                if (!cameraFrame || cameraFrame->Width == 0) {
+                    break;
+                }
 
-                m_d3d11DeviceContext->ExecuteCommandList(commandList.Get(), TRUE);
-            } else {
-                ID3D11Resource* interopResource[] = {m_passthroughLayerTexture[m_swapchainImageIndex].Get()};
-                m_d3d11on12Device->ReleaseWrappedResources(interopResource, 1);
+                const XrTime receptionTime = getCurrentTime();
+                uint8_t* const dest = m_cameraFrameQueue.beginPush(cameraFrame->Width, cameraFrame->Height);
 
-                // Flush to the D3D12 command queue.
-                m_currentContext->Flush();
+                // TODO: Workaround to bad image. We will just show the previous image.
+                if (copyCameraImage(*cameraFrame, dest, cameraFrame->Width)) {
+                    m_cameraFrameQueue.commitPush(receptionTime);
+                    acceptedCount++;
+                }
             }
 
-            m_currentContext = nullptr;
+            return acceptedCount;
         }
-
-        void createDrawingResources() {
-            {
-                ComPtr<ID3DBlob> errors;
-                ComPtr<ID3DBlob> vsBytes;
-                HRESULT hr = D3DCompile(VertexShaderSource.data(),
-                                        VertexShaderSource.length(),
-                                        nullptr,
-                                        nullptr,
-                                        nullptr,
-                                        "vsMain",
-                                        "vs_5_0",
-                                        D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                        0,
-                                        &vsBytes,
-                                        &errors);
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
+#else
+        // Copy the camera images received since the previous frame into the upload memory of the camera texture. Each
+        // image overwrites the previous one, so only the newest one is uploaded, and the previous texture is kept when
+        // it is rejected. Returns whether there was a new image.
+        bool uploadCameraImages() {
+            uint8_t* dest = nullptr;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t pitch = 0;
+            bool isAccepted = false;
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+            XrTime receptionTime = 0;
+#endif
+            for (uint32_t i = 0; i < MaxQueuedCameraImages; i++) {
+                const CameraFrameLease cameraFrame(*m_cameraClient);
+                if (!cameraFrame || cameraFrame->Width == 0) {
+                    break;
                 }
-                CHECK_HRCMD(m_d3d11Device->CreateVertexShader(
-                    vsBytes->GetBufferPointer(), vsBytes->GetBufferSize(), nullptr, &m_vertexShader));
-
-                const D3D11_INPUT_ELEMENT_DESC desc[] = {
-                    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                    {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0},
-                };
 
-                CHECK_HRCMD(m_d3d11Device->CreateInputLayout(
-                    desc, ARRAYSIZE(desc), vsBytes->GetBufferPointer(), vsBytes->GetBufferSize(), &m_inputLayout));
-            }
-            {
-                ComPtr<ID3DBlob> errors;
-                ComPtr<ID3DBlob> psBytes;
-                HRESULT hr = D3DCompile(PixelShaderSource.data(),
-                                        PixelShaderSource.length(),
-                                        nullptr,
-                                        nullptr,
-                                        nullptr,
-                                        "psMain",
-                                        "ps_5_0",
-                                        D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_WARNINGS_ARE_ERRORS,
-                                        0,
-                                        &psBytes,
-                                        &errors);
-                if (FAILED(hr)) {
-                    if (errors) {
-                        Log("%s", (char*)errors->GetBufferPointer());
-                    }
-                    CHECK_HRESULT(hr, "Failed to compile shader");
+                if (!dest) {
+                    width = cameraFrame->Width;
+                    height = cameraFrame->Height;
+                    dest = m_backend->mapCameraTexture(width, height, pitch);
+                } else if (cameraFrame->Width != width || cameraFrame->Height != height) {
+                    continue;
                 }
-                CHECK_HRCMD(m_d3d11Device->CreatePixelShader(
-                    psBytes->GetBufferPointer(), psBytes->GetBufferSize(), nullptr, &m_pixelShader));
-            }
-            {
-                D3D11_SAMPLER_DESC desc;
-                ZeroMemory(&desc, sizeof(desc));
-                desc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
-                desc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-                desc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-                desc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-                desc.MaxAnisotropy = 1;
-                desc.ComparisonFunc = D3D11_COMPARISON_ALWAYS;
-                CHECK_HRCMD(m_d3d11Device->CreateSamplerState(&desc, &m_sampler));
-            }
-            {
-                std::vector<VertexPositionTexture> vertices[ViewCount];
-                std::vector<uint16_t> indices;
-
-                generateMesh(m_passthroughCameraCalibrations.K1, m_passthroughCameraCalibrations.K2, vertices, indices);
-
-                D3D11_BUFFER_DESC desc;
-                ZeroMemory(&desc, sizeof(desc));
-                desc.Usage = D3D11_USAGE_IMMUTABLE;
-
-                D3D11_SUBRESOURCE_DATA data;
-                ZeroMemory(&data, sizeof(data));
-                desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-                for (uint32_t eye = 0; eye < ViewCount; eye++) {
-                    desc.ByteWidth = (UINT)vertices[eye].size() * sizeof(VertexPositionTexture);
-                    data.pSysMem = vertices[eye].data();
-                    CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &data, &m_vertexBuffer[eye]));
+                if (isAccepted) {
+                    m_cameraStaleDropCount++;
                 }
 
-                desc.ByteWidth = (UINT)indices.size() * sizeof(uint16_t);
-                desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-                data.pSysMem = indices.data();
-                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &data, &m_indexBuffer));
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+                receptionTime = getCurrentTime();
+#endif
 
-                m_indexBufferNumIndices = (UINT)indices.size();
-            }
-            {
-                D3D11_BUFFER_DESC desc;
-                ZeroMemory(&desc, sizeof(desc));
-                desc.ByteWidth = (UINT)sizeof(ModelViewProjectionConstantBuffer);
-                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-                for (uint32_t eye = 0; eye < ViewCount; eye++) {
-                    CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, nullptr, &m_modelViewProjectionConstantBuffer[eye]));
-                }
+                // TODO: Workaround to bad image. We will just show the previous image.
+                isAccepted = copyCameraImage(*cameraFrame, dest, pitch);
             }
-            {
-                D3D11_BUFFER_DESC desc;
-                ZeroMemory(&desc, sizeof(desc));
-                desc.ByteWidth = (UINT)sizeof(ColorAdjustmentConstantBuffer);
-                desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 
-                ColorAdjustmentConstantBuffer colorAdjustment;
-#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
-                colorAdjustment.colorAdjustment = {XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT, 1.f};
-#else
-                colorAdjustment.colorAdjustment = {1.f, 1.f, 1.f, 1.f};
+            if (!dest) {
+                return false;
+            }
+            m_backend->unmapCameraTexture(isAccepted);
+            if (isAccepted) {
+                m_cameraUploadCount++;
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+                m_cameraImageTime = receptionTime;
 #endif
+            }
 
-                D3D11_SUBRESOURCE_DATA initialData;
-                ZeroMemory(&initialData, sizeof(initialData));
-                initialData.pSysMem = &colorAdjustment;
+            return isAccepted;
+        }
+#endif
 
-                CHECK_HRCMD(m_d3d11Device->CreateBuffer(&desc, &initialData, &m_colorAdjustmentConstantBuffer));
+        // The time the camera images are received at, in the application's time domain. Returns 0 when the runtime
+        // cannot convert the time.
+        XrTime getCurrentTime() {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            XrTime time;
+            if (XR_FAILED(m_openXR.xrConvertWin32PerformanceCounterToTimeKHR(m_openXR.GetXrInstance(), &now, &time))) {
+                return 0;
             }
+            return time;
         }
 
-        void ensurePassthroughCameraResources(core::CameraFrame& frame) {
-            if (!m_passthroughCameraTexture || m_passthroughCameraTextureDesc.Width != frame.Width ||
-                m_passthroughCameraTextureDesc.Height != frame.Height) {
-                ZeroMemory(&m_passthroughCameraTextureDesc, sizeof(m_passthroughCameraTextureDesc));
-                m_passthroughCameraTextureDesc.Format = DXGI_FORMAT_R8_UNORM;
-                m_passthroughCameraTextureDesc.Width = frame.Width;
-                m_passthroughCameraTextureDesc.Height = frame.Height;
-                m_passthroughCameraTextureDesc.ArraySize = 1;
-                m_passthroughCameraTextureDesc.MipLevels = 1;
-                m_passthroughCameraTextureDesc.SampleDesc.Count = 1;
-                m_passthroughCameraTextureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+        // Runs on the worker thread. Only touches the camera client and the camera images queue, the graphics device
+        // is only used from the frame thread.
+        void ingestNextCameraImage() {
+            const auto start = std::chrono::steady_clock::now();
+
+            // Keep catching newer camera images until the deadline for the next frame.
+            while (true) {
+                const auto remaining = m_ingestScheduler.getDeadline() - std::chrono::steady_clock::now();
+                if (remaining <= 0s) {
+                    break;
+                }
 
-                m_passthroughCameraTexture = nullptr;
-                CHECK_HRCMD(m_d3d11Device->CreateTexture2D(
-                    &m_passthroughCameraTextureDesc, nullptr, &m_passthroughCameraTexture));
+                const auto timeout = std::min<std::chrono::steady_clock::duration>(remaining, CameraIngestWaitSlice);
+                m_cameraIngestCount +=
+                    queueCameraImages(std::chrono::duration_cast<std::chrono::microseconds>(timeout));
+            }
 
-                D3D11_TEXTURE2D_DESC stagingTextureDesc = m_passthroughCameraTextureDesc;
-                stagingTextureDesc.BindFlags = 0;
-                stagingTextureDesc.Usage = D3D11_USAGE_STAGING;
-                stagingTextureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            m_cameraIngestEnd = std::chrono::steady_clock::now();
+            m_cameraIngestWorkTime += m_cameraIngestEnd - start;
+        }
 
-                m_passthroughCameraStagingTexture = nullptr;
-                CHECK_HRCMD(
-                    m_d3d11Device->CreateTexture2D(&stagingTextureDesc, nullptr, &m_passthroughCameraStagingTexture));
+        void finishCameraIngest() {
+            if (!m_isCameraIngestPending) {
+                return;
+            }
 
-                D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-                ZeroMemory(&srvDesc, sizeof(srvDesc));
-                srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-                srvDesc.Format = m_passthroughCameraTextureDesc.Format;
-                srvDesc.Texture2D.MipLevels = 1;
+            // The deadline is already passed when called from the frame loop.
+            const auto start = std::chrono::steady_clock::now();
+            m_ingestScheduler.stopIngest(start);
+            m_cameraIngestTask->wait();
+            m_cameraIngestWaitTime += std::chrono::steady_clock::now() - start;
 
-                m_passthroughCameraResourceView = nullptr;
-                CHECK_HRCMD(m_d3d11Device->CreateShaderResourceView(
-                    m_passthroughCameraTexture.Get(), &srvDesc, &m_passthroughCameraResourceView));
-            }
+            m_ingestScheduler.onIngestFinished(m_cameraIngestEnd);
+            m_isCameraIngestPending = false;
         }
+#endif
 
-        void updatePassthroughCameraTexture(core::CameraFrame& frame) {
-            // This code is taken nearly as-is from XRmonitors\XRmonitorsHologram\CameraImager.cpp
-            const UINT subresourceIndex = D3D11CalcSubresource(0, 0, 1);
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+        // Upload the newest queued camera image. Returns whether there was a new image.
+        bool updatePassthroughCameraTexture(XrTime displayTime) {
+            const CameraFrameQueue::Frame* frame = m_cameraFrameQueue.select(displayTime);
+            if (!frame) {
+                return false;
+            }
 
-            D3D11_MAPPED_SUBRESOURCE subresource;
-            ZeroMemory(&subresource, sizeof(subresource));
+            uint32_t pitch;
+            uint8_t* dest = m_backend->mapCameraTexture(frame->width, frame->height, pitch);
+            const uint8_t* source = frame->image.data();
+            for (uint32_t i = 0; i < frame->height; i++) {
+                memcpy(dest, source, frame->width);
+                dest += pitch;
+                source += frame->width;
+            }
+            m_backend->unmapCameraTexture(true);
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+            m_cameraImageTime = frame->receptionTime;
+#endif
 
-            CHECK_HRCMD(m_d3d11DeviceContext->Map(
-                m_passthroughCameraStagingTexture.Get(), subresourceIndex, D3D11_MAP_WRITE, 0, &subresource));
+            return true;
+        }
+#endif
+
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+        // Deform the mesh for the head motion during the readout of the camera image being shown.
+        void deformMesh() {
+            const auto start = std::chrono::steady_clock::now();
+
+            // The image is received some time after the end of its readout. That delay is unknown, but only the head
+            // motion over the readout matters, which barely changes over a few milliseconds.
+            XrQuaternionf orientations[CameraReadoutPoseCount];
+            bool isValid = m_cameraImageTime != 0;
+            for (uint32_t i = 0; isValid && i < CameraReadoutPoseCount; i++) {
+                const XrTime time = m_cameraImageTime - CameraReadoutTime * (CameraReadoutPoseCount - 1 - i) /
+                                                            (CameraReadoutPoseCount - 1);
+                XrSpaceLocation location{XR_TYPE_SPACE_LOCATION, nullptr};
+                isValid = XR_SUCCEEDED(m_openXR.xrLocateSpace(m_viewSpace, m_localSpace, time, &location)) &&
+                          Pose::IsPoseValid(location.locationFlags);
+                orientations[i] = location.pose.orientation;
+            }
 
-            uint8_t* dest = reinterpret_cast<uint8_t*>(subresource.pData);
-            const unsigned pitch = subresource.RowPitch;
+            if (isValid) {
+                m_meshDeformer.deform(orientations, CameraReadoutPoseCount);
+            } else if (m_meshDeformer.isDeformed()) {
+                m_meshDeformer.reset();
+            } else {
+                return;
+            }
+            m_backend->updateVertexPositions(m_meshDeformer.getPositions());
 
+            m_meshDeformCount++;
+            m_meshDeformTime += std::chrono::steady_clock::now() - start;
+        }
+#endif
+
+        // Remove the tags from the camera image. Returns whether the camera image was accepted.
+        bool copyCameraImage(const core::CameraFrame& frame, uint8_t* dest, unsigned pitch) {
+            // This code is taken nearly as-is from XRmonitors\XRmonitorsHologram\CameraImager.cpp
             // HACK: Remove 32 byte tags from the image
             const unsigned offset = 23264 + 1312 - 32;
             unsigned nextTagOffset = offset - 1312 + 32;
@@ -683,26 +1037,85 @@ float4 psMain(PSVertex input) : SV_TARGET {
                 dest += pitch;
             }
 
-            m_d3d11DeviceContext->Unmap(m_passthroughCameraStagingTexture.Get(), subresourceIndex);
-
             // TODO: Reject bad images. We will just show the previous image.
             int brightAvg = brightSum / brightSumCount * 20;
             if (brightAvg < m_lastAcceptedBright / 4 && m_frameSkipped < 7) {
                 m_frameSkipped++;
-                return;
+                return false;
             }
             m_lastAcceptedBright = brightAvg;
             m_frameSkipped = 0;
 
-            m_d3d11DeviceContext->CopyResource(m_passthroughCameraTexture.Get(),
-                                               m_passthroughCameraStagingTexture.Get());
+            return true;
         }
 
-        void updateModelViewProjection(ModelViewProjectionConstantBuffer& modelViewProjection,
-                                       uint32_t eyeIndex,
-                                       const XrPosef eyePose,
-                                       const XrFovf fov,
-                                       const NearFar& nearFar) {
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+        void updatePassthroughQuadTexture(const uint8_t* cameraImage) {
+            const uint32_t width = m_undistortionMap.getWidth();
+            const uint32_t height = m_undistortionMap.getHeight();
+            if (width != m_passthroughLayerSwapchainInfo.width || height != m_passthroughLayerSwapchainInfo.height) {
+                return;
+            }
+
+            m_undistortedImage.resize((size_t)width * height);
+
+            beginSwapchainContext();
+
+            // Each camera image is on one half of the frame.
+            const size_t sourcePitch = 2 * CameraWidth;
+            const size_t sourceOffset[ViewCount] = {0, (size_t)(sourcePitch * (0.5f + CameraImageBorder))};
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                m_undistortionMap.undistort(cameraImage + sourceOffset[eye],
+                                            sourcePitch,
+                                            m_quadLayerPalette.data(),
+                                            m_undistortedImage.data(),
+                                            width * sizeof(uint32_t));
+                m_backend->uploadSwapchainImage(
+                    m_swapchainImageIndex, eye, m_undistortedImage.data(), width * sizeof(uint32_t));
+            }
+            endSwapchainContext();
+
+            m_hasQuadLayerImage = true;
+        }
+
+        // Convert the camera intensity to the swapchain format, with the same color adjustment and opacity as the pixel
+        // shader.
+        void createQuadLayerPalette() {
+            const SwapchainFormatInfo* const formatInfo =
+                getSwapchainFormatInfo(m_passthroughLayerSwapchainInfo.format, m_backend->getSwapchainFormatApi());
+            const bool isBGRA = formatInfo && formatInfo->isBGRA;
+            const bool isSRGB = formatInfo && formatInfo->isSRGB;
+            if (!formatInfo || !formatInfo->isRGBA8) {
+                Log("Swapchain format %lld cannot be written from the CPU\n", m_passthroughLayerSwapchainInfo.format);
+            }
+
+#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
+            const float colorAdjustment[] = {XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT};
+#else
+            const float colorAdjustment[] = {1.f, 1.f, 1.f};
+#endif
+
+            for (uint32_t i = 0; i < m_quadLayerPalette.size(); i++) {
+                uint32_t channels[3];
+                for (uint32_t c = 0; c < 3; c++) {
+                    float value = i / 255.f * colorAdjustment[c] * m_opacity;
+
+                    // The shader output is encoded by the render target view, we must do it ourselves.
+                    if (isSRGB) {
+                        value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+                    }
+                    channels[c] = (uint32_t)std::clamp(value * 255.f + 0.5f, 0.f, 255.f);
+                }
+                if (isBGRA) {
+                    std::swap(channels[0], channels[2]);
+                }
+                m_quadLayerPalette[i] = 0xff000000 | channels[2] << 16 | channels[1] << 8 | channels[0];
+            }
+        }
+#endif
+
+        // Places the mesh of an eye in the eye's space.
+        XMMATRIX getModelToEye(uint32_t eyeIndex) const {
             // This code is adapted from XRmonitors\XRmonitorsHologram\CameraRenderer.cpp
             const XMMATRIX modelScale = XMMatrixScaling(m_passthroughCameraCalibrations.Scale,
                                                         m_passthroughCameraCalibrations.Scale,
@@ -728,18 +1141,24 @@ float4 psMain(PSVertex input) : SV_TARGET {
                                              m_passthroughCameraCalibrations.EyeCantZ),
             };
 
+            const XMMATRIX distTranslation = XMMatrixTranslation(0.f, 0.f, -1.f);
+
+            return XMMatrixMultiply(
+                rotateMatrix[eyeIndex],
+                XMMatrixMultiply(translateMatrix[eyeIndex], XMMatrixMultiply(modelScale, distTranslation)));
+        }
+
+        void updateModelViewProjection(XMFLOAT4X4& modelViewProjection,
+                                       uint32_t eyeIndex,
+                                       const XrPosef eyePose,
+                                       const XrFovf fov,
+                                       const NearFar& nearFar) {
             const XMMATRIX modelOrientation = XMMatrixRotationQuaternion(LoadXrQuaternion(eyePose.orientation));
             const XMMATRIX modelTranslation =
                 XMMatrixTranslation(eyePose.position.x, eyePose.position.y, eyePose.position.z);
-            const XMMATRIX distTranslation = XMMatrixTranslation(0.f, 0.f, -1.f);
 
-            const XMMATRIX transform = XMMatrixMultiply(
-                rotateMatrix[eyeIndex],
-                XMMatrixMultiply(
-                    translateMatrix[eyeIndex],
-                    XMMatrixMultiply(
-                        modelScale,
-                        XMMatrixMultiply(distTranslation, XMMatrixMultiply(modelOrientation, modelTranslation)))));
+            const XMMATRIX transform =
+                XMMatrixMultiply(getModelToEye(eyeIndex), XMMatrixMultiply(modelOrientation, modelTranslation));
 
             const XMVECTOR position = LoadXrVector3(eyePose.position);
             XMVECTOR orientation = XMVector4Normalize(LoadXrQuaternion(eyePose.orientation));
@@ -767,8 +1186,7 @@ float4 psMain(PSVertex input) : SV_TARGET {
             const XMMATRIX projectionMatrix = ComposeProjectionMatrix(fov, nearFar);
             const XMMATRIX viewProjectionMatrix = XMMatrixMultiply(spaceToView, projectionMatrix);
 
-            XMStoreFloat4x4(&modelViewProjection.modelViewProjection,
-                            XMMatrixTranspose(transform * viewProjectionMatrix));
+            XMStoreFloat4x4(&modelViewProjection, XMMatrixTranspose(transform * viewProjectionMatrix));
         }
 
         static void
@@ -779,10 +1197,10 @@ float4 psMain(PSVertex input) : SV_TARGET {
             }
             indices.clear();
 
-            const float aspect = 640.f / 480.f;
-            const unsigned width = 20;
+            const float aspect = (float)CameraWidth / CameraHeight;
+            const unsigned width = MeshColumns;
             const unsigned pitch = width + 1;
-            const unsigned height = 20;
+            const unsigned height = MeshRows;
             const float dx = 1.f / width;
             const float dy = 1.f / height;
 
@@ -809,7 +1227,7 @@ float4 psMain(PSVertex input) : SV_TARGET {
                     vertex.position.y = t;
                     vertex.position.z = 0.f;
 
-                    const float border = 0.005f;
+                    const float border = CameraImageBorder;
 
                     vertex.textureCoordinate.x = u * (0.5f - border);
                     vertex.textureCoordinate.y = v;
@@ -861,55 +1279,96 @@ float4 psMain(PSVertex input) : SV_TARGET {
         OpenXrApi& m_openXR;
         const XrSystemId m_systemId;
 
-        // Direct3D device resources.
-        ComPtr<ID3D11Device> m_d3d11Device;
-        ComPtr<ID3D11DeviceContext> m_d3d11DeviceContext;
-        ComPtr<ID3D12Device> m_d3d12Device;
-        ComPtr<ID3D12CommandQueue> m_d3d12CommandQueue;
-        ComPtr<ID3D12Fence> m_d3d12Fence;
-        ComPtr<ID3D11On12Device> m_d3d11on12Device;
-        ComPtr<ID3D11DeviceContext> m_currentContext;
+        std::unique_ptr<IGraphicsBackend> m_backend;
 
         // Swapchain resources.
         XrSwapchainCreateInfo m_passthroughLayerSwapchainInfo;
         XrSwapchain m_passthroughLayerSwapchain{XR_NULL_HANDLE};
         uint32_t m_swapchainImageIndex;
-        std::vector<ComPtr<ID3D11Texture2D>> m_passthroughLayerTexture;
-        std::vector<ComPtr<ID3D11RenderTargetView>> m_passthroughLayerRenderTarget[ViewCount];
 
         // Camera service resources.
+        const CameraClientFactory m_createCameraClient;
         std::unique_ptr<ICameraClientWrapper> m_cameraClient;
-        D3D11_TEXTURE2D_DESC m_passthroughCameraTextureDesc;
-        ComPtr<ID3D11Texture2D> m_passthroughCameraTexture;
-        ComPtr<ID3D11Texture2D> m_passthroughCameraStagingTexture;
+        bool m_isCameraStreamingRequested{false};
+        std::chrono::steady_clock::time_point m_lastCameraStreamingChange;
+        std::chrono::steady_clock::duration m_cameraStreamingTime{0};
+        std::chrono::steady_clock::duration m_cameraIdleTime{0};
         HeadsetCameraCalibration m_passthroughCameraCalibrations;
         int m_lastAcceptedBright{0};
         uint32_t m_frameSkipped{0};
+#ifdef XR_WMR_PASSTHROUGH_STAGED_CAMERA_IMAGES
+        CameraFrameQueue m_cameraFrameQueue{MaxQueuedCameraImages};
+#else
+        uint64_t m_cameraUploadCount{0};
+        uint64_t m_cameraStaleDropCount{0};
+#endif
+        bool m_hasCameraImage{false};
         uint32_t m_nextJitterSeed{0};
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+        XrTime m_cameraImageTime{0};
+        MeshDeformer m_meshDeformer;
+        uint64_t m_meshDeformCount{0};
+        std::chrono::steady_clock::duration m_meshDeformTime{0};
+#endif
 
-        // Drawing resources.
-        ComPtr<ID3D11InputLayout> m_inputLayout;
-        ComPtr<ID3D11VertexShader> m_vertexShader;
-        ComPtr<ID3D11PixelShader> m_pixelShader;
-        ComPtr<ID3D11SamplerState> m_sampler;
-        ComPtr<ID3D11Buffer> m_vertexBuffer[ViewCount];
-        ComPtr<ID3D11Buffer> m_indexBuffer;
-        ComPtr<ID3D11Buffer> m_modelViewProjectionConstantBuffer[ViewCount];
-        ComPtr<ID3D11Buffer> m_colorAdjustmentConstantBuffer;
-        UINT m_indexBufferNumIndices;
+        // The opacity requested through XR_FB_passthrough.
+        float m_opacity{1.f};
+
+        // The last layer drawn, to be resubmitted when there is no new camera image.
+        bool m_hasLastDrawnLayer{false};
+        XrSpace m_lastDrawnLayerSpace{XR_NULL_HANDLE};
+        XrCompositionLayerProjectionView m_lastDrawnLayerViews[ViewCount];
+        uint64_t m_drawnLayerCount{0};
+        uint64_t m_reusedLayerCount{0};
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+        uint64_t m_compositedLayerCount{0};
+#endif
 
-        ComPtr<ID3D11ShaderResourceView> m_passthroughCameraResourceView;
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+        // Resources for the quad layers mode.
+        UndistortionMap m_undistortionMap;
+        XrExtent2Df m_quadLayerExtent{};
+        std::array<uint32_t, 256> m_quadLayerPalette{};
+        std::vector<uint32_t> m_undistortedImage;
+        bool m_hasQuadLayerImage{false};
+#endif
 
         // Misc OpenXR resources.
         XrSpace m_viewSpace{XR_NULL_HANDLE};
+#ifdef XR_WMR_PASSTHROUGH_MESH_DEFORMATION
+        XrSpace m_localSpace{XR_NULL_HANDLE};
+#endif
 
         XrSession m_session;
         bool m_isConnected{false};
+        bool m_isReady{false};
+
+        // Warm-up tasks. Declared last, so that destruction waits for them before anything else is released.
+        std::chrono::steady_clock::time_point m_warmUpStart;
+        std::future<std::unique_ptr<ICameraClientWrapper>> m_cameraClientFuture;
+        std::future<std::vector<uint8_t>> m_vertexShaderFuture;
+        std::future<std::vector<uint8_t>> m_pixelShaderFuture;
+        std::future<PassthroughMesh> m_meshFuture;
+
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+        // Camera ingest for the next frame. The worker owns the camera client, the camera images queue and the
+        // bright-image rejection state while an ingest is pending.
+        std::unique_ptr<BackgroundTask> m_cameraIngestTask;
+        IngestScheduler m_ingestScheduler;
+        bool m_isCameraIngestPending{false};
+        std::chrono::steady_clock::time_point m_cameraIngestEnd;
+        uint64_t m_cameraIngestCount{0};
+        std::chrono::steady_clock::duration m_cameraIngestWorkTime{0};
+        std::chrono::steady_clock::duration m_cameraIngestWaitTime{0};
+#endif
     };
 
     class OpenXrLayer : public passthrough::OpenXrApi {
       public:
-        OpenXrLayer() = default;
+        OpenXrLayer(GraphicsBackendFactory createGraphicsBackend, CameraClientFactory createCameraClient)
+            : m_createGraphicsBackend(std::move(createGraphicsBackend)),
+              m_createCameraClient(std::move(createCameraClient)) {
+        }
         ~OpenXrLayer() override = default;
 
         XrResult xrCreateInstance(const XrInstanceCreateInfo* createInfo) override {
@@ -939,6 +1398,25 @@ float4 psMain(PSVertex input) : SV_TARGET {
             return result;
         }
 
+        XrResult xrGetSystemProperties(XrInstance instance,
+                                       XrSystemId systemId,
+                                       XrSystemProperties* properties) override {
+            const XrResult result = OpenXrApi::xrGetSystemProperties(instance, systemId, properties);
+            if (XR_SUCCEEDED(result) && isVrSystem(systemId) && IsExtensionEnabled("XR_FB_passthrough")) {
+                // Advertise the passthrough support of XR_FB_passthrough.
+                XrBaseOutStructure* entry = reinterpret_cast<XrBaseOutStructure*>(properties->next);
+                while (entry) {
+                    if (entry->type == XR_TYPE_SYSTEM_PASSTHROUGH_PROPERTIES_FB) {
+                        reinterpret_cast<XrSystemPassthroughPropertiesFB*>(entry)->supportsPassthrough = XR_TRUE;
+                    }
+
+                    entry = entry->next;
+                }
+            }
+
+            return result;
+        }
+
         XrResult xrEnumerateEnvironmentBlendModes(XrInstance instance,
                                                   XrSystemId systemId,
                                                   XrViewConfigurationType viewConfigurationType,
@@ -972,37 +1450,45 @@ float4 psMain(PSVertex input) : SV_TARGET {
             return result;
         }
 
+        XrResult xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) override {
+            const XrResult result = OpenXrApi::xrPollEvent(instance, eventData);
+            if (result == XR_SUCCESS && eventData->type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED) {
+                const XrEventDataSessionStateChanged* stateChanged =
+                    reinterpret_cast<const XrEventDataSessionStateChanged*>(eventData);
+                if (isVrSession(stateChanged->session)) {
+                    // Events may be polled from any thread. The new state is applied with the next frame.
+                    m_vrSessionState = stateChanged->state;
+                }
+            }
+
+            return result;
+        }
+
         XrResult xrCreateSession(XrInstance instance,
                                  const XrSessionCreateInfo* createInfo,
                                  XrSession* session) override {
+            ALLOCATION_SCOPE("xrCreateSession");
+
             const XrResult result = OpenXrApi::xrCreateSession(instance, createInfo, session);
             if (XR_SUCCEEDED(result) && isVrSystem(createInfo->systemId)) {
                 // Get the graphics device.
-                const XrBaseInStructure* entry = reinterpret_cast<const XrBaseInStructure*>(createInfo->next);
-                while (entry) {
-                    if (entry->type == XR_TYPE_GRAPHICS_BINDING_D3D11_KHR) {
-                        const XrGraphicsBindingD3D11KHR* d3dBindings =
-                            reinterpret_cast<const XrGraphicsBindingD3D11KHR*>(entry);
-                        m_graphicsResources =
-                            std::make_unique<GraphicsResources>(*this, m_vrSystemId, d3dBindings->device);
-                        break;
-                    } else if (entry->type == XR_TYPE_GRAPHICS_BINDING_D3D12_KHR) {
-                        const XrGraphicsBindingD3D12KHR* d3dBindings =
-                            reinterpret_cast<const XrGraphicsBindingD3D12KHR*>(entry);
-                        m_graphicsResources = std::make_unique<GraphicsResources>(
-                            *this, m_vrSystemId, d3dBindings->device, d3dBindings->queue);
-                        break;
-                    }
-
-                    entry = entry->next;
+                auto backend = m_createGraphicsBackend(*createInfo);
+                if (backend) {
+                    m_graphicsResources = std::make_unique<GraphicsResources>(
+                        *this, m_vrSystemId, std::move(backend), m_createCameraClient);
                 }
 
-                if (!m_graphicsResources) {
+                if (m_graphicsResources) {
+                    m_graphicsResources->startWarmUp();
+                } else {
                     Log("Unsupported graphics runtime.\n");
                 }
 
                 // Remember the XrSession to use.
                 m_vrSession = *session;
+                m_vrSessionState = XR_SESSION_STATE_IDLE;
+                m_isVrSessionEnded = false;
+                m_lastPassthroughRequestTime = std::chrono::steady_clock::now();
             }
 
             return result;
@@ -1010,6 +1496,9 @@ float4 psMain(PSVertex input) : SV_TARGET {
 
         XrResult xrDestroySession(XrSession session) override {
             const XrResult result = OpenXrApi::xrDestroySession(session);
+            if (XR_SUCCEEDED(result) && isVrSession(session)) {
+                m_passthroughFB.destroySession(session);
+            }
             if (XR_SUCCEEDED(result) && isVrSession(session) && m_graphicsResources) {
                 m_graphicsResources.reset();
                 m_vrSession = XR_NULL_HANDLE;
@@ -1018,59 +1507,265 @@ float4 psMain(PSVertex input) : SV_TARGET {
             return result;
         }
 
+        XrResult xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) override {
+            const XrResult result = OpenXrApi::xrBeginSession(session, beginInfo);
+            if (XR_SUCCEEDED(result) && isVrSession(session)) {
+                m_isVrSessionEnded = false;
+            }
+
+            return result;
+        }
+
+        XrResult xrEndSession(XrSession session) override {
+            const XrResult result = OpenXrApi::xrEndSession(session);
+            if (XR_SUCCEEDED(result) && isVrSession(session)) {
+                // The camera is only ever started and stopped from the frame thread. Without another frame, it is
+                // released when the session is destroyed.
+                m_isVrSessionEnded = true;
+            }
+
+            return result;
+        }
+
+        XrResult xrCreatePassthroughFB(XrSession session,
+                                       const XrPassthroughCreateInfoFB* createInfo,
+                                       XrPassthroughFB* outPassthrough) override {
+            if (!isVrSession(session)) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
+            if (!m_graphicsResources) {
+                return XR_ERROR_FEATURE_UNSUPPORTED;
+            }
+
+            return m_passthroughFB.createPassthrough(session, *createInfo, *outPassthrough);
+        }
+
+        XrResult xrDestroyPassthroughFB(XrPassthroughFB passthrough) override {
+            return m_passthroughFB.destroyPassthrough(passthrough);
+        }
+
+        XrResult xrPassthroughStartFB(XrPassthroughFB passthrough) override {
+            return m_passthroughFB.setPassthroughRunning(passthrough, true);
+        }
+
+        XrResult xrPassthroughPauseFB(XrPassthroughFB passthrough) override {
+            // The camera is released with the next frame.
+            return m_passthroughFB.setPassthroughRunning(passthrough, false);
+        }
+
+        XrResult xrCreatePassthroughLayerFB(XrSession session,
+                                            const XrPassthroughLayerCreateInfoFB* createInfo,
+                                            XrPassthroughLayerFB* outLayer) override {
+            if (!isVrSession(session)) {
+                return XR_ERROR_HANDLE_INVALID;
+            }
+
+            return m_passthroughFB.createLayer(session, *createInfo, *outLayer);
+        }
+
+        XrResult xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer) override {
+            return m_passthroughFB.destroyLayer(layer);
+        }
+
+        XrResult xrPassthroughLayerPauseFB(XrPassthroughLayerFB layer) override {
+            return m_passthroughFB.setLayerRunning(layer, false);
+        }
+
+        XrResult xrPassthroughLayerResumeFB(XrPassthroughLayerFB layer) override {
+            return m_passthroughFB.setLayerRunning(layer, true);
+        }
+
+        XrResult xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB layer, const XrPassthroughStyleFB* style) override {
+            return m_passthroughFB.setLayerStyle(layer, *style);
+        }
+
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+        XrResult xrCreateSwapchain(XrSession session,
+                                   const XrSwapchainCreateInfo* createInfo,
+                                   XrSwapchain* swapchain) override {
+            const XrResult result = OpenXrApi::xrCreateSwapchain(session, createInfo, swapchain);
+            if (XR_SUCCEEDED(result) && isVrSession(session)) {
+                m_swapchainTracker.add(*swapchain, *createInfo);
+            }
+
+            return result;
+        }
+
+        XrResult xrDestroySwapchain(XrSwapchain swapchain) override {
+            m_swapchainTracker.remove(swapchain);
+            if (m_graphicsResources) {
+                m_graphicsResources->forgetApplicationSwapchain(swapchain);
+            }
+
+            return OpenXrApi::xrDestroySwapchain(swapchain);
+        }
+
+        XrResult xrAcquireSwapchainImage(XrSwapchain swapchain,
+                                         const XrSwapchainImageAcquireInfo* acquireInfo,
+                                         uint32_t* index) override {
+            return m_swapchainTracker.acquireImage(*this, swapchain, acquireInfo, index);
+        }
+
+        XrResult xrReleaseSwapchainImage(XrSwapchain swapchain,
+                                         const XrSwapchainImageReleaseInfo* releaseInfo) override {
+            // The images we draw into are released in xrEndFrame().
+            return m_swapchainTracker.releaseImage(*this, swapchain, releaseInfo);
+        }
+#endif
+
+        XrResult xrWaitFrame(XrSession session,
+                             const XrFrameWaitInfo* frameWaitInfo,
+                             XrFrameState* frameState) override {
+            const XrResult result = OpenXrApi::xrWaitFrame(session, frameWaitInfo, frameState);
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            if (XR_SUCCEEDED(result) && isVrSession(session) && m_graphicsResources) {
+                m_graphicsResources->onWaitFrame(frameState->predictedDisplayPeriod);
+            }
+#endif
+
+            return result;
+        }
+
+        XrResult xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo) override {
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            if (isVrSession(session) && m_graphicsResources) {
+                m_graphicsResources->onBeginFrame();
+            }
+#endif
+
+            return OpenXrApi::xrBeginFrame(session, frameBeginInfo);
+        }
+
         XrResult xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) override {
-            if (!isVrSession(session) || !m_graphicsResources ||
-                frameEndInfo->environmentBlendMode != XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND) {
+#ifdef XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+            allocation::EndFrame();
+#endif
+            ALLOCATION_SCOPE("xrEndFrame");
+
+            if (!isVrSession(session)) {
+                return OpenXrApi::xrEndFrame(session, frameEndInfo);
+            }
+
+            // Everything allocated for the previous frame has been consumed by the runtime.
+            m_frameArena.reset();
+
+            // The runtime does not know the XR_FB_passthrough layers, they only tell us to draw the camera image.
+            float passthroughLayerOpacity = 0.f;
+            frameEndInfo = removePassthroughLayersFB(frameEndInfo, passthroughLayerOpacity);
+
+            if (!m_graphicsResources) {
                 return OpenXrApi::xrEndFrame(session, frameEndInfo);
             }
 
-            // If this is the first frame and we are going to use passthrough, initialize the resources needed.
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            m_graphicsResources->onEndFrame();
+#endif
+
+            const bool isAlphaBlendRequested =
+                frameEndInfo->environmentBlendMode == XR_ENVIRONMENT_BLEND_MODE_ALPHA_BLEND;
+            const bool isPassthroughRequested = isAlphaBlendRequested || passthroughLayerOpacity > 0.f;
+            updateCameraStreaming(isPassthroughRequested);
+            if (!isPassthroughRequested) {
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+                const XrResult releaseResult = m_swapchainTracker.flushDeferredReleases(*this);
+                if (XR_FAILED(releaseResult)) {
+                    return releaseResult;
+                }
+#endif
+                return OpenXrApi::xrEndFrame(session, frameEndInfo);
+            }
+
+            // If this is the first frame and we are going to use passthrough, initialize the session resources needed.
             if (!m_graphicsResources->isConnected()) {
-                m_graphicsResources->connect(m_vrSession);
+                m_graphicsResources->connect(m_vrSession, frameEndInfo->displayTime);
             }
 
+            // The environment blend mode shows the camera image as is.
+            m_graphicsResources->setOpacity(isAlphaBlendRequested ? 1.f : passthroughLayerOpacity);
+
             const XrCompositionLayerProjection* proj0 = nullptr;
             for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
                 if (frameEndInfo->layers[i]->type == XR_TYPE_COMPOSITION_LAYER_PROJECTION && !proj0) {
                     proj0 = reinterpret_cast<const XrCompositionLayerProjection*>(frameEndInfo->layers[i]);
                 }
-
-                // TODO: This is not compliant. We must make copies of the struct to patch them.
-                ((XrCompositionLayerBaseHeader*)frameEndInfo->layers[i])->layerFlags =
-                    XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
             }
 
             // Because the frame info is passed const, we are going to need to reconstruct a writable version of it
             // to add our extra layer.
             XrFrameEndInfo chainFrameEndInfo = *frameEndInfo;
-            std::vector<const XrCompositionLayerBaseHeader*> layers;
-
+            const XrCompositionLayerBaseHeader** layers =
+                m_frameArena.allocateArray<const XrCompositionLayerBaseHeader*>(frameEndInfo->layerCount + ViewCount);
+            uint32_t layerCount = 0;
+
+#ifdef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+            XrCompositionLayerQuad passthroughLayers[ViewCount]{{XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr},
+                                                                {XR_TYPE_COMPOSITION_LAYER_QUAD, nullptr}};
+
+            // Add the camera images. Until the warm-up completes, only the application layers are submitted.
+            if (m_graphicsResources->isReady() &&
+                m_graphicsResources->preparePassthroughQuadLayers(passthroughLayers, frameEndInfo->displayTime)) {
+                for (uint32_t i = 0; i < ViewCount; i++) {
+                    layers[layerCount++] = reinterpret_cast<XrCompositionLayerBaseHeader*>(&passthroughLayers[i]);
+                }
+            }
+#else
             XrCompositionLayerProjection passthroughLayer{XR_TYPE_COMPOSITION_LAYER_PROJECTION, nullptr};
             XrCompositionLayerProjectionView passthroughLayerViews[ViewCount]{
                 {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW, nullptr},
                 {XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW, nullptr}};
 
-            if (m_graphicsResources->isConnected()) {
-                passthroughLayer.viewCount = ViewCount;
-                passthroughLayer.views = passthroughLayerViews;
+            passthroughLayer.viewCount = ViewCount;
+            passthroughLayer.views = passthroughLayerViews;
+
+            bool isComposited = false;
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+            // Draw into the application's layer if possible, before its images are released to the runtime.
+            isComposited = proj0 && m_graphicsResources->isReady() &&
+                           m_graphicsResources->compositePassthroughLayer(
+                               *proj0, frameEndInfo->displayTime, m_swapchainTracker);
+            const XrResult releaseResult = m_swapchainTracker.flushDeferredReleases(*this);
+            if (XR_FAILED(releaseResult)) {
+                return releaseResult;
+            }
+#endif
 
-                // Draw the camera layer.
-                if (m_graphicsResources->drawPassthroughLayer(passthroughLayer, frameEndInfo->displayTime, proj0)) {
-                    // Add the camera layer to the composition.
-                    layers.push_back(reinterpret_cast<XrCompositionLayerBaseHeader*>(&passthroughLayer));
-                }
+            // Draw the camera layer. Until the warm-up completes, only the application layers are submitted.
+            if (!isComposited && m_graphicsResources->isReady() &&
+                m_graphicsResources->drawPassthroughLayer(
+                    passthroughLayer, passthroughLayerViews, frameEndInfo->displayTime, proj0)) {
+                // Add the camera layer to the composition.
+                layers[layerCount++] = reinterpret_cast<XrCompositionLayerBaseHeader*>(&passthroughLayer);
+            }
+#endif
 
-                for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
-                    layers.push_back(frameEndInfo->layers[i]);
+            // The application layers must be blended with the camera layer. When the camera image is already in the
+            // bottom layer, that layer stays opaque.
+            for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
+#ifndef XR_WMR_PASSTHROUGH_QUAD_LAYERS
+                if (isComposited &&
+                    frameEndInfo->layers[i] == reinterpret_cast<const XrCompositionLayerBaseHeader*>(proj0)) {
+                    layers[layerCount++] = frameEndInfo->layers[i];
+                    continue;
                 }
-                chainFrameEndInfo.layerCount = (uint32_t)layers.size();
-                chainFrameEndInfo.layers = layers.data();
-
-                // Restore the supported blending mode.
-                chainFrameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+#endif
+                layers[layerCount++] =
+                    copyLayerWithFlags(frameEndInfo->layers[i], XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT);
             }
+            chainFrameEndInfo.layerCount = layerCount;
+            chainFrameEndInfo.layers = layers;
 
+            // Restore the supported blending mode.
+            chainFrameEndInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+
+#ifdef XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+            const XrResult result = OpenXrApi::xrEndFrame(session, &chainFrameEndInfo);
+            if (XR_SUCCEEDED(result) && m_graphicsResources->isReady()) {
+                m_graphicsResources->startCameraIngest();
+            }
+            return result;
+#else
             return OpenXrApi::xrEndFrame(session, &chainFrameEndInfo);
+#endif
         }
 
       private:
@@ -1082,26 +1777,127 @@ float4 psMain(PSVertex input) : SV_TARGET {
             return session == m_vrSession;
         }
 
+        // Keep the camera streaming while passthrough is visible, and for a short time after, to avoid restarting the
+        // camera when the application only briefly switches to opaque (eg: loading screen).
+        void updateCameraStreaming(bool isPassthroughRequested) {
+            const auto now = std::chrono::steady_clock::now();
+            const XrSessionState sessionState = m_vrSessionState;
+            const bool isVisible =
+                sessionState == XR_SESSION_STATE_VISIBLE || sessionState == XR_SESSION_STATE_FOCUSED;
+            if (isPassthroughRequested && isVisible) {
+                m_lastPassthroughRequestTime = now;
+            }
+
+            // When the application explicitly paused passthrough, it is not coming back soon.
+            const bool isPaused = !isPassthroughRequested && m_passthroughFB.isPaused();
+
+            const bool isStopping = m_isVrSessionEnded || sessionState >= XR_SESSION_STATE_STOPPING;
+            m_graphicsResources->setCameraStreaming(!isStopping && !isPaused &&
+                                                    now - m_lastPassthroughRequestTime < CameraIdleTimeout);
+        }
+
+        // The application's structures are const and cannot be patched in place. Make a shallow copy in the frame
+        // arena instead. Layer types we do not know the size of cannot be copied, so they are submitted unchanged and
+        // may hide the camera image if the application did not request blending for them.
+        const XrCompositionLayerBaseHeader* copyLayerWithFlags(const XrCompositionLayerBaseHeader* layer,
+                                                               XrCompositionLayerFlags layerFlags) {
+            XrCompositionLayerBaseHeader* copy = nullptr;
+            switch (layer->type) {
+            case XR_TYPE_COMPOSITION_LAYER_PROJECTION:
+                copy = copyLayer<XrCompositionLayerProjection>(layer);
+                break;
+            case XR_TYPE_COMPOSITION_LAYER_QUAD:
+                copy = copyLayer<XrCompositionLayerQuad>(layer);
+                break;
+            case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
+                copy = copyLayer<XrCompositionLayerCylinderKHR>(layer);
+                break;
+            case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR:
+                copy = copyLayer<XrCompositionLayerCubeKHR>(layer);
+                break;
+            case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
+                copy = copyLayer<XrCompositionLayerEquirectKHR>(layer);
+                break;
+            case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
+                copy = copyLayer<XrCompositionLayerEquirect2KHR>(layer);
+                break;
+            default:
+                return layer;
+            }
+
+            copy->layerFlags = layerFlags;
+            return copy;
+        }
+
+        // Returns the frame without the XR_FB_passthrough layers, copied into the frame arena if needed. The opacity is
+        // the highest of the layers removed.
+        const XrFrameEndInfo* removePassthroughLayersFB(const XrFrameEndInfo* frameEndInfo,
+                                                        float& passthroughLayerOpacity) {
+            const auto isPassthroughLayer = [](const XrCompositionLayerBaseHeader* layer) {
+                return layer->type == XR_TYPE_COMPOSITION_LAYER_PASSTHROUGH_FB;
+            };
+            if (std::none_of(
+                    frameEndInfo->layers, frameEndInfo->layers + frameEndInfo->layerCount, isPassthroughLayer)) {
+                return frameEndInfo;
+            }
+
+            XrFrameEndInfo* const copy = m_frameArena.copy(*frameEndInfo);
+            const XrCompositionLayerBaseHeader** layers =
+                m_frameArena.allocateArray<const XrCompositionLayerBaseHeader*>(frameEndInfo->layerCount);
+            copy->layerCount = 0;
+            for (uint32_t i = 0; i < frameEndInfo->layerCount; i++) {
+                const XrCompositionLayerBaseHeader* layer = frameEndInfo->layers[i];
+                if (isPassthroughLayer(layer)) {
+                    // The camera image is always drawn underneath all the application layers.
+                    const XrPassthroughLayerFB passthroughLayer =
+                        reinterpret_cast<const XrCompositionLayerPassthroughFB*>(layer)->layerHandle;
+                    passthroughLayerOpacity =
+                        std::max(passthroughLayerOpacity, m_passthroughFB.getLayerOpacity(passthroughLayer));
+                } else {
+                    layers[copy->layerCount++] = layer;
+                }
+            }
+            copy->layers = layers;
+
+            return copy;
+        }
+
+        template <typename T>
+        XrCompositionLayerBaseHeader* copyLayer(const XrCompositionLayerBaseHeader* layer) {
+            return reinterpret_cast<XrCompositionLayerBaseHeader*>(
+                m_frameArena.copy(*reinterpret_cast<const T*>(layer)));
+        }
+
+        const GraphicsBackendFactory m_createGraphicsBackend;
+        const CameraClientFactory m_createCameraClient;
+
         XrSystemId m_vrSystemId{XR_NULL_SYSTEM_ID};
         XrSession m_vrSession{XR_NULL_HANDLE};
+        std::atomic<XrSessionState> m_vrSessionState{XR_SESSION_STATE_UNKNOWN};
+        std::atomic<bool> m_isVrSessionEnded{false};
+        std::chrono::steady_clock::time_point m_lastPassthroughRequestTime;
+
+        // The objects created by the application through XR_FB_passthrough.
+        PassthroughStateFB m_passthroughFB;
+
+#ifdef XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+        // The application's swapchains. Declared before the graphics resources, which release their own swapchain
+        // upon destruction.
+        SwapchainTracker m_swapchainTracker;
+#endif
 
         std::unique_ptr<GraphicsResources> m_graphicsResources;
-    };
 
-    std::unique_ptr<OpenXrLayer> g_instance = nullptr;
+        // Storage for the patched copies of the layers submitted with xrEndFrame().
+        FrameArena m_frameArena;
+    };
 
 } // namespace
 
 namespace passthrough {
-    OpenXrApi* GetInstance() {
-        if (!g_instance) {
-            g_instance = std::make_unique<OpenXrLayer>();
-        }
-        return g_instance.get();
-    }
-
-    void ResetInstance() {
-        g_instance.reset();
+    std::unique_ptr<OpenXrApi> CreateOpenXrLayer(GraphicsBackendFactory createGraphicsBackend,
+                                                 CameraClientFactory createCameraClient) {
+        return std::make_unique<OpenXrLayer>(std::move(createGraphicsBackend), std::move(createCameraClient));
     }
 
 } // namespace passthrough
@@ -22,6 +22,10 @@
 
 #pragma once
 
+// Uncomment the definition below to collect the call count and timings of each OpenXR function (in the layer and in the
+// runtime). The statistics are logged upon xrDestroyInstance().
+//#define LAYER_API_TIMING
+
 #include "framework/dispatch.gen.h"
 
 namespace passthrough {
@@ -38,6 +42,41 @@ namespace passthrough {
 // Uncomment the definition below to tweak the passthrough camera color to gray.
 #define XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT 0.75f, 0.75f, 0.75f
 
+// Uncomment the definition below to only redraw the passthrough layer when a new camera image is accepted. Otherwise
+// the previous image is resubmitted, and the compositor reprojects it.
+//#define XR_WMR_PASSTHROUGH_CAMERA_RATE_RENDERING
+
+// Uncomment the definition below to prepare the camera image of the next frame on a worker thread, instead of on the
+// application's frame thread. The worker waits for newer camera images until shortly before the application is
+// expected to submit its next frame, based on the frame timing observed in xrWaitFrame(), xrBeginFrame() and
+// xrEndFrame().
+//#define XR_WMR_PASSTHROUGH_PIPELINED_INGEST
+
+// Uncomment the definition below to share the camera between all the processes using the layer (eg: an application and
+// an overlay). Only one process streams from the camera server, and publishes the images to the others.
+//#define XR_WMR_PASSTHROUGH_SHARED_CAMERA
+
+// Uncomment the definition below to draw the camera image directly into the application's projection layer, where its
+// depth is at the far plane, instead of submitting a separate layer. Only used when the application submits depth.
+//#define XR_WMR_PASSTHROUGH_DEPTH_COMPOSITION
+
+// Uncomment the definition below to undistort the camera images on the CPU and submit them as quad layers, instead of
+// drawing the passthrough mesh into a projection layer.
+//#define XR_WMR_PASSTHROUGH_QUAD_LAYERS
+
+// Uncomment the definition below to compensate for the rolling shutter of the cameras, by deforming the passthrough
+// mesh with the head motion that happened while each camera image was read out. The value is the readout time of an
+// image, in milliseconds. Not used with quad layers.
+//#define XR_WMR_PASSTHROUGH_ROLLING_SHUTTER_READOUT 10.f
+
+// Change the definition below to trade the sharpness of the passthrough layer for performance. The swapchain resolution
+// is matched to the camera resolution: Performance, Balanced or Quality.
+#define XR_WMR_PASSTHROUGH_QUALITY Balanced
+
+// Uncomment the definition below to count the heap allocations made by the layer. Allocations happening during
+// steady-state frames are logged, and the totals for each scope are logged upon shutdown.
+//#define XR_WMR_PASSTHROUGH_ALLOCATION_TRACKING
+
     const std::string LayerName = "XR_APILAYER_NOVENDOR_wmr_passthrough";
     const uint32_t VersionMajor = 0;
     const uint32_t VersionMinor = 0;
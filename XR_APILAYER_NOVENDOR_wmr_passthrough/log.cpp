@@ -22,24 +22,293 @@
 
 #include "pch.h"
 
+#include "log.h"
+
 namespace passthrough::log {
     extern std::ofstream logStream;
 
     namespace {
 
-        // Utility logging function.
-        void InternalLog(const char* fmt, va_list va) {
-            const std::time_t now = std::time(nullptr);
+        // Longer messages are truncated.
+        constexpr size_t MaxMessageLength = 1024;
+
+        // Number of messages that can be pending. Must be a power of 2.
+        constexpr uint32_t QueueDepth = 256;
+
+        // How often the background thread wakes up to drain the queue.
+        constexpr DWORD DrainPeriodMs = 10;
+
+        // A message repeated more than RateLimitBurst times within RateLimitWindow is dropped.
+        constexpr auto RateLimitWindow = 1s;
+        constexpr uint32_t RateLimitBurst = 10;
+        constexpr uint32_t RateLimitSlots = 16;
+
+        struct LogEntry {
+            std::atomic<uint32_t> sequence;
+            std::time_t timestamp;
+            char message[MaxMessageLength];
+        };
+
+        // Bounded multi-producer/single-consumer queue, based on Dmitry Vyukov's lock-free design. Each slot carries a
+        // sequence number telling whether it is free for the producers or ready for the consumer.
+        class LogQueue {
+          public:
+            LogQueue() {
+                for (uint32_t i = 0; i < QueueDepth; i++) {
+                    m_entries[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            // Returns nullptr if the queue is full.
+            LogEntry* beginPush(uint32_t& position) {
+                position = m_pushPosition.load(std::memory_order_relaxed);
+                while (true) {
+                    LogEntry& entry = m_entries[position & (QueueDepth - 1)];
+                    const int32_t diff = (int32_t)(entry.sequence.load(std::memory_order_acquire) - position);
+                    if (diff == 0) {
+                        if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            return &entry;
+                        }
+                    } else if (diff < 0) {
+                        return nullptr;
+                    } else {
+                        position = m_pushPosition.load(std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void endPush(LogEntry* entry, uint32_t position) {
+                entry->sequence.store(position + 1, std::memory_order_release);
+            }
+
+            // Only called from the background thread. Returns nullptr if the queue is empty.
+            LogEntry* beginPop() {
+                LogEntry& entry = m_entries[m_popPosition & (QueueDepth - 1)];
+                if (entry.sequence.load(std::memory_order_acquire) != m_popPosition + 1) {
+                    return nullptr;
+                }
+                return &entry;
+            }
 
-            char buf[1024];
-            size_t offset =
-                std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %z: ", std::localtime(&now));
-            vsnprintf_s(buf + offset, sizeof(buf) - offset, _TRUNCATE, fmt, va);
-            OutputDebugStringA(buf);
-            if (logStream.is_open()) {
-                logStream << buf;
-                logStream.flush();
+            void endPop(LogEntry* entry) {
+                entry->sequence.store(m_popPosition + QueueDepth, std::memory_order_release);
+                m_popPosition++;
             }
+
+          private:
+            LogEntry m_entries[QueueDepth];
+            std::atomic<uint32_t> m_pushPosition{0};
+            uint32_t m_popPosition{0};
+        };
+
+        // Formatting the timestamp, the debugger output and the file I/O are deferred to a background thread. Start()
+        // starts the thread and Flush() stops it. Messages logged while the thread is stopped are queued (and dropped
+        // once the queue is full) until the thread is started again.
+        //
+        // The thread holds a reference on the DLL, which it releases upon exiting. This way, the DLL is never unloaded
+        // under a running thread: the thread can be abandoned when it does not exit in time, and it never needs to be
+        // joined from the destructor (which runs under the loader lock).
+        class AsyncLogger {
+          public:
+            ~AsyncLogger() {
+                // The thread is either gone or terminated by the process exit.
+                if (m_thread) {
+                    CloseHandle(m_thread);
+                }
+                if (m_wakeEvent) {
+                    CloseHandle(m_wakeEvent);
+                }
+            }
+
+            void start() {
+                std::unique_lock lock(m_lifecycleMutex);
+
+                if (m_isRunning) {
+                    return;
+                }
+
+                if (m_thread) {
+                    // A thread that was abandoned by flush() is still the consumer of the queue, until it exits.
+                    if (WaitForSingleObject(m_thread, 0) != WAIT_OBJECT_0) {
+                        return;
+                    }
+                    CloseHandle(m_thread);
+                    m_thread = nullptr;
+                    CloseHandle(m_wakeEvent);
+                    m_wakeEvent = nullptr;
+                }
+
+                HMODULE module;
+                if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)&threadProc, &module)) {
+                    return;
+                }
+
+                m_stopRequested.store(false, std::memory_order_relaxed);
+                m_discardRequested.store(false, std::memory_order_relaxed);
+                m_wakeEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+                m_module = module;
+                m_thread = CreateThread(nullptr, 0, threadProc, this, 0, nullptr);
+                if (!m_thread) {
+                    FreeLibrary(module);
+                    return;
+                }
+
+                m_isRunning = true;
+            }
+
+            void push(const char* fmt, va_list va) {
+                // The message is formatted first, so that different messages sharing a format string (eg: statistics
+                // dumped in a loop) are not rate-limited together.
+                thread_local char message[MaxMessageLength];
+                const int length = vsnprintf_s(message, sizeof(message), _TRUNCATE, fmt, va);
+                const size_t size = length < 0 ? sizeof(message) : (size_t)length + 1;
+                if (!checkRateLimit(message, size)) {
+                    return;
+                }
+
+                uint32_t position;
+                LogEntry* const entry = m_queue.beginPush(position);
+                if (!entry) {
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                entry->timestamp = std::time(nullptr);
+                memcpy(entry->message, message, size);
+                m_queue.endPush(entry, position);
+            }
+
+            void flush(std::chrono::milliseconds timeout) {
+                std::unique_lock lock(m_lifecycleMutex);
+
+                if (!m_isRunning) {
+                    return;
+                }
+                m_isRunning = false;
+
+                // The background thread drains the queue before exiting. Past the timeout, it is abandoned and drops
+                // the remaining messages instead. Its reference on the DLL keeps the code alive until it exits.
+                m_stopRequested.store(true, std::memory_order_release);
+                SetEvent(m_wakeEvent);
+                if (WaitForSingleObject(m_thread, (DWORD)timeout.count()) != WAIT_OBJECT_0) {
+                    m_discardRequested.store(true, std::memory_order_release);
+                    return;
+                }
+
+                CloseHandle(m_thread);
+                m_thread = nullptr;
+                CloseHandle(m_wakeEvent);
+                m_wakeEvent = nullptr;
+            }
+
+          private:
+            struct RateLimitSlot {
+                uint32_t hash{0};
+                std::chrono::steady_clock::time_point windowStart;
+                uint32_t count{0};
+                uint32_t suppressed{0};
+            };
+
+            static DWORD WINAPI threadProc(LPVOID parameter) {
+                AsyncLogger* const logger = reinterpret_cast<AsyncLogger*>(parameter);
+                const HMODULE module = logger->m_module;
+                logger->drainLoop();
+                FreeLibraryAndExitThread(module, 0);
+            }
+
+            // Rate limiting is tracked per-thread and per-message, so it does not need any synchronization.
+            bool checkRateLimit(const char* message, size_t size) {
+                thread_local RateLimitSlot slots[RateLimitSlots];
+
+                // FNV-1a.
+                uint32_t hash = 0x811c9dc5;
+                for (size_t i = 0; i < size; i++) {
+                    hash = (hash ^ (uint8_t)message[i]) * 0x01000193;
+                }
+
+                RateLimitSlot& slot = slots[hash % RateLimitSlots];
+                const auto now = std::chrono::steady_clock::now();
+                if (slot.hash != hash || now - slot.windowStart >= RateLimitWindow) {
+                    if (slot.suppressed) {
+                        m_suppressedCount.fetch_add(slot.suppressed, std::memory_order_relaxed);
+                    }
+                    slot.hash = hash;
+                    slot.windowStart = now;
+                    slot.count = 0;
+                    slot.suppressed = 0;
+                }
+
+                if (++slot.count > RateLimitBurst) {
+                    slot.suppressed++;
+                    return false;
+                }
+                return true;
+            }
+
+            void drainLoop() {
+                while (true) {
+                    const bool stop = m_stopRequested.load(std::memory_order_acquire);
+
+                    bool wroteFile = false;
+                    LogEntry* entry;
+                    while ((entry = m_queue.beginPop())) {
+                        if (!m_discardRequested.load(std::memory_order_acquire)) {
+                            write(entry->timestamp, entry->message);
+                        }
+                        m_queue.endPop(entry);
+                        wroteFile = true;
+                    }
+
+                    const uint32_t dropped = m_droppedCount.exchange(0, std::memory_order_relaxed);
+                    const uint32_t suppressed = m_suppressedCount.exchange(0, std::memory_order_relaxed);
+                    if (dropped || suppressed) {
+                        char buf[128];
+                        sprintf_s(buf, sizeof(buf), "(%u messages dropped, %u suppressed)\n", dropped, suppressed);
+                        write(std::time(nullptr), buf);
+                        wroteFile = true;
+                    }
+
+                    if (wroteFile && logStream.is_open()) {
+                        logStream.flush();
+                    }
+
+                    if (stop) {
+                        break;
+                    }
+
+                    WaitForSingleObject(m_wakeEvent, DrainPeriodMs);
+                }
+            }
+
+            void write(std::time_t timestamp, const char* message) {
+                char buf[MaxMessageLength + 32];
+                size_t offset =
+                    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S %z: ", std::localtime(&timestamp));
+                strncpy_s(buf + offset, sizeof(buf) - offset, message, _TRUNCATE);
+                OutputDebugStringA(buf);
+                if (logStream.is_open()) {
+                    logStream << buf;
+                }
+            }
+
+            LogQueue m_queue;
+            std::atomic<uint32_t> m_droppedCount{0};
+            std::atomic<uint32_t> m_suppressedCount{0};
+
+            std::mutex m_lifecycleMutex;
+            bool m_isRunning{false};
+            std::atomic<bool> m_stopRequested{false};
+            std::atomic<bool> m_discardRequested{false};
+            HMODULE m_module{nullptr};
+            HANDLE m_thread{nullptr};
+            HANDLE m_wakeEvent{nullptr};
+        };
+
+        AsyncLogger g_logger;
+
+        // Utility logging function.
+        void InternalLog(const char* fmt, va_list va) {
+            g_logger.push(fmt, va);
         }
     } // namespace
 
@@ -59,4 +328,12 @@ namespace passthrough::log {
 #endif
     }
 
+    void Start() {
+        g_logger.start();
+    }
+
+    void Flush(std::chrono::milliseconds timeout) {
+        g_logger.flush(timeout);
+    }
+
 } // namespace passthrough::log
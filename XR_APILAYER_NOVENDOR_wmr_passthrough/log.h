@@ -32,4 +32,10 @@ namespace passthrough::log {
     // Debug logging function. Can make things very slow (only enabled on Debug builds).
     void DebugLog(const char* fmt, ...);
 
+    // Start writing out messages. Until then, and after Flush(), messages are only queued.
+    void Start();
+
+    // Write out all pending messages, waiting at most for the specified timeout, then stop writing out messages.
+    void Flush(std::chrono::milliseconds timeout);
+
 } // namespace passthrough::log
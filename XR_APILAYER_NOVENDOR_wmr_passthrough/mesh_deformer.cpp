@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "mesh_deformer.h"
+
+namespace {
+
+    using namespace xr::math;
+    using namespace DirectX;
+
+    // The orientation at a point of the readout, from 0 (first row) to 1 (last row).
+    XMVECTOR interpolateOrientation(const XrQuaternionf* orientations, uint32_t orientationCount, float readout) {
+        const float position = std::clamp(readout, 0.f, 1.f) * (orientationCount - 1);
+        const uint32_t index = std::min((uint32_t)position, orientationCount - 2);
+        return XMQuaternionSlerp(
+            LoadXrQuaternion(orientations[index]), LoadXrQuaternion(orientations[index + 1]), position - index);
+    }
+
+} // namespace
+
+namespace passthrough {
+
+    void MeshDeformer::setMesh(const std::vector<VertexPositionTexture>& vertices,
+                               uint32_t rowLength,
+                               const XMMATRIX (&modelToHead)[ViewCount]) {
+        assert(rowLength > 0 && vertices.size() % rowLength == 0);
+
+        m_rowLength = rowLength;
+        m_basePositions.resize(vertices.size());
+        m_rowReadout.resize(vertices.size() / rowLength);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            m_basePositions[i] = vertices[i].position;
+        }
+        for (size_t row = 0; row < m_rowReadout.size(); row++) {
+            // The first image row is at the top of the texture.
+            m_rowReadout[row] = vertices[row * rowLength].textureCoordinate.y;
+        }
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            XMStoreFloat4x4(&m_modelToHead[eye], modelToHead[eye]);
+            XMStoreFloat4x4(&m_headToModel[eye], XMMatrixInverse(nullptr, modelToHead[eye]));
+        }
+
+        reset();
+    }
+
+    void MeshDeformer::deform(const XrQuaternionf* orientations, uint32_t orientationCount) {
+        assert(orientationCount >= 2);
+
+        const XMMATRIX modelToHead[ViewCount] = {XMLoadFloat4x4(&m_modelToHead[0]), XMLoadFloat4x4(&m_modelToHead[1])};
+        const XMMATRIX headToModel[ViewCount] = {XMLoadFloat4x4(&m_headToModel[0]), XMLoadFloat4x4(&m_headToModel[1])};
+        const XMVECTOR invertReference =
+            XMQuaternionConjugate(interpolateOrientation(orientations, orientationCount, 0.5f));
+
+        for (size_t row = 0; row < m_rowReadout.size(); row++) {
+            // What was seen in the head's space when the row was read out, seen from the reference orientation.
+            const XMVECTOR orientation = interpolateOrientation(orientations, orientationCount, m_rowReadout[row]);
+            const XMMATRIX correction = XMMatrixRotationQuaternion(XMQuaternionMultiply(orientation, invertReference));
+
+            const size_t first = row * m_rowLength;
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                const XMMATRIX transform =
+                    XMMatrixMultiply(XMMatrixMultiply(modelToHead[eye], correction), headToModel[eye]);
+                XMVector3TransformCoordStream(&m_positions[eye][first],
+                                              sizeof(XMFLOAT3),
+                                              &m_basePositions[first],
+                                              sizeof(XMFLOAT3),
+                                              m_rowLength,
+                                              transform);
+            }
+        }
+
+        m_isDeformed = true;
+    }
+
+    void MeshDeformer::reset() {
+        for (uint32_t eye = 0; eye < ViewCount; eye++) {
+            m_positions[eye] = m_basePositions;
+        }
+        m_isDeformed = false;
+    }
+
+} // namespace passthrough
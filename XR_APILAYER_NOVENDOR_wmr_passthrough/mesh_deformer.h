@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+#include "graphics_backend.h"
+
+namespace passthrough {
+
+    // Deform the passthrough mesh to compensate for the rolling shutter of the cameras. The rows of a camera image are
+    // read out one after the other, so during a head motion each row is seen from a slightly different orientation.
+    // Each row of the mesh is rotated by the head rotation between the readout of its image row and the readout of the
+    // middle row, which the image is shown for.
+    class MeshDeformer {
+      public:
+        // The mesh is made of rows of rowLength vertices, all with the same vertical texture coordinate, which gives
+        // the readout order of the row. modelToHead places the mesh of each eye in the head's space.
+        void setMesh(const std::vector<VertexPositionTexture>& vertices,
+                     uint32_t rowLength,
+                     const DirectX::XMMATRIX (&modelToHead)[ViewCount]);
+
+        // Deform the mesh given the head orientations (in any fixed space), sampled at evenly spaced times from the
+        // start to the end of the readout of the camera image. Needs at least 2 orientations.
+        void deform(const XrQuaternionf* orientations, uint32_t orientationCount);
+
+        // Restore the mesh without deformation.
+        void reset();
+
+        bool isDeformed() const {
+            return m_isDeformed;
+        }
+
+        // The vertex positions of each eye.
+        const std::vector<DirectX::XMFLOAT3>* getPositions() const {
+            return m_positions;
+        }
+
+      private:
+        std::vector<DirectX::XMFLOAT3> m_basePositions;
+        std::vector<float> m_rowReadout;
+        uint32_t m_rowLength{0};
+        DirectX::XMFLOAT4X4 m_modelToHead[ViewCount];
+        DirectX::XMFLOAT4X4 m_headToModel[ViewCount];
+
+        std::vector<DirectX::XMFLOAT3> m_positions[ViewCount];
+        bool m_isDeformed{false};
+    };
+
+} // namespace passthrough
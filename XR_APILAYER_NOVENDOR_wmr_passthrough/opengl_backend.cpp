@@ -0,0 +1,748 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include <GL/gl.h>
+
+#include "allocation_tracker.h"
+#include "graphics_backend.h"
+#include "log.h"
+#include "swapchain_planner.h"
+
+// The definitions below are from glext.h, which is not part of the Windows SDK.
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_ARRAY_BUFFER_BINDING 0x8894
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#define GL_PIXEL_UNPACK_BUFFER_BINDING 0x88EF
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_CURRENT_PROGRAM 0x8B8D
+#define GL_VERTEX_ARRAY_BINDING 0x85B5
+#define GL_TEXTURE0 0x84C0
+#define GL_ACTIVE_TEXTURE 0x84E0
+#define GL_CLAMP_TO_EDGE 0x812F
+#define GL_R8 0x8229
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_TEXTURE_BINDING_2D_ARRAY 0x8C1D
+#define GL_SAMPLER_BINDING 0x8919
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#define GL_FRAMEBUFFER_SRGB 0x8DB9
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_WAIT_FAILED 0x911D
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+
+typedef char GLchar;
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+#endif
+
+// The OpenGL functions beyond 1.1, resolved with wglGetProcAddress(). OpenGL 4.4 is needed for glBufferStorage().
+#define PASSTHROUGH_GL_FUNCTIONS(X)                                                                                    \
+    X(void, glGenBuffers, (GLsizei n, GLuint * buffers))                                                               \
+    X(void, glDeleteBuffers, (GLsizei n, const GLuint* buffers))                                                       \
+    X(void, glBindBuffer, (GLenum target, GLuint buffer))                                                              \
+    X(void, glBufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage))                            \
+    X(void, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data))                      \
+    X(void, glBufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags))                     \
+    X(void*, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))                 \
+    X(GLuint, glCreateShader, (GLenum type))                                                                           \
+    X(void, glShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length))          \
+    X(void, glCompileShader, (GLuint shader))                                                                          \
+    X(void, glGetShaderiv, (GLuint shader, GLenum pname, GLint * params))                                              \
+    X(void, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei * length, GLchar * infoLog))                  \
+    X(void, glDeleteShader, (GLuint shader))                                                                           \
+    X(GLuint, glCreateProgram, ())                                                                                     \
+    X(void, glAttachShader, (GLuint program, GLuint shader))                                                           \
+    X(void, glLinkProgram, (GLuint program))                                                                           \
+    X(void, glGetProgramiv, (GLuint program, GLenum pname, GLint * params))                                            \
+    X(void, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei * length, GLchar * infoLog))                \
+    X(void, glDeleteProgram, (GLuint program))                                                                         \
+    X(void, glUseProgram, (GLuint program))                                                                            \
+    X(GLint, glGetUniformLocation, (GLuint program, const GLchar* name))                                               \
+    X(void, glUniform1i, (GLint location, GLint v0))                                                                   \
+    X(void, glUniform4fv, (GLint location, GLsizei count, const GLfloat* value))                                       \
+    X(void, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value))             \
+    X(void, glGenVertexArrays, (GLsizei n, GLuint * arrays))                                                           \
+    X(void, glDeleteVertexArrays, (GLsizei n, const GLuint* arrays))                                                   \
+    X(void, glBindVertexArray, (GLuint array))                                                                         \
+    X(void, glEnableVertexAttribArray, (GLuint index))                                                                 \
+    X(void,                                                                                                            \
+      glVertexAttribPointer,                                                                                           \
+      (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer))              \
+    X(void, glGenFramebuffers, (GLsizei n, GLuint * framebuffers))                                                     \
+    X(void, glDeleteFramebuffers, (GLsizei n, const GLuint* framebuffers))                                             \
+    X(void, glBindFramebuffer, (GLenum target, GLuint framebuffer))                                                    \
+    X(void, glFramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer))    \
+    X(GLenum, glCheckFramebufferStatus, (GLenum target))                                                               \
+    X(void, glActiveTexture, (GLenum texture))                                                                         \
+    X(void, glBindSampler, (GLuint unit, GLuint sampler))                                                              \
+    X(void,                                                                                                            \
+      glTexSubImage3D,                                                                                                 \
+      (GLenum target,                                                                                                  \
+       GLint level,                                                                                                    \
+       GLint xoffset,                                                                                                  \
+       GLint yoffset,                                                                                                  \
+       GLint zoffset,                                                                                                  \
+       GLsizei width,                                                                                                  \
+       GLsizei height,                                                                                                 \
+       GLsizei depth,                                                                                                  \
+       GLenum format,                                                                                                  \
+       GLenum type,                                                                                                    \
+       const void* pixels))                                                                                            \
+    X(GLsync, glFenceSync, (GLenum condition, GLbitfield flags))                                                       \
+    X(GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout))                                     \
+    X(void, glDeleteSync, (GLsync sync))
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::log;
+
+    using namespace DirectX;
+
+    // This code is adapted from the HLSL shaders in d3d11_backend.cpp.
+    const std::string_view VertexShaderSource = R"_(
+#version 330 core
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec2 tex;
+
+uniform mat4 modelViewProjection;
+
+out vec2 texCoord;
+
+void main() {
+    gl_Position = vec4(pos, 1.0) * modelViewProjection;
+
+    // Place it behind everything else
+    gl_Position.z = 0.9999 * gl_Position.w;
+
+    texCoord = tex;
+}
+)_";
+
+    const std::string_view PixelShaderSource = R"_(
+#version 330 core
+
+// The alpha component is the opacity of the passthrough.
+uniform vec4 colorAdjustment;
+uniform sampler2D cameraTexture;
+
+in vec2 texCoord;
+
+out vec4 outColor;
+
+void main() {
+    float color = texture(cameraTexture, texCoord).r;
+    outColor = vec4(color * colorAdjustment.rgb * colorAdjustment.a, 1.0);
+}
+)_";
+
+    // GLSL can only be compiled with a context current, which the warm-up threads do not have. The "bytecode" is the
+    // source itself, and the actual compilation happens in createDrawingResources().
+    class GLSLSourceCompiler : public IShaderCompiler {
+      public:
+        uint32_t getVersion() const override {
+            return 1;
+        }
+
+        std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) override {
+            return {source.begin(), source.end()};
+        }
+    };
+
+    struct GLFunctions {
+#define DECLARE_GL_FUNCTION(ret, name, args) ret(APIENTRY* name) args = nullptr;
+        PASSTHROUGH_GL_FUNCTIONS(DECLARE_GL_FUNCTION)
+#undef DECLARE_GL_FUNCTION
+
+        // Returns false if any of the functions is not available.
+        bool load() {
+            bool isComplete = true;
+#define LOAD_GL_FUNCTION(ret, name, args)                                                                              \
+    name = reinterpret_cast<decltype(name)>(wglGetProcAddress(#name));                                                 \
+    if (!name) {                                                                                                       \
+        Log("OpenGL function %s is not available\n", #name);                                                           \
+        isComplete = false;                                                                                            \
+    }
+            PASSTHROUGH_GL_FUNCTIONS(LOAD_GL_FUNCTION)
+#undef LOAD_GL_FUNCTION
+            return isComplete;
+        }
+    };
+
+    // Make the session's context current for the duration of the scope, if the application did not do it.
+    class GLContextScope {
+      public:
+        GLContextScope(HDC dc, HGLRC glrc) : m_previousDC(wglGetCurrentDC()), m_previousGLRC(wglGetCurrentContext()) {
+            if (m_previousGLRC != glrc) {
+                wglMakeCurrent(dc, glrc);
+            }
+        }
+
+        ~GLContextScope() {
+            if (m_previousGLRC != wglGetCurrentContext()) {
+                wglMakeCurrent(m_previousDC, m_previousGLRC);
+            }
+        }
+
+      private:
+        const HDC m_previousDC;
+        const HGLRC m_previousGLRC;
+    };
+
+    // Save the state the backend modifies, and restore it for the application.
+    class GLStateScope {
+      public:
+        GLStateScope(const GLFunctions& gl) : m_gl(gl) {
+            glGetIntegerv(GL_CURRENT_PROGRAM, &m_program);
+            glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &m_vertexArray);
+            glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &m_arrayBuffer);
+            glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &m_unpackBuffer);
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_drawFramebuffer);
+            glGetIntegerv(GL_ACTIVE_TEXTURE, &m_activeTexture);
+            m_gl.glActiveTexture(GL_TEXTURE0);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &m_texture2D);
+            glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &m_texture2DArray);
+            glGetIntegerv(GL_SAMPLER_BINDING, &m_sampler);
+            glGetIntegerv(GL_VIEWPORT, m_viewport);
+            glGetBooleanv(GL_COLOR_WRITEMASK, m_colorMask);
+            glGetIntegerv(GL_UNPACK_ALIGNMENT, &m_unpackAlignment);
+            glGetIntegerv(GL_UNPACK_ROW_LENGTH, &m_unpackRowLength);
+            for (uint32_t i = 0; i < ARRAYSIZE(Capabilities); i++) {
+                m_capabilities[i] = glIsEnabled(Capabilities[i]);
+            }
+        }
+
+        ~GLStateScope() {
+            for (uint32_t i = 0; i < ARRAYSIZE(Capabilities); i++) {
+                m_capabilities[i] ? glEnable(Capabilities[i]) : glDisable(Capabilities[i]);
+            }
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, m_unpackRowLength);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, m_unpackAlignment);
+            glColorMask(m_colorMask[0], m_colorMask[1], m_colorMask[2], m_colorMask[3]);
+            glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+            m_gl.glBindSampler(0, m_sampler);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture2DArray);
+            glBindTexture(GL_TEXTURE_2D, m_texture2D);
+            m_gl.glActiveTexture(m_activeTexture);
+            m_gl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_drawFramebuffer);
+            m_gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_unpackBuffer);
+            m_gl.glBindBuffer(GL_ARRAY_BUFFER, m_arrayBuffer);
+            m_gl.glBindVertexArray(m_vertexArray);
+            m_gl.glUseProgram(m_program);
+        }
+
+      private:
+        static constexpr GLenum Capabilities[] = {
+            GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_FRAMEBUFFER_SRGB};
+
+        const GLFunctions& m_gl;
+        GLint m_program;
+        GLint m_vertexArray;
+        GLint m_arrayBuffer;
+        GLint m_unpackBuffer;
+        GLint m_drawFramebuffer;
+        GLint m_activeTexture;
+        GLint m_texture2D;
+        GLint m_texture2DArray;
+        GLint m_sampler;
+        GLint m_viewport[4];
+        GLboolean m_colorMask[4];
+        GLint m_unpackAlignment;
+        GLint m_unpackRowLength;
+        GLboolean m_capabilities[ARRAYSIZE(Capabilities)];
+    };
+
+    // A sync object, inserted after the copy from an upload slot.
+    class GLUploadFence {
+      public:
+        GLUploadFence(const GLFunctions& gl) : m_gl(&gl) {
+        }
+
+        GLUploadFence(GLUploadFence&& other) noexcept : m_gl(other.m_gl), m_sync(other.m_sync) {
+            other.m_sync = nullptr;
+        }
+
+        ~GLUploadFence() {
+            if (m_sync) {
+                m_gl->glDeleteSync(m_sync);
+            }
+        }
+
+        void signal() {
+            if (m_sync) {
+                m_gl->glDeleteSync(m_sync);
+            }
+            m_sync = m_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        bool isCompleted() {
+            return !m_sync || m_gl->glClientWaitSync(m_sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED;
+        }
+
+        void wait() {
+            if (m_sync) {
+                m_gl->glClientWaitSync(m_sync, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            }
+        }
+
+      private:
+        const GLFunctions* m_gl;
+        GLsync m_sync{nullptr};
+    };
+
+    // Draw with the OpenGL context of the application.
+    class OpenGLBackend : public IGraphicsBackend {
+      public:
+        OpenGLBackend(HDC dc, HGLRC glrc, const GLFunctions& gl) : m_dc(dc), m_glrc(glrc), m_gl(gl) {
+        }
+
+        ~OpenGLBackend() override {
+            GLContextScope context(m_dc, m_glrc);
+
+            m_cameraUploadRing.reset({});
+            if (m_cameraUploadBuffer) {
+                // Deleting the buffer also unmaps it.
+                m_gl.glDeleteBuffers(1, &m_cameraUploadBuffer);
+            }
+            if (m_cameraTexture) {
+                glDeleteTextures(1, &m_cameraTexture);
+            }
+            if (m_framebuffer) {
+                m_gl.glDeleteFramebuffers(1, &m_framebuffer);
+            }
+            if (m_vertexArray[0]) {
+                m_gl.glDeleteVertexArrays(ViewCount, m_vertexArray);
+                m_gl.glDeleteBuffers(ViewCount, m_vertexBuffer);
+                m_gl.glDeleteBuffers(1, &m_indexBuffer);
+            }
+            if (m_program) {
+                m_gl.glDeleteProgram(m_program);
+            }
+        }
+
+        std::unique_ptr<IShaderCompiler> createShaderCompiler() const override {
+            return std::make_unique<GLSLSourceCompiler>();
+        }
+
+        ShaderDescription getVertexShader() const override {
+            return {VertexShaderSource, "main", "vertex", 0};
+        }
+
+        ShaderDescription getPixelShader() const override {
+            return {PixelShaderSource, "main", "fragment", 0};
+        }
+
+        SwapchainFormatApi getSwapchainFormatApi() const override {
+            return SwapchainFormatApi::DXGIOrOpenGL;
+        }
+
+        void importSwapchainImages(OpenXrApi& openXR,
+                                   XrSwapchain swapchain,
+                                   const XrSwapchainCreateInfo& createInfo) override {
+            GLContextScope context(m_dc, m_glrc);
+
+            m_swapchainInfo = createInfo;
+
+            uint32_t imageCount;
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+            std::vector<XrSwapchainImageOpenGLKHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR, nullptr});
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+            for (uint32_t i = 0; i < imageCount; i++) {
+                m_swapchainImages.push_back(images[i].image);
+            }
+
+            m_gl.glGenFramebuffers(1, &m_framebuffer);
+        }
+
+        void createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                    const std::vector<uint8_t>& psBytes,
+                                    const std::vector<VertexPositionTexture>* vertices,
+                                    const std::vector<uint16_t>& indices) override {
+            ALLOCATION_SCOPE("createDrawingResources");
+
+            GLContextScope context(m_dc, m_glrc);
+            GLStateScope state(m_gl);
+
+            {
+                const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vsBytes);
+                const GLuint pixelShader = compileShader(GL_FRAGMENT_SHADER, psBytes);
+
+                m_program = m_gl.glCreateProgram();
+                m_gl.glAttachShader(m_program, vertexShader);
+                m_gl.glAttachShader(m_program, pixelShader);
+                m_gl.glLinkProgram(m_program);
+                m_gl.glDeleteShader(vertexShader);
+                m_gl.glDeleteShader(pixelShader);
+
+                GLint status;
+                m_gl.glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+                if (!status) {
+                    char log[1024]{};
+                    m_gl.glGetProgramInfoLog(m_program, sizeof(log), nullptr, log);
+                    Log("%s\n", log);
+                }
+                CHECK_MSG(status, "Failed to link shaders");
+
+                m_modelViewProjectionLocation = m_gl.glGetUniformLocation(m_program, "modelViewProjection");
+                m_colorAdjustmentLocation = m_gl.glGetUniformLocation(m_program, "colorAdjustment");
+
+                m_gl.glUseProgram(m_program);
+                m_gl.glUniform1i(m_gl.glGetUniformLocation(m_program, "cameraTexture"), 0);
+            }
+            {
+                m_gl.glGenVertexArrays(ViewCount, m_vertexArray);
+                m_gl.glGenBuffers(ViewCount, m_vertexBuffer);
+                m_gl.glGenBuffers(1, &m_indexBuffer);
+                for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                    m_gl.glBindVertexArray(m_vertexArray[eye]);
+
+                    // The positions may be updated.
+                    m_vertices[eye] = vertices[eye];
+                    m_gl.glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer[eye]);
+                    m_gl.glBufferData(GL_ARRAY_BUFFER,
+                                      vertices[eye].size() * sizeof(VertexPositionTexture),
+                                      vertices[eye].data(),
+                                      GL_DYNAMIC_DRAW);
+                    m_gl.glEnableVertexAttribArray(0);
+                    m_gl.glVertexAttribPointer(0,
+                                               3,
+                                               GL_FLOAT,
+                                               GL_FALSE,
+                                               sizeof(VertexPositionTexture),
+                                               (void*)offsetof(VertexPositionTexture, position));
+                    m_gl.glEnableVertexAttribArray(1);
+                    m_gl.glVertexAttribPointer(1,
+                                               2,
+                                               GL_FLOAT,
+                                               GL_FALSE,
+                                               sizeof(VertexPositionTexture),
+                                               (void*)offsetof(VertexPositionTexture, textureCoordinate));
+
+                    // The index buffer binding is part of the vertex array state.
+                    m_gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+                    if (eye == 0) {
+                        m_gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                                          indices.size() * sizeof(uint16_t),
+                                          indices.data(),
+                                          GL_STATIC_DRAW);
+                    }
+                }
+                m_gl.glBindVertexArray(0);
+
+                m_indexCount = (GLsizei)indices.size();
+            }
+        }
+
+        void updateVertexPositions(const std::vector<XMFLOAT3>* positions) override {
+            GLContextScope context(m_dc, m_glrc);
+            GLStateScope state(m_gl);
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                for (size_t i = 0; i < m_vertices[eye].size(); i++) {
+                    m_vertices[eye][i].position = positions[eye][i];
+                }
+
+                m_gl.glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer[eye]);
+                m_gl.glBufferSubData(GL_ARRAY_BUFFER,
+                                     0,
+                                     m_vertices[eye].size() * sizeof(VertexPositionTexture),
+                                     m_vertices[eye].data());
+            }
+        }
+
+        uint8_t* mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) override {
+            GLContextScope context(m_dc, m_glrc);
+
+            ensureCameraTexture(width, height);
+
+            // The slot is not in use by the GPU anymore, so writing to it does not race with the previous copy.
+            m_cameraUploadSlot = m_cameraUploadRing.acquire();
+
+            pitch = m_cameraUploadPitch;
+            return m_cameraUploadMemory + m_cameraUploadSlot * m_cameraUploadSlotSize;
+        }
+
+        void unmapCameraTexture(bool commit) override {
+            if (!commit) {
+                // The slot will be overwritten by the next image.
+                m_cameraUploadRing.cancel(m_cameraUploadSlot);
+                return;
+            }
+
+            GLContextScope context(m_dc, m_glrc);
+            GLStateScope state(m_gl);
+
+            // The buffer is coherent, the copy sees the CPU writes without flushing.
+            m_gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_cameraUploadBuffer);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, m_cameraUploadPitch);
+            glBindTexture(GL_TEXTURE_2D, m_cameraTexture);
+            glTexSubImage2D(GL_TEXTURE_2D,
+                            0,
+                            0,
+                            0,
+                            m_cameraTextureWidth,
+                            m_cameraTextureHeight,
+                            GL_RED,
+                            GL_UNSIGNED_BYTE,
+                            (void*)(m_cameraUploadSlot * m_cameraUploadSlotSize));
+
+            m_cameraUploadRing.getFence(m_cameraUploadSlot).signal();
+            m_cameraUploadRing.submit(m_cameraUploadSlot);
+        }
+
+        const UploadRingStatistics& getCameraUploadStatistics() const override {
+            return m_cameraUploadRing.getStatistics();
+        }
+
+        void setOpacity(float opacity) override {
+            m_colorAdjustment[3] = opacity;
+        }
+
+        void drawPassthroughLayer(uint32_t imageIndex,
+                                  const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+            GLContextScope context(m_dc, m_glrc);
+            GLStateScope state(m_gl);
+
+            // Setup the common rendering state.
+            for (const GLenum capability : {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST, GL_STENCIL_TEST}) {
+                glDisable(capability);
+            }
+
+            // Match the D3D11 behavior of writing through an sRGB render target view.
+            const SwapchainFormatInfo* formatInfo = getSwapchainFormatInfo(m_swapchainInfo.format);
+            if (formatInfo && formatInfo->isSRGB) {
+                glEnable(GL_FRAMEBUFFER_SRGB);
+            } else {
+                glDisable(GL_FRAMEBUFFER_SRGB);
+            }
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glViewport(0, 0, m_swapchainInfo.width, m_swapchainInfo.height);
+
+            m_gl.glUseProgram(m_program);
+            m_gl.glUniform4fv(m_colorAdjustmentLocation, 1, m_colorAdjustment);
+            m_gl.glBindSampler(0, 0);
+            glBindTexture(GL_TEXTURE_2D, m_cameraTexture);
+            m_gl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                // The matrix is already transposed for HLSL, which is the column-major layout OpenGL expects.
+                m_gl.glUniformMatrix4fv(
+                    m_modelViewProjectionLocation, 1, GL_FALSE, &modelViewProjection[eye].m[0][0]);
+
+                // Setup per-eye rendering state.
+                m_gl.glFramebufferTextureLayer(
+                    GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_swapchainImages[imageIndex], 0, eye);
+                m_gl.glBindVertexArray(m_vertexArray[eye]);
+
+                // Draw the screen.
+                glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, nullptr);
+            }
+
+            m_gl.glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0);
+        }
+
+        void uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) override {
+            GLContextScope context(m_dc, m_glrc);
+            GLStateScope state(m_gl);
+
+            // OpenGL images are bottom-up.
+            const size_t rowSize = m_swapchainInfo.width * sizeof(uint32_t);
+            m_flippedImage.resize(rowSize * m_swapchainInfo.height);
+            for (uint32_t y = 0; y < m_swapchainInfo.height; y++) {
+                memcpy(m_flippedImage.data() + (m_swapchainInfo.height - 1 - y) * rowSize,
+                       reinterpret_cast<const uint8_t*>(data) + y * pitch,
+                       rowSize);
+            }
+
+            m_gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, m_swapchainImages[imageIndex]);
+            m_gl.glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                 0,
+                                 0,
+                                 0,
+                                 slice,
+                                 m_swapchainInfo.width,
+                                 m_swapchainInfo.height,
+                                 1,
+                                 GL_RGBA,
+                                 GL_UNSIGNED_BYTE,
+                                 m_flippedImage.data());
+        }
+
+        bool isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const override {
+            return false;
+        }
+
+        void importApplicationSwapchain(OpenXrApi& openXR,
+                                        XrSwapchain swapchain,
+                                        const XrSwapchainCreateInfo& createInfo) override {
+        }
+
+        void forgetApplicationSwapchain(XrSwapchain swapchain) override {
+        }
+
+        void compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                       const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+        }
+
+      private:
+        // Enough to never wait on the GPU before reusing a slot.
+        static constexpr uint32_t CameraUploadSlots = 3;
+
+        GLuint compileShader(GLenum type, const std::vector<uint8_t>& source) {
+            const GLuint shader = m_gl.glCreateShader(type);
+            const GLchar* const sources[] = {reinterpret_cast<const GLchar*>(source.data())};
+            const GLint lengths[] = {(GLint)source.size()};
+            m_gl.glShaderSource(shader, 1, sources, lengths);
+            m_gl.glCompileShader(shader);
+
+            GLint status;
+            m_gl.glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+            if (!status) {
+                char log[1024]{};
+                m_gl.glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+                Log("%s\n", log);
+            }
+            CHECK_MSG(status, "Failed to compile shader");
+
+            return shader;
+        }
+
+        void ensureCameraTexture(uint32_t width, uint32_t height) {
+            if (m_cameraTexture && m_cameraTextureWidth == width && m_cameraTextureHeight == height) {
+                return;
+            }
+
+            GLStateScope state(m_gl);
+
+            if (m_cameraTexture) {
+                glDeleteTextures(1, &m_cameraTexture);
+            }
+            glGenTextures(1, &m_cameraTexture);
+            glBindTexture(GL_TEXTURE_2D, m_cameraTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            m_cameraTextureWidth = width;
+            m_cameraTextureHeight = height;
+
+            // A persistently mapped buffer with one slot per upload in flight.
+            std::vector<GLUploadFence> fences;
+            for (uint32_t i = 0; i < CameraUploadSlots; i++) {
+                fences.emplace_back(m_gl);
+            }
+            m_cameraUploadRing.reset(std::move(fences));
+            if (m_cameraUploadBuffer) {
+                m_gl.glDeleteBuffers(1, &m_cameraUploadBuffer);
+            }
+            m_cameraUploadPitch = width;
+            m_cameraUploadSlotSize = (size_t)m_cameraUploadPitch * height;
+
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            m_gl.glGenBuffers(1, &m_cameraUploadBuffer);
+            m_gl.glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_cameraUploadBuffer);
+            m_gl.glBufferStorage(GL_PIXEL_UNPACK_BUFFER, CameraUploadSlots * m_cameraUploadSlotSize, nullptr, flags);
+            m_cameraUploadMemory = reinterpret_cast<uint8_t*>(m_gl.glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER, 0, CameraUploadSlots * m_cameraUploadSlotSize, flags));
+            CHECK_MSG(m_cameraUploadMemory, "Failed to map the camera upload buffer");
+        }
+
+        const HDC m_dc;
+        const HGLRC m_glrc;
+        const GLFunctions m_gl;
+
+        // Swapchain resources.
+        XrSwapchainCreateInfo m_swapchainInfo{};
+        std::vector<GLuint> m_swapchainImages;
+        GLuint m_framebuffer{0};
+        std::vector<uint8_t> m_flippedImage;
+
+        // Camera image resources.
+        GLuint m_cameraTexture{0};
+        uint32_t m_cameraTextureWidth{0};
+        uint32_t m_cameraTextureHeight{0};
+        GLuint m_cameraUploadBuffer{0};
+        uint8_t* m_cameraUploadMemory{nullptr};
+        uint32_t m_cameraUploadPitch{0};
+        size_t m_cameraUploadSlotSize{0};
+        uint32_t m_cameraUploadSlot{0};
+        UploadRing<GLUploadFence> m_cameraUploadRing;
+
+        // Drawing resources.
+        GLuint m_program{0};
+        GLint m_modelViewProjectionLocation{-1};
+        GLint m_colorAdjustmentLocation{-1};
+#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
+        GLfloat m_colorAdjustment[4]{XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT, 1.f};
+#else
+        GLfloat m_colorAdjustment[4]{1.f, 1.f, 1.f, 1.f};
+#endif
+        GLuint m_vertexArray[ViewCount]{};
+        GLuint m_vertexBuffer[ViewCount]{};
+        std::vector<VertexPositionTexture> m_vertices[ViewCount];
+        GLuint m_indexBuffer{0};
+        GLsizei m_indexCount{0};
+    };
+
+} // namespace
+
+namespace passthrough {
+
+    std::unique_ptr<IGraphicsBackend> createOpenGLBackend(HDC dc, HGLRC glrc) {
+        GLContextScope context(dc, glrc);
+
+        GLFunctions gl;
+        if (!gl.load()) {
+            return nullptr;
+        }
+
+        return std::make_unique<OpenGLBackend>(dc, glrc, gl);
+    }
+
+} // namespace passthrough
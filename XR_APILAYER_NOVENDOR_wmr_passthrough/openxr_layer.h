@@ -0,0 +1,44 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+#include "graphics_backend.h"
+
+namespace passthrough {
+
+    // Creates the graphics backend for the graphics binding passed to xrCreateSession(). Returns nullptr if the
+    // graphics API is not supported.
+    using GraphicsBackendFactory =
+        std::function<std::unique_ptr<IGraphicsBackend>(const XrSessionCreateInfo& createInfo)>;
+
+    // Creates the client of the camera server. Called on a background thread.
+    using CameraClientFactory = std::function<std::unique_ptr<ICameraClientWrapper>()>;
+
+    // The layer, drawing with the graphics backends and the camera client from the factories. GetInstance() creates it
+    // with the ones for the application's graphics device and the headset's cameras.
+    std::unique_ptr<OpenXrApi> CreateOpenXrLayer(GraphicsBackendFactory createGraphicsBackend,
+                                                 CameraClientFactory createCameraClient);
+
+} // namespace passthrough
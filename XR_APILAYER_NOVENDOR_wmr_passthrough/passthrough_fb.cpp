@@ -0,0 +1,233 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "passthrough_fb.h"
+
+namespace passthrough {
+
+    namespace {
+
+        uint32_t getGeneration(uint64_t handle) {
+            return (uint32_t)(handle / PassthroughStateFB::MaxLayers);
+        }
+
+        uint32_t getLayerIndex(uint64_t handle) {
+            return (uint32_t)(handle % PassthroughStateFB::MaxLayers);
+        }
+
+        uint64_t packLayerOpacity(uint64_t handle, float opacity) {
+            uint32_t opacityBits;
+            memcpy(&opacityBits, &opacity, sizeof(opacityBits));
+            return (uint64_t)getGeneration(handle) << 32 | opacityBits;
+        }
+
+    } // namespace
+
+    XrResult PassthroughStateFB::createPassthrough(XrSession session,
+                                                   const XrPassthroughCreateInfoFB& createInfo,
+                                                   XrPassthroughFB& passthrough) {
+        if (createInfo.type != XR_TYPE_PASSTHROUGH_CREATE_INFO_FB) {
+            return XR_ERROR_VALIDATION_FAILURE;
+        }
+
+        std::unique_lock lock(m_mutex);
+
+        passthrough = reinterpret_cast<XrPassthroughFB>((uint64_t)m_nextGeneration++ * MaxLayers);
+        m_passthroughs[passthrough] = {session, !!(createInfo.flags & XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB)};
+        updateIsPaused();
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::destroyPassthrough(XrPassthroughFB passthrough) {
+        std::unique_lock lock(m_mutex);
+
+        if (!m_passthroughs.erase(passthrough)) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        for (const auto& [layer, state] : m_layers) {
+            if (state.passthrough == passthrough) {
+                updateLayerOpacity(layer);
+            }
+        }
+        updateIsPaused();
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::setPassthroughRunning(XrPassthroughFB passthrough, bool isRunning) {
+        std::unique_lock lock(m_mutex);
+
+        const auto it = m_passthroughs.find(passthrough);
+        if (it == m_passthroughs.end()) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        it->second.isRunning = isRunning;
+        for (const auto& [layer, state] : m_layers) {
+            if (state.passthrough == passthrough) {
+                updateLayerOpacity(layer);
+            }
+        }
+        updateIsPaused();
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::createLayer(XrSession session,
+                                             const XrPassthroughLayerCreateInfoFB& createInfo,
+                                             XrPassthroughLayerFB& layer) {
+        if (createInfo.type != XR_TYPE_PASSTHROUGH_LAYER_CREATE_INFO_FB) {
+            return XR_ERROR_VALIDATION_FAILURE;
+        }
+
+        // We only have the camera image to show, there is no geometry to project it onto.
+        if (createInfo.purpose != XR_PASSTHROUGH_LAYER_PURPOSE_RECONSTRUCTION_FB) {
+            return XR_ERROR_FEATURE_UNSUPPORTED;
+        }
+
+        std::unique_lock lock(m_mutex);
+
+        if (!m_passthroughs.count(createInfo.passthrough)) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+
+        const auto unused = std::find_if(std::cbegin(m_layerOpacities),
+                                         std::cend(m_layerOpacities),
+                                         [](const std::atomic<uint64_t>& entry) { return !entry.load(); });
+        if (unused == std::cend(m_layerOpacities)) {
+            return XR_ERROR_LIMIT_REACHED;
+        }
+
+        layer = reinterpret_cast<XrPassthroughLayerFB>((uint64_t)m_nextGeneration++ * MaxLayers +
+                                                       (unused - std::cbegin(m_layerOpacities)));
+        m_layers[layer] = {session,
+                           createInfo.passthrough,
+                           !!(createInfo.flags & XR_PASSTHROUGH_IS_RUNNING_AT_CREATION_BIT_FB),
+                           1.f};
+        updateLayerOpacity(layer);
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::destroyLayer(XrPassthroughLayerFB layer) {
+        std::unique_lock lock(m_mutex);
+
+        if (!m_layers.erase(layer)) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        m_layerOpacities[getLayerIndex(reinterpret_cast<uint64_t>(layer))].store(0, std::memory_order_release);
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::setLayerRunning(XrPassthroughLayerFB layer, bool isRunning) {
+        std::unique_lock lock(m_mutex);
+
+        const auto it = m_layers.find(layer);
+        if (it == m_layers.end()) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+        it->second.isRunning = isRunning;
+        updateLayerOpacity(layer);
+
+        return XR_SUCCESS;
+    }
+
+    XrResult PassthroughStateFB::setLayerStyle(XrPassthroughLayerFB layer, const XrPassthroughStyleFB& style) {
+        if (style.type != XR_TYPE_PASSTHROUGH_STYLE_FB || style.textureOpacityFactor < 0.f ||
+            style.textureOpacityFactor > 1.f) {
+            return XR_ERROR_VALIDATION_FAILURE;
+        }
+
+        std::unique_lock lock(m_mutex);
+
+        const auto it = m_layers.find(layer);
+        if (it == m_layers.end()) {
+            return XR_ERROR_HANDLE_INVALID;
+        }
+
+        // The camera image is faded to black by the opacity. The edge color and the color maps are ignored.
+        it->second.opacity = style.textureOpacityFactor;
+        updateLayerOpacity(layer);
+
+        return XR_SUCCESS;
+    }
+
+    void PassthroughStateFB::destroySession(XrSession session) {
+        std::unique_lock lock(m_mutex);
+
+        for (auto it = m_layers.begin(); it != m_layers.end();) {
+            if (it->second.session == session) {
+                m_layerOpacities[getLayerIndex(reinterpret_cast<uint64_t>(it->first))].store(
+                    0, std::memory_order_release);
+                it = m_layers.erase(it);
+            } else {
+                it++;
+            }
+        }
+        for (auto it = m_passthroughs.begin(); it != m_passthroughs.end();) {
+            it = it->second.session == session ? m_passthroughs.erase(it) : std::next(it);
+        }
+        updateIsPaused();
+    }
+
+    float PassthroughStateFB::getLayerOpacity(XrPassthroughLayerFB layer) const {
+        const uint64_t handle = reinterpret_cast<uint64_t>(layer);
+        const uint64_t entry = m_layerOpacities[getLayerIndex(handle)].load(std::memory_order_acquire);
+
+        // The entry was reused by another layer, or the handle is invalid.
+        if (entry >> 32 != getGeneration(handle)) {
+            return 0.f;
+        }
+
+        const uint32_t opacityBits = (uint32_t)entry;
+        float opacity;
+        memcpy(&opacity, &opacityBits, sizeof(opacity));
+        return opacity;
+    }
+
+    bool PassthroughStateFB::isPaused() const {
+        return m_isPaused.load(std::memory_order_relaxed);
+    }
+
+    void PassthroughStateFB::updateLayerOpacity(XrPassthroughLayerFB layer) {
+        const Layer& state = m_layers.at(layer);
+        const auto passthrough = m_passthroughs.find(state.passthrough);
+        const bool isShown =
+            state.isRunning && passthrough != m_passthroughs.end() && passthrough->second.isRunning;
+
+        const uint64_t handle = reinterpret_cast<uint64_t>(layer);
+        m_layerOpacities[getLayerIndex(handle)].store(packLayerOpacity(handle, isShown ? state.opacity : 0.f),
+                                                      std::memory_order_release);
+    }
+
+    void PassthroughStateFB::updateIsPaused() {
+        m_isPaused.store(!m_passthroughs.empty() &&
+                             std::none_of(m_passthroughs.cbegin(),
+                                          m_passthroughs.cend(),
+                                          [](const auto& entry) { return entry.second.isRunning; }),
+                         std::memory_order_relaxed);
+    }
+
+} // namespace passthrough
@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // The passthrough features and layers created by the application through XR_FB_passthrough. Only the state is
+    // kept here: the camera image is always drawn by the layer underneath the application's layers. Thread-safe, since
+    // the application may pause or resume passthrough from any thread.
+    class PassthroughStateFB {
+      public:
+        // The number of passthrough layers that can exist at the same time.
+        static constexpr uint32_t MaxLayers = 16;
+
+        XrResult createPassthrough(XrSession session,
+                                   const XrPassthroughCreateInfoFB& createInfo,
+                                   XrPassthroughFB& passthrough);
+        XrResult destroyPassthrough(XrPassthroughFB passthrough);
+        XrResult setPassthroughRunning(XrPassthroughFB passthrough, bool isRunning);
+
+        XrResult createLayer(XrSession session,
+                             const XrPassthroughLayerCreateInfoFB& createInfo,
+                             XrPassthroughLayerFB& layer);
+        XrResult destroyLayer(XrPassthroughLayerFB layer);
+        XrResult setLayerRunning(XrPassthroughLayerFB layer, bool isRunning);
+        XrResult setLayerStyle(XrPassthroughLayerFB layer, const XrPassthroughStyleFB& style);
+
+        // Destroy the objects that are children of the session.
+        void destroySession(XrSession session);
+
+        // The opacity of the camera image for a layer submitted by the application, 0 when it must not be shown. Does
+        // not lock, since it is called for every frame.
+        float getLayerOpacity(XrPassthroughLayerFB layer) const;
+
+        // Whether the application created passthrough features and paused all of them. The camera can be released
+        // right away, without waiting for the idle timeout. Does not lock either.
+        bool isPaused() const;
+
+      private:
+        struct Passthrough {
+            XrSession session;
+            bool isRunning;
+        };
+
+        struct Layer {
+            XrSession session;
+            XrPassthroughFB passthrough;
+            bool isRunning;
+            float opacity;
+        };
+
+        // Recompute the state read without locking. Called with the mutex held.
+        void updateLayerOpacity(XrPassthroughLayerFB layer);
+        void updateIsPaused();
+
+        mutable std::mutex m_mutex;
+        std::map<XrPassthroughFB, Passthrough> m_passthroughs;
+        std::map<XrPassthroughLayerFB, Layer> m_layers;
+
+        // Handles are a unique generation times MaxLayers, plus the index of the layer's entry below.
+        uint32_t m_nextGeneration{1};
+
+        // The opacity of each layer, with the generation of the layer's handle in the upper 32 bits, so that both are
+        // read at once. Unused entries are 0.
+        std::atomic<uint64_t> m_layerOpacities[MaxLayers]{};
+        std::atomic<bool> m_isPaused{false};
+    };
+
+} // namespace passthrough
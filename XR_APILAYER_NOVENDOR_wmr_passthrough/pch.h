@@ -23,19 +23,27 @@
 #pragma once
 
 // Standard library.
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdarg>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <future>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <map>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <vector>
 
 using namespace std::chrono_literals;
@@ -43,6 +51,7 @@ using namespace std::chrono_literals;
 // Windows header files.
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 #include <windows.h>
+#include <intrin.h>
 #include <unknwn.h>
 #include <wrl.h>
 
@@ -54,11 +63,17 @@ using Microsoft::WRL::ComPtr;
 #include <d3d11on12.h>
 #include <d3dcompiler.h>
 
+// Vulkan, from the Vulkan SDK. The functions are resolved at runtime from the application's device.
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+
 // OpenXR + Windows-specific definitions.
 #define XR_NO_PROTOTYPES
 #define XR_USE_PLATFORM_WIN32
 #define XR_USE_GRAPHICS_API_D3D11
 #define XR_USE_GRAPHICS_API_D3D12
+#define XR_USE_GRAPHICS_API_OPENGL
+#define XR_USE_GRAPHICS_API_VULKAN
 #include <openxr/openxr.h>
 #include <openxr/openxr_platform.h>
 
@@ -0,0 +1,193 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "log.h"
+#include "shader_cache.h"
+
+namespace {
+
+    using namespace passthrough::log;
+
+    constexpr uint32_t CacheFileMagic = 0x43535057; // "WPSC"
+    constexpr uint32_t CacheFileFormatVersion = 1;
+
+    // Anything larger is not a shader we produced.
+    constexpr uint64_t MaxBytecodeSize = 16 * 1024 * 1024;
+
+    struct CacheFileHeader {
+        uint32_t magic;
+        uint32_t formatVersion;
+        uint64_t key;
+        uint64_t size;
+        uint32_t checksum;
+        uint32_t reserved;
+    };
+
+    // FNV-1a. Not cryptographic, but good enough to key a cache and to detect truncated or damaged files.
+    constexpr uint64_t Fnv64OffsetBasis = 0xcbf29ce484222325ull;
+    constexpr uint64_t Fnv64Prime = 0x100000001b3ull;
+    constexpr uint32_t Fnv32OffsetBasis = 0x811c9dc5u;
+    constexpr uint32_t Fnv32Prime = 0x01000193u;
+
+    uint64_t fnv1a64(uint64_t hash, const void* data, size_t size) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * Fnv64Prime;
+        }
+        return hash;
+    }
+
+    uint32_t fnv1a32(const void* data, size_t size) {
+        uint32_t hash = Fnv32OffsetBasis;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * Fnv32Prime;
+        }
+        return hash;
+    }
+
+} // namespace
+
+namespace passthrough {
+
+    ShaderCache::ShaderCache(std::unique_ptr<IShaderCompiler> compiler,
+                             const std::filesystem::path& directory,
+                             const PrecompiledShader* precompiledShaders,
+                             size_t precompiledShadersCount)
+        : m_compiler(std::move(compiler)), m_directory(directory), m_precompiledShaders(precompiledShaders),
+          m_precompiledShadersCount(precompiledShadersCount) {
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+    }
+
+    std::vector<uint8_t>
+    ShaderCache::getOrCompile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) {
+        const uint64_t key = computeKey(source, entryPoint, target, flags);
+
+        for (size_t i = 0; i < m_precompiledShadersCount; i++) {
+            if (m_precompiledShaders[i].key == key) {
+                DebugLog("Using precompiled shader for %s/%s\n", entryPoint, target);
+                return {m_precompiledShaders[i].bytecode,
+                        m_precompiledShaders[i].bytecode + m_precompiledShaders[i].size};
+            }
+        }
+
+        if (auto bytecode = load(key)) {
+            DebugLog("Shader cache hit for %s/%s\n", entryPoint, target);
+            return std::move(*bytecode);
+        }
+
+        Log("Shader cache miss for %s/%s\n", entryPoint, target);
+        std::vector<uint8_t> bytecode = m_compiler->compile(source, entryPoint, target, flags);
+        store(key, bytecode);
+
+        return bytecode;
+    }
+
+    uint64_t
+    ShaderCache::computeKey(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) const {
+        // The string terminators are hashed too, so that the boundaries between the fields are unambiguous.
+        uint64_t hash = Fnv64OffsetBasis;
+        hash = fnv1a64(hash, source.data(), source.length());
+        hash = fnv1a64(hash, "", 1);
+        hash = fnv1a64(hash, entryPoint, strlen(entryPoint) + 1);
+        hash = fnv1a64(hash, target, strlen(target) + 1);
+        hash = fnv1a64(hash, &flags, sizeof(flags));
+        const uint32_t compilerVersion = m_compiler->getVersion();
+        hash = fnv1a64(hash, &compilerVersion, sizeof(compilerVersion));
+
+        return hash;
+    }
+
+    std::optional<std::vector<uint8_t>> ShaderCache::load(uint64_t key) const {
+        const std::filesystem::path path = getCacheFile(key);
+
+        std::ifstream file(path, std::ios_base::binary);
+        if (!file.is_open()) {
+            return {};
+        }
+
+        std::vector<uint8_t> bytecode;
+        bool isValid = false;
+        CacheFileHeader header{};
+        if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) && header.magic == CacheFileMagic &&
+            header.formatVersion == CacheFileFormatVersion && header.key == key && header.size > 0 &&
+            header.size <= MaxBytecodeSize) {
+            bytecode.resize((size_t)header.size);
+            if (file.read(reinterpret_cast<char*>(bytecode.data()), bytecode.size()) &&
+                file.peek() == std::ifstream::traits_type::eof()) {
+                isValid = fnv1a32(bytecode.data(), bytecode.size()) == header.checksum;
+            }
+        }
+        file.close();
+
+        if (!isValid) {
+            // Discard the entry, it will be rewritten after compilation.
+            Log("Shader cache entry %s is corrupted\n", path.filename().string().c_str());
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            return {};
+        }
+
+        return bytecode;
+    }
+
+    void ShaderCache::store(uint64_t key, const std::vector<uint8_t>& bytecode) const {
+        const std::filesystem::path path = getCacheFile(key);
+
+        // Another thread or process might be writing the same entry. Each writer uses its own temporary file, and the
+        // final rename replaces the entry at once, so readers never see a partial file.
+        std::filesystem::path temporaryPath = path;
+        temporaryPath += fmt::format(".{}-{}.tmp", GetCurrentProcessId(), GetCurrentThreadId());
+
+        CacheFileHeader header{};
+        header.magic = CacheFileMagic;
+        header.formatVersion = CacheFileFormatVersion;
+        header.key = key;
+        header.size = bytecode.size();
+        header.checksum = fnv1a32(bytecode.data(), bytecode.size());
+
+        bool written;
+        {
+            std::ofstream file(temporaryPath, std::ios_base::binary | std::ios_base::trunc);
+            written = file.is_open() && file.write(reinterpret_cast<const char*>(&header), sizeof(header)) &&
+                      file.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size()) && file.flush();
+        }
+
+        std::error_code ec;
+        if (written) {
+            std::filesystem::rename(temporaryPath, path, ec);
+        }
+        if (!written || ec) {
+            // Losing the race to another writer is fine, the entry will be identical.
+            DebugLog("Failed to write shader cache entry %s\n", path.filename().string().c_str());
+            std::filesystem::remove(temporaryPath, ec);
+        }
+    }
+
+    std::filesystem::path ShaderCache::getCacheFile(uint64_t key) const {
+        return m_directory / fmt::format("{:016x}.bin", key);
+    }
+
+} // namespace passthrough
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // Interface to the HLSL compiler, so that the cache does not depend on D3DCompile() directly.
+    struct IShaderCompiler {
+        virtual ~IShaderCompiler() = default;
+
+        // Changing the version invalidates the bytecode previously cached.
+        virtual uint32_t getVersion() const = 0;
+
+        virtual std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) = 0;
+    };
+
+    // Bytecode embedded in the DLL at build time, looked up before the on-disk cache.
+    struct PrecompiledShader {
+        uint64_t key;
+        const uint8_t* bytecode;
+        size_t size;
+    };
+
+    // A persistent cache of compiled shaders, keyed by a hash of everything that affects the bytecode. Lookups can be
+    // made concurrently from multiple threads and processes.
+    class ShaderCache {
+      public:
+        ShaderCache(std::unique_ptr<IShaderCompiler> compiler,
+                    const std::filesystem::path& directory,
+                    const PrecompiledShader* precompiledShaders = nullptr,
+                    size_t precompiledShadersCount = 0);
+
+        std::vector<uint8_t>
+        getOrCompile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags);
+
+        uint64_t computeKey(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) const;
+
+      private:
+        std::optional<std::vector<uint8_t>> load(uint64_t key) const;
+        void store(uint64_t key, const std::vector<uint8_t>& bytecode) const;
+        std::filesystem::path getCacheFile(uint64_t key) const;
+
+        const std::unique_ptr<IShaderCompiler> m_compiler;
+        const std::filesystem::path m_directory;
+        const PrecompiledShader* const m_precompiledShaders;
+        const size_t m_precompiledShadersCount;
+    };
+
+} // namespace passthrough
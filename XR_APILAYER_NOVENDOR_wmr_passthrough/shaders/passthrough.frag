@@ -0,0 +1,20 @@
+#version 450
+
+// This code is adapted from the HLSL shaders in d3d11_backend.cpp. It is compiled to SPIR-V at build time.
+
+// The alpha component of colorAdjustment is the opacity of the passthrough.
+layout(set = 0, binding = 0) uniform ConstantBuffer {
+    mat4 modelViewProjection[2];
+    vec4 colorAdjustment;
+};
+
+layout(set = 0, binding = 1) uniform sampler2D cameraTexture;
+
+layout(location = 0) in vec2 texCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    float color = texture(cameraTexture, texCoord).r;
+    outColor = vec4(color * colorAdjustment.rgb * colorAdjustment.a, 1.0);
+}
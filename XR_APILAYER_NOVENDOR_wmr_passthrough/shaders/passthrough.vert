@@ -0,0 +1,29 @@
+#version 450
+
+// This code is adapted from the HLSL shaders in d3d11_backend.cpp. It is compiled to SPIR-V at build time.
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec2 tex;
+
+layout(set = 0, binding = 0) uniform ConstantBuffer {
+    mat4 modelViewProjection[2];
+    vec4 colorAdjustment;
+};
+
+layout(push_constant) uniform EyeConstants {
+    uint eye;
+};
+
+layout(location = 0) out vec2 texCoord;
+
+void main() {
+    gl_Position = vec4(pos, 1.0) * modelViewProjection[eye];
+
+    // Place it behind everything else
+    gl_Position.z = 0.9999 * gl_Position.w;
+
+    // The Vulkan clip space is upside down compared to Direct3D.
+    gl_Position.y = -gl_Position.y;
+
+    texCoord = tex;
+}
@@ -0,0 +1,158 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "swapchain_planner.h"
+
+namespace {
+
+    using namespace passthrough;
+
+    // The OpenGL internal formats, from glext.h.
+    constexpr int64_t GL_RGBA8 = 0x8058;
+    constexpr int64_t GL_RGB10_A2 = 0x8059;
+    constexpr int64_t GL_RGBA16 = 0x805B;
+    constexpr int64_t GL_RGBA32F = 0x8814;
+    constexpr int64_t GL_RGBA16F = 0x881A;
+    constexpr int64_t GL_R11F_G11F_B10F = 0x8C3A;
+    constexpr int64_t GL_SRGB8_ALPHA8 = 0x8C43;
+
+    // The color formats good enough for the 8-bit camera image. Depth formats and formats with fewer bits per channel
+    // are never acceptable.
+    constexpr SwapchainFormatInfo SwapchainFormats[] = {
+        {DXGI_FORMAT_R8G8B8A8_UNORM, 4, false, true, false},
+        {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 4, true, true, false},
+        {DXGI_FORMAT_B8G8R8A8_UNORM, 4, false, true, true},
+        {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 4, true, true, true},
+        {DXGI_FORMAT_B8G8R8X8_UNORM, 4, false, true, true},
+        {DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, 4, true, true, true},
+        {DXGI_FORMAT_R10G10B10A2_UNORM, 4, false, false, false},
+        {DXGI_FORMAT_R11G11B10_FLOAT, 4, false, false, false},
+        {DXGI_FORMAT_R16G16B16A16_UNORM, 8, false, false, false},
+        {DXGI_FORMAT_R16G16B16A16_FLOAT, 8, false, false, false},
+        {DXGI_FORMAT_R32G32B32A32_FLOAT, 16, false, false, false},
+        {GL_RGBA8, 4, false, true, false},
+        {GL_SRGB8_ALPHA8, 4, true, true, false},
+        {GL_RGB10_A2, 4, false, false, false},
+        {GL_R11F_G11F_B10F, 4, false, false, false},
+        {GL_RGBA16, 8, false, false, false},
+        {GL_RGBA16F, 8, false, false, false},
+        {GL_RGBA32F, 16, false, false, false},
+    };
+
+    constexpr SwapchainFormatInfo VulkanSwapchainFormats[] = {
+        {VK_FORMAT_R8G8B8A8_UNORM, 4, false, true, false},
+        {VK_FORMAT_R8G8B8A8_SRGB, 4, true, true, false},
+        {VK_FORMAT_B8G8R8A8_UNORM, 4, false, true, true},
+        {VK_FORMAT_B8G8R8A8_SRGB, 4, true, true, true},
+        {VK_FORMAT_A2B10G10R10_UNORM_PACK32, 4, false, false, false},
+        {VK_FORMAT_B10G11R11_UFLOAT_PACK32, 4, false, false, false},
+        {VK_FORMAT_R16G16B16A16_UNORM, 8, false, false, false},
+        {VK_FORMAT_R16G16B16A16_SFLOAT, 8, false, false, false},
+        {VK_FORMAT_R32G32B32A32_SFLOAT, 16, false, false, false},
+    };
+
+    float getOversampling(PassthroughQuality quality) {
+        switch (quality) {
+        case PassthroughQuality::Performance:
+            return 1.f;
+        case PassthroughQuality::Balanced:
+            return 1.4f;
+        case PassthroughQuality::Quality:
+        default:
+            return 2.f;
+        }
+    }
+
+    // The number of swapchain pixels needed along one axis, given the extent of the field of view and of the mesh (as
+    // tangents of the angles, since the mesh sits 1 meter away) and the number of camera pixels across the mesh.
+    uint32_t getPlannedSize(
+        float fovExtent, float meshExtent, uint32_t cameraPixels, float oversampling, uint32_t recommendedPixels) {
+        if (fovExtent <= 0.f || meshExtent <= 0.f) {
+            return recommendedPixels;
+        }
+
+        const float pixelsPerUnit = cameraPixels / meshExtent;
+        const uint32_t size = (uint32_t)std::ceil(pixelsPerUnit * fovExtent * oversampling);
+        return std::clamp(size, std::min(cameraPixels, recommendedPixels), recommendedPixels);
+    }
+
+} // namespace
+
+namespace passthrough {
+
+    const SwapchainFormatInfo* getSwapchainFormatInfo(int64_t format, SwapchainFormatApi api) {
+        const bool isVulkan = api == SwapchainFormatApi::Vulkan;
+        const SwapchainFormatInfo* const begin =
+            isVulkan ? std::begin(VulkanSwapchainFormats) : std::begin(SwapchainFormats);
+        const SwapchainFormatInfo* const end = isVulkan ? std::end(VulkanSwapchainFormats) : std::end(SwapchainFormats);
+        for (const SwapchainFormatInfo* entry = begin; entry != end; entry++) {
+            if (entry->format == format) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    SwapchainPlan planPassthroughSwapchain(const SwapchainPlannerInput& input) {
+        SwapchainPlan plan{};
+
+        // Pick the cheapest acceptable format. The pixel shader does not apply any gamma correction, so only the
+        // formats with the same encoding as the runtime's preferred format will look the same.
+        if (input.formatCount > 0) {
+            plan.format = input.formats[0];
+
+            const SwapchainFormatInfo* const preferred = getSwapchainFormatInfo(input.formats[0], input.formatApi);
+            const SwapchainFormatInfo* best = nullptr;
+            for (size_t i = 0; i < input.formatCount; i++) {
+                const SwapchainFormatInfo* const candidate = getSwapchainFormatInfo(input.formats[i], input.formatApi);
+                if (!candidate || (preferred && candidate->isSRGB != preferred->isSRGB) ||
+                    (input.isCpuWritten && !candidate->isRGBA8)) {
+                    continue;
+                }
+
+                // Ties are broken by the runtime's order of preference.
+                if (!best || candidate->bytesPerPixel < best->bytesPerPixel) {
+                    best = candidate;
+                }
+            }
+            if (best) {
+                plan.format = best->format;
+            }
+        }
+
+        // The camera image covers a (meshScale * aspect) x meshScale area, so its density on the display does not
+        // depend on how much of the field of view it covers.
+        const float oversampling = getOversampling(input.quality);
+        const float aspect = input.cameraHeight ? (float)input.cameraWidth / input.cameraHeight : 1.f;
+        const float fovWidth = std::tan(input.fov.angleRight) - std::tan(input.fov.angleLeft);
+        const float fovHeight = std::tan(input.fov.angleUp) - std::tan(input.fov.angleDown);
+        plan.width = getPlannedSize(
+            fovWidth, input.meshScale * aspect, input.cameraWidth, oversampling, input.recommendedWidth);
+        plan.height =
+            getPlannedSize(fovHeight, input.meshScale, input.cameraHeight, oversampling, input.recommendedHeight);
+
+        return plan;
+    }
+
+} // namespace passthrough
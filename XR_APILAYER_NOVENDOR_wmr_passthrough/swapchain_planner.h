@@ -0,0 +1,92 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // The trade-off between the sharpness of the passthrough layer and its cost for the compositor.
+    enum class PassthroughQuality {
+        // One swapchain pixel per camera pixel.
+        Performance,
+        // Enough oversampling to hide most of the aliasing from the mesh distortion.
+        Balanced,
+        // Two swapchain pixels per camera pixel in each direction.
+        Quality,
+    };
+
+    // The graphics API the swapchain format values belong to. The DXGI and OpenGL values do not overlap, but the Vulkan
+    // values overlap with the DXGI values.
+    enum class SwapchainFormatApi {
+        DXGIOrOpenGL,
+        Vulkan,
+    };
+
+    struct SwapchainPlannerInput {
+        // The camera image, and the scale of the mesh it is projected onto, 1 meter in front of the eye.
+        uint32_t cameraWidth;
+        uint32_t cameraHeight;
+        float meshScale;
+
+        // The field of view of the eye, and the resolution the runtime recommends for it.
+        XrFovf fov;
+        uint32_t recommendedWidth;
+        uint32_t recommendedHeight;
+
+        // The formats returned by xrEnumerateSwapchainFormats(), in the runtime's order of preference.
+        const int64_t* formats;
+        size_t formatCount;
+        SwapchainFormatApi formatApi;
+
+        PassthroughQuality quality;
+
+        // Only formats with 8-bit RGBA or BGRA channels can be written directly from the CPU.
+        bool isCpuWritten;
+    };
+
+    struct SwapchainPlan {
+        int64_t format;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct SwapchainFormatInfo {
+        int64_t format;
+        uint32_t bytesPerPixel;
+        bool isSRGB;
+
+        // 8-bit RGBA or BGRA formats can be written directly from the CPU.
+        bool isRGBA8;
+        bool isBGRA;
+    };
+
+    // Returns nullptr for the formats that are not suitable for the passthrough layer.
+    const SwapchainFormatInfo* getSwapchainFormatInfo(int64_t format,
+                                                      SwapchainFormatApi api = SwapchainFormatApi::DXGIOrOpenGL);
+
+    // Choose the resolution and format of the passthrough swapchain. The resolution is derived from the density of
+    // the camera pixels on the display, and never exceeds the recommended resolution.
+    SwapchainPlan planPassthroughSwapchain(const SwapchainPlannerInput& input);
+
+} // namespace passthrough
@@ -0,0 +1,165 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "swapchain_tracker.h"
+
+#include "log.h"
+
+namespace passthrough {
+
+    using namespace passthrough::log;
+
+    void SwapchainTracker::add(XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo) {
+        std::unique_lock lock(m_mutex);
+
+        TrackedSwapchain& entry = m_swapchains[swapchain];
+        entry = {};
+        entry.state.createInfo = createInfo;
+        entry.state.createInfo.next = nullptr;
+    }
+
+    void SwapchainTracker::remove(XrSwapchain swapchain) {
+        std::unique_lock lock(m_mutex);
+
+        m_swapchains.erase(swapchain);
+    }
+
+    XrResult SwapchainTracker::acquireImage(OpenXrApi& openXR,
+                                            XrSwapchain swapchain,
+                                            const XrSwapchainImageAcquireInfo* acquireInfo,
+                                            uint32_t* index) {
+        // The runtime expects xrWaitSwapchainImage() on the oldest image not released. Any release held back must be
+        // flushed, otherwise the application would wait on the wrong image.
+        uint32_t deferredReleaseCount = 0;
+        {
+            std::unique_lock lock(m_mutex);
+
+            const auto it = m_swapchains.find(swapchain);
+            if (it != m_swapchains.end()) {
+                deferredReleaseCount = it->second.state.deferredReleaseCount;
+                it->second.state.deferredReleaseCount = 0;
+            }
+        }
+        const XrResult releaseResult = releaseDeferredImages(openXR, swapchain, deferredReleaseCount);
+        if (XR_FAILED(releaseResult)) {
+            return releaseResult;
+        }
+
+        const XrResult result = openXR.OpenXrApi::xrAcquireSwapchainImage(swapchain, acquireInfo, index);
+        if (XR_SUCCEEDED(result)) {
+            std::unique_lock lock(m_mutex);
+
+            const auto it = m_swapchains.find(swapchain);
+            if (it != m_swapchains.end()) {
+                it->second.acquiredImages.push_back(*index);
+                it->second.state.acquiredImageCount++;
+            }
+        }
+
+        return result;
+    }
+
+    XrResult SwapchainTracker::releaseImage(OpenXrApi& openXR,
+                                            XrSwapchain swapchain,
+                                            const XrSwapchainImageReleaseInfo* releaseInfo) {
+        {
+            std::unique_lock lock(m_mutex);
+
+            const auto it = m_swapchains.find(swapchain);
+            if (it != m_swapchains.end()) {
+                TrackedSwapchain& entry = it->second;
+                if (!entry.acquiredImages.empty()) {
+                    entry.state.lastReleasedImage = entry.acquiredImages.front();
+                    entry.acquiredImages.erase(entry.acquiredImages.begin());
+                    entry.state.acquiredImageCount--;
+                }
+
+                // The layer draws into the image in xrEndFrame(), where it is released.
+                if (entry.state.isCompositionTarget) {
+                    entry.state.deferredReleaseCount++;
+                    return XR_SUCCESS;
+                }
+            }
+        }
+
+        return openXR.OpenXrApi::xrReleaseSwapchainImage(swapchain, releaseInfo);
+    }
+
+    XrResult SwapchainTracker::flushDeferredReleases(OpenXrApi& openXR) {
+        {
+            std::unique_lock lock(m_mutex);
+
+            m_deferredReleases.clear();
+            for (auto& [swapchain, entry] : m_swapchains) {
+                if (entry.state.deferredReleaseCount) {
+                    m_deferredReleases.push_back({swapchain, entry.state.deferredReleaseCount});
+                    entry.state.deferredReleaseCount = 0;
+                }
+            }
+        }
+
+        for (const auto& [swapchain, count] : m_deferredReleases) {
+            const XrResult result = releaseDeferredImages(openXR, swapchain, count);
+            if (XR_FAILED(result)) {
+                return result;
+            }
+        }
+
+        return XR_SUCCESS;
+    }
+
+    std::optional<ApplicationSwapchain> SwapchainTracker::get(XrSwapchain swapchain) const {
+        std::unique_lock lock(m_mutex);
+
+        const auto it = m_swapchains.find(swapchain);
+        if (it == m_swapchains.end()) {
+            return {};
+        }
+        return it->second.state;
+    }
+
+    void SwapchainTracker::setCompositionTarget(XrSwapchain swapchain) {
+        std::unique_lock lock(m_mutex);
+
+        const auto it = m_swapchains.find(swapchain);
+        if (it != m_swapchains.end()) {
+            it->second.state.isCompositionTarget = true;
+        }
+    }
+
+    XrResult SwapchainTracker::releaseDeferredImages(OpenXrApi& openXR, XrSwapchain swapchain, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            // Skip the layer's own xrReleaseSwapchainImage(), which would hold the release back again.
+            XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO, nullptr};
+            const XrResult result = openXR.OpenXrApi::xrReleaseSwapchainImage(swapchain, &releaseInfo);
+            if (XR_FAILED(result)) {
+                Log("Failed to release a deferred image of swapchain %p: %d\n", swapchain, result);
+                return result;
+            }
+        }
+
+        return XR_SUCCESS;
+    }
+
+} // namespace passthrough
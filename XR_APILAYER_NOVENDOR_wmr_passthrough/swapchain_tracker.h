@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+#include "layer.h"
+
+namespace passthrough {
+
+    // The state of a swapchain created by the application. Looked up for every view in xrEndFrame(), so it is kept
+    // cheap to copy.
+    struct ApplicationSwapchain {
+        XrSwapchainCreateInfo createInfo;
+
+        // The number of images acquired and not released yet.
+        uint32_t acquiredImageCount{0};
+
+        // The image that will be submitted with the next frame.
+        std::optional<uint32_t> lastReleasedImage;
+
+        // Releases held back from the runtime, so the layer can still draw into the image.
+        uint32_t deferredReleaseCount{0};
+
+        // Whether the layer draws into this swapchain's images. Only then are the releases deferred.
+        bool isCompositionTarget{false};
+    };
+    static_assert(std::is_trivially_copyable_v<ApplicationSwapchain>);
+
+    // Follow the images of the application's swapchains through acquire and release. Thread-safe, since the
+    // application may use its swapchains from a different thread than the one calling xrEndFrame().
+    class SwapchainTracker {
+      public:
+        void add(XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo);
+        void remove(XrSwapchain swapchain);
+
+        // The layer's xrAcquireSwapchainImage() and xrReleaseSwapchainImage(), calling the next layer through
+        // openXR. The releases of the composition targets are held back from the runtime.
+        XrResult acquireImage(OpenXrApi& openXR,
+                              XrSwapchain swapchain,
+                              const XrSwapchainImageAcquireInfo* acquireInfo,
+                              uint32_t* index);
+        XrResult releaseImage(OpenXrApi& openXR, XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo);
+
+        // Pass all the releases held back to the runtime, which requires them before the frame is submitted. Only
+        // called from the thread calling xrEndFrame().
+        XrResult flushDeferredReleases(OpenXrApi& openXR);
+
+        // Returns nullopt for swapchains that are not tracked.
+        std::optional<ApplicationSwapchain> get(XrSwapchain swapchain) const;
+
+        void setCompositionTarget(XrSwapchain swapchain);
+
+      private:
+        // Stops at the first error, the remaining releases are dropped.
+        static XrResult releaseDeferredImages(OpenXrApi& openXR, XrSwapchain swapchain, uint32_t count);
+
+        struct TrackedSwapchain {
+            ApplicationSwapchain state;
+
+            // The images acquired and not released yet, oldest first.
+            std::vector<uint32_t> acquiredImages;
+        };
+
+        mutable std::mutex m_mutex;
+        std::map<XrSwapchain, TrackedSwapchain> m_swapchains;
+
+        std::vector<std::pair<XrSwapchain, uint32_t>> m_deferredReleases;
+    };
+
+} // namespace passthrough
@@ -0,0 +1,168 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "undistortion.h"
+
+namespace {
+
+    // The distortion applied by the passthrough mesh, as a function of the distance to the center of the image.
+    float distortRadius(float k1, float k2, float r) {
+        const float r_sqr = r * r;
+        return r / (1.f + k1 * r_sqr + k2 * r_sqr * r_sqr);
+    }
+
+    // The distortion function does not have a closed-form inverse. It is monotonic over the image, so use bisection.
+    float undistortRadius(float k1, float k2, float r, float maxRadius) {
+        float low = 0.f;
+        float high = maxRadius;
+        if (r >= distortRadius(k1, k2, high)) {
+            return std::numeric_limits<float>::infinity();
+        }
+
+        for (uint32_t i = 0; i < 24; i++) {
+            const float middle = (low + high) / 2.f;
+            if (distortRadius(k1, k2, middle) < r) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return (low + high) / 2.f;
+    }
+
+} // namespace
+
+namespace passthrough {
+
+    XrExtent2Df getUndistortedExtent(float k1, float k2, float aspect) {
+        // The scaling is radial, so the extent is reached on the border of the image. Walk one quarter of it.
+        const uint32_t steps = 64;
+        XrExtent2Df extent{0.f, 0.f};
+        for (uint32_t i = 0; i <= steps; i++) {
+            const float x = (aspect / 2.f) * i / steps;
+            const float y = 0.5f * i / steps;
+
+            const float rightEdge = std::sqrt(aspect * aspect / 4.f + y * y);
+            extent.width = std::max(extent.width, aspect / 2.f * distortRadius(k1, k2, rightEdge) / rightEdge);
+
+            const float topEdge = std::sqrt(x * x + 0.25f);
+            extent.height = std::max(extent.height, 0.5f * distortRadius(k1, k2, topEdge) / topEdge);
+        }
+        extent.width *= 2.f;
+        extent.height *= 2.f;
+
+        return extent;
+    }
+
+    void placePassthroughQuadLayer(XrCompositionLayerQuad& layer,
+                                   uint32_t eye,
+                                   const XrPosef& eyePose,
+                                   const HeadsetCameraCalibration& calibration,
+                                   const XrExtent2Df& extent) {
+        // Same placement as the mesh in updateModelViewProjection() in layer.cpp, but relative to the eye.
+        const float sign = eye ? 1.f : -1.f;
+        const float offsetY = calibration.OffsetY + sign * calibration.RightOffsetY;
+
+        XrPosef pose;
+        const DirectX::XMVECTOR orientation = DirectX::XMQuaternionRotationRollPitchYaw(
+            calibration.EyeCantX, sign * calibration.EyeCantY, sign * calibration.EyeCantZ);
+        xr::math::StoreXrQuaternion(&pose.orientation, orientation);
+        pose.position = {sign * calibration.OffsetX * calibration.Scale, offsetY * calibration.Scale, -1.f};
+
+        layer.eyeVisibility = eye ? XR_EYE_VISIBILITY_RIGHT : XR_EYE_VISIBILITY_LEFT;
+        layer.pose = xr::math::Pose::Multiply(pose, eyePose);
+        layer.size = {extent.width * calibration.Scale, extent.height * calibration.Scale};
+    }
+
+    UndistortionMap::UndistortionMap(float k1,
+                                     float k2,
+                                     const XrExtent2Df& extent,
+                                     uint32_t width,
+                                     uint32_t height,
+                                     float sourceWidth,
+                                     uint32_t sourceHeight)
+        : m_width(width), m_height(height) {
+        const float aspect = sourceWidth / sourceHeight;
+        const float maxRadius = std::sqrt(aspect * aspect / 4.f + 0.25f);
+
+        m_samples.resize((size_t)width * height);
+        Sample* sample = m_samples.data();
+        for (uint32_t y = 0; y < height; y++) {
+            const float t = (0.5f - (y + 0.5f) / height) * extent.height;
+            for (uint32_t x = 0; x < width; x++, sample++) {
+                const float s = ((x + 0.5f) / width - 0.5f) * extent.width;
+
+                // Find the point of the mesh that is displayed at (s, t).
+                const float r = std::sqrt(s * s + t * t);
+                const float scale = r > 0.f ? undistortRadius(k1, k2, r, maxRadius) / r : 1.f;
+                const float u = s * scale / aspect + 0.5f;
+                const float v = 0.5f - t * scale;
+                if (!(u >= 0.f && u <= 1.f && v >= 0.f && v <= 1.f)) {
+                    sample->x = sample->y = InvalidSample;
+                    continue;
+                }
+
+                // Convert to texel coordinates, and keep the bilinear footprint within the image.
+                const float sx = std::clamp(u * sourceWidth - 0.5f, 0.f, sourceWidth - 2.f);
+                const float sy = std::clamp(v * sourceHeight - 0.5f, 0.f, sourceHeight - 2.f);
+                const auto quantize = [](float coordinate, uint16_t& texel, uint8_t& weight) {
+                    texel = (uint16_t)coordinate;
+                    const uint32_t fraction = (uint32_t)std::lround((coordinate - texel) * 256.f);
+                    if (fraction < 256) {
+                        weight = (uint8_t)fraction;
+                    } else {
+                        texel++;
+                        weight = 0;
+                    }
+                };
+                quantize(sx, sample->x, sample->fx);
+                quantize(sy, sample->y, sample->fy);
+            }
+        }
+    }
+
+    void UndistortionMap::undistort(const uint8_t* source,
+                                    size_t sourcePitch,
+                                    const uint32_t* palette,
+                                    uint32_t* destination,
+                                    size_t destinationPitch) const {
+        const Sample* sample = m_samples.data();
+        for (uint32_t y = 0; y < m_height; y++) {
+            uint32_t* row = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(destination) + y * destinationPitch);
+            for (uint32_t x = 0; x < m_width; x++, sample++) {
+                if (sample->x == InvalidSample) {
+                    // Opaque black in both RGBA and BGRA.
+                    row[x] = 0xff000000;
+                    continue;
+                }
+
+                const uint8_t* texel = source + sample->y * sourcePitch + sample->x;
+                const uint32_t top = texel[0] * (256 - sample->fx) + texel[1] * sample->fx;
+                const uint32_t bottom = texel[sourcePitch] * (256 - sample->fx) + texel[sourcePitch + 1] * sample->fx;
+                row[x] = palette[(top * (256 - sample->fy) + bottom * sample->fy) >> 16];
+            }
+        }
+    }
+
+} // namespace passthrough
@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    // These values are taken as-is from XRmonitors\XRmonitorsHologram\CameraCalibration.hpp
+    struct HeadsetCameraCalibration {
+        float K1 = -0.65f;
+        float K2 = 0.f;
+        float Scale = 1.9f;
+        float OffsetX = 0.241f;
+        float OffsetY = -0.178f;
+        float RightOffsetY = 0.f;
+        float EyeCantX = -0.391003f;
+        float EyeCantY = -0.504997f;
+        float EyeCantZ = 0.012f;
+    };
+
+    // The size of the camera image once the radial distortion of the passthrough mesh is applied, in units of the
+    // image height.
+    XrExtent2Df getUndistortedExtent(float k1, float k2, float aspect);
+
+    // Fill the pose, size and eye visibility of the quad layer showing the undistorted image of one eye. The quad is
+    // placed like the passthrough mesh, relative to the pose of the eye. The extent is from getUndistortedExtent().
+    void placePassthroughQuadLayer(XrCompositionLayerQuad& layer,
+                                   uint32_t eye,
+                                   const XrPosef& eyePose,
+                                   const HeadsetCameraCalibration& calibration,
+                                   const XrExtent2Df& extent);
+
+    // Resamples a camera image on the CPU, so that it can be displayed on a flat quad and look the same as on the
+    // passthrough mesh. The source coordinates of each destination pixel are computed once.
+    class UndistortionMap {
+      public:
+        UndistortionMap() = default;
+
+        // The destination image is width x height pixels and covers extent (see getUndistortedExtent()). The source
+        // image is sourceWidth x sourceHeight pixels, sourceWidth can be fractional to crop the image.
+        UndistortionMap(float k1,
+                        float k2,
+                        const XrExtent2Df& extent,
+                        uint32_t width,
+                        uint32_t height,
+                        float sourceWidth,
+                        uint32_t sourceHeight);
+
+        // Convert an 8-bit grayscale image into 32-bit colors using the palette. Pixels outside of the camera image
+        // are black.
+        void undistort(const uint8_t* source,
+                       size_t sourcePitch,
+                       const uint32_t* palette,
+                       uint32_t* destination,
+                       size_t destinationPitch) const;
+
+        uint32_t getWidth() const {
+            return m_width;
+        }
+
+        uint32_t getHeight() const {
+            return m_height;
+        }
+
+      private:
+        // A bilinear sample, with 8-bit weights.
+        struct Sample {
+            uint16_t x;
+            uint16_t y;
+            uint8_t fx;
+            uint8_t fy;
+        };
+
+        static constexpr uint16_t InvalidSample = 0xffff;
+
+        uint32_t m_width{0};
+        uint32_t m_height{0};
+        std::vector<Sample> m_samples;
+    };
+
+} // namespace passthrough
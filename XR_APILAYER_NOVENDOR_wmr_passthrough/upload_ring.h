@@ -0,0 +1,143 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "pch.h"
+
+namespace passthrough {
+
+    struct UploadRingStatistics {
+        uint64_t acquireCount{0};
+        uint64_t submitCount{0};
+
+        // Acquisitions that had to wait for the GPU to finish reading a slot.
+        uint64_t stallCount{0};
+        std::chrono::steady_clock::duration stallTime{};
+
+        // The number of slots in flight when acquiring a slot.
+        uint64_t inFlightSum{0};
+        uint32_t inFlightMax{0};
+    };
+
+    // A ring of staging slots for uploading data to the GPU without waiting on the previous copy. Each slot is tagged
+    // with a fence, which must provide:
+    //   bool isCompleted();   // Never blocks.
+    //   void wait();          // Blocks until the GPU is done with the slot.
+    // The ring only tracks the slots, the memory and the fences themselves are owned by the graphics backend.
+    template <typename Fence>
+    class UploadRing {
+      public:
+        // Replace the slots, for example when the size of the data changes. The statistics are preserved.
+        void reset(std::vector<Fence> fences) {
+            flush();
+            m_fences = std::move(fences);
+            m_slots.assign(m_fences.size(), SlotState::Free);
+            m_next = 0;
+        }
+
+        // Returns the slot to write to. Only blocks if all the slots are still in use by the GPU.
+        uint32_t acquire() {
+            assert(!m_slots.empty() && m_slots[m_next] != SlotState::Writing);
+
+            m_statistics.acquireCount++;
+            const uint32_t inFlight = getInFlightCount();
+            m_statistics.inFlightSum += inFlight;
+            m_statistics.inFlightMax = std::max(m_statistics.inFlightMax, inFlight);
+
+            if (m_slots[m_next] == SlotState::InFlight) {
+                Fence& fence = m_fences[m_next];
+                if (!fence.isCompleted()) {
+                    const auto start = std::chrono::steady_clock::now();
+                    fence.wait();
+                    m_statistics.stallCount++;
+                    m_statistics.stallTime += std::chrono::steady_clock::now() - start;
+                }
+            }
+
+            m_slots[m_next] = SlotState::Writing;
+            return m_next;
+        }
+
+        // The copy from the slot was queued, and the slot's fence will be signaled once the copy is done.
+        void submit(uint32_t slot) {
+            assert(slot == m_next && m_slots[slot] == SlotState::Writing);
+
+            m_slots[slot] = SlotState::InFlight;
+            m_next = (m_next + 1) % (uint32_t)m_slots.size();
+            m_statistics.submitCount++;
+        }
+
+        // The content of the slot is discarded, and the slot is returned by the next acquire().
+        void cancel(uint32_t slot) {
+            assert(slot == m_next && m_slots[slot] == SlotState::Writing);
+
+            m_slots[slot] = SlotState::Free;
+        }
+
+        // Wait for all the copies in flight.
+        void flush() {
+            for (uint32_t i = 0; i < m_slots.size(); i++) {
+                if (m_slots[i] == SlotState::InFlight) {
+                    m_fences[i].wait();
+                    m_slots[i] = SlotState::Free;
+                }
+            }
+        }
+
+        Fence& getFence(uint32_t slot) {
+            return m_fences[slot];
+        }
+
+        uint32_t getSize() const {
+            return (uint32_t)m_slots.size();
+        }
+
+        uint32_t getInFlightCount() {
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < m_slots.size(); i++) {
+                if (m_slots[i] == SlotState::InFlight) {
+                    if (m_fences[i].isCompleted()) {
+                        m_slots[i] = SlotState::Free;
+                    } else {
+                        count++;
+                    }
+                }
+            }
+            return count;
+        }
+
+        const UploadRingStatistics& getStatistics() const {
+            return m_statistics;
+        }
+
+      private:
+        enum class SlotState { Free, Writing, InFlight };
+
+        std::vector<Fence> m_fences;
+        std::vector<SlotState> m_slots;
+        uint32_t m_next{0};
+
+        UploadRingStatistics m_statistics;
+    };
+
+} // namespace passthrough
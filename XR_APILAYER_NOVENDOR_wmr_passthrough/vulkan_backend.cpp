@@ -0,0 +1,1093 @@
+// MIT License
+//
+// Copyright(c) 2022 Matthieu Bucchianeri
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this softwareand associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright noticeand this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pch.h"
+
+#include "allocation_tracker.h"
+#include "graphics_backend.h"
+#include "log.h"
+
+// The SPIR-V bytecode of the shaders/ directory, compiled by glslangValidator at build time.
+#include "passthrough.frag.h"
+#include "passthrough.vert.h"
+
+// The Vulkan functions resolved from the application's instance and device. The layer does not link against the Vulkan
+// loader.
+#define PASSTHROUGH_VK_INSTANCE_FUNCTIONS(X)                                                                           \
+    X(vkGetDeviceProcAddr)                                                                                             \
+    X(vkGetPhysicalDeviceProperties)                                                                                   \
+    X(vkGetPhysicalDeviceMemoryProperties)
+
+#define PASSTHROUGH_VK_DEVICE_FUNCTIONS(X)                                                                             \
+    X(vkGetDeviceQueue)                                                                                                \
+    X(vkQueueSubmit)                                                                                                   \
+    X(vkCreateCommandPool)                                                                                             \
+    X(vkDestroyCommandPool)                                                                                            \
+    X(vkAllocateCommandBuffers)                                                                                        \
+    X(vkFreeCommandBuffers)                                                                                            \
+    X(vkResetCommandBuffer)                                                                                            \
+    X(vkBeginCommandBuffer)                                                                                            \
+    X(vkEndCommandBuffer)                                                                                              \
+    X(vkCreateFence)                                                                                                   \
+    X(vkDestroyFence)                                                                                                  \
+    X(vkResetFences)                                                                                                   \
+    X(vkGetFenceStatus)                                                                                                \
+    X(vkWaitForFences)                                                                                                 \
+    X(vkAllocateMemory)                                                                                                \
+    X(vkFreeMemory)                                                                                                    \
+    X(vkMapMemory)                                                                                                     \
+    X(vkCreateBuffer)                                                                                                  \
+    X(vkDestroyBuffer)                                                                                                 \
+    X(vkGetBufferMemoryRequirements)                                                                                   \
+    X(vkBindBufferMemory)                                                                                              \
+    X(vkCreateImage)                                                                                                   \
+    X(vkDestroyImage)                                                                                                  \
+    X(vkGetImageMemoryRequirements)                                                                                    \
+    X(vkBindImageMemory)                                                                                               \
+    X(vkCreateImageView)                                                                                               \
+    X(vkDestroyImageView)                                                                                              \
+    X(vkCreateSampler)                                                                                                 \
+    X(vkDestroySampler)                                                                                                \
+    X(vkCreateShaderModule)                                                                                            \
+    X(vkDestroyShaderModule)                                                                                           \
+    X(vkCreateDescriptorSetLayout)                                                                                     \
+    X(vkDestroyDescriptorSetLayout)                                                                                    \
+    X(vkCreateDescriptorPool)                                                                                          \
+    X(vkDestroyDescriptorPool)                                                                                         \
+    X(vkAllocateDescriptorSets)                                                                                        \
+    X(vkUpdateDescriptorSets)                                                                                          \
+    X(vkCreatePipelineLayout)                                                                                          \
+    X(vkDestroyPipelineLayout)                                                                                         \
+    X(vkCreateGraphicsPipelines)                                                                                       \
+    X(vkDestroyPipeline)                                                                                               \
+    X(vkCreateRenderPass)                                                                                              \
+    X(vkDestroyRenderPass)                                                                                             \
+    X(vkCreateFramebuffer)                                                                                             \
+    X(vkDestroyFramebuffer)                                                                                            \
+    X(vkCmdPipelineBarrier)                                                                                            \
+    X(vkCmdCopyBufferToImage)                                                                                          \
+    X(vkCmdBeginRenderPass)                                                                                            \
+    X(vkCmdEndRenderPass)                                                                                              \
+    X(vkCmdBindPipeline)                                                                                               \
+    X(vkCmdBindDescriptorSets)                                                                                         \
+    X(vkCmdBindVertexBuffers)                                                                                          \
+    X(vkCmdBindIndexBuffer)                                                                                            \
+    X(vkCmdPushConstants)                                                                                              \
+    X(vkCmdSetViewport)                                                                                                \
+    X(vkCmdSetScissor)                                                                                                 \
+    X(vkCmdDrawIndexed)
+
+#define CHECK_VKCMD(cmd) CHECK_MSG((cmd) >= VK_SUCCESS, "Vulkan call failed")
+
+namespace {
+
+    using namespace passthrough;
+    using namespace passthrough::log;
+
+    using namespace DirectX;
+
+    // The layout of the uniform buffer of the shaders, which matches std140.
+    struct ConstantBuffer {
+        XMFLOAT4X4 modelViewProjection[ViewCount];
+        XMFLOAT4 colorAdjustment;
+    };
+
+    // Enough to never wait on the GPU before reusing a slot.
+    constexpr uint32_t CameraUploadSlots = 3;
+
+    // The bytecode is compiled ahead of time, there is nothing left to compile.
+    class SPIRVCompiler : public IShaderCompiler {
+      public:
+        uint32_t getVersion() const override {
+            return 1;
+        }
+
+        std::vector<uint8_t>
+        compile(std::string_view source, const char* entryPoint, const char* target, uint32_t flags) override {
+            return {source.begin(), source.end()};
+        }
+    };
+
+    struct VulkanFunctions {
+#define DECLARE_VK_FUNCTION(name) PFN_##name name = nullptr;
+        DECLARE_VK_FUNCTION(vkGetInstanceProcAddr)
+        PASSTHROUGH_VK_INSTANCE_FUNCTIONS(DECLARE_VK_FUNCTION)
+        PASSTHROUGH_VK_DEVICE_FUNCTIONS(DECLARE_VK_FUNCTION)
+#undef DECLARE_VK_FUNCTION
+
+        // Returns false if any of the functions is not available.
+        bool load(HMODULE loader, VkInstance instance, VkDevice device) {
+            vkGetInstanceProcAddr =
+                reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(loader, "vkGetInstanceProcAddr"));
+            if (!vkGetInstanceProcAddr) {
+                Log("Vulkan function vkGetInstanceProcAddr is not available\n");
+                return false;
+            }
+
+            bool isComplete = true;
+#define LOAD_VK_FUNCTION(name, getProcAddr, handle)                                                                    \
+    name = reinterpret_cast<PFN_##name>(getProcAddr(handle, #name));                                                   \
+    if (!name) {                                                                                                       \
+        Log("Vulkan function %s is not available\n", #name);                                                           \
+        isComplete = false;                                                                                            \
+    }
+#define LOAD_VK_INSTANCE_FUNCTION(name) LOAD_VK_FUNCTION(name, vkGetInstanceProcAddr, instance)
+#define LOAD_VK_DEVICE_FUNCTION(name) LOAD_VK_FUNCTION(name, vkGetDeviceProcAddr, device)
+            PASSTHROUGH_VK_INSTANCE_FUNCTIONS(LOAD_VK_INSTANCE_FUNCTION)
+            if (!vkGetDeviceProcAddr) {
+                return false;
+            }
+            PASSTHROUGH_VK_DEVICE_FUNCTIONS(LOAD_VK_DEVICE_FUNCTION)
+#undef LOAD_VK_DEVICE_FUNCTION
+#undef LOAD_VK_INSTANCE_FUNCTION
+#undef LOAD_VK_FUNCTION
+            return isComplete;
+        }
+    };
+
+    // A buffer in host-visible memory, mapped for its whole lifetime.
+    struct MappedBuffer {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VkDeviceMemory memory{VK_NULL_HANDLE};
+        uint8_t* data{nullptr};
+    };
+
+    // A command buffer, and the fence signaled when its last submission is completed. It is also the fence of the
+    // camera upload slots.
+    class VulkanSubmission {
+      public:
+        VulkanSubmission(const VulkanFunctions& vk, VkDevice device, VkQueue queue, VkCommandPool pool)
+            : m_vk(&vk), m_device(device), m_queue(queue), m_pool(pool) {
+            VkCommandBufferAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+            allocateInfo.commandPool = pool;
+            allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocateInfo.commandBufferCount = 1;
+            CHECK_VKCMD(m_vk->vkAllocateCommandBuffers(device, &allocateInfo, &m_commandBuffer));
+
+            // The fence starts signaled, so the first recording does not wait.
+            VkFenceCreateInfo fenceInfo{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+            CHECK_VKCMD(m_vk->vkCreateFence(device, &fenceInfo, nullptr, &m_fence));
+        }
+
+        VulkanSubmission(VulkanSubmission&& other) noexcept
+            : m_vk(other.m_vk), m_device(other.m_device), m_queue(other.m_queue), m_pool(other.m_pool),
+              m_commandBuffer(other.m_commandBuffer), m_fence(other.m_fence) {
+            other.m_commandBuffer = VK_NULL_HANDLE;
+            other.m_fence = VK_NULL_HANDLE;
+        }
+
+        ~VulkanSubmission() {
+            if (m_fence != VK_NULL_HANDLE) {
+                m_vk->vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, UINT64_MAX);
+                m_vk->vkDestroyFence(m_device, m_fence, nullptr);
+            }
+            if (m_commandBuffer != VK_NULL_HANDLE) {
+                m_vk->vkFreeCommandBuffers(m_device, m_pool, 1, &m_commandBuffer);
+            }
+        }
+
+        // Returns the command buffer to record into, once the GPU is done with its previous content.
+        VkCommandBuffer beginRecording(VkCommandBufferUsageFlags flags) {
+            wait();
+            CHECK_VKCMD(m_vk->vkResetCommandBuffer(m_commandBuffer, 0));
+
+            VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+            beginInfo.flags = flags;
+            CHECK_VKCMD(m_vk->vkBeginCommandBuffer(m_commandBuffer, &beginInfo));
+            return m_commandBuffer;
+        }
+
+        void endRecording() {
+            CHECK_VKCMD(m_vk->vkEndCommandBuffer(m_commandBuffer));
+        }
+
+        // Submit the recorded commands, once their previous submission is completed.
+        void submit() {
+            wait();
+            CHECK_VKCMD(m_vk->vkResetFences(m_device, 1, &m_fence));
+
+            VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &m_commandBuffer;
+            CHECK_VKCMD(m_vk->vkQueueSubmit(m_queue, 1, &submitInfo, m_fence));
+        }
+
+        bool isCompleted() {
+            return m_vk->vkGetFenceStatus(m_device, m_fence) == VK_SUCCESS;
+        }
+
+        void wait() {
+            CHECK_VKCMD(m_vk->vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, UINT64_MAX));
+        }
+
+      private:
+        const VulkanFunctions* m_vk;
+        VkDevice m_device;
+        VkQueue m_queue;
+        VkCommandPool m_pool;
+        VkCommandBuffer m_commandBuffer{VK_NULL_HANDLE};
+        VkFence m_fence{VK_NULL_HANDLE};
+    };
+
+    VkImageMemoryBarrier getImageBarrier(VkImage image,
+                                         uint32_t arrayLayer,
+                                         VkImageLayout oldLayout,
+                                         VkImageLayout newLayout,
+                                         VkAccessFlags srcAccessMask,
+                                         VkAccessFlags dstAccessMask) {
+        VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        barrier.srcAccessMask = srcAccessMask;
+        barrier.dstAccessMask = dstAccessMask;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = arrayLayer;
+        barrier.subresourceRange.layerCount = 1;
+        return barrier;
+    }
+
+    // Draw with the Vulkan device of the application, on the queue it gave to the OpenXR session. The layer only
+    // submits from within the OpenXR calls during which the runtime may use that queue too, so the application does not
+    // access it concurrently.
+    class VulkanBackend : public IGraphicsBackend {
+      public:
+        VulkanBackend(HMODULE loader,
+                      const VulkanFunctions& vk,
+                      VkPhysicalDevice physicalDevice,
+                      VkDevice device,
+                      uint32_t queueFamilyIndex,
+                      uint32_t queueIndex)
+            : m_loader(loader), m_vk(vk), m_device(device) {
+            m_vk.vkGetDeviceQueue(device, queueFamilyIndex, queueIndex, &m_queue);
+            m_vk.vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+            VkPhysicalDeviceProperties properties;
+            m_vk.vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+            m_uniformBufferAlignment = properties.limits.minUniformBufferOffsetAlignment;
+
+            {
+                VkCommandPoolCreateInfo createInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+                createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+                createInfo.queueFamilyIndex = queueFamilyIndex;
+                CHECK_VKCMD(m_vk.vkCreateCommandPool(m_device, &createInfo, nullptr, &m_commandPool));
+            }
+            {
+                VkSamplerCreateInfo createInfo{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+                createInfo.magFilter = VK_FILTER_NEAREST;
+                createInfo.minFilter = VK_FILTER_NEAREST;
+                createInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+                createInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                createInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                createInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+                createInfo.maxLod = VK_LOD_CLAMP_NONE;
+                CHECK_VKCMD(m_vk.vkCreateSampler(m_device, &createInfo, nullptr, &m_sampler));
+            }
+            {
+                VkDescriptorSetLayoutBinding bindings[2]{};
+                bindings[0].binding = 0;
+                bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                bindings[0].descriptorCount = 1;
+                bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+                bindings[1].binding = 1;
+                bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                bindings[1].descriptorCount = 1;
+                bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+                bindings[1].pImmutableSamplers = &m_sampler;
+
+                VkDescriptorSetLayoutCreateInfo createInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+                createInfo.bindingCount = ARRAYSIZE(bindings);
+                createInfo.pBindings = bindings;
+                CHECK_VKCMD(m_vk.vkCreateDescriptorSetLayout(m_device, &createInfo, nullptr, &m_descriptorSetLayout));
+            }
+            {
+                // The eye index selects the matrix in the vertex shader.
+                VkPushConstantRange pushConstantRange{};
+                pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+                pushConstantRange.offset = 0;
+                pushConstantRange.size = sizeof(uint32_t);
+
+                VkPipelineLayoutCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+                createInfo.setLayoutCount = 1;
+                createInfo.pSetLayouts = &m_descriptorSetLayout;
+                createInfo.pushConstantRangeCount = 1;
+                createInfo.pPushConstantRanges = &pushConstantRange;
+                CHECK_VKCMD(m_vk.vkCreatePipelineLayout(m_device, &createInfo, nullptr, &m_pipelineLayout));
+            }
+        }
+
+        ~VulkanBackend() override {
+            // Destroying the submissions waits for the GPU to be done with the resources.
+            m_cameraUploadRing.reset({});
+            m_drawSubmissions.clear();
+            m_swapchainUploadSubmissions.clear();
+
+            destroyCameraTexture();
+            destroyBuffer(m_swapchainUploadBuffer);
+            destroyBuffer(m_constantBuffer);
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                destroyBuffer(m_vertexBuffer[eye]);
+            }
+            destroyBuffer(m_indexBuffer);
+            for (const VkFramebuffer framebuffer : m_framebuffers) {
+                m_vk.vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+            }
+            for (const VkImageView view : m_swapchainImageViews) {
+                m_vk.vkDestroyImageView(m_device, view, nullptr);
+            }
+            m_vk.vkDestroyPipeline(m_device, m_pipeline, nullptr);
+            m_vk.vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+            m_vk.vkDestroyShaderModule(m_device, m_vertexShader, nullptr);
+            m_vk.vkDestroyShaderModule(m_device, m_pixelShader, nullptr);
+            m_vk.vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+            m_vk.vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+            m_vk.vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+            m_vk.vkDestroySampler(m_device, m_sampler, nullptr);
+            m_vk.vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+
+            FreeLibrary(m_loader);
+        }
+
+        std::unique_ptr<IShaderCompiler> createShaderCompiler() const override {
+            return std::make_unique<SPIRVCompiler>();
+        }
+
+        ShaderDescription getVertexShader() const override {
+            return {std::string_view(reinterpret_cast<const char*>(PassthroughVertexShaderSpirv),
+                                     sizeof(PassthroughVertexShaderSpirv)),
+                    "main",
+                    "vertex",
+                    0};
+        }
+
+        ShaderDescription getPixelShader() const override {
+            return {std::string_view(reinterpret_cast<const char*>(PassthroughPixelShaderSpirv),
+                                     sizeof(PassthroughPixelShaderSpirv)),
+                    "main",
+                    "fragment",
+                    0};
+        }
+
+        SwapchainFormatApi getSwapchainFormatApi() const override {
+            return SwapchainFormatApi::Vulkan;
+        }
+
+        void importSwapchainImages(OpenXrApi& openXR,
+                                   XrSwapchain swapchain,
+                                   const XrSwapchainCreateInfo& createInfo) override {
+            m_swapchainInfo = createInfo;
+
+            uint32_t imageCount;
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(swapchain, 0, &imageCount, nullptr));
+            std::vector<XrSwapchainImageVulkanKHR> images(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR, nullptr});
+            CHECK_XRCMD(openXR.xrEnumerateSwapchainImages(
+                swapchain, imageCount, &imageCount, reinterpret_cast<XrSwapchainImageBaseHeader*>(images.data())));
+            for (uint32_t i = 0; i < imageCount; i++) {
+                m_swapchainImages.push_back(images[i].image);
+            }
+
+            // The runtime hands over the images in the color attachment layout, and expects them back in that layout.
+            // The passthrough is drawn over the previous content, like with the other graphics APIs.
+            {
+                VkAttachmentDescription attachment{};
+                attachment.format = (VkFormat)createInfo.format;
+                attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+                attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+                VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+                VkSubpassDescription subpass{};
+                subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+                subpass.colorAttachmentCount = 1;
+                subpass.pColorAttachments = &colorReference;
+
+                VkRenderPassCreateInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+                renderPassInfo.attachmentCount = 1;
+                renderPassInfo.pAttachments = &attachment;
+                renderPassInfo.subpassCount = 1;
+                renderPassInfo.pSubpasses = &subpass;
+                CHECK_VKCMD(m_vk.vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass));
+            }
+
+            // One view and framebuffer per slice, indexed by imageIndex * ViewCount + eye.
+            for (uint32_t i = 0; i < imageCount; i++) {
+                for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                    VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+                    viewInfo.image = m_swapchainImages[i];
+                    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                    viewInfo.format = (VkFormat)createInfo.format;
+                    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    viewInfo.subresourceRange.levelCount = 1;
+                    viewInfo.subresourceRange.baseArrayLayer = eye;
+                    viewInfo.subresourceRange.layerCount = 1;
+                    VkImageView view;
+                    CHECK_VKCMD(m_vk.vkCreateImageView(m_device, &viewInfo, nullptr, &view));
+                    m_swapchainImageViews.push_back(view);
+
+                    VkFramebufferCreateInfo framebufferInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+                    framebufferInfo.renderPass = m_renderPass;
+                    framebufferInfo.attachmentCount = 1;
+                    framebufferInfo.pAttachments = &view;
+                    framebufferInfo.width = createInfo.width;
+                    framebufferInfo.height = createInfo.height;
+                    framebufferInfo.layers = 1;
+                    VkFramebuffer framebuffer;
+                    CHECK_VKCMD(m_vk.vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &framebuffer));
+                    m_framebuffers.push_back(framebuffer);
+                }
+            }
+
+            // The draw is recorded once per swapchain image, and reads the matrices from that image's slot of the
+            // constant buffer.
+            m_constantBufferStride = (sizeof(ConstantBuffer) + m_uniformBufferAlignment - 1) /
+                                     m_uniformBufferAlignment * m_uniformBufferAlignment;
+            m_constantBuffer = createMappedBuffer(imageCount * m_constantBufferStride,
+                                                  VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+            {
+                VkDescriptorPoolSize poolSizes[2]{};
+                poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                poolSizes[0].descriptorCount = imageCount;
+                poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                poolSizes[1].descriptorCount = imageCount;
+
+                VkDescriptorPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+                poolInfo.maxSets = imageCount;
+                poolInfo.poolSizeCount = ARRAYSIZE(poolSizes);
+                poolInfo.pPoolSizes = poolSizes;
+                CHECK_VKCMD(m_vk.vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool));
+
+                const std::vector<VkDescriptorSetLayout> layouts(imageCount, m_descriptorSetLayout);
+                VkDescriptorSetAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+                allocateInfo.descriptorPool = m_descriptorPool;
+                allocateInfo.descriptorSetCount = imageCount;
+                allocateInfo.pSetLayouts = layouts.data();
+                m_descriptorSets.resize(imageCount);
+                CHECK_VKCMD(m_vk.vkAllocateDescriptorSets(m_device, &allocateInfo, m_descriptorSets.data()));
+            }
+            for (uint32_t i = 0; i < imageCount; i++) {
+                m_drawSubmissions.emplace_back(m_vk, m_device, m_queue, m_commandPool);
+            }
+            m_isDrawRecorded.assign(imageCount, false);
+            updateDescriptorSets();
+
+            // The images prepared on the CPU are staged in one slot per slice.
+            if (createInfo.usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT) {
+                m_swapchainUploadSliceSize = (size_t)createInfo.width * createInfo.height * sizeof(uint32_t);
+                m_swapchainUploadBuffer = createMappedBuffer(imageCount * ViewCount * m_swapchainUploadSliceSize,
+                                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+                for (uint32_t i = 0; i < imageCount * ViewCount; i++) {
+                    m_swapchainUploadSubmissions.emplace_back(m_vk, m_device, m_queue, m_commandPool);
+                }
+            }
+        }
+
+        void createDrawingResources(const std::vector<uint8_t>& vsBytes,
+                                    const std::vector<uint8_t>& psBytes,
+                                    const std::vector<VertexPositionTexture>* vertices,
+                                    const std::vector<uint16_t>& indices) override {
+            ALLOCATION_SCOPE("createDrawingResources");
+
+            m_vertexShader = createShaderModule(vsBytes);
+            m_pixelShader = createShaderModule(psBytes);
+
+            // The buffers stay mapped, so the positions may be updated in place.
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                m_vertexCount = (uint32_t)vertices[eye].size();
+                m_vertexBuffer[eye] = createMappedBuffer(m_vertexCount * sizeof(VertexPositionTexture),
+                                                         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+                memcpy(m_vertexBuffer[eye].data, vertices[eye].data(), m_vertexCount * sizeof(VertexPositionTexture));
+            }
+            m_indexCount = (uint32_t)indices.size();
+            m_indexBuffer = createMappedBuffer(m_indexCount * sizeof(uint16_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+            memcpy(m_indexBuffer.data, indices.data(), m_indexCount * sizeof(uint16_t));
+        }
+
+        void updateVertexPositions(const std::vector<XMFLOAT3>* positions) override {
+            // The previous draw may still be reading the positions.
+            waitForDraws();
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                VertexPositionTexture* const vertices =
+                    reinterpret_cast<VertexPositionTexture*>(m_vertexBuffer[eye].data);
+                for (uint32_t i = 0; i < m_vertexCount; i++) {
+                    vertices[i].position = positions[eye][i];
+                }
+            }
+        }
+
+        uint8_t* mapCameraTexture(uint32_t width, uint32_t height, uint32_t& pitch) override {
+            ensureCameraTexture(width, height);
+
+            // The slot is not in use by the GPU anymore, so writing to it does not race with the previous copy.
+            m_cameraUploadSlot = m_cameraUploadRing.acquire();
+
+            pitch = width;
+            return m_cameraUploadBuffer.data + m_cameraUploadSlot * m_cameraUploadSlotSize;
+        }
+
+        void unmapCameraTexture(bool commit) override {
+            if (!commit) {
+                // The slot will be overwritten by the next image.
+                m_cameraUploadRing.cancel(m_cameraUploadSlot);
+                return;
+            }
+
+            // The memory is coherent, the submission makes the CPU writes visible to the copy. The previous content
+            // of the texture is discarded, but the copy must still wait for the draws reading it.
+            VulkanSubmission& submission = m_cameraUploadRing.getFence(m_cameraUploadSlot);
+            const VkCommandBuffer commandBuffer =
+                submission.beginRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            {
+                const VkImageMemoryBarrier barrier = getImageBarrier(m_cameraImage,
+                                                                     0,
+                                                                     VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                     0,
+                                                                     VK_ACCESS_TRANSFER_WRITE_BIT);
+                m_vk.vkCmdPipelineBarrier(commandBuffer,
+                                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          0,
+                                          0,
+                                          nullptr,
+                                          0,
+                                          nullptr,
+                                          1,
+                                          &barrier);
+            }
+            {
+                VkBufferImageCopy region{};
+                region.bufferOffset = m_cameraUploadSlot * m_cameraUploadSlotSize;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = {m_cameraTextureWidth, m_cameraTextureHeight, 1};
+                m_vk.vkCmdCopyBufferToImage(commandBuffer,
+                                            m_cameraUploadBuffer.buffer,
+                                            m_cameraImage,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                            1,
+                                            &region);
+            }
+            {
+                const VkImageMemoryBarrier barrier = getImageBarrier(m_cameraImage,
+                                                                     0,
+                                                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                                     VK_ACCESS_SHADER_READ_BIT);
+                m_vk.vkCmdPipelineBarrier(commandBuffer,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                          0,
+                                          0,
+                                          nullptr,
+                                          0,
+                                          nullptr,
+                                          1,
+                                          &barrier);
+            }
+            submission.endRecording();
+            submission.submit();
+
+            m_cameraUploadRing.submit(m_cameraUploadSlot);
+            m_isCameraTextureUploaded = true;
+        }
+
+        const UploadRingStatistics& getCameraUploadStatistics() const override {
+            return m_cameraUploadRing.getStatistics();
+        }
+
+        void setOpacity(float opacity) override {
+            m_opacity = opacity;
+        }
+
+        void drawPassthroughLayer(uint32_t imageIndex,
+                                  const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+            if (!m_isCameraTextureUploaded) {
+                return;
+            }
+
+            ensurePipeline();
+
+            // The slot of the constant buffer is not read anymore once the previous draw into this image is done.
+            VulkanSubmission& submission = m_drawSubmissions[imageIndex];
+            submission.wait();
+            {
+                ConstantBuffer* const constants =
+                    reinterpret_cast<ConstantBuffer*>(m_constantBuffer.data + imageIndex * m_constantBufferStride);
+                std::copy(std::begin(modelViewProjection),
+                          std::end(modelViewProjection),
+                          std::begin(constants->modelViewProjection));
+#ifdef XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT
+                constants->colorAdjustment = {XR_WMR_PASSTHROUGH_COLOR_ADJUSTMENT, m_opacity};
+#else
+                constants->colorAdjustment = {1.f, 1.f, 1.f, m_opacity};
+#endif
+            }
+
+            if (!m_isDrawRecorded[imageIndex]) {
+                recordDraw(submission.beginRecording(0), imageIndex);
+                submission.endRecording();
+                m_isDrawRecorded[imageIndex] = true;
+            }
+            submission.submit();
+        }
+
+        void uploadSwapchainImage(uint32_t imageIndex, uint32_t slice, const void* data, size_t pitch) override {
+            const uint32_t slot = imageIndex * ViewCount + slice;
+            VulkanSubmission& submission = m_swapchainUploadSubmissions[slot];
+
+            // The staging slot is not read anymore once the previous copy into this slice is done.
+            submission.wait();
+            const size_t rowSize = m_swapchainInfo.width * sizeof(uint32_t);
+            uint8_t* const staging = m_swapchainUploadBuffer.data + slot * m_swapchainUploadSliceSize;
+            for (uint32_t y = 0; y < m_swapchainInfo.height; y++) {
+                memcpy(staging + y * rowSize, reinterpret_cast<const uint8_t*>(data) + y * pitch, rowSize);
+            }
+
+            const VkImage image = m_swapchainImages[imageIndex];
+            const VkCommandBuffer commandBuffer =
+                submission.beginRecording(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+            {
+                const VkImageMemoryBarrier barrier = getImageBarrier(image,
+                                                                     slice,
+                                                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                     VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                                                     VK_ACCESS_TRANSFER_WRITE_BIT);
+                m_vk.vkCmdPipelineBarrier(commandBuffer,
+                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          0,
+                                          0,
+                                          nullptr,
+                                          0,
+                                          nullptr,
+                                          1,
+                                          &barrier);
+            }
+            {
+                VkBufferImageCopy region{};
+                region.bufferOffset = slot * m_swapchainUploadSliceSize;
+                region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.baseArrayLayer = slice;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = {m_swapchainInfo.width, m_swapchainInfo.height, 1};
+                m_vk.vkCmdCopyBufferToImage(commandBuffer,
+                                            m_swapchainUploadBuffer.buffer,
+                                            image,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                            1,
+                                            &region);
+            }
+            {
+                const VkImageMemoryBarrier barrier =
+                    getImageBarrier(image,
+                                    slice,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                                    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+                m_vk.vkCmdPipelineBarrier(commandBuffer,
+                                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          0,
+                                          0,
+                                          nullptr,
+                                          0,
+                                          nullptr,
+                                          1,
+                                          &barrier);
+            }
+            submission.endRecording();
+            submission.submit();
+        }
+
+        bool isDepthCompositionSupported(int64_t colorFormat, int64_t depthFormat) const override {
+            return false;
+        }
+
+        void importApplicationSwapchain(OpenXrApi& openXR,
+                                        XrSwapchain swapchain,
+                                        const XrSwapchainCreateInfo& createInfo) override {
+        }
+
+        void forgetApplicationSwapchain(XrSwapchain swapchain) override {
+        }
+
+        void compositePassthroughLayer(const CompositionView (&views)[ViewCount],
+                                       const XMFLOAT4X4 (&modelViewProjection)[ViewCount]) override {
+        }
+
+      private:
+        uint32_t findMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags flags) const {
+            for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+                if ((memoryTypeBits & (1u << i)) &&
+                    (m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+                    return i;
+                }
+            }
+            CHECK_MSG(false, "No suitable memory type");
+            return 0;
+        }
+
+        VkDeviceMemory allocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags) {
+            VkMemoryAllocateInfo allocateInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+            allocateInfo.allocationSize = requirements.size;
+            allocateInfo.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, flags);
+            VkDeviceMemory memory;
+            CHECK_VKCMD(m_vk.vkAllocateMemory(m_device, &allocateInfo, nullptr, &memory));
+            return memory;
+        }
+
+        MappedBuffer createMappedBuffer(VkDeviceSize size, VkBufferUsageFlags usage) {
+            MappedBuffer buffer;
+
+            VkBufferCreateInfo createInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+            createInfo.size = size;
+            createInfo.usage = usage;
+            createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            CHECK_VKCMD(m_vk.vkCreateBuffer(m_device, &createInfo, nullptr, &buffer.buffer));
+
+            VkMemoryRequirements requirements;
+            m_vk.vkGetBufferMemoryRequirements(m_device, buffer.buffer, &requirements);
+            buffer.memory = allocateMemory(requirements,
+                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            CHECK_VKCMD(m_vk.vkBindBufferMemory(m_device, buffer.buffer, buffer.memory, 0));
+            CHECK_VKCMD(
+                m_vk.vkMapMemory(m_device, buffer.memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&buffer.data)));
+
+            return buffer;
+        }
+
+        void destroyBuffer(MappedBuffer& buffer) {
+            // Freeing the memory also unmaps it.
+            m_vk.vkDestroyBuffer(m_device, buffer.buffer, nullptr);
+            m_vk.vkFreeMemory(m_device, buffer.memory, nullptr);
+            buffer = {};
+        }
+
+        VkShaderModule createShaderModule(const std::vector<uint8_t>& bytecode) {
+            VkShaderModuleCreateInfo createInfo{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+            createInfo.codeSize = bytecode.size();
+            createInfo.pCode = reinterpret_cast<const uint32_t*>(bytecode.data());
+            VkShaderModule module;
+            CHECK_VKCMD(m_vk.vkCreateShaderModule(m_device, &createInfo, nullptr, &module));
+            return module;
+        }
+
+        // Both the shaders and the swapchain format must be known.
+        void ensurePipeline() {
+            if (m_pipeline != VK_NULL_HANDLE) {
+                return;
+            }
+
+            VkPipelineShaderStageCreateInfo stages[2]{};
+            stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+            stages[0].module = m_vertexShader;
+            stages[0].pName = "main";
+            stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+            stages[1].module = m_pixelShader;
+            stages[1].pName = "main";
+
+            VkVertexInputBindingDescription binding{0, sizeof(VertexPositionTexture), VK_VERTEX_INPUT_RATE_VERTEX};
+            VkVertexInputAttributeDescription attributes[2]{};
+            attributes[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexPositionTexture, position)};
+            attributes[1] = {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexPositionTexture, textureCoordinate)};
+            VkPipelineVertexInputStateCreateInfo vertexInput{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+            vertexInput.vertexBindingDescriptionCount = 1;
+            vertexInput.pVertexBindingDescriptions = &binding;
+            vertexInput.vertexAttributeDescriptionCount = ARRAYSIZE(attributes);
+            vertexInput.pVertexAttributeDescriptions = attributes;
+
+            VkPipelineInputAssemblyStateCreateInfo inputAssembly{
+                VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+            inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+            VkPipelineViewportStateCreateInfo viewport{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+            viewport.viewportCount = 1;
+            viewport.scissorCount = 1;
+
+            VkPipelineRasterizationStateCreateInfo rasterization{
+                VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+            rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+            rasterization.cullMode = VK_CULL_MODE_NONE;
+            rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+            rasterization.lineWidth = 1.f;
+
+            VkPipelineMultisampleStateCreateInfo multisample{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+            multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            VkPipelineColorBlendAttachmentState blendAttachment{};
+            blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                             VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+            VkPipelineColorBlendStateCreateInfo blend{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+            blend.attachmentCount = 1;
+            blend.pAttachments = &blendAttachment;
+
+            const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+            VkPipelineDynamicStateCreateInfo dynamicState{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+            dynamicState.dynamicStateCount = ARRAYSIZE(dynamicStates);
+            dynamicState.pDynamicStates = dynamicStates;
+
+            VkGraphicsPipelineCreateInfo createInfo{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+            createInfo.stageCount = ARRAYSIZE(stages);
+            createInfo.pStages = stages;
+            createInfo.pVertexInputState = &vertexInput;
+            createInfo.pInputAssemblyState = &inputAssembly;
+            createInfo.pViewportState = &viewport;
+            createInfo.pRasterizationState = &rasterization;
+            createInfo.pMultisampleState = &multisample;
+            createInfo.pColorBlendState = &blend;
+            createInfo.pDynamicState = &dynamicState;
+            createInfo.layout = m_pipelineLayout;
+            createInfo.renderPass = m_renderPass;
+            createInfo.subpass = 0;
+            CHECK_VKCMD(m_vk.vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_pipeline));
+        }
+
+        void recordDraw(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+            const VkViewport viewport{
+                0.f, 0.f, (float)m_swapchainInfo.width, (float)m_swapchainInfo.height, 0.f, 1.f};
+            const VkRect2D scissor{{0, 0}, {m_swapchainInfo.width, m_swapchainInfo.height}};
+            m_vk.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
+            m_vk.vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            m_vk.vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            m_vk.vkCmdBindDescriptorSets(commandBuffer,
+                                         VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                         m_pipelineLayout,
+                                         0,
+                                         1,
+                                         &m_descriptorSets[imageIndex],
+                                         0,
+                                         nullptr);
+            m_vk.vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+            for (uint32_t eye = 0; eye < ViewCount; eye++) {
+                // Setup per-eye rendering state.
+                VkRenderPassBeginInfo beginInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+                beginInfo.renderPass = m_renderPass;
+                beginInfo.framebuffer = m_framebuffers[imageIndex * ViewCount + eye];
+                beginInfo.renderArea = scissor;
+                m_vk.vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+                const VkDeviceSize offset = 0;
+                m_vk.vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_vertexBuffer[eye].buffer, &offset);
+                m_vk.vkCmdPushConstants(
+                    commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &eye);
+
+                // Draw the screen.
+                m_vk.vkCmdDrawIndexed(commandBuffer, m_indexCount, 1, 0, 0, 0);
+
+                m_vk.vkCmdEndRenderPass(commandBuffer);
+            }
+        }
+
+        void waitForDraws() {
+            for (VulkanSubmission& submission : m_drawSubmissions) {
+                submission.wait();
+            }
+        }
+
+        // Point each swapchain image's descriptor set to its slot of the constant buffer and to the camera texture.
+        // The sets must not be in use by the GPU.
+        void updateDescriptorSets() {
+            for (uint32_t i = 0; i < m_descriptorSets.size(); i++) {
+                VkDescriptorBufferInfo bufferInfo{};
+                bufferInfo.buffer = m_constantBuffer.buffer;
+                bufferInfo.offset = i * m_constantBufferStride;
+                bufferInfo.range = sizeof(ConstantBuffer);
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.imageView = m_cameraImageView;
+                imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+                VkWriteDescriptorSet writes[2]{};
+                writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[0].dstSet = m_descriptorSets[i];
+                writes[0].dstBinding = 0;
+                writes[0].descriptorCount = 1;
+                writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                writes[0].pBufferInfo = &bufferInfo;
+                writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[1].dstSet = m_descriptorSets[i];
+                writes[1].dstBinding = 1;
+                writes[1].descriptorCount = 1;
+                writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                writes[1].pImageInfo = &imageInfo;
+                m_vk.vkUpdateDescriptorSets(m_device, m_cameraImageView != VK_NULL_HANDLE ? 2 : 1, writes, 0, nullptr);
+            }
+
+            // The recorded draws refer to the previous descriptors.
+            m_isDrawRecorded.assign(m_isDrawRecorded.size(), false);
+        }
+
+        void ensureCameraTexture(uint32_t width, uint32_t height) {
+            if (m_cameraImage != VK_NULL_HANDLE && m_cameraTextureWidth == width && m_cameraTextureHeight == height) {
+                return;
+            }
+
+            // A persistently mapped buffer with one slot per upload in flight. Destroying the previous slots waits for
+            // their copies.
+            std::vector<VulkanSubmission> fences;
+            for (uint32_t i = 0; i < CameraUploadSlots; i++) {
+                fences.emplace_back(m_vk, m_device, m_queue, m_commandPool);
+            }
+            m_cameraUploadRing.reset(std::move(fences));
+            waitForDraws();
+            destroyCameraTexture();
+
+            {
+                VkImageCreateInfo createInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+                createInfo.imageType = VK_IMAGE_TYPE_2D;
+                createInfo.format = VK_FORMAT_R8_UNORM;
+                createInfo.extent = {width, height, 1};
+                createInfo.mipLevels = 1;
+                createInfo.arrayLayers = 1;
+                createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+                createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+                createInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+                createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                CHECK_VKCMD(m_vk.vkCreateImage(m_device, &createInfo, nullptr, &m_cameraImage));
+
+                VkMemoryRequirements requirements;
+                m_vk.vkGetImageMemoryRequirements(m_device, m_cameraImage, &requirements);
+                m_cameraImageMemory = allocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                CHECK_VKCMD(m_vk.vkBindImageMemory(m_device, m_cameraImage, m_cameraImageMemory, 0));
+
+                VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+                viewInfo.image = m_cameraImage;
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = VK_FORMAT_R8_UNORM;
+                viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                viewInfo.subresourceRange.levelCount = 1;
+                viewInfo.subresourceRange.layerCount = 1;
+                CHECK_VKCMD(m_vk.vkCreateImageView(m_device, &viewInfo, nullptr, &m_cameraImageView));
+            }
+            m_cameraTextureWidth = width;
+            m_cameraTextureHeight = height;
+
+            // The copies read each slot at an offset that must be a multiple of 4.
+            m_cameraUploadSlotSize = ((size_t)width * height + 3) & ~(size_t)3;
+            m_cameraUploadBuffer =
+                createMappedBuffer(CameraUploadSlots * m_cameraUploadSlotSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+            updateDescriptorSets();
+        }
+
+        void destroyCameraTexture() {
+            m_vk.vkDestroyImageView(m_device, m_cameraImageView, nullptr);
+            m_vk.vkDestroyImage(m_device, m_cameraImage, nullptr);
+            m_vk.vkFreeMemory(m_device, m_cameraImageMemory, nullptr);
+            destroyBuffer(m_cameraUploadBuffer);
+            m_cameraImageView = VK_NULL_HANDLE;
+            m_cameraImage = VK_NULL_HANDLE;
+            m_cameraImageMemory = VK_NULL_HANDLE;
+            m_isCameraTextureUploaded = false;
+        }
+
+        const HMODULE m_loader;
+        const VulkanFunctions m_vk;
+        const VkDevice m_device;
+        VkQueue m_queue{VK_NULL_HANDLE};
+        VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+        VkDeviceSize m_uniformBufferAlignment{1};
+        VkCommandPool m_commandPool{VK_NULL_HANDLE};
+
+        // Swapchain resources.
+        XrSwapchainCreateInfo m_swapchainInfo{};
+        std::vector<VkImage> m_swapchainImages;
+        std::vector<VkImageView> m_swapchainImageViews;
+        std::vector<VkFramebuffer> m_framebuffers;
+        VkRenderPass m_renderPass{VK_NULL_HANDLE};
+        MappedBuffer m_constantBuffer;
+        VkDeviceSize m_constantBufferStride{0};
+        VkDescriptorPool m_descriptorPool{VK_NULL_HANDLE};
+        std::vector<VkDescriptorSet> m_descriptorSets;
+        std::vector<VulkanSubmission> m_drawSubmissions;
+        std::vector<bool> m_isDrawRecorded;
+        MappedBuffer m_swapchainUploadBuffer;
+        size_t m_swapchainUploadSliceSize{0};
+        std::vector<VulkanSubmission> m_swapchainUploadSubmissions;
+
+        // Camera image resources.
+        VkImage m_cameraImage{VK_NULL_HANDLE};
+        VkDeviceMemory m_cameraImageMemory{VK_NULL_HANDLE};
+        VkImageView m_cameraImageView{VK_NULL_HANDLE};
+        uint32_t m_cameraTextureWidth{0};
+        uint32_t m_cameraTextureHeight{0};
+        bool m_isCameraTextureUploaded{false};
+        MappedBuffer m_cameraUploadBuffer;
+        size_t m_cameraUploadSlotSize{0};
+        uint32_t m_cameraUploadSlot{0};
+        UploadRing<VulkanSubmission> m_cameraUploadRing;
+
+        // Drawing resources.
+        VkSampler m_sampler{VK_NULL_HANDLE};
+        VkDescriptorSetLayout m_descriptorSetLayout{VK_NULL_HANDLE};
+        VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+        VkShaderModule m_vertexShader{VK_NULL_HANDLE};
+        VkShaderModule m_pixelShader{VK_NULL_HANDLE};
+        VkPipeline m_pipeline{VK_NULL_HANDLE};
+        MappedBuffer m_vertexBuffer[ViewCount];
+        uint32_t m_vertexCount{0};
+        MappedBuffer m_indexBuffer;
+        uint32_t m_indexCount{0};
+        float m_opacity{1.f};
+    };
+
+} // namespace
+
+namespace passthrough {
+
+    std::unique_ptr<IGraphicsBackend> createVulkanBackend(VkInstance instance,
+                                                          VkPhysicalDevice physicalDevice,
+                                                          VkDevice device,
+                                                          uint32_t queueFamilyIndex,
+                                                          uint32_t queueIndex) {
+        // The application already loaded the Vulkan loader, this only adds a reference.
+        const HMODULE loader = LoadLibraryA("vulkan-1.dll");
+        if (!loader) {
+            Log("Failed to load the Vulkan loader\n");
+            return nullptr;
+        }
+
+        VulkanFunctions vk;
+        if (!vk.load(loader, instance, device)) {
+            FreeLibrary(loader);
+            return nullptr;
+        }
+
+        return std::make_unique<VulkanBackend>(loader, vk, physicalDevice, device, queueFamilyIndex, queueIndex);
+    }
+
+} // namespace passthrough
@@ -26,26 +26,98 @@
 
 namespace {
 
+    // How often to look for a frame once it is overdue.
+    constexpr auto PollInterval = 500us;
+
+    // Wake up ahead of the predicted arrival of the next frame, to absorb the jitter of the camera.
+    constexpr auto WakeUpMargin = 1ms;
+
     class CameraClientWrapper : public ICameraClientWrapper {
       public:
         CameraClientWrapper() {
             m_cameraClient.Start();
+
+            // Unlike Sleep(), the high resolution timer is not bound to the system timer resolution.
+            m_timer = CreateWaitableTimerExW(
+                nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, SYNCHRONIZE | TIMER_MODIFY_STATE);
+            if (!m_timer) {
+                m_timer = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+            }
         }
 
         ~CameraClientWrapper() override {
+            if (m_timer) {
+                CloseHandle(m_timer);
+            }
             m_cameraClient.Stop();
         };
 
         bool AcquireNextFrame(core::CameraFrame& frame) override {
-            return m_cameraClient.AcquireNextFrame(frame);
+            if (!m_cameraClient.AcquireNextFrame(frame)) {
+                return false;
+            }
+
+            updateFramePeriod(std::chrono::steady_clock::now());
+            return true;
         }
 
         void ReleaseFrame() override {
             m_cameraClient.ReleaseFrame();
         }
 
+        // The camera server does not signal new frames. Rather than spinning on the shared memory, sleep until the
+        // next frame is expected from the camera cadence, then look for it at a finer interval.
+        bool WaitForNextFrame(core::CameraFrame& frame, std::chrono::microseconds timeout) override {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (true) {
+                if (AcquireNextFrame(frame)) {
+                    return true;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
+                    return false;
+                }
+
+                auto wakeUp = m_lastFrameTime + m_framePeriod - WakeUpMargin;
+                if (m_framePeriod.count() == 0 || wakeUp <= now) {
+                    wakeUp = now + PollInterval;
+                }
+                sleepFor(std::min(wakeUp, deadline) - now);
+            }
+        }
+
       private:
+        void updateFramePeriod(std::chrono::steady_clock::time_point now) {
+            if (m_lastFrameTime.time_since_epoch().count() != 0) {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastFrameTime);
+
+                // Skip the outliers (eg: camera restarting), and smooth the rest.
+                if (elapsed < 100ms) {
+                    m_framePeriod = m_framePeriod.count() == 0 ? elapsed : (m_framePeriod * 7 + elapsed) / 8;
+                }
+            }
+            m_lastFrameTime = now;
+        }
+
+        void sleepFor(std::chrono::steady_clock::duration duration) {
+            // Relative due times are negative, in 100ns units.
+            LARGE_INTEGER dueTime;
+            dueTime.QuadPart = -std::max(
+                std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(duration).count(),
+                (int64_t)1);
+            if (m_timer && SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(m_timer, INFINITE);
+            } else {
+                Sleep(1);
+            }
+        }
+
         core::CameraClient m_cameraClient;
+        HANDLE m_timer{nullptr};
+
+        std::chrono::steady_clock::time_point m_lastFrameTime{};
+        std::chrono::microseconds m_framePeriod{0};
     };
 
 } // namespace
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include <CameraClient.hpp>
@@ -31,6 +32,46 @@ struct ICameraClientWrapper {
 
     virtual bool AcquireNextFrame(core::CameraFrame& frame) = 0;
     virtual void ReleaseFrame() = 0;
+
+    // Like AcquireNextFrame(), but blocks until a new frame is available or the timeout expires.
+    virtual bool WaitForNextFrame(core::CameraFrame& frame, std::chrono::microseconds timeout) = 0;
+};
+
+// Holds a frame acquired from the camera client until going out of scope. The image is read in place from the memory
+// shared with the camera server, and must not be used after the lease is destroyed.
+class CameraFrameLease {
+  public:
+    // Without a timeout, only a frame that is already available is acquired.
+    CameraFrameLease(ICameraClientWrapper& client, std::chrono::microseconds timeout = {}) : m_client(client) {
+        m_isAcquired =
+            timeout.count() > 0 ? client.WaitForNextFrame(m_frame, timeout) : client.AcquireNextFrame(m_frame);
+    }
+
+    ~CameraFrameLease() {
+        if (m_isAcquired) {
+            m_client.ReleaseFrame();
+        }
+    }
+
+    CameraFrameLease(const CameraFrameLease&) = delete;
+    CameraFrameLease& operator=(const CameraFrameLease&) = delete;
+
+    explicit operator bool() const {
+        return m_isAcquired;
+    }
+
+    const core::CameraFrame& operator*() const {
+        return m_frame;
+    }
+
+    const core::CameraFrame* operator->() const {
+        return &m_frame;
+    }
+
+  private:
+    ICameraClientWrapper& m_client;
+    core::CameraFrame m_frame{};
+    bool m_isAcquired;
 };
 
 __declspec(dllexport) std::unique_ptr<ICameraClientWrapper> createCameraClientWrapper();
@@ -22,6 +22,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
+using namespace std::chrono_literals;
+
+// Windows header files.
+#define WIN32_LEAN_AND_MEAN // Exclude rarely-used stuff from Windows headers
+#include <windows.h>
+
 #include <CameraClient.hpp>
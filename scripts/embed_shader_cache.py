@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+#
+# Convert the entries of a shader cache directory (%LOCALAPPDATA%\WMR-Passthrough\shader-cache) into
+# precompiled_shaders.gen.h, so they can be embedded into the layer DLL at build time.
+#
+# Usage: embed_shader_cache.py <shader-cache directory> <output header>
+
+import struct
+import sys
+from pathlib import Path
+
+# Must match CacheFileHeader in shader_cache.cpp.
+HEADER = struct.Struct('<IIQQII')
+MAGIC = 0x43535057
+FORMAT_VERSION = 1
+
+
+def fnv1a32(data):
+    value = 0x811c9dc5
+    for byte in data:
+        value = ((value ^ byte) * 0x01000193) & 0xffffffff
+    return value
+
+
+def load_entries(directory):
+    entries = []
+    for path in sorted(Path(directory).glob('*.bin')):
+        data = path.read_bytes()
+        if len(data) < HEADER.size:
+            continue
+        magic, version, key, size, checksum, _ = HEADER.unpack_from(data)
+        bytecode = data[HEADER.size:]
+        if magic != MAGIC or version != FORMAT_VERSION or size != len(bytecode) or fnv1a32(bytecode) != checksum:
+            print('Skipping invalid entry {}'.format(path.name), file=sys.stderr)
+            continue
+        entries.append((key, bytecode))
+    return entries
+
+
+def main():
+    if len(sys.argv) != 3:
+        print('Usage: {} <shader-cache directory> <output header>'.format(sys.argv[0]), file=sys.stderr)
+        return 1
+
+    entries = load_entries(sys.argv[1])
+
+    lines = ['// Generated by embed_shader_cache.py. Do not edit.', '', '#pragma once', '']
+    for key, bytecode in entries:
+        lines.append('const uint8_t PrecompiledShader_{:016x}[] = {{'.format(key))
+        for offset in range(0, len(bytecode), 16):
+            lines.append('    ' + ', '.join('0x{:02x}'.format(b) for b in bytecode[offset:offset + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+    lines.append('const std::array<PrecompiledShader, {}> PrecompiledShaders{{{{'.format(len(entries)))
+    for key, bytecode in entries:
+        lines.append('    {{0x{0:016x}ull, PrecompiledShader_{0:016x}, sizeof(PrecompiledShader_{0:016x})}},'.format(key))
+    lines.append('}};')
+
+    Path(sys.argv[2]).write_text('\n'.join(lines) + '\n')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())